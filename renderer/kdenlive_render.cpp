@@ -23,6 +23,9 @@
 #include <QApplication>
 #include <QDir>
 #include <QDomDocument>
+#include <QThread>
+#include <atomic>
+#include <vector>
 
 int main(int argc, char **argv)
 {
@@ -73,6 +76,13 @@ int main(int argc, char **argv)
             QStringList consumerParams = args.at(0).split(QLatin1Char(' '), Qt::SkipEmptyParts);
 #endif
             args.removeFirst();
+            // number of chunks rendered in parallel
+            int workers = 1;
+            if (!args.isEmpty() && args.at(0).startsWith(QLatin1String("-workers:"))) {
+                workers = qMax(1, args.at(0).section(QLatin1Char(':'), 1).toInt());
+                args.removeFirst();
+            }
+            workers = qMin(workers, chunks.count());
             QDir baseFolder(target);
 
             // After initialising the MLT factory, set the locale back from user default to C
@@ -89,33 +99,61 @@ int main(int argc, char **argv)
             }
             const char *localename = prod.get_lcnumeric();
             QLocale::setDefault(QLocale(localename));
-            for (const QString &frame : qAsConst(chunks)) {
-                fprintf(stderr, "START:%d \n", frame.toInt());
-                QString fileName = QStringLiteral("%1.%2").arg(frame,extension);
-                if (baseFolder.exists(fileName)) {
-                    // Don't overwrite an existing file
+            // Chunks are taken in the given order, so the caller decides which ones come first.
+            // Each worker has its own producer, there is nothing shared between workers but the chunk index
+            std::atomic<int> nextChunk(0);
+            std::atomic<bool> failed(false);
+            auto renderChunks = [&](Mlt::Profile &workerProfile, Mlt::Producer &workerProd) {
+                for (int ix = nextChunk++; ix < chunks.count() && !failed; ix = nextChunk++) {
+                    const QString &frame = chunks.at(ix);
+                    fprintf(stderr, "START:%d \n", frame.toInt());
+                    QString fileName = QStringLiteral("%1.%2").arg(frame,extension);
+                    if (baseFolder.exists(fileName)) {
+                        // Don't overwrite an existing file
+                        fprintf(stderr, "DONE:%d \n", frame.toInt());
+                        continue;
+                    }
+                    QScopedPointer<Mlt::Producer> playlst(workerProd.cut(frame.toInt(), frame.toInt() + chunkSize));
+                    QScopedPointer<Mlt::Consumer> cons(
+                        new Mlt::Consumer(workerProfile, QString("avformat:%1").arg(baseFolder.absoluteFilePath(fileName)).toUtf8().constData()));
+                    for (const QString &param : qAsConst(consumerParams)) {
+                        if (param.contains(QLatin1Char('='))) {
+                            cons->set(param.section(QLatin1Char('='), 0, 0).toUtf8().constData(), param.section(QLatin1Char('='), 1).toUtf8().constData());
+                        }
+                    }
+                    if (!cons->is_valid()) {
+                        fprintf(stderr, " = =  = INVALID CONSUMER\n\n");
+                        failed = true;
+                        return;
+                    }
+                    cons->set("terminate_on_pause", 1);
+                    cons->connect(*playlst);
+                    playlst.reset();
+                    cons->run();
+                    cons->stop();
+                    cons->purge();
                     fprintf(stderr, "DONE:%d \n", frame.toInt());
-                    continue;
                 }
-                QScopedPointer<Mlt::Producer> playlst(prod.cut(frame.toInt(), frame.toInt() + chunkSize));
-                QScopedPointer<Mlt::Consumer> cons(
-                    new Mlt::Consumer(profile, QString("avformat:%1").arg(baseFolder.absoluteFilePath(fileName)).toUtf8().constData()));
-                for (const QString &param : qAsConst(consumerParams)) {
-                    if (param.contains(QLatin1Char('='))) {
-                        cons->set(param.section(QLatin1Char('='), 0, 0).toUtf8().constData(), param.section(QLatin1Char('='), 1).toUtf8().constData());
+            };
+            std::vector<QThread *> threads;
+            for (int i = 1; i < workers; ++i) {
+                threads.push_back(QThread::create([&]() {
+                    Mlt::Profile workerProfile(profilePath.toUtf8().constData());
+                    workerProfile.set_explicit(1);
+                    Mlt::Producer workerProd(workerProfile, nullptr, playlist.toUtf8().constData());
+                    if (workerProd.is_valid()) {
+                        renderChunks(workerProfile, workerProd);
                     }
-                }
-                if (!cons->is_valid()) {
-                    fprintf(stderr, " = =  = INVALID CONSUMER\n\n");
-                    return 1;
-                }
-                cons->set("terminate_on_pause", 1);
-                cons->connect(*playlst);
-                playlst.reset();
-                cons->run();
-                cons->stop();
-                cons->purge();
-                fprintf(stderr, "DONE:%d \n", frame.toInt());
+                }));
+                threads.back()->start();
+            }
+            renderChunks(profile, prod);
+            for (QThread *t : threads) {
+                t->wait();
+                delete t;
+            }
+            if (failed) {
+                return 1;
             }
             // Mlt::Factory::close();
             fprintf(stderr, "+ + + RENDERING FINSHED + + + \n");
@@ -163,6 +163,12 @@ void AbstractTreeModel::notifyRowAboutToAppend(const std::shared_ptr<TreeItem> &
     beginInsertRows(index, item->childCount(), item->childCount());
 }
 
+void AbstractTreeModel::notifyRowsAboutToAppend(const std::shared_ptr<TreeItem> &item, int count)
+{
+    auto index = getIndexFromItem(item);
+    beginInsertRows(index, item->childCount(), item->childCount() + count - 1);
+}
+
 void AbstractTreeModel::notifyRowAppended(const std::shared_ptr<TreeItem> &row)
 {
     Q_UNUSED(row);
@@ -294,6 +300,18 @@ Fun AbstractTreeModel::addItem_lambda(const std::shared_ptr<TreeItem> &new_item,
     };
 }
 
+Fun AbstractTreeModel::addItems_lambda(const std::vector<std::shared_ptr<TreeItem>> &new_items, int parentId)
+{
+    return [this, new_items, parentId]() {
+        std::shared_ptr<TreeItem> parent = getItemById(parentId);
+        if (!parent) {
+            Q_ASSERT(parent);
+            return false;
+        }
+        return parent->appendChildren(new_items);
+    };
+}
+
 Fun AbstractTreeModel::removeItem_lambda(int id)
 {
     return [this, id]() {
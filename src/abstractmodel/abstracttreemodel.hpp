@@ -26,6 +26,7 @@
 #include <QAbstractItemModel>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 /* @brief This class represents a generic tree hierarchy
  */
@@ -72,6 +73,9 @@ public:
     /* @brief Helper function to generate a lambda that adds an item to the tree */
     Fun addItem_lambda(const std::shared_ptr<TreeItem> &new_item, int parentId);
 
+    /* @brief Helper function to generate a lambda that adds new items to the same parent, as a single row insertion */
+    Fun addItems_lambda(const std::vector<std::shared_ptr<TreeItem>> &new_items, int parentId);
+
     /* @brief Helper function to generate a lambda that removes an item from the tree */
     Fun removeItem_lambda(int id);
 
@@ -95,6 +99,8 @@ protected:
        @param item is the parent item to which row is appended
     */
     void notifyRowAboutToAppend(const std::shared_ptr<TreeItem> &item);
+    /* @brief Same as notifyRowAboutToAppend, for count rows appended at once */
+    void notifyRowsAboutToAppend(const std::shared_ptr<TreeItem> &item, int count);
 
     /* @brief Send the appropriate notification related to a row that we have appended
        @param row is the new element
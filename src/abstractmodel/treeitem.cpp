@@ -22,12 +22,15 @@
 #include "treeitem.hpp"
 #include "abstracttreemodel.hpp"
 #include <QDebug>
+#include <algorithm>
 #include <numeric>
 #include <utility>
 
 TreeItem::TreeItem(QList<QVariant> data, const std::shared_ptr<AbstractTreeModel> &model, bool isRoot, int id)
     : m_itemData(std::move(data))
     , m_model(model)
+    , m_validRows(0)
+    , m_row(-1)
     , m_depth(0)
     , m_id(id == -1 ? AbstractTreeModel::getNextId() : id)
     , m_isInModel(false)
@@ -89,6 +92,11 @@ bool TreeItem::appendChild(const std::shared_ptr<TreeItem> &child)
         int id = child->getId();
         auto it = m_childItems.insert(m_childItems.end(), child);
         m_iteratorTable[id] = it;
+        m_childRows.push_back(child);
+        if (m_validRows == (int)m_childRows.size() - 1) {
+            // Appending keeps the cached rows valid
+            child->m_row = m_validRows++;
+        }
         registerSelf(child);
         ptr->notifyRowAppended(child);
         return true;
@@ -98,6 +106,38 @@ bool TreeItem::appendChild(const std::shared_ptr<TreeItem> &child)
     return false;
 }
 
+bool TreeItem::appendChildren(const std::vector<std::shared_ptr<TreeItem>> &children)
+{
+    if (children.empty()) {
+        return true;
+    }
+    for (const auto &child : children) {
+        if (hasAncestor(child->getId()) || child->parentItem().lock()) {
+            qDebug() << "ERROR: trying to append a batch containing an item that already has a parent";
+            return false;
+        }
+    }
+    if (auto ptr = m_model.lock()) {
+        ptr->notifyRowsAboutToAppend(shared_from_this(), (int)children.size());
+        for (const auto &child : children) {
+            child->updateParent(shared_from_this());
+            int id = child->getId();
+            auto it = m_childItems.insert(m_childItems.end(), child);
+            m_iteratorTable[id] = it;
+            m_childRows.push_back(child);
+            if (m_validRows == (int)m_childRows.size() - 1) {
+                child->m_row = m_validRows++;
+            }
+            registerSelf(child);
+        }
+        ptr->notifyRowAppended(children.back());
+        return true;
+    }
+    qDebug() << "ERROR: Something went wrong when appending children in TreeItem. Model is not available anymore";
+    Q_ASSERT(false);
+    return false;
+}
+
 void TreeItem::moveChild(int ix, const std::shared_ptr<TreeItem> &child)
 {
     if (auto ptr = m_model.lock()) {
@@ -106,6 +146,11 @@ void TreeItem::moveChild(int ix, const std::shared_ptr<TreeItem> &child)
             parentPtr->removeChild(child);
         } else {
             // deletion of child
+            int row = child->row();
+            if (row >= 0) {
+                m_childRows.erase(m_childRows.begin() + row);
+                m_validRows = std::min(m_validRows.load(), row);
+            }
             auto it = m_iteratorTable[child->getId()];
             m_childItems.erase(it);
         }
@@ -116,6 +161,8 @@ void TreeItem::moveChild(int ix, const std::shared_ptr<TreeItem> &child)
         std::advance(pos, ix);
         auto it = m_childItems.insert(pos, child);
         m_iteratorTable[id] = it;
+        m_childRows.insert(m_childRows.begin() + ix, child);
+        m_validRows = std::min(m_validRows.load(), ix);
         ptr->notifyRowAppended(child);
         m_isInModel = true;
     } else {
@@ -127,12 +174,15 @@ void TreeItem::moveChild(int ix, const std::shared_ptr<TreeItem> &child)
 void TreeItem::removeChild(const std::shared_ptr<TreeItem> &child)
 {
     if (auto ptr = m_model.lock()) {
-        ptr->notifyRowAboutToDelete(shared_from_this(), child->row());
+        int row = child->row();
+        ptr->notifyRowAboutToDelete(shared_from_this(), row);
         // get iterator corresponding to child
         Q_ASSERT(m_iteratorTable.count(child->getId()) > 0);
         auto it = m_iteratorTable[child->getId()];
         // deletion of child
         m_childItems.erase(it);
+        m_childRows.erase(m_childRows.begin() + row);
+        m_validRows = std::min(m_validRows.load(), row);
         // clean iterator table
         m_iteratorTable.erase(child->getId());
         child->m_depth = 0;
@@ -169,10 +219,8 @@ bool TreeItem::changeParent(std::shared_ptr<TreeItem> newParent)
 
 std::shared_ptr<TreeItem> TreeItem::child(int row) const
 {
-    Q_ASSERT(row >= 0 && row < (int)m_childItems.size());
-    auto it = m_childItems.cbegin();
-    std::advance(it, row);
-    return (*it);
+    Q_ASSERT(row >= 0 && row < (int)m_childRows.size());
+    return m_childRows[(size_t)row];
 }
 
 int TreeItem::childCount() const
@@ -203,9 +251,18 @@ std::weak_ptr<TreeItem> TreeItem::parentItem() const
 int TreeItem::row() const
 {
     if (auto ptr = m_parentItem.lock()) {
-        // we compute the distance in the parent's children list
-        auto it = ptr->m_childItems.begin();
-        return (int)std::distance(it, (decltype(it))ptr->m_iteratorTable.at(m_id));
+        // The parent keeps the rows of its first m_validRows children up to date. Insertions and removals
+        // only invalidate the rows after them, which are recomputed here in one pass
+        int row = m_row;
+        if (row < 0 || row >= ptr->m_validRows || ptr->m_childRows[(size_t)row].get() != this) {
+            for (int i = ptr->m_validRows; i < (int)ptr->m_childRows.size(); ++i) {
+                ptr->m_childRows[(size_t)i]->m_row = i;
+            }
+            ptr->m_validRows = (int)ptr->m_childRows.size();
+            row = m_row;
+        }
+        Q_ASSERT(ptr->m_childRows[(size_t)row].get() == this);
+        return row;
     }
     return -1;
 }
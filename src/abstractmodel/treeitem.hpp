@@ -25,8 +25,10 @@
 #include "definitions.h"
 #include <QList>
 #include <QVariant>
+#include <atomic>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 /* @brief This class is a generic class to represent items of a tree-like model
    It works in tandem with AbstractTreeModel or one of its derived classes.
@@ -75,6 +77,11 @@ public:
        @return true on success. Otherwise, nothing is modified.
     */
     bool appendChild(const std::shared_ptr<TreeItem> &child);
+    /* @brief Appends several newly created children with a single row insertion notification
+       The children must not have a parent yet.
+       @return true on success. Otherwise, nothing is modified.
+    */
+    bool appendChildren(const std::vector<std::shared_ptr<TreeItem>> &children);
     void moveChild(int ix, const std::shared_ptr<TreeItem> &child);
 
     /* @brief Remove given child from children list. The parent of the child is updated
@@ -163,6 +170,11 @@ protected:
     std::weak_ptr<TreeItem> m_parentItem;
 
     std::weak_ptr<AbstractTreeModel> m_model;
+    std::vector<std::shared_ptr<TreeItem>> m_childRows; // children by row, mirrors m_childItems for O(1) access by row
+    // The row cache is refreshed by the const row(), which can run concurrently from several readers.
+    // They all store the same values, atomics make this safe
+    mutable std::atomic<int> m_validRows; // children in rows below this index have an up to date m_row
+    mutable std::atomic<int> m_row;       // cached row of this item in its parent, see row()
     int m_depth;
     int m_id;
 
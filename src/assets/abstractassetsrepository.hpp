@@ -23,6 +23,7 @@
 #define ASSETSREPOSITORY_H
 
 #include "definitions.h"
+#include <QFileInfoList>
 #include <QSet>
 #include <memory>
 #include <mlt++/Mlt.h>
@@ -76,7 +77,25 @@ protected:
     // Reads the asset list from file and populates appropriate structure
     void parseAssetList(const QString &filePath, QSet<QString> &destination);
 
+    /* @brief Fills the asset list, from the catalog cache if it is still valid, otherwise by querying MLT and parsing the custom XML files */
     void init();
+
+    /* @brief Returns the key identifying the content of the catalog: format, MLT version, languages, blacklist, MLT services, MLT modules and
+       plugins, and custom files
+       @param services the list of MLT's available assets
+       @param customFiles the custom XML files, in parsing order
+     */
+    QByteArray catalogKey(Mlt::Properties &services, const QStringList &dirs, const QFileInfoList &customFiles) const;
+    /* @brief Returns the directories of MLT's modules and of the frei0r and LADSPA plugins */
+    static QStringList pluginDirs();
+    /* @brief Fills m_assets from the catalog cache
+       @return false if there is no cache or if it does not match the given key
+     */
+    bool loadCatalog(const QByteArray &key);
+    /* @brief Writes m_assets to the catalog cache */
+    void saveCatalog(const QByteArray &key) const;
+    /* @brief Returns the path of the catalog cache file */
+    QString catalogPath() const;
     virtual Mlt::Properties *retrieveListFromMlt() const = 0;
 
     /* @brief Parse some info from a mlt structure
@@ -100,7 +119,12 @@ protected:
     /* @brief Retrieves additional info about asset from a custom XML file
        The resulting assets are stored in customAssets
      */
-    virtual void parseCustomAssetFile(const QString &file_name, std::unordered_map<QString, Info> &customAssets) const = 0;
+    void parseCustomAssetFile(const QString &file_name, std::unordered_map<QString, Info> &customAssets) const;
+
+    /* @brief Retrieves additional info about asset from the parsed content of a custom XML file
+       The resulting assets are stored in customAssets
+     */
+    virtual void parseCustomAssetDocument(const QString &file_name, QDomDocument &doc, std::unordered_map<QString, Info> &customAssets) const = 0;
 
     /* @brief Returns the path to custom XML description of the assets*/
     virtual QStringList assetDirs() const = 0;
@@ -111,11 +135,21 @@ protected:
     /* @brief Returns the path to the assets' preferred list*/
     virtual QString assetPreferredListPath() const = 0;
 
+    /* @brief Returns the name of the catalog cache file of this repository*/
+    virtual QString assetCacheName() const = 0;
+
     std::unordered_map<QString, Info> m_assets;
 
     QSet<QString> m_blacklist;
 
     QSet<QString> m_preferred_list;
+
+    /* @brief Identifies a catalog cache file, and the version of its format */
+    static constexpr quint32 catalogMagic = 0x4b444143;
+    static constexpr qint32 catalogVersion = 1;
+
+    /* @brief True if the asset list was loaded from the catalog cache */
+    bool m_fromCache{false};
 };
 
 #include "abstractassetsrepository.ipp"
@@ -21,13 +21,22 @@
 
 #include "xml/xml.hpp"
 #include "kdenlivesettings.h"
+#include <config-kdenlive.h>
 
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QSaveFile>
 #include <QStandardPaths>
 #include <QString>
 #include <QTextStream>
+#include <QtConcurrent>
 #include <KLocalizedString>
+#include <framework/mlt_factory.h>
+#include <framework/mlt_version.h>
 
 #include <locale>
 #ifdef Q_OS_MAC
@@ -38,6 +47,8 @@ template <typename AssetType> AbstractAssetsRepository<AssetType>::AbstractAsset
 
 template <typename AssetType> void AbstractAssetsRepository<AssetType>::init()
 {
+    QElapsedTimer timer;
+    timer.start();
     // Parse blacklist
     parseAssetList(assetBlackListPath(), m_blacklist);
 
@@ -46,6 +57,25 @@ template <typename AssetType> void AbstractAssetsRepository<AssetType>::init()
 
     // Retrieve the list of MLT's available assets.
     QScopedPointer<Mlt::Properties> assets(retrieveListFromMlt());
+
+    // Set the directories to look into for effects.
+    QStringList asset_dirs = assetDirs();
+    QFileInfoList customFiles;
+    // reverse order to prioritize local install
+    QListIterator<QString> dirs_it(asset_dirs);
+    for (dirs_it.toBack(); dirs_it.hasPrevious();) { auto dir=dirs_it.previous();
+        QDir current_dir(dir);
+        QStringList filter {QStringLiteral("*.xml")};
+        customFiles << current_dir.entryInfoList(filter, QDir::Files);
+    }
+
+    const QByteArray key = catalogKey(*assets, asset_dirs, customFiles);
+    if (loadCatalog(key)) {
+        m_fromCache = true;
+        qDebug() << "Loaded" << m_assets.size() << "assets from" << catalogPath() << "in" << timer.elapsed() << "ms";
+        return;
+    }
+
     int max = assets->count();
     QString sox = QStringLiteral("sox.");
     for (int i = 0; i < max; ++i) {
@@ -70,25 +100,24 @@ template <typename AssetType> void AbstractAssetsRepository<AssetType>::init()
 
     // We now parse custom effect xml
 
-    // Set the directories to look into for effects.
-    QStringList asset_dirs = assetDirs();
-
     /* Parsing of custom xml works as follows: we parse all custom files.
        Each of them contains a tag, which is the corresponding mlt asset, and an id that is the name of the asset. Note that several custom files can correspond
        to the same tag, and in that case they must have different ids. We do the parsing in a map from ids to parse info, and then we add them to the asset
        list, while discarding the bare version of each tag (the one with no file associated)
     */
+    std::vector<std::pair<QString, QDomDocument>> customDocuments;
+    customDocuments.reserve(size_t(customFiles.size()));
+    for (const QFileInfo &file : qAsConst(customFiles)) {
+        customDocuments.emplace_back(file.absoluteFilePath(), QDomDocument());
+    }
+    // Reading the files is independent, but a file can refer to the assets of the previous ones (effect groups), so they are interpreted in order
+    QtConcurrent::blockingMap(customDocuments, [](std::pair<QString, QDomDocument> &custom) {
+        QFile file(custom.first);
+        custom.second.setContent(&file, false);
+    });
     std::unordered_map<QString, Info> customAssets;
-    // reverse order to prioritize local install
-    QListIterator<QString> dirs_it(asset_dirs);
-    for (dirs_it.toBack(); dirs_it.hasPrevious();) { auto dir=dirs_it.previous();
-        QDir current_dir(dir);
-        QStringList filter {QStringLiteral("*.xml")};
-        QStringList fileList = current_dir.entryList(filter, QDir::Files);
-        for (const auto &file : qAsConst(fileList)) {
-            QString path = current_dir.absoluteFilePath(file);
-            parseCustomAssetFile(path, customAssets);
-        }
+    for (auto &custom : customDocuments) {
+        parseCustomAssetDocument(custom.first, custom.second, customAssets);
     }
 
     // We add the custom assets
@@ -104,6 +133,194 @@ template <typename AssetType> void AbstractAssetsRepository<AssetType>::init()
             qDebug() << "Error: conflicting asset name " << custom.first;
         }*/
     }
+    saveCatalog(key);
+    qDebug() << "Parsed" << m_assets.size() << "assets in" << timer.elapsed() << "ms";
+}
+
+template <typename AssetType> QString AbstractAssetsRepository<AssetType>::catalogPath() const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/assets/") + assetCacheName() + QStringLiteral(".cache");
+}
+
+template <typename AssetType>
+QByteArray AbstractAssetsRepository<AssetType>::catalogKey(Mlt::Properties &services, const QStringList &dirs, const QFileInfoList &customFiles) const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    auto add = [&hash](const QString &value) {
+        hash.addData(value.toUtf8());
+        hash.addData("\n", 1);
+    };
+    add(QString::number(catalogVersion));
+    add(QStringLiteral(KDENLIVE_VERSION));
+    add(QString::fromLatin1(mlt_version_get_string()));
+    // Names and descriptions are translated when parsed
+    add(KLocalizedString::languages().join(QLatin1Char(',')));
+    QStringList blacklist = m_blacklist.values();
+    blacklist.sort();
+    add(blacklist.join(QLatin1Char(',')));
+    for (int i = 0; i < services.count(); ++i) {
+        add(QString::fromUtf8(services.get_name(i)));
+    }
+    for (const QString &dir : dirs) {
+        add(dir + QLatin1Char(':') + QString::number(QFileInfo(dir).lastModified().toMSecsSinceEpoch()));
+    }
+    // Parameters of plugin based services are described by the plugins, which can be upgraded without MLT
+    for (const QString &dir : pluginDirs()) {
+        const QFileInfoList plugins = QDir(dir).entryInfoList(QDir::Files, QDir::Name);
+        add(dir + QLatin1Char(':') + QString::number(plugins.count()));
+        for (const QFileInfo &plugin : plugins) {
+            add(plugin.fileName() + QLatin1Char(':') + QString::number(plugin.lastModified().toMSecsSinceEpoch()) + QLatin1Char(':') +
+                QString::number(plugin.size()));
+        }
+    }
+    // The directory time does not change when a file is edited in place
+    for (const QFileInfo &file : customFiles) {
+        add(file.absoluteFilePath() + QLatin1Char(':') + QString::number(file.lastModified().toMSecsSinceEpoch()) + QLatin1Char(':') +
+            QString::number(file.size()));
+    }
+    return hash.result();
+}
+
+template <typename AssetType> QStringList AbstractAssetsRepository<AssetType>::pluginDirs()
+{
+    QStringList result;
+    const QString modules = QString::fromUtf8(mlt_factory_directory());
+    QStringList libDirs{QStringLiteral("/usr/lib"), QStringLiteral("/usr/lib64"), QStringLiteral("/usr/local/lib"), QStringLiteral("/opt/local/lib")};
+    if (!modules.isEmpty()) {
+        result << modules;
+        // Plugins are usually installed in the same library folder as MLT, ie. /usr/lib/x86_64-linux-gnu/mlt-7
+        QDir libDir(modules);
+        if (libDir.cdUp()) {
+            libDirs.prepend(libDir.absolutePath());
+        }
+    }
+    // Multiarch library folders (Debian and derivatives)
+    for (const QString &root : {QStringLiteral("/usr/lib"), QStringLiteral("/usr/local/lib")}) {
+        const QStringList triplets = QDir(root).entryList({QStringLiteral("*-linux-*")}, QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+        for (const QString &triplet : triplets) {
+            libDirs << root + QLatin1Char('/') + triplet;
+        }
+    }
+    libDirs.removeDuplicates();
+    // Same search paths as MLT's frei0r and LADSPA modules
+    const QString home = QDir::homePath();
+    const QString frei0r = qEnvironmentVariable("FREI0R_PATH");
+    if (!frei0r.isEmpty()) {
+        for (const QString &dir : frei0r.split(QDir::listSeparator())) {
+            if (!dir.isEmpty()) {
+                result << dir;
+            }
+        }
+    } else {
+        for (const QString &dir : qAsConst(libDirs)) {
+            result << dir + QStringLiteral("/frei0r-1");
+        }
+        result << home + QStringLiteral("/.frei0r-1/lib");
+    }
+    const QString ladspa = qEnvironmentVariable("LADSPA_PATH");
+    if (!ladspa.isEmpty()) {
+        for (const QString &dir : ladspa.split(QDir::listSeparator())) {
+            if (!dir.isEmpty()) {
+                result << dir;
+            }
+        }
+    } else {
+        for (const QString &dir : qAsConst(libDirs)) {
+            result << dir + QStringLiteral("/ladspa");
+        }
+        result << home + QStringLiteral("/.ladspa");
+    }
+    return result;
+}
+
+template <typename AssetType> bool AbstractAssetsRepository<AssetType>::loadCatalog(const QByteArray &key)
+{
+    QFile file(catalogPath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_11);
+    quint32 magic = 0;
+    qint32 version = 0;
+    QByteArray storedKey;
+    in >> magic >> version >> storedKey;
+    if (magic != catalogMagic || version != catalogVersion || storedKey != key) {
+        qDebug() << "Asset catalog" << file.fileName() << "is outdated";
+        return false;
+    }
+    std::vector<std::pair<QString, Info>> assets;
+    quint32 count = 0;
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString id;
+        Info info;
+        qint32 type = 0;
+        in >> id >> info.id >> info.mltId >> info.name >> info.description >> info.author >> info.version_str >> info.version >> type;
+        info.type = static_cast<AssetType>(type);
+        assets.emplace_back(id, info);
+    }
+    // The xml descriptions of all assets are stored as one document, in the same order
+    QByteArray xml;
+    in >> xml;
+    QDomDocument doc;
+    if (in.status() != QDataStream::Ok || !doc.setContent(xml, false)) {
+        qDebug() << "Asset catalog" << file.fileName() << "is corrupted";
+        return false;
+    }
+    QDomElement entry = doc.documentElement().firstChildElement();
+    for (auto &asset : assets) {
+        if (entry.isNull()) {
+            return false;
+        }
+        asset.second.xml = entry.firstChildElement();
+        entry = entry.nextSiblingElement();
+    }
+    for (auto &asset : assets) {
+        m_assets[asset.first] = std::move(asset.second);
+    }
+    return true;
+}
+
+template <typename AssetType> void AbstractAssetsRepository<AssetType>::saveCatalog(const QByteArray &key) const
+{
+    const QString path = catalogPath();
+    if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+        return;
+    }
+    QDomDocument doc;
+    QDomElement root = doc.createElement(QStringLiteral("catalog"));
+    doc.appendChild(root);
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Cannot write asset catalog" << path;
+        return;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_11);
+    out << catalogMagic << catalogVersion << key << quint32(m_assets.size());
+    for (const auto &asset : m_assets) {
+        const Info &info = asset.second;
+        out << asset.first << info.id << info.mltId << info.name << info.description << info.author << info.version_str << qint32(info.version)
+            << qint32(info.type);
+        QDomElement entry = doc.createElement(QStringLiteral("asset"));
+        if (!info.xml.isNull()) {
+            entry.appendChild(doc.importNode(info.xml, true));
+        }
+        root.appendChild(entry);
+    }
+    out << doc.toByteArray(-1);
+    file.commit();
+}
+
+template <typename AssetType>
+void AbstractAssetsRepository<AssetType>::parseCustomAssetFile(const QString &file_name, std::unordered_map<QString, Info> &customAssets) const
+{
+    QFile file(file_name);
+    QDomDocument doc;
+    doc.setContent(&file, false);
+    file.close();
+    parseCustomAssetDocument(file_name, doc, customAssets);
 }
 
 template <typename AssetType> void AbstractAssetsRepository<AssetType>::parseAssetList(const QString &filePath, QSet<QString> &destination)
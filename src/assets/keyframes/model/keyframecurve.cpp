@@ -0,0 +1,162 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "keyframecurve.hpp"
+
+#include <algorithm>
+
+void KeyframeCurve::append(int frame, Interpolation type, const double *values, int count)
+{
+    m_frames.push_back(frame);
+    m_types.push_back(type);
+    m_values.insert(m_values.end(), values, values + count);
+    m_offsets.push_back(static_cast<int>(m_values.size()));
+}
+
+void KeyframeCurve::compile()
+{
+    m_segments.clear();
+    m_coefficients.clear();
+    const int count = keyframeCount();
+    for (int ix = 0; ix + 1 < count; ++ix) {
+        m_segments.push_back(static_cast<int>(m_coefficients.size()));
+        const int width = segmentWidth(ix);
+        for (int c = 0; c < width; ++c) {
+            const double y1 = m_values[m_offsets[ix] + c];
+            const double y2 = m_values[m_offsets[ix + 1] + c];
+            double a0 = 0., a1 = 0., a2 = 0., a3 = y1;
+            if (m_types[ix] == Interpolation::Linear) {
+                a2 = y2 - y1;
+            } else if (m_types[ix] == Interpolation::Smooth) {
+                // Catmull-Rom spline, the curve ends are extended by repeating the end points like MLT does
+                const double y0 = (ix > 0 && m_offsets[ix] - m_offsets[ix - 1] > c) ? m_values[m_offsets[ix - 1] + c] : y1;
+                const double y3 = (ix + 2 < count && m_offsets[ix + 3] - m_offsets[ix + 2] > c) ? m_values[m_offsets[ix + 2] + c] : y2;
+                a0 = -0.5 * y0 + 1.5 * y1 - 1.5 * y2 + 0.5 * y3;
+                a1 = y0 - 2.5 * y1 + 2 * y2 - 0.5 * y3;
+                a2 = -0.5 * y0 + 0.5 * y2;
+            }
+            m_coefficients.insert(m_coefficients.end(), {a0, a1, a2, a3});
+        }
+    }
+    m_hint = 0;
+}
+
+bool KeyframeCurve::isEmpty() const
+{
+    return m_frames.empty();
+}
+
+int KeyframeCurve::keyframeCount() const
+{
+    return static_cast<int>(m_frames.size());
+}
+
+int KeyframeCurve::segmentWidth(int ix) const
+{
+    return std::min(m_offsets[ix + 1] - m_offsets[ix], m_offsets[ix + 2] - m_offsets[ix + 1]);
+}
+
+int KeyframeCurve::keyframeAt(int frame) const
+{
+    const int count = keyframeCount();
+    int hint = m_hint.load(std::memory_order_relaxed);
+    if (hint < count && m_frames[hint] <= frame) {
+        if (hint + 1 == count || frame < m_frames[hint + 1]) {
+            return hint;
+        }
+        if (hint + 2 == count || frame < m_frames[hint + 2]) {
+            m_hint.store(hint + 1, std::memory_order_relaxed);
+            return hint + 1;
+        }
+    }
+    int ix = static_cast<int>(std::upper_bound(m_frames.begin(), m_frames.end(), frame) - m_frames.begin()) - 1;
+    if (ix >= 0) {
+        m_hint.store(ix, std::memory_order_relaxed);
+    }
+    return ix;
+}
+
+double KeyframeCurve::evaluateSegment(int ix, int frame, int component) const
+{
+    const double *a = &m_coefficients[m_segments[ix] + 4 * component];
+    // Same evaluation order as MLT, so that we get the exact same values
+    const double t = double(frame - m_frames[ix]) / double(m_frames[ix + 1] - m_frames[ix]);
+    const double t2 = t * t;
+    return a[0] * t * t2 + a[1] * t2 + a[2] * t + a[3];
+}
+
+int KeyframeCurve::evaluate(int frame, std::vector<double> &out) const
+{
+    out.clear();
+    if (isEmpty()) {
+        return 0;
+    }
+    int ix = keyframeAt(frame);
+    if (ix < 0 || ix + 1 == keyframeCount() || frame == m_frames[ix]) {
+        ix = std::max(ix, 0);
+        out.assign(m_values.begin() + m_offsets[ix], m_values.begin() + m_offsets[ix + 1]);
+        return static_cast<int>(out.size());
+    }
+    const int width = segmentWidth(ix);
+    out.reserve(width);
+    for (int c = 0; c < width; ++c) {
+        out.push_back(evaluateSegment(ix, frame, c));
+    }
+    return width;
+}
+
+double KeyframeCurve::evaluate(int frame, int component) const
+{
+    if (isEmpty()) {
+        return 0.;
+    }
+    int ix = keyframeAt(frame);
+    if (ix < 0 || ix + 1 == keyframeCount() || frame == m_frames[ix]) {
+        ix = std::max(ix, 0);
+        return component < m_offsets[ix + 1] - m_offsets[ix] ? m_values[m_offsets[ix] + component] : 0.;
+    }
+    return component < segmentWidth(ix) ? evaluateSegment(ix, frame, component) : 0.;
+}
+
+void KeyframeCurve::sample(int start, int count, int component, double *out) const
+{
+    if (count <= 0) {
+        return;
+    }
+    if (isEmpty()) {
+        std::fill(out, out + count, 0.);
+        return;
+    }
+    const int last = keyframeCount() - 1;
+    int ix = keyframeAt(start);
+    for (int i = 0; i < count; ++i) {
+        const int frame = start + i;
+        while (ix < last && frame >= m_frames[ix + 1]) {
+            ++ix;
+        }
+        if (ix < 0 || ix == last || frame == m_frames[ix]) {
+            const int k = std::max(ix, 0);
+            out[i] = component < m_offsets[k + 1] - m_offsets[k] ? m_values[m_offsets[k] + component] : 0.;
+        } else {
+            out[i] = component < segmentWidth(ix) ? evaluateSegment(ix, frame, component) : 0.;
+        }
+    }
+}
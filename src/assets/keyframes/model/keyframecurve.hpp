@@ -0,0 +1,84 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifndef KEYFRAMECURVE_H
+#define KEYFRAMECURVE_H
+
+#include <atomic>
+#include <vector>
+
+/* @brief This class is a compiled, read-only form of a list of keyframes, used to evaluate an animated parameter quickly.
+   Each keyframe holds a fixed number of numerical components (1 for a double, 5 for a rect, ...).
+   The interpolation towards the next keyframe is precomputed as a cubic polynomial per component, following MLT's rules:
+   a discrete keyframe holds its value, a linear one interpolates linearly and a smooth one uses a Catmull-Rom spline
+   through the surrounding keyframes. Before the first keyframe the curve takes the first value, after the last one the last value.
+   Lookups are a binary search, with a fast path for sequential queries.
+ */
+class KeyframeCurve
+{
+public:
+    enum class Interpolation { Discrete, Linear, Smooth };
+
+    KeyframeCurve() = default;
+    KeyframeCurve(const KeyframeCurve &) = delete;
+    KeyframeCurve &operator=(const KeyframeCurve &) = delete;
+
+    /* @brief Adds a keyframe. Keyframes must be appended in increasing frame order, before calling compile()
+       @param values points to count components
+     */
+    void append(int frame, Interpolation type, const double *values, int count);
+    /* @brief Precomputes the interpolation segments. Must be called once all keyframes are appended */
+    void compile();
+
+    bool isEmpty() const;
+    int keyframeCount() const;
+
+    /* @brief Evaluates all components at the given frame.
+       Between two keyframes with a different number of components, only the common ones are interpolated.
+       @return the number of components written in out
+     */
+    int evaluate(int frame, std::vector<double> &out) const;
+    /* @brief Evaluates a single component at the given frame, returns 0 if it does not exist */
+    double evaluate(int frame, int component) const;
+    /* @brief Evaluates a single component on the frames [start, start + count[, writing count values in out.
+       This walks the segments once, which is much cheaper than count separate queries */
+    void sample(int start, int count, int component, double *out) const;
+
+private:
+    /* @brief Returns the index of the last keyframe at or before frame, or -1 if frame is before the first keyframe */
+    int keyframeAt(int frame) const;
+    /* @brief Number of components interpolated on the segment starting at keyframe ix */
+    int segmentWidth(int ix) const;
+    double evaluateSegment(int ix, int frame, int component) const;
+
+    std::vector<int> m_frames;
+    std::vector<Interpolation> m_types;
+    /* @brief Start of each keyframe's components in m_values, with a final entry holding the total size */
+    std::vector<int> m_offsets{0};
+    std::vector<double> m_values;
+    /* @brief Start of each segment's coefficients in m_coefficients, 4 per component */
+    std::vector<int> m_segments;
+    std::vector<double> m_coefficients;
+    /* @brief Last keyframe index found, used to answer sequential queries without searching */
+    mutable std::atomic<int> m_hint{0};
+};
+
+#endif
@@ -379,6 +379,7 @@ Fun KeyframeModel::updateKeyframe_lambda(GenTime pos, KeyframeType type, const Q
         int row = static_cast<int>(std::distance(m_keyframeList.begin(), m_keyframeList.find(pos)));
         m_keyframeList[pos].first = type;
         m_keyframeList[pos].second = value;
+        invalidateCurve();
         if (notify) emit dataChanged(index(row), index(row), {ValueRole, NormalizedValueRole, TypeRole});
         return true;
     };
@@ -399,6 +400,7 @@ Fun KeyframeModel::addKeyframe_lambda(GenTime pos, KeyframeType type, const QVar
         if (notify) beginInsertRows(QModelIndex(), insertionRow, insertionRow);
         m_keyframeList[pos].first = type;
         m_keyframeList[pos].second = value;
+        invalidateCurve();
         if (notify) endInsertRows();
         return true;
     };
@@ -415,6 +417,7 @@ Fun KeyframeModel::deleteKeyframe_lambda(GenTime pos, bool notify)
         int row = static_cast<int>(std::distance(m_keyframeList.begin(), m_keyframeList.find(pos)));
         if (notify) beginRemoveRows(QModelIndex(), row, row);
         m_keyframeList.erase(pos);
+        invalidateCurve();
         if (notify) endRemoveRows();
         qDebug() << "after" << getAnimProperty();
         return true;
@@ -931,6 +934,45 @@ QVariant KeyframeModel::getInterpolatedValue(const GenTime &pos) const
     if (m_keyframeList.size() == 0) {
         return QVariant();
     }
+    if (std::shared_ptr<const KeyframeCurve> curve = compiledCurve()) {
+        int frame = pos.frames(pCore->getCurrentFps());
+        if (m_paramType == ParamType::KeyframeParam) {
+            return QVariant(curve->evaluate(frame, 0));
+        }
+        std::vector<double> values;
+        int count = curve->evaluate(frame, values);
+        if (m_paramType == ParamType::AnimatedRect) {
+            bool useOpacity = false;
+            if (auto ptr = m_model.lock()) {
+                useOpacity = ptr->data(m_index, AssetParameterModel::OpacityRole).toBool();
+            }
+            if (count >= (useOpacity ? 5 : 4)) {
+                QString res = QStringLiteral("%1 %2 %3 %4").arg((int)values[0]).arg((int)values[1]).arg((int)values[2]).arg((int)values[3]);
+                if (useOpacity) {
+                    res.append(QStringLiteral(" %1").arg(QString::number(values[4], 'f')));
+                }
+                return QVariant(res);
+            }
+        } else if (m_paramType == ParamType::Roto_spline) {
+            // Outside of the keyframes, return the stored shape unchanged
+            auto next = m_keyframeList.upper_bound(pos);
+            if (next == m_keyframeList.cbegin()) {
+                return next->second.second;
+            } else if (next == m_keyframeList.cend()) {
+                return m_keyframeList.crbegin()->second.second;
+            }
+            // Each point is stored as 3 normalized (x, y) pairs: the point and its 2 handles
+            QList<QVariant> vlist;
+            for (int i = 0; i + 6 <= count; i += 6) {
+                QList<QVariant> pl;
+                for (int j = 0; j < 6; j += 2) {
+                    pl << QVariant(QList<QVariant>() << QVariant(values[i + j]) << QVariant(values[i + j + 1]));
+                }
+                vlist << QVariant(pl);
+            }
+            return vlist;
+        }
+    }
     Mlt::Properties mlt_prop;
     QString animData;
     int out = 0;
@@ -1006,6 +1048,119 @@ QVariant KeyframeModel::getInterpolatedValue(const GenTime &pos) const
     return QVariant();
 }
 
+QVector<double> KeyframeModel::getInterpolatedValues(int start, int count, int component) const
+{
+    QVector<double> values(qMax(0, count));
+    if (values.isEmpty()) {
+        return values;
+    }
+    if (std::shared_ptr<const KeyframeCurve> curve = compiledCurve()) {
+        curve->sample(start, count, component, values.data());
+        return values;
+    }
+    for (int i = 0; i < count; ++i) {
+        QVariant value = getInterpolatedValue(start + i);
+        if (m_paramType == ParamType::AnimatedRect) {
+            values[i] = value.toString().split(QLatin1Char(' ')).value(component).toDouble();
+        } else if (component == 0) {
+            values[i] = value.toDouble();
+        }
+    }
+    return values;
+}
+
+std::shared_ptr<const KeyframeCurve> KeyframeModel::compiledCurve() const
+{
+    QMutexLocker lk(&m_curveMutex);
+    double fps = pCore->getCurrentFps();
+    if (m_curveBuilt && qFuzzyCompare(m_curveFps, fps)) {
+        return m_curve;
+    }
+    m_curveBuilt = true;
+    m_curveFps = fps;
+    m_curve.reset();
+    if (m_paramType != ParamType::KeyframeParam && m_paramType != ParamType::AnimatedRect && m_paramType != ParamType::Roto_spline) {
+        return nullptr;
+    }
+    auto curve = std::make_shared<KeyframeCurve>();
+    std::vector<double> values;
+    for (const auto &keyframe : m_keyframeList) {
+        if (!curveValues(keyframe.second.second, values)) {
+            return nullptr;
+        }
+        KeyframeCurve::Interpolation type = KeyframeCurve::Interpolation::Linear;
+        // Rotoscoping shapes are always interpolated linearly
+        if (m_paramType != ParamType::Roto_spline) {
+            switch (keyframe.second.first) {
+            case KeyframeType::Discrete:
+                type = KeyframeCurve::Interpolation::Discrete;
+                break;
+            case KeyframeType::Curve:
+                type = KeyframeCurve::Interpolation::Smooth;
+                break;
+            default:
+                break;
+            }
+        }
+        curve->append(keyframe.first.frames(fps), type, values.data(), (int)values.size());
+    }
+    curve->compile();
+    m_curve = curve;
+    return m_curve;
+}
+
+bool KeyframeModel::curveValues(const QVariant &value, std::vector<double> &values) const
+{
+    values.clear();
+    bool ok = true;
+    switch (m_paramType) {
+    case ParamType::KeyframeParam:
+        values.push_back(value.toDouble(&ok));
+        return ok;
+    case ParamType::AnimatedRect: {
+        const QStringList fields = value.toString().simplified().split(QLatin1Char(' '));
+        for (const QString &field : fields) {
+            values.push_back(field.toDouble(&ok));
+            if (!ok) {
+                return false;
+            }
+        }
+        return values.size() >= 4;
+    }
+    case ParamType::Roto_spline: {
+        QList<QVariant> data = value.toList();
+        // skip tracking flag
+        if (data.count() && data.at(0).canConvert(QVariant::String)) {
+            data.removeFirst();
+        }
+        for (const QVariant &bpoint : qAsConst(data)) {
+            const QList<QVariant> handles = bpoint.toList();
+            if (handles.count() < 3) {
+                return false;
+            }
+            for (int i = 0; i < 3; ++i) {
+                const QList<QVariant> coords = handles.at(i).toList();
+                if (coords.count() < 2) {
+                    return false;
+                }
+                values.push_back(coords.at(0).toDouble());
+                values.push_back(coords.at(1).toDouble());
+            }
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+void KeyframeModel::invalidateCurve()
+{
+    QMutexLocker lk(&m_curveMutex);
+    m_curveBuilt = false;
+    m_curve.reset();
+}
+
 void KeyframeModel::sendModification()
 {
     if (auto ptr = m_model.lock()) {
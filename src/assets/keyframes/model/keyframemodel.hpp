@@ -25,9 +25,11 @@
 #include "assets/model/assetparametermodel.hpp"
 #include "definitions.h"
 #include "gentime.h"
+#include "keyframecurve.hpp"
 #include "undohelper.hpp"
 
 #include <QAbstractListModel>
+#include <QMutex>
 #include <QReadWriteLock>
 
 #include <map>
@@ -156,6 +158,9 @@ public:
     /* @brief Return the interpolated value at given pos */
     QVariant getInterpolatedValue(int pos) const;
     QVariant getInterpolatedValue(const GenTime &pos) const;
+    /* @brief Return the interpolated values of one component of the parameter (0 for a double, 0 to 4 for the x, y, w, h, opacity of a rect)
+       on the frames [start, start + count[, for example to draw its curve */
+    QVector<double> getInterpolatedValues(int start, int count, int component = 0) const;
     QVariant updateInterpolated(const QVariant &interpValue, double val);
     /* @brief Return the real value from a normalized one */
     QVariant getNormalizedValue(double newVal) const;
@@ -199,6 +204,14 @@ protected:
     void parseAnimProperty(const QString &prop);
     void parseRotoProperty(const QString &prop);
 
+    /* @brief Returns the compiled form of the keyframes, building it if needed.
+       Returns nullptr if the values cannot be compiled, in which case MLT is used to interpolate */
+    std::shared_ptr<const KeyframeCurve> compiledCurve() const;
+    /* @brief Extracts the numerical components of a keyframe value, returns false if the value has an unexpected format */
+    bool curveValues(const QVariant &value, std::vector<double> &values) const;
+    /* @brief Drops the compiled curve, must be called whenever the keyframe list changes */
+    void invalidateCurve();
+
 private:
     std::weak_ptr<AssetParameterModel> m_model;
     std::weak_ptr<DocUndoStack> m_undoStack;
@@ -209,6 +222,11 @@ private:
 
     std::map<GenTime, std::pair<KeyframeType, QVariant>> m_keyframeList;
 
+    mutable QMutex m_curveMutex;
+    mutable std::shared_ptr<const KeyframeCurve> m_curve;
+    mutable bool m_curveBuilt{false};
+    mutable double m_curveFps{0.};
+
 signals:
     void modelChanged();
 
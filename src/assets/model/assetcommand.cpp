@@ -47,11 +47,17 @@ AssetCommand::AssetCommand(const std::shared_ptr<AssetParameterModel> &model, co
 void AssetCommand::undo()
 {
     m_model->setParameter(m_name, m_oldValue, true, m_index);
+    // Undo is a final state, don't wait for the next frame to show it
+    m_model->flushParameterUpdates();
 }
 
 void AssetCommand::redo()
 {
     m_model->setParameter(m_name, m_value, m_updateView, m_index);
+    if (m_updateView) {
+        // Redo from the stack, while the first redo is part of an interactive change that keeps coalescing
+        m_model->flushParameterUpdates();
+    }
     m_updateView = true;
 }
 
@@ -101,6 +107,7 @@ void AssetMultiCommand::undo()
         m_model->setParameter(m_model->data(ix, AssetParameterModel::NameRole).toString(), m_oldValues.at(indx), indx == max, ix);
         indx++;
     }
+    m_model->flushParameterUpdates();
 }
 // virtual
 void AssetMultiCommand::redo()
@@ -111,6 +118,9 @@ void AssetMultiCommand::redo()
         m_model->setParameter(m_model->data(ix, AssetParameterModel::NameRole).toString(), m_values.at(indx), m_updateView && indx == max, ix);
         indx++;
     }
+    if (m_updateView) {
+        m_model->flushParameterUpdates();
+    }
     m_updateView = true;
 }
 
@@ -195,11 +205,13 @@ AssetUpdateCommand::AssetUpdateCommand(const std::shared_ptr<AssetParameterModel
 void AssetUpdateCommand::undo()
 {
     m_model->setParameters(m_oldValue);
+    m_model->flushParameterUpdates();
 }
 // virtual
 void AssetUpdateCommand::redo()
 {
     m_model->setParameters(m_value);
+    m_model->flushParameterUpdates();
 }
 
 // virtual
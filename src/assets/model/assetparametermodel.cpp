@@ -22,6 +22,7 @@
 #include "assetparametermodel.hpp"
 #include "assets/keyframes/model/keyframemodellist.hpp"
 #include "core.h"
+#include "kdenlive_debug.h"
 #include "kdenlivesettings.h"
 #include "klocalizedstring.h"
 #include "profiles/profilemodel.hpp"
@@ -41,6 +42,7 @@ AssetParameterModel::AssetParameterModel(std::unique_ptr<Mlt::Properties> asset,
     , m_ownerId(ownerId)
     , m_asset(std::move(asset))
     , m_keyframes(nullptr)
+    , m_updates([this](const ParameterUpdateCoalescer::Batch &batch) { sendUpdates(batch); })
 {
     Q_ASSERT(m_asset->is_valid());
     QDomNodeList parameterNodes = assetXml.elementsByTagName(QStringLiteral("parameter"));
@@ -280,16 +282,7 @@ void AssetParameterModel::setParameter(const QString &name, int value, bool upda
         emit replugEffect(shared_from_this());
     }
     if (update) {
-        emit modelChanged();
-        emit dataChanged(index(0, 0), index(m_rows.count() - 1, 0), {});
-        // Update fades in timeline
-        pCore->updateItemModel(m_ownerId, m_assetId);
-        if (!m_isAudio) {
-            // Trigger monitor refresh
-            pCore->refreshProjectItem(m_ownerId);
-            // Invalidate timeline preview
-            pCore->invalidateItem(m_ownerId);
-        }
+        scheduleUpdate(m_rows.indexOf(name), true, true);
     }
 }
 
@@ -367,35 +360,63 @@ void AssetParameterModel::setParameter(const QString &name, const QString &param
         // these effects don't understand param change and need to be rebuild
         emit replugEffect(shared_from_this());
         updateChildRequired = false;
-    } else if (update) {
-        qDebug() << "// SENDING DATA CHANGE....";
-        if (paramIndex.isValid()) {
-            emit dataChanged(paramIndex, paramIndex);
-        } else {
-            QModelIndex ix = index(m_rows.indexOf(name), 0);
-            emit dataChanged(ix, ix);
-        }
-        emit modelChanged();
     }
     if (updateChildRequired) {
         emit updateChildren(name);
     }
-    // Update timeline view if necessary
-    if (m_ownerId.first == ObjectType::NoItem) {
-        // Used for generator clips
-        if (!update) emit modelChanged();
-    } else {
+    // Used for generator clips
+    if (m_ownerId.first == ObjectType::NoItem && !update) {
+        emit modelChanged();
+    }
+    int row = paramIndex.isValid() ? paramIndex.row() : m_rows.indexOf(name);
+    scheduleUpdate(row, update && updateChildRequired, m_ownerId.first != ObjectType::NoItem);
+}
+
+void AssetParameterModel::scheduleUpdate(int row, bool updateView, bool refreshOwner)
+{
+    if (!updateView && !refreshOwner) {
+        return;
+    }
+    // Gather the changes until the next monitor frame
+    double fps = pCore->getCurrentFps();
+    m_updates.addUpdate(row, updateView, refreshOwner, fps > 0 ? int(1000. / fps) : 40);
+}
+
+void AssetParameterModel::sendUpdates(const ParameterUpdateCoalescer::Batch &batch)
+{
+    const ParameterUpdateCoalescer::Statistics stats = updateStatistics();
+    qCDebug(KDENLIVE_LOG) << "Sending" << batch.updates << "parameter updates of" << m_assetId << "at once," << stats.merged() << "of" << stats.updates
+                          << "updates merged so far";
+    if (batch.allRows) {
+        emit dataChanged(index(0, 0), index(m_rows.count() - 1, 0), {});
+    } else if (batch.firstRow >= 0) {
+        emit dataChanged(index(batch.firstRow, 0), index(batch.lastRow, 0));
+    }
+    if (batch.allRows || batch.firstRow >= 0) {
+        emit modelChanged();
+    }
+    if (batch.refreshOwner && m_ownerId.first != ObjectType::NoItem) {
         // Update fades in timeline
         pCore->updateItemModel(m_ownerId, m_assetId);
         if (!m_isAudio) {
             // Trigger monitor refresh
             pCore->refreshProjectItem(m_ownerId);
-            // Invalidate timeline preview
+            // Invalidate timeline preview, once for all the changes of the batch
             pCore->invalidateItem(m_ownerId);
         }
     }
 }
 
+void AssetParameterModel::flushParameterUpdates()
+{
+    m_updates.flush();
+}
+
+ParameterUpdateCoalescer::Statistics AssetParameterModel::updateStatistics() const
+{
+    return m_updates.statistics();
+}
+
 AssetParameterModel::~AssetParameterModel() = default;
 
 QVariant AssetParameterModel::data(const QModelIndex &index, int role) const
@@ -24,6 +24,7 @@
 
 #include "definitions.h"
 #include "klocalizedstring.h"
+#include "parameterupdatecoalescer.hpp"
 #include <QAbstractListModel>
 #include <QDomElement>
 #include <QJsonDocument>
@@ -188,6 +189,11 @@ public:
     /** @brief Returns the current value of an effect parameter */
     const QString getParam(const QString &paramName);
 
+    /** @brief Sends the view update and monitor refresh of the parameter changes gathered since the last frame now */
+    void flushParameterUpdates();
+    /** @brief Returns how many parameter updates were requested and how many were merged in a batch */
+    ParameterUpdateCoalescer::Statistics updateStatistics() const;
+
 protected:
     /* @brief Helper function to retrieve the type of a parameter given the string corresponding to it*/
     static ParamType paramTypeFromStr(const QString &type);
@@ -235,6 +241,15 @@ protected:
      */
     void internalSetParameter(const QString &name, const QString &paramValue, const QModelIndex &paramIndex = QModelIndex());
 
+    /* @brief Records a parameter change, the notifications are sent once per monitor frame by m_updates
+       @param row is the row to update in the view, -1 for all rows
+     */
+    void scheduleUpdate(int row, bool updateView, bool refreshOwner);
+    /* @brief Sends the notifications of a batch of parameter changes */
+    void sendUpdates(const ParameterUpdateCoalescer::Batch &batch);
+
+    ParameterUpdateCoalescer m_updates;
+
 signals:
     void modelChanged();
     /** @brief inform child effects (in case of bin effect with timeline producers)
@@ -0,0 +1,75 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "parameterupdatecoalescer.hpp"
+
+#include <utility>
+
+ParameterUpdateCoalescer::ParameterUpdateCoalescer(FlushFunction flush)
+    : m_flush(std::move(flush))
+{
+    m_timer.setSingleShot(true);
+    QObject::connect(&m_timer, &QTimer::timeout, [this]() { flush(); });
+}
+
+void ParameterUpdateCoalescer::addUpdate(int row, bool updateView, bool refreshOwner, int interval)
+{
+    if (updateView) {
+        if (row < 0) {
+            m_pending.allRows = true;
+        } else if (m_pending.firstRow < 0) {
+            m_pending.firstRow = m_pending.lastRow = row;
+        } else {
+            m_pending.firstRow = qMin(m_pending.firstRow, row);
+            m_pending.lastRow = qMax(m_pending.lastRow, row);
+        }
+    }
+    m_pending.refreshOwner |= refreshOwner;
+    m_pending.updates++;
+    m_stats.updates++;
+    // Don't restart a running timer, so that a continuous drag still produces one update per frame
+    if (!m_timer.isActive()) {
+        m_timer.start(qMax(0, interval));
+    }
+}
+
+void ParameterUpdateCoalescer::flush()
+{
+    m_timer.stop();
+    if (m_pending.updates == 0) {
+        return;
+    }
+    // Reset before sending, the flush function might record new updates
+    Batch batch = m_pending;
+    m_pending = Batch();
+    m_stats.batches++;
+    m_flush(batch);
+}
+
+bool ParameterUpdateCoalescer::isPending() const
+{
+    return m_pending.updates > 0;
+}
+
+ParameterUpdateCoalescer::Statistics ParameterUpdateCoalescer::statistics() const
+{
+    return m_stats;
+}
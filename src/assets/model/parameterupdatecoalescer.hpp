@@ -0,0 +1,82 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QTimer>
+#include <functional>
+
+/**
+ * @class ParameterUpdateCoalescer
+ * @brief Gathers the parameter changes of an asset that happen between two monitor frames.
+ *
+ * Dragging a slider or a color wheel changes a parameter many times per frame. Each change is applied to the MLT service
+ * right away, but the view update, monitor refresh and preview invalidation it requires are only recorded here, and sent
+ * once per batch when the timer expires or flush() is called.
+ */
+class ParameterUpdateCoalescer
+{
+public:
+    /** @brief The changes gathered since the last flush */
+    struct Batch
+    {
+        /** @brief Range of the rows to send in dataChanged, -1 if no row needs a view update */
+        int firstRow = -1;
+        int lastRow = -1;
+        /** @brief A change could not be mapped to a row, the whole model must be updated */
+        bool allRows = false;
+        /** @brief Monitor and timeline preview of the owner must be refreshed */
+        bool refreshOwner = false;
+        /** @brief Number of updates merged in this batch */
+        int updates = 0;
+    };
+    using FlushFunction = std::function<void(const Batch &)>;
+
+    explicit ParameterUpdateCoalescer(FlushFunction flush);
+
+    /** @brief Records a change and schedules a flush.
+        @param row the row of the parameter to update in the view, -1 for all rows
+        @param updateView if false, the change does not need a dataChanged
+        @param refreshOwner if true, the owner's monitor and preview must be refreshed
+        @param interval delay before the flush in milliseconds, usually one frame. A pending flush is not delayed further
+    */
+    void addUpdate(int row, bool updateView, bool refreshOwner, int interval);
+    /** @brief Sends the pending batch now, if any */
+    void flush();
+    bool isPending() const;
+
+    struct Statistics
+    {
+        /** @brief Number of recorded updates */
+        int updates = 0;
+        /** @brief Number of batches sent */
+        int batches = 0;
+        /** @brief Number of updates that did not cause a batch of their own */
+        int merged() const { return updates - batches; }
+    };
+    Statistics statistics() const;
+
+private:
+    FlushFunction m_flush;
+    QTimer m_timer;
+    Batch m_pending;
+    Statistics m_stats;
+};
@@ -0,0 +1,73 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "audiolevelring.hpp"
+
+namespace {
+unsigned roundCapacity(int capacity)
+{
+    unsigned size = 2;
+    while (size < unsigned(capacity)) {
+        size <<= 1;
+    }
+    return size;
+}
+} // namespace
+
+AudioLevelRing::AudioLevelRing(int capacity)
+    : m_records(roundCapacity(capacity))
+    , m_mask(unsigned(m_records.size()) - 1)
+{
+}
+
+bool AudioLevelRing::push(const Record &record)
+{
+    const unsigned head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) > m_mask) {
+        return false;
+    }
+    m_records[head & m_mask] = record;
+    // Publish the record only once it is completely written
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool AudioLevelRing::pop(Record &record)
+{
+    const unsigned tail = m_tail.load(std::memory_order_relaxed);
+    if (tail == m_head.load(std::memory_order_acquire)) {
+        return false;
+    }
+    record = m_records[tail & m_mask];
+    // Only release the slot once it has been copied
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+void AudioLevelRing::discard()
+{
+    m_tail.store(m_head.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+int AudioLevelRing::capacity() const
+{
+    return int(m_records.size());
+}
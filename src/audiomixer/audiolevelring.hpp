@@ -0,0 +1,67 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifndef AUDIOLEVELRING_H
+#define AUDIOLEVELRING_H
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+/** @class AudioLevelRing
+    @brief Single producer / single consumer queue of audio level records.
+    The MLT consumer thread pushes the levels of each rendered frame, the GUI thread pops them.
+    Neither side ever blocks, when the queue is full the new records are dropped until the reader catches up.
+ */
+class AudioLevelRing
+{
+public:
+    static constexpr int maxChannels = 8;
+
+    struct Record
+    {
+        int position;
+        int channels;
+        std::array<float, maxChannels> levels;
+    };
+
+    /** @brief capacity is rounded up to a power of 2 */
+    explicit AudioLevelRing(int capacity = 64);
+
+    /** @brief Producer side. Returns false if the record was dropped because the queue is full */
+    bool push(const Record &record);
+    /** @brief Consumer side. Returns false if there is nothing to read */
+    bool pop(Record &record);
+    /** @brief Consumer side. Drops all pending records */
+    void discard();
+    /** @brief Number of records that can be stored */
+    int capacity() const;
+
+private:
+    std::vector<Record> m_records;
+    const unsigned m_mask;
+    /** @brief Next slot to write, only modified by the producer */
+    alignas(64) std::atomic<unsigned> m_head{0};
+    /** @brief Next slot to read, only modified by the consumer */
+    alignas(64) std::atomic<unsigned> m_tail{0};
+};
+
+#endif
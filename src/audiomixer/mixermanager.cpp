@@ -42,6 +42,7 @@ const double log_factor = 1.0 / log10(1.0 / 127);
 MixerManager::MixerManager(QWidget *parent)
     : QWidget(parent)
     , m_masterMixer(nullptr)
+    , m_lastFrame(-1)
     , m_visibleMixerManager(false)
     , m_expandedWidth(-1)
     , m_recommandedWidth(300)
@@ -65,6 +66,10 @@ MixerManager::MixerManager(QWidget *parent)
     m_channelsLayout->addStretch(10);
     m_box->addLayout(m_masterBox);
     setLayout(m_box);
+    // Repaint the meters at most 50 times per second, whatever the number of tracks and frame rate
+    m_levelTimer.setSingleShot(true);
+    m_levelTimer.setInterval(20);
+    connect(&m_levelTimer, &QTimer::timeout, this, &MixerManager::refreshLevels);
 }
 
 void MixerManager::registerTrack(int tid, std::shared_ptr<Mlt::Tractor> service, const QString &trackTag)
@@ -80,7 +85,6 @@ void MixerManager::registerTrack(int tid, std::shared_ptr<Mlt::Tractor> service,
     if (m_visibleMixerManager) {
         mixer->connectMixer(!KdenliveSettings::mixerCollapse());
     }
-    connect(this, &MixerManager::updateLevels, mixer.get(), &MixerWidget::updateAudioLevel);
     connect(this, &MixerManager::clearMixers, mixer.get(), &MixerWidget::clear);
     connect(mixer.get(), &MixerWidget::toggleSolo, this, [&](int trid, bool solo) {
         if (!solo) {
@@ -168,7 +172,6 @@ void MixerManager::setModel(std::shared_ptr<TimelineItemModel> model)
     if (m_visibleMixerManager) {
         m_masterMixer->connectMixer(true);
     }
-    connect(this, &MixerManager::updateLevels, m_masterMixer.get(), &MixerWidget::updateAudioLevel);
     connect(this, &MixerManager::clearMixers, m_masterMixer.get(), &MixerWidget::clear);
     m_masterBox->addWidget(m_masterMixer.get());
     if (KdenliveSettings::mixerCollapse()) {
@@ -224,6 +227,24 @@ QSize MixerManager::sizeHint() const
     return QSize(m_recommandedWidth, 0);
 }
 
+void MixerManager::updateLevels(int pos)
+{
+    m_lastFrame = pos;
+    if (!m_levelTimer.isActive()) {
+        m_levelTimer.start();
+    }
+}
+
+void MixerManager::refreshLevels()
+{
+    for (const auto &item : m_mixers) {
+        item.second->updateAudioLevel(m_lastFrame);
+    }
+    if (m_masterMixer != nullptr) {
+        m_masterMixer->updateAudioLevel(m_lastFrame);
+    }
+}
+
 void MixerManager::pauseMonitoring(bool pause)
 {
     for (const auto &item : m_mixers) {
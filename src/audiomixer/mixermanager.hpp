@@ -26,6 +26,7 @@
 #include <memory>
 #include <unordered_map>
 
+#include <QTimer>
 #include <QWidget>
 
 namespace Mlt {
@@ -53,15 +54,18 @@ public:
     void collapseMixers();
     /** @brief Pause/unpause audio monitoring */
     void pauseMonitoring(bool pause);
+    /** @brief A frame was displayed, schedule a refresh of the vu-meters */
+    void updateLevels(int pos);
 
 public slots:
     void recordStateChanged(int tid, bool recording);
 
 private slots:
     void resetSizePolicy();
+    /** @brief Refresh the vu-meters of all tracks for the last displayed frame */
+    void refreshLevels();
 
 signals:
-    void updateLevels(int);
     void recordAudio(int tid);
     void purgeCache();
     void clearMixers();
@@ -81,6 +85,8 @@ private:
     QHBoxLayout *m_channelsLayout;
     QScrollArea *m_channelsBox;
     int m_lastFrame;
+    /** @brief Coalesces the level updates of all tracks */
+    QTimer m_levelTimer;
     bool m_visibleMixerManager;
     int m_expandedWidth;
     QVector <int> m_soloMuted;
@@ -83,19 +83,15 @@ static inline int fromDB(double level)
 void MixerWidget::property_changed( mlt_service , MixerWidget *widget, char *name )
 {
     if (widget && !strcmp(name, "_position")) {
+        // Called from the consumer thread: don't touch the widget data, only queue the levels
         mlt_properties filter_props = MLT_FILTER_PROPERTIES( widget->m_monitorFilter->get_filter());
-        int pos = mlt_properties_get_int(filter_props, "_position");
-        if (!widget->m_levels.contains(pos)) {
-            QVector<double> levels;
-            for (int i = 0; i < widget->m_channels; i++) {
-                levels << IEC_Scale(mlt_properties_get_double(filter_props, QString("_audio_level.%1").arg(i).toUtf8().constData()));
-            }
-            widget->m_levels[pos] = std::move(levels);
-            //{IEC_Scale(mlt_properties_get_double(filter_props, "_audio_level.0")), IEC_Scale(mlt_properties_get_double(filter_props, "_audio_level.1"))};
-            if (widget->m_levels.size() > widget->m_maxLevels) {
-                widget->m_levels.erase(widget->m_levels.begin());
-            }
+        AudioLevelRing::Record record;
+        record.position = mlt_properties_get_int(filter_props, "_position");
+        record.channels = int(widget->m_levelKeys.size());
+        for (int i = 0; i < record.channels; i++) {
+            record.levels[i] = float(IEC_Scale(mlt_properties_get_double(filter_props, widget->m_levelKeys[i].constData())));
         }
+        widget->m_levelRing.push(record);
     }
 }
 
@@ -153,6 +149,9 @@ void MixerWidget::buildUI(Mlt::Tractor *service, const QString &trackTag)
     for (int i = 0; i < m_channels; i++) {
         m_audioData << -100;
     }
+    for (int i = 0; i < qMin(m_channels, AudioLevelRing::maxChannels); i++) {
+        m_levelKeys.push_back(QStringLiteral("_audio_level.%1").arg(i).toUtf8());
+    }
     m_audioMeterWidget->setAudioValues(m_audioData);
 
     // Build volume widget
@@ -332,7 +331,7 @@ void MixerWidget::buildUI(Mlt::Tractor *service, const QString &trackTag)
             m_volumeSpin->setValue(dbValue);
             m_levelFilter->set("level", dbValue);
             m_levelFilter->set("disable", value == 60 ? 1 : 0);
-            m_levels.clear();
+            clear();
             emit m_manager->purgeCache();
             pCore->setDocumentModified();
         }
@@ -343,7 +342,7 @@ void MixerWidget::buildUI(Mlt::Tractor *service, const QString &trackTag)
         if (m_balanceFilter != nullptr) {
             m_balanceFilter->set("start", (value + 50) / 100.);
             m_balanceFilter->set("disable", value == 0 ? 1 : 0);
-            m_levels.clear();
+            clear();
             emit m_manager->purgeCache();
             pCore->setDocumentModified();
         }
@@ -432,7 +431,17 @@ void MixerWidget::updateLabel()
 
 void MixerWidget::updateAudioLevel(int pos)
 {
-    QMutexLocker lk(&m_storeMutex);
+    AudioLevelRing::Record record;
+    while (m_levelRing.pop(record)) {
+        QVector<double> &levels = m_levels[record.position];
+        levels.resize(record.channels);
+        for (int i = 0; i < record.channels; i++) {
+            levels[i] = record.levels[i];
+        }
+        if (m_levels.size() > m_maxLevels) {
+            m_levels.erase(m_levels.begin());
+        }
+    }
     if (m_levels.contains(pos)) {
         m_audioMeterWidget->setAudioValues(m_levels.value(pos));
         //m_levels.remove(pos);
@@ -444,14 +453,14 @@ void MixerWidget::updateAudioLevel(int pos)
 
 void MixerWidget::reset()
 {
-    QMutexLocker lk(&m_storeMutex);
+    m_levelRing.discard();
     m_levels.clear();
     m_audioMeterWidget->setAudioValues(m_audioData);
 }
 
 void MixerWidget::clear()
 {
-    QMutexLocker lk(&m_storeMutex);
+    m_levelRing.discard();
     m_levels.clear();
 }
 
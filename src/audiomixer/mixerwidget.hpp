@@ -22,13 +22,14 @@
 #ifndef MIXERWIDGET_H
 #define MIXERWIDGET_H
 
+#include "audiolevelring.hpp"
 #include "definitions.h"
 #include "mlt++/MltService.h"
 
 #include <memory>
 #include <unordered_map>
+#include <vector>
 #include <QWidget>
-#include <QMutex>
 
 class KDualAction;
 class AudioLevelWidget;
@@ -75,6 +76,7 @@ protected:
     void mousePressEvent(QMouseEvent *event) override;
 
 public slots:
+    /** @brief Collect the levels sent by the consumer thread and display the ones of frame pos */
     void updateAudioLevel(int pos);
     void setRecordState(bool recording);
 
@@ -87,7 +89,12 @@ protected:
     std::shared_ptr<Mlt::Filter> m_levelFilter;
     std::shared_ptr<Mlt::Filter> m_monitorFilter;
     std::shared_ptr<Mlt::Filter> m_balanceFilter;
+    /** @brief Levels per frame, only accessed from the GUI thread */
     QMap<int, QVector<double>> m_levels;
+    /** @brief Levels written by the MLT consumer thread, read by the GUI thread */
+    AudioLevelRing m_levelRing;
+    /** @brief Names of the level properties of each channel */
+    std::vector<QByteArray> m_levelKeys;
     int m_channels;
     KDualAction *m_muteAction;
     QSpinBox *m_balanceSpin;
@@ -102,7 +109,6 @@ private:
     QToolButton *m_record;
     QToolButton *m_collapse;
     QLabel *m_trackLabel;
-    QMutex m_storeMutex;
     int m_lastVolume;
     QVector <double>m_audioData;
     Mlt::Event *m_listener;
@@ -1656,6 +1656,8 @@ void Bin::setMonitor(Monitor *monitor)
     connect(m_monitor, &Monitor::addClipToProject, this, &Bin::slotAddClipToProject);
     connect(m_monitor, &Monitor::refreshCurrentClip, this, &Bin::slotOpenCurrent);
     connect(this, &Bin::openClip, [&](std::shared_ptr<ProjectClip> clip, int in, int out) {
+        // Jobs of the clip shown in the monitor go first
+        pCore->jobManager()->setInteractiveClip(clip ? clip->clipId() : QString());
         m_monitor->slotOpenClip(clip, in, out);
     });
 }
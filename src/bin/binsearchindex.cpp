@@ -0,0 +1,146 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "binsearchindex.hpp"
+#include <algorithm>
+
+bool BinSearchIndex::Filter::isEmpty() const
+{
+    return search.isEmpty() && tags.isEmpty() && type <= 0 && rating <= 0;
+}
+
+std::vector<BinSearchIndex::Trigram> BinSearchIndex::trigrams(const QString &folded)
+{
+    std::vector<Trigram> result;
+    if (folded.size() < 3) {
+        return result;
+    }
+    result.reserve(size_t(folded.size() - 2));
+    const QChar *chars = folded.constData();
+    for (int i = 0; i + 2 < folded.size(); ++i) {
+        result.push_back((Trigram(chars[i].unicode()) << 32) | (Trigram(chars[i + 1].unicode()) << 16) | Trigram(chars[i + 2].unicode()));
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+void BinSearchIndex::setItem(int id, const Fields &fields)
+{
+    removeItem(id);
+    Entry entry{fields.text.toCaseFolded(), fields.tags.toCaseFolded(), fields.type, fields.rating, {}};
+    entry.grams = trigrams(entry.text);
+    for (Trigram gram : entry.grams) {
+        m_postings[gram].insert(id);
+    }
+    m_items.emplace(id, std::move(entry));
+}
+
+void BinSearchIndex::removeItem(int id)
+{
+    auto it = m_items.find(id);
+    if (it == m_items.end()) {
+        return;
+    }
+    for (Trigram gram : it->second.grams) {
+        auto posting = m_postings.find(gram);
+        posting->second.erase(id);
+        if (posting->second.empty()) {
+            m_postings.erase(posting);
+        }
+    }
+    m_items.erase(it);
+}
+
+void BinSearchIndex::clear()
+{
+    m_items.clear();
+    m_postings.clear();
+}
+
+bool BinSearchIndex::contains(int id) const
+{
+    return m_items.count(id) > 0;
+}
+
+int BinSearchIndex::count() const
+{
+    return int(m_items.size());
+}
+
+bool BinSearchIndex::accepts(const Entry &entry, const Filter &folded)
+{
+    if (folded.rating > 0 && entry.rating != folded.rating) {
+        return false;
+    }
+    if (folded.type > 0 && entry.type != folded.type) {
+        return false;
+    }
+    for (const QString &tag : folded.tags) {
+        if (!entry.tags.contains(tag)) {
+            return false;
+        }
+    }
+    return entry.text.contains(folded.search);
+}
+
+std::unordered_set<int> BinSearchIndex::match(const Filter &filter) const
+{
+    Filter folded = filter;
+    folded.search = filter.search.toCaseFolded();
+    for (QString &tag : folded.tags) {
+        tag = tag.toCaseFolded();
+    }
+    std::unordered_set<int> result;
+    const std::vector<Trigram> grams = trigrams(folded.search);
+    if (grams.empty()) {
+        // Search string too short for the index, check every item
+        for (const auto &item : m_items) {
+            if (accepts(item.second, folded)) {
+                result.insert(item.first);
+            }
+        }
+        return result;
+    }
+    // Candidates are the items having all the trigrams, start from the rarest one
+    std::vector<const std::unordered_set<int> *> postings;
+    postings.reserve(grams.size());
+    for (Trigram gram : grams) {
+        auto posting = m_postings.find(gram);
+        if (posting == m_postings.end()) {
+            return result;
+        }
+        postings.push_back(&posting->second);
+    }
+    std::sort(postings.begin(), postings.end(),
+              [](const std::unordered_set<int> *a, const std::unordered_set<int> *b) { return a->size() < b->size(); });
+    for (int id : *postings.front()) {
+        bool candidate = true;
+        for (size_t i = 1; i < postings.size() && candidate; ++i) {
+            candidate = postings[i]->count(id) > 0;
+        }
+        // Having all trigrams does not mean they are in the right order, check the text itself
+        if (candidate && accepts(m_items.at(id), folded)) {
+            result.insert(id);
+        }
+    }
+    return result;
+}
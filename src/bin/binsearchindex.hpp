@@ -0,0 +1,87 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#pragma once
+
+#include "definitions.h"
+#include <QString>
+#include <QStringList>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/** @brief This class is an inverted index of the searchable content of the bin items.
+    The searchable text of an item (name, date, description, marker comments) is case folded and split in trigrams.
+    A search string of at least 3 characters only needs to check the items that contain all its trigrams, so a query costs
+    in proportion to the number of candidates instead of the number of items.
+ */
+class BinSearchIndex
+{
+public:
+    struct Fields
+    {
+        /** @brief Text matched by the search string, one line per field */
+        QString text;
+        QString tags;
+        int type = 0;
+        int rating = 0;
+    };
+
+    struct Filter
+    {
+        QString search;
+        QStringList tags;
+        /** @brief Item type and rating the items must have, 0 to accept any */
+        int type = 0;
+        int rating = 0;
+        /** @brief Returns true if all items are accepted */
+        bool isEmpty() const;
+    };
+
+    /** @brief Adds an item or updates its content */
+    void setItem(int id, const Fields &fields);
+    void removeItem(int id);
+    void clear();
+    bool contains(int id) const;
+    int count() const;
+
+    /** @brief Returns the ids of the items that match the filter by themselves */
+    std::unordered_set<int> match(const Filter &filter) const;
+
+private:
+    using Trigram = quint64;
+    /** @brief Returns the distinct trigrams of a case folded text */
+    static std::vector<Trigram> trigrams(const QString &folded);
+
+    struct Entry
+    {
+        QString text;
+        QString tags;
+        int type;
+        int rating;
+        std::vector<Trigram> grams;
+    };
+    /** @brief Returns true if the item passes the filter, search and tags must be case folded */
+    static bool accepts(const Entry &entry, const Filter &folded);
+
+    std::unordered_map<int, Entry> m_items;
+    std::unordered_map<Trigram, std::unordered_set<int>> m_postings;
+};
@@ -37,6 +37,8 @@
 #include <QDomDocument>
 #include <QMimeDatabase>
 #include <QProgressDialog>
+#include <QThreadPool>
+#include <QtConcurrent>
 #include <utility>
 
 namespace {
@@ -59,6 +61,32 @@ QDomElement createProducer(QDomDocument &xml, ClipType::ProducerType type, const
     return prod;
 }
 
+/* @brief Detects the mime types of the files to import on a bounded thread pool.
+   Files sharing their suffix, like image sequences or the clips of a camera card, are only probed once
+*/
+std::vector<QMimeType> probeMimeTypes(const QStringList &paths)
+{
+    QHash<QString, QVector<int>> groups;
+    for (int i = 0; i < paths.size(); ++i) {
+        const QString suffix = QFileInfo(paths.at(i)).suffix().toLower();
+        groups[suffix.isEmpty() ? paths.at(i) : suffix] << i;
+    }
+    std::vector<QMimeType> types(size_t(paths.size()));
+    QThreadPool pool;
+    pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), 4));
+    for (const QVector<int> &indexes : qAsConst(groups)) {
+        QtConcurrent::run(&pool, [&paths, &types, indexes]() {
+            QMimeDatabase db;
+            const QMimeType type = db.mimeTypeForFile(paths.at(indexes.first()));
+            for (int ix : indexes) {
+                types[size_t(ix)] = type;
+            }
+        });
+    }
+    pool.waitForDone();
+    return types;
+}
+
 } // namespace
 
 QString ClipCreator::createTitleClip(const std::unordered_map<QString, QString> &properties, int duration, const QString &name, const QString &parentFolder,
@@ -86,6 +114,12 @@ QString ClipCreator::createColorClip(const QString &color, int duration, const Q
 }
 
 QDomDocument ClipCreator::getXmlFromUrl(const QString &path)
+{
+    QMimeDatabase db;
+    return getXmlFromUrl(path, db.mimeTypeForUrl(QUrl::fromLocalFile(path)));
+}
+
+QDomDocument ClipCreator::getXmlFromUrl(const QString &path, const QMimeType &type)
 {
     QDomDocument xml;
     QUrl fileUrl = QUrl::fromLocalFile(path);
@@ -94,8 +128,6 @@ QDomDocument ClipCreator::getXmlFromUrl(const QString &path)
         KMessageBox::sorry(QApplication::activeWindow(), i18n("You cannot add a project inside itself."), i18n("Cannot create clip"));        
         return xml;
     }
-    QMimeDatabase db;
-    QMimeType type = db.mimeTypeForUrl(fileUrl);
 
     QDomElement prod;
     qDebug()<<"=== GOT DROPPED MIME: "<<type.name();
@@ -168,6 +200,30 @@ bool ClipCreator::createClipFromFile(const QString &path, const QString &parentF
     return ok;
 }
 
+QStringList ClipCreator::createClipsFromFiles(const QStringList &paths, const QString &parentFolder, const std::shared_ptr<ProjectItemModel> &model, Fun &undo,
+                                              Fun &redo)
+{
+    const std::vector<QMimeType> types = probeMimeTypes(paths);
+    QList<QDomElement> descriptions;
+    for (int i = 0; i < paths.size(); ++i) {
+        QDomDocument xml = getXmlFromUrl(paths.at(i), types.at(size_t(i)));
+        if (xml.isNull()) {
+            continue;
+        }
+        QDomElement prod = xml.documentElement();
+        if (!descriptions.isEmpty()) {
+            // Only the first clip of the batch may change the project profile
+            prod.removeAttribute(QStringLiteral("_checkProfile"));
+        }
+        descriptions << prod;
+    }
+    QStringList ids;
+    if (descriptions.isEmpty() || !model->requestAddBinClips(ids, descriptions, parentFolder, undo, redo)) {
+        return QStringList();
+    }
+    return ids;
+}
+
 QString ClipCreator::createSlideshowClip(const QString &path, int duration, const QString &name, const QString &parentFolder,
                                          const std::unordered_map<QString, QString> &properties, const std::shared_ptr<ProjectItemModel> &model)
 {
@@ -232,6 +288,8 @@ const QString ClipCreator::createClipsFromList(const QList<QUrl> &list, bool che
     qDebug() << "/////////// creatclipsfromlist" << list << checkRemovable << parentFolder;
     bool created = false;
     QMimeDatabase db;
+    // Files of this level are imported together once the folders are handled
+    QStringList files;
     for (const QUrl &file : list) {
         if (!QFile::exists(file.toLocalFile())) {
             continue;
@@ -313,10 +371,13 @@ const QString ClipCreator::createClipsFromList(const QList<QUrl> &list, bool che
 
                 if (answer == KMessageBox::Cancel) continue;
             }
-            const QString clipId = ClipCreator::createClipFromFile(file.toLocalFile(), parentFolder, model, undo, redo);
-            if (createdItem.isEmpty() && clipId != QLatin1String("-1")) {
-                createdItem = clipId;
-            }
+            files << file.toLocalFile();
+        }
+    }
+    if (!files.isEmpty()) {
+        const QStringList ids = createClipsFromFiles(files, parentFolder, model, undo, redo);
+        if (createdItem.isEmpty() && !ids.isEmpty()) {
+            createdItem = ids.first();
         }
     }
     qDebug() << "/////////// creatclipsfromlist return" << created;
@@ -24,7 +24,9 @@
 
 #include "definitions.h"
 #include "undohelper.hpp"
+#include <QMimeType>
 #include <QString>
+#include <QStringList>
 #include <memory>
 #include <unordered_map>
 
@@ -86,6 +88,15 @@ QString createClipFromFile(const QString &path, const QString &parentFolder, con
                            const std::function<void(const QString &)> &readyCallBack = [](const QString &) {});
 bool createClipFromFile(const QString &path, const QString &parentFolder, std::shared_ptr<ProjectItemModel> model);
 
+/* @brief Imports a list of files as a batch: their mime types are probed in parallel and the clips are inserted in the bin at once.
+   The clips are then loaded as usual, one producer per file
+   @param paths : paths to the files, they must not be folders
+   @param parentFolder: the binId of the containing folder
+   @param model: a shared pointer to the bin item model
+   @return the binIds of the created clips
+*/
+QStringList createClipsFromFiles(const QStringList &paths, const QString &parentFolder, const std::shared_ptr<ProjectItemModel> &model, Fun &undo, Fun &redo);
+
 /* @brief Iterates recursively through the given url list and add the files it finds, recreating a folder structure
    @param list: the list of items (can be folders)
    @param checkRemovable: if true, it will check if files are on removable devices, and warn the user if so
@@ -99,6 +110,9 @@ const QString createClipsFromList(const QList<QUrl> &list, bool checkRemovable,
 /* @brief Create minimal xml description from an url
  */
 QDomDocument getXmlFromUrl(const QString &path);
+/* @brief Same as above, when the mime type of the file is already known
+ */
+QDomDocument getXmlFromUrl(const QString &path, const QMimeType &type);
 } // namespace ClipCreator
 
 #endif
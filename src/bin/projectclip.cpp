@@ -33,6 +33,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "jobs/thumbjob.hpp"
 #include "jobs/cachejob.hpp"
 #include "kdenlivesettings.h"
+#include "lib/audio/audioLevelsStore.h"
 #include "lib/audio/audioStreamInfo.h"
 #include "mltcontroller/clipcontroller.h"
 #include "mltcontroller/clippropertiescontroller.h"
@@ -46,7 +47,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "timecode.h"
 #include "timeline2/model/snapmodel.hpp"
 
+#include "utils/filehasher.hpp"
 #include "utils/thumbnailcache.hpp"
+#include "utils/thumbnailextractor.hpp"
 #include "xml/xml.hpp"
 #include <QPainter>
 #include <jobs/proxyclipjob.h>
@@ -108,6 +111,11 @@ ProjectClip::ProjectClip(const QString &id, const QIcon &thumb, const std::share
     hash();
     connect(m_markerModel.get(), &MarkerListModel::modelChanged, this, [&]() {
         setProducerProperty(QStringLiteral("kdenlive:markers"), m_markerModel->toJson());
+        // Marker comments are searchable in the bin, notify the bin filter which also outdates the search index
+        if (auto ptr = m_model.lock()) {
+            std::static_pointer_cast<ProjectItemModel>(ptr)->onItemUpdated(std::static_pointer_cast<ProjectClip>(shared_from_this()),
+                                                                           AbstractProjectItem::DataDescription);
+        }
     });
     QString markers = getProducerProperty(QStringLiteral("kdenlive:markers"));
     if (!markers.isEmpty()) {
@@ -157,7 +165,14 @@ ProjectClip::ProjectClip(const QString &id, const QDomElement &description, cons
     } else {
         m_name = i18n("Untitled");
     }
-    connect(m_markerModel.get(), &MarkerListModel::modelChanged, this, [&]() { setProducerProperty(QStringLiteral("kdenlive:markers"), m_markerModel->toJson()); });
+    connect(m_markerModel.get(), &MarkerListModel::modelChanged, this, [&]() {
+        setProducerProperty(QStringLiteral("kdenlive:markers"), m_markerModel->toJson());
+        // Marker comments are searchable in the bin, notify the bin filter which also outdates the search index
+        if (auto ptr = m_model.lock()) {
+            std::static_pointer_cast<ProjectItemModel>(ptr)->onItemUpdated(std::static_pointer_cast<ProjectClip>(shared_from_this()),
+                                                                           AbstractProjectItem::DataDescription);
+        }
+    });
 }
 
 std::shared_ptr<ProjectClip> ProjectClip::construct(const QString &id, const QDomElement &description, const QIcon &thumb,
@@ -242,6 +257,9 @@ void ProjectClip::updateAudioThumbnail()
             ffmpeg.waitForFinished(-1);
         }
     }
+    m_audioStoresMutex.lock();
+    m_audioStores.clear();
+    m_audioStoresMutex.unlock();
     emit audioThumbReady();
     if (m_clipType == ClipType::Audio) {
         QImage thumb = ThumbnailCache::get()->getThumbnail(m_binId, 0);
@@ -263,19 +281,24 @@ void ProjectClip::updateAudioThumbnail()
                     st.next();
                     int channels = channelsList.value(st.key());
                     double channelHeight = (double) streamHeight / channels;
-                    const QVector <uint8_t> audioLevels = audioFrameCache(st.key());
-                    qreal indicesPrPixel = qreal(audioLevels.length()) / img.width();
-                    int idx;
-                    for (int channel = 0; channel < channels; channel++) {
+                    std::shared_ptr<AudioLevelsStore> store = audioLevelsStore(st.key());
+                    if (!store) {
+                        streamCount++;
+                        continue;
+                    }
+                    // Read the zoom level matching the icon width instead of every frame
+                    qreal framesPrPixel = qreal(store->sampleCount(0)) / img.width();
+                    int zoomLevel = store->levelForFramesPerPixel(framesPrPixel);
+                    int samples = store->sampleCount(zoomLevel);
+                    for (int channel = 0; channel < qMin(channels, store->channels()); channel++) {
                         double y = (streamHeight * streamCount) + (channel * channelHeight) + channelHeight / 2;
+                        const uint8_t *peaks = store->peaks(zoomLevel, channel);
                         for (int i = 0; i <= img.width(); i++) {
-                            idx = ceil(i * indicesPrPixel);
-                            idx += idx % channels;
-                            idx += channel;
-                            if (idx >= audioLevels.length() || idx < 0) {
+                            int idx = int(i * framesPrPixel) >> zoomLevel;
+                            if (idx >= samples) {
                                 break;
                             }
-                            double level = audioLevels.at(idx) * channelHeight / 510.; // divide height by 510 (2*255) to get height
+                            double level = peaks[idx] * channelHeight / 510.; // divide height by 510 (2*255) to get height
                             painter.drawLine(i, y - level, i, y + level);
                         }
                     }
@@ -403,6 +426,7 @@ void ProjectClip::reloadProducer(bool refreshOnly, bool isProxy, bool forceAudio
         ThumbnailCache::get()->invalidateThumbsForClip(clipId());
         pCore->jobManager()->discardJobs(clipId(), AbstractClipJob::THUMBJOB);
         m_thumbsProducer.reset();
+        ThumbnailExtractor::get()->releaseClip(m_binId);
         emit pCore->jobManager()->startJob<ThumbJob>({clipId()}, loadjobId, QString(), -1, true, true);
     } else {
         // If another load job is running?
@@ -416,6 +440,7 @@ void ProjectClip::reloadProducer(bool refreshOnly, bool isProxy, bool forceAudio
             bool hashChanged = false;
             pCore->jobManager()->discardJobs(clipId(), AbstractClipJob::THUMBJOB);
             m_thumbsProducer.reset();
+            ThumbnailExtractor::get()->releaseClip(m_binId);
             ClipType::ProducerType type = clipType();
             if (type != ClipType::Color && type != ClipType::Image && type != ClipType::SlideShow) {
                 xml.removeAttribute("out");
@@ -516,6 +541,7 @@ bool ProjectClip::setProducer(std::shared_ptr<Mlt::Producer> producer, bool repl
     updateProducer(producer);
     emit producerChanged(m_binId, producer);
     m_thumbsProducer.reset();
+    ThumbnailExtractor::get()->releaseClip(m_binId);
     connectEffectStack();
 
     // Update info
@@ -627,36 +653,50 @@ std::shared_ptr<Mlt::Producer> ProjectClip::thumbProducer()
         return nullptr;
     }
     QMutexLocker lock(&m_thumbMutex);
+    m_thumbsProducer = buildThumbProducer();
+    return m_thumbsProducer;
+}
+
+std::shared_ptr<Mlt::Producer> ProjectClip::createThumbProducer()
+{
+    if (clipType() == ClipType::Unknown) {
+        return nullptr;
+    }
+    QMutexLocker lock(&m_thumbMutex);
+    return buildThumbProducer();
+}
+
+std::shared_ptr<Mlt::Producer> ProjectClip::buildThumbProducer()
+{
     std::shared_ptr<Mlt::Producer> prod = originalProducer();
     if (!prod->is_valid()) {
         return nullptr;
     }
     if (KdenliveSettings::gpu_accel()) {
         // TODO: when the original producer changes, we must reload this thumb producer
-        m_thumbsProducer = softClone(ClipController::getPassPropertiesList());
-    } else {
-        QString mltService = m_masterProducer->get("mlt_service");
-        const QString mltResource = m_masterProducer->get("resource");
-        if (mltService == QLatin1String("avformat")) {
-            mltService = QStringLiteral("avformat-novalidate");
-        }
-        m_thumbsProducer.reset(new Mlt::Producer(*pCore->thumbProfile(), mltService.toUtf8().constData(), mltResource.toUtf8().constData()));
-        if (m_thumbsProducer->is_valid()) {
-            Mlt::Properties original(m_masterProducer->get_properties());
-            Mlt::Properties cloneProps(m_thumbsProducer->get_properties());
-            cloneProps.pass_list(original, ClipController::getPassPropertiesList());
-            Mlt::Filter scaler(*pCore->thumbProfile(), "swscale");
-            Mlt::Filter padder(*pCore->thumbProfile(), "resize");
-            Mlt::Filter converter(*pCore->thumbProfile(), "avcolor_space");
-            m_thumbsProducer->set("audio_index", -1);
-            // Required to make get_playtime() return > 1
-            m_thumbsProducer->set("out", m_thumbsProducer->get_length() -1);
-            m_thumbsProducer->attach(scaler);
-            m_thumbsProducer->attach(padder);
-            m_thumbsProducer->attach(converter);
-        }
+        return softClone(ClipController::getPassPropertiesList());
     }
-    return m_thumbsProducer;
+    QString mltService = m_masterProducer->get("mlt_service");
+    const QString mltResource = m_masterProducer->get("resource");
+    if (mltService == QLatin1String("avformat")) {
+        mltService = QStringLiteral("avformat-novalidate");
+    }
+    std::shared_ptr<Mlt::Producer> thumbsProducer(new Mlt::Producer(*pCore->thumbProfile(), mltService.toUtf8().constData(), mltResource.toUtf8().constData()));
+    if (thumbsProducer->is_valid()) {
+        Mlt::Properties original(m_masterProducer->get_properties());
+        Mlt::Properties cloneProps(thumbsProducer->get_properties());
+        cloneProps.pass_list(original, ClipController::getPassPropertiesList());
+        Mlt::Filter scaler(*pCore->thumbProfile(), "swscale");
+        Mlt::Filter padder(*pCore->thumbProfile(), "resize");
+        Mlt::Filter converter(*pCore->thumbProfile(), "avcolor_space");
+        thumbsProducer->set("audio_index", -1);
+        // Required to make get_playtime() return > 1
+        thumbsProducer->set("out", thumbsProducer->get_length() -1);
+        thumbsProducer->attach(scaler);
+        thumbsProducer->attach(padder);
+        thumbsProducer->attach(converter);
+    }
+    return thumbsProducer;
 }
 
 void ProjectClip::createDisabledMasterProducer()
@@ -1054,28 +1094,9 @@ const QString ProjectClip::getFileHash()
 
 const QPair<QByteArray, qint64> ProjectClip::calculateHash(const QString path)
 {
-    QFile file(path);
-    QByteArray fileHash;
-    qint64 fSize = 0;
-    if (file.open(QIODevice::ReadOnly)) { // write size and hash only if resource points to a file
-        /*
-        * 1 MB = 1 second per 450 files (or faster)
-        * 10 MB = 9 seconds per 450 files (or faster)
-        */
-        QByteArray fileData;
-        fSize = file.size();
-        if (fSize > 2000000) {
-            fileData = file.read(1000000);
-            if (file.seek(file.size() - 1000000)) {
-                fileData.append(file.readAll());
-            }
-        } else {
-            fileData = file.readAll();
-        }
-        file.close();
-        fileHash = QCryptographicHash::hash(fileData, QCryptographicHash::Md5);
-    }
-    return {fileHash, fSize};
+    // Unchanged files are not read again
+    FileHasher::Result result = FileHasher::get()->hash(path);
+    return {result.hash, result.size};
 }
 
 double ProjectClip::getOriginalFps() const
@@ -1393,6 +1414,10 @@ void ProjectClip::discardAudioThumb()
         return;
     }
     pCore->jobManager()->discardJobs(clipId(), AbstractClipJob::AUDIOTHUMBJOB);
+    // Release the mapped files before deleting them
+    m_audioStoresMutex.lock();
+    m_audioStores.clear();
+    m_audioStoresMutex.unlock();
     QString audioThumbPath;
     QList <int> streams = m_audioInfo->streams().keys();
     // Delete audio thumbnail data
@@ -1443,7 +1468,7 @@ const QString ProjectClip::getAudioThumbPath(int stream)
     QString audioPath = thumbFolder.absoluteFilePath(clipHash);
     audioPath.append(QLatin1Char('_') + QString::number(stream));
     int roundedFps = (int)pCore->getCurrentFps();
-    audioPath.append(QStringLiteral("_%1_audio.png").arg(roundedFps));
+    audioPath.append(QStringLiteral("_%1_audio.kdal").arg(roundedFps));
     return audioPath;
 }
 
@@ -1679,43 +1704,25 @@ void ProjectClip::setRating(uint rating)
     pCore->currentDoc()->setModified(true);
 }
 
-const QVector <uint8_t> ProjectClip::audioFrameCache(int stream)
+std::shared_ptr<AudioLevelsStore> ProjectClip::audioLevelsStore(int stream)
 {
-    QVector <uint8_t> audioLevels;
     if (stream == -1) {
         if (m_audioInfo) {
             stream = m_audioInfo->ffmpeg_audio_index();
         } else {
-            return audioLevels;
-        }
-    }
-    QString key = QString("%1:%2").arg(m_binId).arg(stream);
-    QByteArray audioData;
-    if (pCore->audioThumbCache.find(key, &audioData)) {
-        QDataStream in(audioData);
-        in >> audioLevels;
-        return audioLevels;
-    }
-    // convert cached image
-    const QString cachePath = getAudioThumbPath(stream);
-    // checking for cached thumbs
-    QImage image(cachePath);
-    if (!image.isNull()) {
-        int channels = m_audioInfo->channelsForStream(stream);
-        int n = image.width() * image.height();
-        for (int i = 0; i < n; i++) {
-            QRgb p = image.pixel(i / channels, i % channels);
-            audioLevels << (uint8_t)qRed(p);
-            audioLevels << (uint8_t)qGreen(p);
-            audioLevels << (uint8_t)qBlue(p);
-            audioLevels << (uint8_t)qAlpha(p);
-        }
-        // populate vector
-        QDataStream st(&audioData, QIODevice::WriteOnly);
-        st << audioLevels;
-        pCore->audioThumbCache.insert(key, audioData);
-    }
-    return audioLevels;
+            return nullptr;
+        }
+    }
+    QMutexLocker lk(&m_audioStoresMutex);
+    if (m_audioStores.contains(stream)) {
+        return m_audioStores.value(stream);
+    }
+    std::shared_ptr<AudioLevelsStore> store = AudioLevelsStore::open(getAudioThumbPath(stream));
+    if (store) {
+        // Only keep valid stores, missing ones may be created later by the audio thumb job
+        m_audioStores.insert(stream, store);
+    }
+    return store;
 }
 
 void ProjectClip::setClipStatus(FileStatus::ClipStatus status)
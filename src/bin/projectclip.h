@@ -32,6 +32,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QMutex>
 #include <memory>
 
+class AudioLevelsStore;
 class ClipPropertiesController;
 class ProjectFolder;
 class ProjectSubClip;
@@ -148,6 +149,8 @@ public:
 
     /** @brief Returns this clip's producer. */
     std::shared_ptr<Mlt::Producer> thumbProducer() override;
+    /** @brief Returns a new producer for thumbnail extraction, not shared with thumbProducer(). */
+    std::shared_ptr<Mlt::Producer> createThumbProducer();
 
     /** @brief Recursively disable/enable bin effects. */
     void setBinEffectsEnabled(bool enabled) override;
@@ -162,7 +165,7 @@ public:
 
     /** @brief The clip hash created from the clip's resource. */
     const QString hash();
-    /** @brief Callculate a file hash from a path. */
+    /** @brief Callculate a file hash from a path, from the file hash cache if the file did not change. */
     static const QPair<QByteArray, qint64> calculateHash(const QString path);
 
     /** @brief Returns true if we are using a proxy for this clip. */
@@ -222,9 +225,9 @@ public:
     /** @brief Display Bin thumbnail given a percent
      */
     void getThumbFromPercent(int percent);
-    /** @brief Return audio cache for a stream
+    /** @brief Return the memory mapped audio levels for a stream, or nullptr if they were not generated yet
      */
-    const QVector <uint8_t> audioFrameCache(int stream = -1);
+    std::shared_ptr<AudioLevelsStore> audioLevelsStore(int stream = -1);
     /** @brief Return FFmpeg's audio stream index for an MLT audio stream index
      */
     int getAudioStreamFfmpegIndex(int mltStream);
@@ -286,12 +289,16 @@ public slots:
 private:
     /** @brief Generate and store file hash if not available. */
     const QString getFileHash();
+    /** @brief Build a producer for thumbnail extraction, m_thumbMutex must be locked. */
+    std::shared_ptr<Mlt::Producer> buildThumbProducer();
     QMutex m_producerMutex;
     QMutex m_thumbMutex;
     QFuture<void> m_thumbThread;
     QList<int> m_requestedThumbs;
     const QString geometryWithOffset(const QString &data, int offset);
-    QMap <QString, QByteArray> m_audioLevels;
+    /** @brief Opened audio levels stores, by stream */
+    QMap <int, std::shared_ptr<AudioLevelsStore>> m_audioStores;
+    QMutex m_audioStoresMutex;
     /** @brief If true, all timeline occurences of this clip will be replaced from a fresh producer on reload. */
     bool m_resetTimelineOccurences;
 
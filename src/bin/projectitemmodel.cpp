@@ -40,17 +40,36 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "projectfolder.h"
 #include "projectsubclip.h"
 #include "lib/localeHandling.h"
+#include "model/markerlistmodel.hpp"
 #include "xml/xml.hpp"
 
 #include <KLocalizedString>
+#include <KMessageWidget>
+#include <QDateTime>
+#include <QElapsedTimer>
 #include <QIcon>
 #include <QMimeData>
 #include <QProgressDialog>
 #include <mlt++/Mlt.h>
 #include <queue>
+#include <atomic>
 #include <qvarlengtharray.h>
 #include <utility>
 
+namespace {
+/** @brief Number of clips loaded by each job of a batch import, small enough for the first clips to get ready early */
+const int importBatchSize = 32;
+
+/** @brief Progress of a batch import, used to report its throughput once all clips are processed */
+struct ImportStats
+{
+    QElapsedTimer timer;
+    int total = 0;
+    std::atomic<int> processed{0};
+    std::atomic<int> failed{0};
+};
+} // namespace
+
 ProjectItemModel::ProjectItemModel(QObject *parent)
     : AbstractTreeModel(parent)
     , m_lock(QReadWriteLock::Recursive)
@@ -66,6 +85,14 @@ ProjectItemModel::ProjectItemModel(QObject *parent)
     connect(m_fileWatcher.get(), &FileWatcher::binClipModified, this, &ProjectItemModel::reloadClip);
     connect(m_fileWatcher.get(), &FileWatcher::binClipWaiting, this, &ProjectItemModel::setClipWaiting);
     connect(m_fileWatcher.get(), &FileWatcher::binClipMissing, this, &ProjectItemModel::setClipInvalid);
+    // Direct connection so that the index is outdated before any view reacts to the change
+    connect(this, &QAbstractItemModel::dataChanged, this,
+            [this](const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+                for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+                    invalidateSearchItem(int(topLeft.sibling(row, 0).internalId()));
+                }
+            },
+            Qt::DirectConnection);
 }
 
 std::shared_ptr<ProjectItemModel> ProjectItemModel::construct(QObject *parent)
@@ -382,36 +409,30 @@ std::shared_ptr<ProjectClip> ProjectItemModel::getClipByBinID(const QString &bin
     if (binId.contains(QLatin1Char('_'))) {
         return getClipByBinID(binId.section(QLatin1Char('_'), 0, 0));
     }
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->itemType() == AbstractProjectItem::ClipItem && c->clipId() == binId) {
-            return std::static_pointer_cast<ProjectClip>(c);
-        }
+    auto c = findBinItem(binId);
+    if (c && c->itemType() == AbstractProjectItem::ClipItem) {
+        return std::static_pointer_cast<ProjectClip>(c);
     }
     return nullptr;
 }
 
-const QVector<uint8_t> ProjectItemModel::getAudioLevelsByBinID(const QString &binId, int stream)
+std::shared_ptr<AudioLevelsStore> ProjectItemModel::getAudioLevelsStore(const QString &binId, int stream)
 {
     READ_LOCK();
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->itemType() == AbstractProjectItem::ClipItem && c->clipId() == binId) {
-            return std::static_pointer_cast<ProjectClip>(c)->audioFrameCache(stream);
-        }
+    std::shared_ptr<ProjectClip> clip = getClipByBinID(binId);
+    if (clip) {
+        return clip->audioLevelsStore(stream);
     }
-    return QVector<uint8_t>();
+    return nullptr;
 }
 
 double ProjectItemModel::getAudioMaxLevel(const QString &binId)
 {
     READ_LOCK();
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->itemType() == AbstractProjectItem::ClipItem && c->clipId() == binId) {
-            int volume = std::static_pointer_cast<ProjectClip>(c)->getProducerIntProperty(QStringLiteral("kdenlive:audio_max"));
-            return volume > 1 ? qSqrt(volume) : volume;
-        }
+    auto c = findBinItem(binId);
+    if (c && c->itemType() == AbstractProjectItem::ClipItem) {
+        int volume = std::static_pointer_cast<ProjectClip>(c)->getProducerIntProperty(QStringLiteral("kdenlive:audio_max"));
+        return volume > 1 ? qSqrt(volume) : volume;
     }
     return 0;
 }
@@ -425,11 +446,9 @@ bool ProjectItemModel::hasClip(const QString &binId)
 std::shared_ptr<ProjectFolder> ProjectItemModel::getFolderByBinId(const QString &binId)
 {
     READ_LOCK();
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->itemType() == AbstractProjectItem::FolderItem && c->clipId() == binId) {
-            return std::static_pointer_cast<ProjectFolder>(c);
-        }
+    auto c = findBinItem(binId);
+    if (c && c->itemType() == AbstractProjectItem::FolderItem) {
+        return std::static_pointer_cast<ProjectFolder>(c);
     }
     return nullptr;
 }
@@ -462,13 +481,16 @@ const QString ProjectItemModel::getFolderIdByName(const QString &folderName)
 std::shared_ptr<AbstractProjectItem> ProjectItemModel::getItemByBinId(const QString &binId)
 {
     READ_LOCK();
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->clipId() == binId) {
-            return c;
-        }
+    return findBinItem(binId);
+}
+
+std::shared_ptr<AbstractProjectItem> ProjectItemModel::findBinItem(const QString &binId) const
+{
+    auto it = m_binIdIndex.constFind(binId);
+    if (it == m_binIdIndex.constEnd()) {
+        return nullptr;
     }
-    return nullptr;
+    return std::static_pointer_cast<AbstractProjectItem>(m_allItems.at(it.value()).lock());
 }
 
 void ProjectItemModel::setBinEffectsEnabled(bool enabled)
@@ -624,6 +646,9 @@ void ProjectItemModel::registerItem(const std::shared_ptr<TreeItem> &item)
     auto clip = std::static_pointer_cast<AbstractProjectItem>(item);
     m_binPlaylist->manageBinItemInsertion(clip);
     AbstractTreeModel::registerItem(item);
+    Q_ASSERT(!m_binIdIndex.contains(clip->clipId()));
+    m_binIdIndex.insert(clip->clipId(), clip->getId());
+    invalidateSearchItem(clip->getId());
     if (clip->itemType() == AbstractProjectItem::ClipItem) {
         auto clipItem = std::static_pointer_cast<ProjectClip>(clip);
         updateWatcher(clipItem);
@@ -636,6 +661,12 @@ void ProjectItemModel::deregisterItem(int id, TreeItem *item)
     m_binPlaylist->manageBinItemDeletion(clip);
     // TODO : here, we should suspend jobs belonging to the item we delete. They can be restarted if the item is reinserted by undo
     AbstractTreeModel::deregisterItem(id, item);
+    m_binIdIndex.remove(clip->clipId());
+    {
+        QMutexLocker searchLocker(&m_searchMutex);
+        m_searchIndex.removeItem(id);
+        m_searchDirty.erase(id);
+    }
     if (clip->itemType() == AbstractProjectItem::ClipItem) {
         auto clipItem = static_cast<ProjectClip *>(clip);
         m_fileWatcher->removeFile(clipItem->clipId());
@@ -684,6 +715,28 @@ bool ProjectItemModel::addItem(const std::shared_ptr<AbstractProjectItem> &item,
     return res;
 }
 
+bool ProjectItemModel::addItems(const std::vector<std::shared_ptr<AbstractProjectItem>> &items, const QString &parentId, Fun &undo, Fun &redo)
+{
+    QWriteLocker locker(&m_lock);
+    std::shared_ptr<AbstractProjectItem> parentItem = getItemByBinId(parentId);
+    if (!parentItem || parentItem->itemType() != AbstractProjectItem::FolderItem) {
+        qCDebug(KDENLIVE_LOG) << "  / / ERROR when inserting clips: clips should be inserted in a folder";
+        return false;
+    }
+    std::vector<std::shared_ptr<TreeItem>> treeItems(items.begin(), items.end());
+    Fun operation = addItems_lambda(treeItems, parentItem->getId());
+    Fun reverse = []() { return true; };
+    for (const auto &item : items) {
+        Fun removal = removeItem_lambda(item->getId());
+        PUSH_FRONT_LAMBDA(removal, reverse);
+    }
+    bool res = operation();
+    if (res) {
+        UPDATE_UNDO_REDO(operation, reverse, undo, redo);
+    }
+    return res;
+}
+
 bool ProjectItemModel::requestAddFolder(QString &id, const QString &name, const QString &parentId, Fun &undo, Fun &redo)
 {
     QWriteLocker locker(&m_lock);
@@ -729,6 +782,71 @@ bool ProjectItemModel::requestAddBinClip(QString &id, const QDomElement &descrip
     return res;
 }
 
+bool ProjectItemModel::requestAddBinClips(QStringList &ids, const QList<QDomElement> &descriptions, const QString &parentId, Fun &undo, Fun &redo)
+{
+    QWriteLocker locker(&m_lock);
+    ids.clear();
+    if (descriptions.isEmpty()) {
+        return false;
+    }
+    auto xmlById = std::make_shared<std::unordered_map<QString, QDomElement>>();
+    std::vector<std::shared_ptr<ProjectClip>> clips;
+    for (const QDomElement &description : descriptions) {
+        QString id = Xml::getXmlProperty(description, QStringLiteral("kdenlive:id"), QStringLiteral("-1"));
+        if (id == QStringLiteral("-1") || !isIdFree(id) || xmlById->count(id) > 0) {
+            id = QString::number(getFreeClipId());
+        }
+        clips.push_back(ProjectClip::construct(id, description, m_blankThumb, std::static_pointer_cast<ProjectItemModel>(shared_from_this())));
+        (*xmlById)[id] = description;
+        ids << id;
+    }
+    if (!addItems(std::vector<std::shared_ptr<AbstractProjectItem>>(clips.begin(), clips.end()), parentId, undo, redo)) {
+        ids.clear();
+        return false;
+    }
+    // Clips are loaded by a few jobs holding several clips each, the jobs still run in parallel on the job manager pool
+    auto stats = std::make_shared<ImportStats>();
+    stats->timer.start();
+    stats->total = ids.size();
+    // Failures are reported from the job threads, successes from the GUI thread
+    auto clipProcessed = [stats](bool success) {
+        if (!success) {
+            ++stats->failed;
+        }
+        if (++stats->processed == stats->total && stats->total > 1) {
+            const double seconds = qMax(1, int(stats->timer.elapsed())) / 1000.;
+            const int loaded = stats->total - stats->failed;
+            qCDebug(KDENLIVE_LOG) << "Imported" << loaded << "of" << stats->total << "clips in" << seconds << "seconds";
+            QString message = i18n("Imported %1 clips in %2 seconds (%3 clips per second)", loaded, QString::number(seconds, 'f', 1),
+                                   QString::number(loaded / seconds, 'f', 1));
+            if (stats->failed > 0) {
+                message.append(QLatin1Char(' ') + i18np("%1 clip could not be loaded.", "%1 clips could not be loaded.", stats->failed.load()));
+            }
+            QMetaObject::invokeMethod(pCore.get(), [message]() { pCore->displayBinMessage(message, KMessageWidget::Information); }, Qt::QueuedConnection);
+        }
+    };
+    for (int start = 0; start < ids.size(); start += importBatchSize) {
+        std::vector<QString> batch;
+        std::vector<QString> audioBatch;
+        for (int i = start; i < qMin(ids.size(), start + importBatchSize); ++i) {
+            batch.push_back(ids.at(i));
+            ClipType::ProducerType type = clips.at(size_t(i))->clipType();
+            if (type == ClipType::AV || type == ClipType::Audio || type == ClipType::Playlist || type == ClipType::Unknown) {
+                audioBatch.push_back(ids.at(i));
+            }
+        }
+        std::function<std::shared_ptr<LoadJob>(const QString &)> createFn = [xmlById, clipProcessed](const QString &binId) {
+            return AbstractClipJob::make<LoadJob>(binId, xmlById->at(binId), std::bind(clipProcessed, true), std::bind(clipProcessed, false));
+        };
+        int loadJob = emit pCore->jobManager()->startJob<LoadJob>(batch, -1, QString(), std::move(createFn));
+        emit pCore->jobManager()->startJob<ThumbJob>(batch, loadJob, QString(), 0, true);
+        if (KdenliveSettings::audiothumbnails() && !audioBatch.empty()) {
+            emit pCore->jobManager()->startJob<AudioThumbJob>(audioBatch, loadJob, QString());
+        }
+    }
+    return true;
+}
+
 bool ProjectItemModel::requestAddBinClip(QString &id, const QDomElement &description, const QString &parentId, const QString &undoText)
 {
     QWriteLocker locker(&m_lock);
@@ -982,13 +1100,7 @@ bool ProjectItemModel::isIdFree(const QString &id) const
     if (id.isEmpty()) {
         return false;
     }
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->clipId() == id) {
-            return false;
-        }
-    }
-    return true;
+    return !m_binIdIndex.contains(id);
 }
 
 void ProjectItemModel::loadBinPlaylist(Mlt::Tractor *documentTractor, Mlt::Tractor *modelTractor, std::unordered_map<QString, QString> &binIdCorresp, QStringList &expandedFolders, QProgressDialog *progressDialog)
@@ -1135,6 +1247,54 @@ int ProjectItemModel::clipsCount() const
     return m_binPlaylist->count();
 }
 
+BinSearchIndex::Fields ProjectItemModel::searchFields(const std::shared_ptr<AbstractProjectItem> &item) const
+{
+    BinSearchIndex::Fields fields;
+    // Same content as the name, date and description columns that were searched by the view
+    QStringList text{item->name(), item->getData(AbstractProjectItem::DataDate).toDateTime().toString(Qt::ISODateWithMs), item->description()};
+    if (item->itemType() == AbstractProjectItem::ClipItem) {
+        for (const CommentedTime &marker : std::static_pointer_cast<ProjectClip>(item)->getMarkerModel()->getAllMarkers()) {
+            text << marker.comment();
+        }
+    }
+    fields.text = text.join(QLatin1Char('\n'));
+    fields.tags = item->tags();
+    fields.type = int(item->clipType());
+    fields.rating = int(item->rating());
+    return fields;
+}
+
+void ProjectItemModel::invalidateSearchItem(int itemId)
+{
+    QMutexLocker locker(&m_searchMutex);
+    m_searchDirty.insert(itemId);
+}
+
+std::unordered_set<int> ProjectItemModel::searchItems(const BinSearchIndex::Filter &filter)
+{
+    READ_LOCK();
+    QMutexLocker locker(&m_searchMutex);
+    for (int id : m_searchDirty) {
+        if (m_allItems.count(id) > 0) {
+            auto item = std::static_pointer_cast<AbstractProjectItem>(getItemById(id));
+            if (item != rootItem) {
+                m_searchIndex.setItem(id, searchFields(item));
+            }
+        }
+    }
+    m_searchDirty.clear();
+    std::unordered_set<int> result = m_searchIndex.match(filter);
+    // The folders and clips containing a match must stay visible to display it
+    std::vector<int> matches(result.begin(), result.end());
+    for (int id : matches) {
+        auto parent = getItemById(id)->parentItem().lock();
+        while (parent && parent != rootItem && result.insert(parent->getId()).second) {
+            parent = parent->parentItem().lock();
+        }
+    }
+    return result;
+}
+
 bool ProjectItemModel::validateClip(const QString &binId, const QString &clipHash)
 {
     QWriteLocker locker(&m_lock);
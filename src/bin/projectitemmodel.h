@@ -25,15 +25,19 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define PROJECTITEMMODEL_H
 
 #include "abstractmodel/abstracttreemodel.hpp"
+#include "binsearchindex.hpp"
 #include "definitions.h"
 #include "undohelper.hpp"
 #include <QDomElement>
 #include <QFileInfo>
+#include <QHash>
 #include <QIcon>
+#include <QMutex>
 #include <QReadWriteLock>
 #include <QSize>
 
 class AbstractProjectItem;
+class AudioLevelsStore;
 class BinPlaylist;
 class FileWatcher;
 class MarkerListModel;
@@ -67,8 +71,8 @@ public:
 
     /** @brief Returns a clip from the hierarchy, given its id */
     std::shared_ptr<ProjectClip> getClipByBinID(const QString &binId);
-    /** @brief Returns audio levels for a clip from its id */
-    const QVector <uint8_t>getAudioLevelsByBinID(const QString &binId, int stream);
+    /** @brief Returns the memory mapped audio levels of a clip stream, or nullptr if not available */
+    std::shared_ptr<AudioLevelsStore> getAudioLevelsStore(const QString &binId, int stream);
     double getAudioMaxLevel(const QString &binId);
 
     /** @brief Returns a list of clips using the given url */
@@ -162,6 +166,15 @@ public:
     bool requestAddBinClip(QString &id, const QDomElement &description, const QString &parentId, Fun &undo, Fun &redo,
                            const std::function<void(const QString &)> &readyCallBack = [](const QString &) {});
     bool requestAddBinClip(QString &id, const QDomElement &description, const QString &parentId, const QString &undoText = QString());
+    /* @brief Request creation of several bin clips in the same folder, as a single model insertion
+       The clips are then loaded by a few jobs that each hold a batch of clips, and the import throughput is reported when all are processed.
+       Each clip still gets its own producer: only the row insertion and the job bookkeeping are shared.
+       @param ids is filled with the bin ids of the created clips, in the order of the descriptions
+       @param descriptions Xml description of each clip
+       @param parentId Bin id of the parent folder
+       @param undo,redo: lambdas that are updated to accumulate operation.
+    */
+    bool requestAddBinClips(QStringList &ids, const QList<QDomElement> &descriptions, const QString &parentId, Fun &undo, Fun &redo);
 
     /* @brief This is the addition function when we already have a producer for the clip*/
     bool requestAddBinClip(QString &id, const std::shared_ptr<Mlt::Producer> &producer, const QString &parentId, Fun &undo, Fun &redo);
@@ -214,6 +227,11 @@ public:
     /** @brief Number of clips in the bin playlist */
     int clipsCount() const;
 
+    /** @brief Returns the ids of the items matching the filter, and of the folders and clips containing them */
+    std::unordered_set<int> searchItems(const BinSearchIndex::Filter &filter);
+    /** @brief Marks the searchable content of an item as changed, it is indexed again by the next search */
+    void invalidateSearchItem(int itemId);
+
 protected:
     /* @brief Register the existence of a new element
      */
@@ -226,6 +244,8 @@ protected:
 
     /* @brief Helper function to add a given item to the tree */
     bool addItem(const std::shared_ptr<AbstractProjectItem> &item, const QString &parentId, Fun &undo, Fun &redo);
+    /* @brief Helper function to add new clips to a folder with a single row insertion */
+    bool addItems(const std::vector<std::shared_ptr<AbstractProjectItem>> &items, const QString &parentId, Fun &undo, Fun &redo);
 
     /* @brief Function to be called when the url of a clip changes */
     void updateWatcher(const std::shared_ptr<ProjectClip> &item);
@@ -245,12 +265,26 @@ private:
     /** @brief Return reference to column specific data */
     int mapToColumn(int column) const;
 
+    /** @brief Returns the item with the given bin id, or nullptr. The caller must hold m_lock */
+    std::shared_ptr<AbstractProjectItem> findBinItem(const QString &binId) const;
+
+    /** @brief Reads the searchable content of an item */
+    BinSearchIndex::Fields searchFields(const std::shared_ptr<AbstractProjectItem> &item) const;
+
     mutable QReadWriteLock m_lock; // This is a lock that ensures safety in case of concurrent access
 
     std::unique_ptr<BinPlaylist> m_binPlaylist;
 
     std::unique_ptr<FileWatcher> m_fileWatcher;
 
+    /** @brief Tree item id of every registered item, indexed by bin id (clips, subclips and folders share one id space) */
+    QHash<QString, int> m_binIdIndex;
+
+    /** @brief Searchable content of the items. Changed items are only marked in m_searchDirty, and indexed again by the next search */
+    BinSearchIndex m_searchIndex;
+    std::unordered_set<int> m_searchDirty;
+    QMutex m_searchMutex;
+
     int m_nextId;
     QIcon m_blankThumb;
     PlaylistState::ClipState m_dragType;
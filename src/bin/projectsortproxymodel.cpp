@@ -21,13 +21,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "projectsortproxymodel.h"
 #include "abstractprojectitem.h"
+#include "projectitemmodel.h"
 
 #include <QItemSelectionModel>
 
 ProjectSortProxyModel::ProjectSortProxyModel(QObject *parent)
     : QSortFilterProxyModel(parent)
-    , m_searchType(0)
-    , m_searchRating(0)
 {
     m_collator.setLocale(QLocale()); // Locale used for sorting → OK
     m_collator.setCaseSensitivity(Qt::CaseInsensitive);
@@ -40,76 +39,53 @@ ProjectSortProxyModel::ProjectSortProxyModel(QObject *parent)
 // Responsible for item sorting!
 bool ProjectSortProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
 {
-    if (filterAcceptsRowItself(sourceRow, sourceParent)) {
+    if (m_filter.isEmpty()) {
         return true;
     }
-    // accept if any of the children is accepted on it's own merits
-    return hasAcceptedChildren(sourceRow, sourceParent);
+    // Matching items and their parents were computed in a single index query
+    QModelIndex index0 = sourceModel()->index(sourceRow, 0, sourceParent);
+    return index0.isValid() && m_accepted.count(int(index0.internalId())) > 0;
 }
 
-bool ProjectSortProxyModel::filterAcceptsRowItself(int sourceRow, const QModelIndex &sourceParent) const
+bool ProjectSortProxyModel::updateAcceptedItems()
 {
-    if (m_searchRating > 0) {
-        // Column 7 contains the rating
-        QModelIndex indexTag = sourceModel()->index(sourceRow, 7, sourceParent);
-        if (sourceModel()->data(indexTag).toInt() != m_searchRating) {
-            return false;
-        }
-    }
-    if (m_searchType > 0) {
-        // Column 3 contains the item type (video, image, title, etc)
-        QModelIndex indexTag = sourceModel()->index(sourceRow, 3, sourceParent);
-        if (sourceModel()->data(indexTag).toInt() != m_searchType) {
-            return false;
-        }
+    std::unordered_set<int> accepted;
+    auto *model = qobject_cast<ProjectItemModel *>(sourceModel());
+    if (!m_filter.isEmpty() && model) {
+        accepted = model->searchItems(m_filter);
     }
-    if (!m_searchTag.isEmpty()) {
-        // Column 4 contains the item tag data
-        QModelIndex indexTag = sourceModel()->index(sourceRow, 4, sourceParent);
-        auto tagData = sourceModel()->data(indexTag);
-        for (const QString &tag : m_searchTag) {
-            if (!tagData.toString().contains(tag, Qt::CaseInsensitive)) {
-                return false;
-            }
-        }
+    if (accepted == m_accepted) {
+        return false;
     }
+    m_accepted = std::move(accepted);
+    return true;
+}
 
-    for (int i = 0; i < 3; i++) {
-        QModelIndex index0 = sourceModel()->index(sourceRow, i, sourceParent);
-        if (!index0.isValid()) {
-            return false;
-        }
-        auto data = sourceModel()->data(index0);
-        if (data.toString().contains(m_searchString, Qt::CaseInsensitive)) {
-            return true;
-        }
+void ProjectSortProxyModel::onSourceChanged()
+{
+    if (!m_filter.isEmpty() && updateAcceptedItems()) {
+        invalidateFilter();
     }
-    return false;
 }
 
-bool ProjectSortProxyModel::hasAcceptedChildren(int sourceRow, const QModelIndex &source_parent) const
+void ProjectSortProxyModel::setSourceModel(QAbstractItemModel *model)
 {
-    QModelIndex item = sourceModel()->index(sourceRow, 0, source_parent);
-    if (!item.isValid()) {
-        return false;
+    for (const QMetaObject::Connection &connection : qAsConst(m_sourceConnections)) {
+        disconnect(connection);
     }
-
-    // check if there are children
-    int childCount = item.model()->rowCount(item);
-    if (childCount == 0) {
-        return false;
+    m_sourceConnections.clear();
+    QSortFilterProxyModel::setSourceModel(model);
+    if (!model) {
+        return;
     }
-
-    for (int i = 0; i < childCount; ++i) {
-        if (filterAcceptsRowItself(i, item)) {
-            return true;
+    m_sourceConnections << connect(model, &QAbstractItemModel::rowsInserted, this, &ProjectSortProxyModel::onSourceChanged);
+    m_sourceConnections << connect(model, &QAbstractItemModel::dataChanged, this, [this](const QModelIndex &, const QModelIndex &, const QVector<int> &roles) {
+        if (roles.isEmpty() || roles.contains(AbstractProjectItem::DataName) || roles.contains(AbstractProjectItem::DataDescription) ||
+            roles.contains(AbstractProjectItem::DataTag) || roles.contains(AbstractProjectItem::DataRating) ||
+            roles.contains(AbstractProjectItem::ClipType) || roles.contains(AbstractProjectItem::DataDate)) {
+            onSourceChanged();
         }
-        // recursive call -> NOTICE that this is depth-first searching, you're probably better off with breadth first search...
-        if (hasAcceptedChildren(i, item)) {
-            return true;
-        }
-    }
-    return false;
+    });
 }
 
 bool ProjectSortProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
@@ -142,23 +118,26 @@ QItemSelectionModel *ProjectSortProxyModel::selectionModel()
 
 void ProjectSortProxyModel::slotSetSearchString(const QString &str)
 {
-    m_searchString = str;
+    m_filter.search = str;
+    updateAcceptedItems();
     invalidateFilter();
 }
 
 void ProjectSortProxyModel::slotSetFilters(const QStringList tagFilters, const int rateFilters, const int typeFilters)
 {
-    m_searchType = typeFilters;
-    m_searchRating = rateFilters;
-    m_searchTag = tagFilters;
+    m_filter.type = typeFilters;
+    m_filter.rating = rateFilters;
+    m_filter.tags = tagFilters;
+    updateAcceptedItems();
     invalidateFilter();
 }
 
 void ProjectSortProxyModel::slotClearSearchFilters()
 {
-    m_searchTag.clear();
-    m_searchRating = 0;
-    m_searchType = 0;
+    m_filter.tags.clear();
+    m_filter.rating = 0;
+    m_filter.type = 0;
+    updateAcceptedItems();
     invalidateFilter();
 }
 
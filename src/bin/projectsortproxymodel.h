@@ -22,8 +22,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef PROJECTSORTPROXYMODEL_H
 #define PROJECTSORTPROXYMODEL_H
 
+#include "binsearchindex.hpp"
 #include <QCollator>
 #include <QSortFilterProxyModel>
+#include <unordered_set>
 
 class QItemSelectionModel;
 
@@ -39,6 +41,8 @@ class ProjectSortProxyModel : public QSortFilterProxyModel
 public:
     explicit ProjectSortProxyModel(QObject *parent = nullptr);
     QItemSelectionModel *selectionModel();
+    /** @brief Reimplemented to update the filter results when the searched content changes */
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
 
 public slots:
     /** @brief Set search string that will filter the view */
@@ -62,15 +66,18 @@ protected:
     bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
     /** @brief Reimplemented to show folders first  */
     bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
-    bool filterAcceptsRowItself(int source_row, const QModelIndex &source_parent) const;
-    bool hasAcceptedChildren(int source_row, const QModelIndex &source_parent) const;
 
 private:
+    /** @brief Queries the bin search index for the current filter. Returns true if the accepted items changed */
+    bool updateAcceptedItems();
+    /** @brief Called when the source model content changes, filters again if the search results changed */
+    void onSourceChanged();
+
     QItemSelectionModel *m_selection;
-    QString m_searchString;
-    QStringList m_searchTag;
-    int m_searchType;
-    int m_searchRating;
+    BinSearchIndex::Filter m_filter;
+    /** @brief Tree item ids of the items to display when a filter is set */
+    std::unordered_set<int> m_accepted;
+    QList<QMetaObject::Connection> m_sourceConnections;
     QCollator m_collator;
 
 signals:
@@ -29,6 +29,7 @@ the Free Software Foundation, either version 3 of the License, or
 #include "timeline2/model/timelineitemmodel.hpp"
 #include "timeline2/view/timelinecontroller.h"
 #include "timeline2/view/timelinewidget.h"
+#include "utils/filehasher.hpp"
 #include <mlt++/MltRepository.h>
 
 #include <KMessageBox>
@@ -43,8 +44,7 @@ the Free Software Foundation, either version 3 of the License, or
 
 std::unique_ptr<Core> Core::m_self;
 Core::Core()
-    : audioThumbCache(QStringLiteral("audioCache"), 2000000)
-    , m_thumbProfile(nullptr)
+    : m_thumbProfile(nullptr)
     , m_capture(new MediaCapture(this))
 {
 }
@@ -782,6 +782,7 @@ const QString Core::actionText(const QString &name)
 
 void Core::clean()
 {
+    FileHasher::get()->save();
     m_self.reset();
 }
 
@@ -20,7 +20,6 @@ the Free Software Foundation, either version 3 of the License, or
 #include <QUrl>
 #include <memory>
 #include <QPoint>
-#include <KSharedDataCache>
 #include <unordered_set>
 #include "timecode.h"
 
@@ -232,8 +231,6 @@ public:
     void addGuides(QList <int> guides);
     /** @brief Temporarily un/plug a list of clips in timeline. */
     void temporaryUnplug(QList<int> clipIds, bool hide);
-    
-    KSharedDataCache audioThumbCache;
 
 private:
     explicit Core();
@@ -24,6 +24,7 @@
 #include "kthumb.h"
 #include "titler/titlewidget.h"
 #include "bin/projectclip.h"
+#include "utils/filehasher.hpp"
 
 #include <KMessageBox>
 #include <KRecentDirs>
@@ -31,7 +32,6 @@
 #include <klocalizedstring.h>
 
 #include "kdenlive_debug.h"
-#include <QCryptographicHash>
 #include <QFile>
 #include <QFileDialog>
 #include <QFontDatabase>
@@ -149,6 +149,9 @@ bool DocumentChecker::hasErrorInClips()
     max = documentProducers.count();
     QStringList verifiedPaths;
     QStringList missingPaths;
+    // Clips whose file hash must be verified, with their resource
+    QList<QDomElement> hashedClips;
+    QStringList hashedPaths;
     QStringList serviceToCheck;
     serviceToCheck << QStringLiteral("kdenlivetitle") << QStringLiteral("qimage") << QStringLiteral("pixbuf") << QStringLiteral("timewarp")
                    << QStringLiteral("framebuffer") << QStringLiteral("xml") << QStringLiteral("qtext");
@@ -332,16 +335,16 @@ bool DocumentChecker::hasErrorInClips()
             // Check if file changed
             const QByteArray hash = Xml::getXmlProperty(e, "kdenlive:file_hash").toLatin1();
             if (!hash.isEmpty()) {
-                const QByteArray fileData = slideshow ? ProjectClip::getFolderHash(QDir(resource)).toHex() : ProjectClip::calculateHash(resource).first.toHex();
-                if (hash != fileData) {
+                if (slideshow) {
                     // For slideshow clips, silently upgrade hash
-                    if (slideshow) {
+                    const QByteArray fileData = ProjectClip::getFolderHash(QDir(resource)).toHex();
+                    if (hash != fileData) {
                         Xml::setXmlProperty(e, "kdenlive:file_hash", fileData);
-                    } else {
-                        // Clip was changed, notify and trigger clip reload
-                        Xml::removeXmlProperty(e, "kdenlive:file_hash");
-                        m_changedClips.append(resource);
                     }
+                } else {
+                    // Files are hashed together once all clips are known
+                    hashedClips.append(e);
+                    hashedPaths.append(resource);
                 }
             }
         }
@@ -349,6 +352,17 @@ bool DocumentChecker::hasErrorInClips()
         verifiedPaths.append(resource);
     }
 
+    // Check if files changed, reading them in parallel. Unchanged files are not read again
+    const std::vector<FileHasher::Result> hashes = FileHasher::get()->hashFiles(hashedPaths);
+    for (int i = 0; i < hashedClips.count(); ++i) {
+        QDomElement e = hashedClips.at(i);
+        if (Xml::getXmlProperty(e, "kdenlive:file_hash").toLatin1() != hashes.at(size_t(i)).hash.toHex()) {
+            // Clip was changed, notify and trigger clip reload
+            Xml::removeXmlProperty(e, "kdenlive:file_hash");
+            m_changedClips.append(hashedPaths.at(i));
+        }
+    }
+
     // Get list of used Luma files
     QStringList missingLumas;
     QStringList filesToCheck;
@@ -1057,7 +1071,6 @@ QString DocumentChecker::searchFileRecursively(const QDir &dir, const QString &m
         return searchPathRecursively(dir, QUrl::fromLocalFile(fileName).fileName());
     }
     QString foundFileName;
-    QByteArray fileData;
     QByteArray fileHash;
     QStringList filesAndDirs = dir.entryList(QDir::Files | QDir::Readable);
     for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
@@ -1067,24 +1080,9 @@ QString DocumentChecker::searchFileRecursively(const QDir &dir, const QString &m
         }
         QFile file(dir.absoluteFilePath(filesAndDirs.at(i)));
         if (QString::number(file.size()) == matchSize) {
-            if (file.open(QIODevice::ReadOnly)) {
-                /*
-                 * 1 MB = 1 second per 450 files (or faster)
-                 * 10 MB = 9 seconds per 450 files (or faster)
-                 */
-                if (file.size() > 1000000 * 2) {
-                    fileData = file.read(1000000);
-                    if (file.seek(file.size() - 1000000)) {
-                        fileData.append(file.readAll());
-                    }
-                } else {
-                    fileData = file.readAll();
-                }
-                file.close();
-                fileHash = QCryptographicHash::hash(fileData, QCryptographicHash::Md5);
-                if (QString::fromLatin1(fileHash.toHex()) == matchHash) {
-                    return file.fileName();
-                }
+            fileHash = FileHasher::get()->hash(file.fileName()).hash;
+            if (QString::fromLatin1(fileHash.toHex()) == matchHash) {
+                return file.fileName();
             }
         }
         ////qCDebug(KDENLIVE_LOG) << filesAndDirs.at(i) << file.size() << fileHash.toHex();
@@ -40,6 +40,7 @@
 #include "project/projectcommands.h"
 #include "titler/titlewidget.h"
 #include "transitions/transitionsrepository.hpp"
+#include "utils/filehasher.hpp"
 
 #include <config-kdenlive.h>
 
@@ -52,12 +53,12 @@
 #include <klocalizedstring.h>
 
 #include "kdenlive_debug.h"
-#include <QCryptographicHash>
 #include <QDomImplementation>
 #include <QFile>
 #include <QFileDialog>
 #include <QUndoGroup>
 #include <QUndoStack>
+#include <QtConcurrent>
 
 #include <KJobWidgets/KJobWidgets>
 #include <QStandardPaths>
@@ -292,6 +293,7 @@ KdenliveDoc::~KdenliveDoc()
     // Clean up guide model
     m_guideModel.reset();
     // qCDebug(KDENLIVE_LOG) << "// DEL CLP MAN done";
+    m_autosaveWrite.waitForFinished();
     if (m_autosave) {
         if (!m_autosave->fileName().isEmpty()) {
             m_autosave->remove();
@@ -449,14 +451,25 @@ void KdenliveDoc::slotAutoSave(const QString &scene)
             KMessageBox::error(QApplication::activeWindow(), i18n("Cannot write to file %1, scene list is corrupted.", m_autosave->fileName()));
             return;
         }
-        m_autosave->resize(0);
-        if (m_autosave->write(scene.toUtf8()) < 0) {
-            pCore->displayMessage(i18n("Cannot create autosave file %1", m_autosave->fileName()), ErrorMessage);
-        };
-        m_autosave->flush();
+        // Only one write at a time so that an older scene never overwrites a newer one
+        m_autosaveWrite.waitForFinished();
+        // The worker writes through its own file handle, m_autosave is only used on this thread
+        const QString fileName = m_autosave->fileName();
+        const QByteArray data = scene.toUtf8();
+        m_autosaveWrite = QtConcurrent::run([fileName, data]() {
+            QFile file(fileName);
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(data) < 0) {
+                pCore->displayMessage(i18n("Cannot create autosave file %1", fileName), ErrorMessage);
+            }
+        });
     }
 }
 
+void KdenliveDoc::flushAutoSave()
+{
+    m_autosaveWrite.waitForFinished();
+}
+
 void KdenliveDoc::setZoom(int horizontal, int vertical)
 {
     m_documentProperties[QStringLiteral("zoom")] = QString::number(horizontal);
@@ -792,32 +805,16 @@ const QString KdenliveDoc::description() const
 QString KdenliveDoc::searchFileRecursively(const QDir &dir, const QString &matchSize, const QString &matchHash) const
 {
     QString foundFileName;
-    QByteArray fileData;
     QByteArray fileHash;
     QStringList filesAndDirs = dir.entryList(QDir::Files | QDir::Readable);
     for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
         QFile file(dir.absoluteFilePath(filesAndDirs.at(i)));
-        if (file.open(QIODevice::ReadOnly)) {
-            if (QString::number(file.size()) == matchSize) {
-                /*
-                 * 1 MB = 1 second per 450 files (or faster)
-                 * 10 MB = 9 seconds per 450 files (or faster)
-                 */
-                if (file.size() > 1000000 * 2) {
-                    fileData = file.read(1000000);
-                    if (file.seek(file.size() - 1000000)) {
-                        fileData.append(file.readAll());
-                    }
-                } else {
-                    fileData = file.readAll();
-                }
-                file.close();
-                fileHash = QCryptographicHash::hash(fileData, QCryptographicHash::Md5);
-                if (QString::fromLatin1(fileHash.toHex()) == matchHash) {
-                    return file.fileName();
-                }
-                qCDebug(KDENLIVE_LOG) << filesAndDirs.at(i) << "size match but not hash";
+        if (QString::number(file.size()) == matchSize) {
+            fileHash = FileHasher::get()->hash(file.fileName()).hash;
+            if (QString::fromLatin1(fileHash.toHex()) == matchHash) {
+                return file.fileName();
             }
+            qCDebug(KDENLIVE_LOG) << filesAndDirs.at(i) << "size match but not hash";
         }
         ////qCDebug(KDENLIVE_LOG) << filesAndDirs.at(i) << file.size() << fileHash.toHex();
     }
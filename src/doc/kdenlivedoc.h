@@ -27,6 +27,7 @@
 
 #include <QAction>
 #include <QDir>
+#include <QFuture>
 #include <QList>
 #include <QMap>
 #include <memory>
@@ -68,6 +69,8 @@ public:
     int height() const;
     QUrl url() const;
     KAutoSaveFile *m_autosave;
+    /** @brief Wait until the pending autosave write is on disk */
+    void flushAutoSave();
     Timecode timecode() const;
     std::shared_ptr<DocUndoStack> commandStack();
 
@@ -176,6 +179,8 @@ private:
     QString m_documentRoot;
     Timecode m_timecode;
     std::shared_ptr<DocUndoStack> m_commandStack;
+    /** @brief Autosave file write running in a background thread */
+    QFuture<void> m_autosaveWrite;
     QString m_searchFolder;
 
     /** @brief Tells whether the current document has been changed after being saved. */
@@ -228,7 +233,7 @@ public slots:
     void slotProxyCurrentItem(bool doProxy, QList<std::shared_ptr<ProjectClip>> clipList = QList<std::shared_ptr<ProjectClip>>(), bool force = false,
                               QUndoCommand *masterCommand = nullptr);
     /** @brief Saves the current project at the autosave location.
-     * @description The autosave files are in ~/.kde/data/stalefiles/kdenlive/ */
+     * @description The autosave files are in ~/.kde/data/stalefiles/kdenlive/, the file is written in a background thread */
     void slotAutoSave(const QString &scene);
     /** @brief Groups were changed, save to MLT. */
     void groupsChanged(const QString &groups);
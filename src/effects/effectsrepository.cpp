@@ -66,12 +66,8 @@ Mlt::Properties *EffectsRepository::getMetadata(const QString &effectId) const
     return pCore->getMltRepository()->metadata(filter_type, effectId.toLatin1().data());
 }
 
-void EffectsRepository::parseCustomAssetFile(const QString &file_name, std::unordered_map<QString, Info> &customAssets) const
+void EffectsRepository::parseCustomAssetDocument(const QString &file_name, QDomDocument &doc, std::unordered_map<QString, Info> &customAssets) const
 {
-    QFile file(file_name);
-    QDomDocument doc;
-    doc.setContent(&file, false);
-    file.close();
     QDomElement base = doc.documentElement();
     if (base.tagName() == QLatin1String("effectgroup")) {
         QDomNodeList effects = base.elementsByTagName(QStringLiteral("effect"));
@@ -168,7 +164,6 @@ void EffectsRepository::parseCustomAssetFile(const QString &file_name, std::unor
                 if (effectFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
                     effectFile.write(doc.toString().toUtf8());
                 }
-                file.close();
             }
         }
         customAssets[result.id] = result;
@@ -205,6 +200,11 @@ QString EffectsRepository::assetPreferredListPath() const
     return QStringLiteral(":data/preferred_effects.txt");
 }
 
+QString EffectsRepository::assetCacheName() const
+{
+    return QStringLiteral("effects");
+}
+
 bool EffectsRepository::isPreferred(const QString &effectId) const
 {
     return m_preferred_list.contains(effectId);
@@ -68,7 +68,7 @@ protected:
     /* @brief Retrieves additional info about effects from a custom XML file
        The resulting assets are stored in customAssets
     */
-    void parseCustomAssetFile(const QString &file_name, std::unordered_map<QString, Info> &customAssets) const override;
+    void parseCustomAssetDocument(const QString &file_name, QDomDocument &doc, std::unordered_map<QString, Info> &customAssets) const override;
 
     /* @brief Returns the path to the effects' blacklist*/
     QString assetBlackListPath() const override;
@@ -76,6 +76,9 @@ protected:
     /* @brief Returns the path to the effects' preferred list*/
     QString assetPreferredListPath() const override;
 
+    /* @brief Returns the name of the catalog cache file*/
+    QString assetCacheName() const override;
+
     QStringList assetDirs() const override;
 
     void parseType(QScopedPointer<Mlt::Properties> &metadata, Info &res) override;
@@ -27,11 +27,11 @@
 #include "doc/kthumb.h"
 #include "kdenlivesettings.h"
 #include "klocalizedstring.h"
+#include "lib/audio/audioLevelsBuilder.h"
 #include "lib/audio/audioStreamInfo.h"
 #include "macros.hpp"
 #include "utils/thumbnailcache.hpp"
 #include <QScopedPointer>
-#include <QTemporaryFile>
 #include <QProcess>
 #include <memory>
 #include <mlt++/MltProducer.h>
@@ -49,7 +49,7 @@ const QString AudioThumbJob::getDescription() const
 
 bool AudioThumbJob::computeWithMlt()
 {
-    m_audioLevels.clear();
+    m_levels.reset();
     m_errorMessage.clear();
     // MLT audio thumbs: slower but safer
     QString service = m_prod->get("mlt_service");
@@ -66,22 +66,14 @@ bool AudioThumbJob::computeWithMlt()
     audioProducer->set("video_index", "-1");
     Mlt::Filter chans(*m_prod->profile(), "audiochannels");
     Mlt::Filter converter(*m_prod->profile(), "audioconvert");
-    Mlt::Filter levels(*m_prod->profile(), "audiolevel");
     audioProducer->attach(chans);
     audioProducer->attach(converter);
-    audioProducer->attach(levels);
 
     int last_val = 0;
     double framesPerSecond = audioProducer->get_fps();
-    mlt_audio_format audioFormat = mlt_audio_s16;
-    QStringList keys;
-    keys.reserve(m_channels);
-    for (int i = 0; i < m_channels; i++) {
-        keys << "meta.media.audio_level." + QString::number(i);
-    }
-    double maxLevel = 1;
-    QVector <double> mltLevels;
-    for (int z = 0; z < m_lengthInFrames; ++z) {
+    // Levels are computed directly from the decoded samples, one frame at a time
+    m_levels.reset(new AudioLevelsBuilder(m_channels));
+    for (int z = 0; z < m_lengthInFrames && m_successful; ++z) {
         int val = (int)(100.0 * z / m_lengthInFrames);
         if (last_val != val) {
             emit jobProgress(val);
@@ -89,22 +81,17 @@ bool AudioThumbJob::computeWithMlt()
         }
         QScopedPointer<Mlt::Frame> mltFrame(audioProducer->get_frame());
         if ((mltFrame != nullptr) && mltFrame->is_valid() && (mltFrame->get_int("test_audio") == 0)) {
+            mlt_audio_format audioFormat = mlt_audio_s16;
+            int frequency = m_frequency;
+            int channels = m_channels;
             int samples = mlt_sample_calculator(float(framesPerSecond), m_frequency, z);
-            mltFrame->get_audio(audioFormat, m_frequency, m_channels, samples);
-            for (int channel = 0; channel < m_channels; ++channel) {
-                double lev = mltFrame->get_double(keys.at(channel).toUtf8().constData());
-                mltLevels << lev;
-                maxLevel = qMax(lev, maxLevel);
-            }
-        } else if (!mltLevels.isEmpty()) {
-            for (int channel = 0; channel < m_channels; channel++) {
-                mltLevels << mltLevels.last();
+            const auto *pcm = static_cast<const int16_t *>(mltFrame->get_audio(audioFormat, frequency, channels, samples));
+            if (pcm != nullptr && audioFormat == mlt_audio_s16 && channels == m_channels && samples > 0) {
+                m_levels->addFrame(pcm, samples);
+                continue;
             }
         }
-    }
-    // Normalize
-    for (double &v : mltLevels) {
-        m_audioLevels << 255 * v / maxLevel;
+        m_levels->repeatFrame();
     }
 
     m_done = true;
@@ -127,168 +114,72 @@ bool AudioThumbJob::computeWithFFMPEG()
 
     int audioStreamIndex = m_binClip->getAudioStreamFfmpegIndex(m_audioStream);
     if (!QFile::exists(m_cachePath) && !m_dataInCache) {
-        // Generate timeline audio thumbnail data
-        m_audioLevels.clear();
-        std::vector<std::unique_ptr<QTemporaryFile>> channelFiles;
-        for (int i = 0; i < m_channels; i++) {
-            std::unique_ptr<QTemporaryFile> channelTmpfile(new QTemporaryFile());
-            if (!channelTmpfile->open()) {
-                m_errorMessage.append(i18n("Audio thumbs: cannot create temporary file, check disk space and permissions\n"));
-                return false;
-            }
-            channelTmpfile->close();
-            channelFiles.emplace_back(std::move(channelTmpfile));
-        }
-        // Always create audio thumbs from the original source file, because proxy 
-        // can have a different audio config (channels / mono/ stereo)
-        QStringList args {QStringLiteral("-hide_banner"), QStringLiteral("-i"), QUrl::fromLocalFile(filePath).toLocalFile(), QStringLiteral("-progress")};
-#ifdef Q_OS_WIN
-        args << QStringLiteral("-");
-#else
-        args << QStringLiteral("/dev/stdout");
-#endif
+        // Generate timeline audio thumbnail data. Decoded samples are read from FFmpeg's output
+        // in fixed size blocks and reduced on the fly, so nothing proportional to the clip length is written
+        m_levels.reset();
         bool isFFmpeg = KdenliveSettings::ffmpegpath().contains(QLatin1String("ffmpeg"));
-        args << QStringLiteral("-filter_complex");
-        if (m_channels == 1) {
-            if (m_audioStream >= 0) {
-                args << QStringLiteral("[a:%1]aformat=channel_layouts=mono,%2=100").arg(audioStreamIndex).arg(isFFmpeg ? "aresample=1500:async" : "sample_rates");
-            } else {
-                args << QStringLiteral("[a]aformat=channel_layouts=mono,%1=100").arg(isFFmpeg ? "aresample=1500:async" : "sample_rates");
-            }
-            /*args << QStringLiteral("-map") << QStringLiteral("0:a%1").arg(m_audioStream > 0 ? ":" + QString::number(audioStreamIndex) : QString())*/
-            args << QStringLiteral("-c:a") << QStringLiteral("pcm_s16le") << QStringLiteral("-frames:v") 
-             << QStringLiteral("1") << QStringLiteral("-y") << QStringLiteral("-f") << QStringLiteral("data")
-             << channelFiles[0]->fileName();
-        } else {
-            QString aformat = QStringLiteral("[a%1]%2=100,channelsplit=channel_layout=%3")
-                              .arg(audioStreamIndex >= 0 ? ":" + QString::number(audioStreamIndex) : QString(),
-                                   isFFmpeg ? "aresample=1500:async" : "aformat=sample_rates",
-                                   m_channels > 2 ? "5.1" : "stereo");
-            for (int i = 0; i < m_channels; ++i) {
-                aformat.append(QStringLiteral("[0:%1]").arg(i));
-            }
-            args << aformat;
-            args << QStringLiteral("-frames:v") << QStringLiteral("1");
-            for (int i = 0; i < m_channels; i++) {
-                // Channel 1
-                args << QStringLiteral("-map") << QStringLiteral("[0:%1]").arg(i) << QStringLiteral("-c:a") << QStringLiteral("pcm_s16le") << QStringLiteral("-y")
-                 << QStringLiteral("-f") << QStringLiteral("data") << channelFiles[size_t(i)]->fileName();
-            }
+        const int sampleRate = isFFmpeg ? 1500 : 100;
+        // Always create audio thumbs from the original source file, because proxy
+        // can have a different audio config (channels / mono/ stereo)
+        QStringList args {QStringLiteral("-hide_banner"), QStringLiteral("-loglevel"), QStringLiteral("error"), QStringLiteral("-i"),
+                          QUrl::fromLocalFile(filePath).toLocalFile(), QStringLiteral("-vn")};
+        if (audioStreamIndex >= 0) {
+            args << QStringLiteral("-map") << QStringLiteral("0:a:%1").arg(audioStreamIndex);
         }
+        args << QStringLiteral("-af")
+             << (isFFmpeg ? QStringLiteral("aresample=%1:async=100") : QStringLiteral("aformat=sample_rates=%1")).arg(sampleRate);
+        args << QStringLiteral("-ac") << QString::number(m_channels) << QStringLiteral("-c:a") << QStringLiteral("pcm_s16le") << QStringLiteral("-f")
+             << QStringLiteral("s16le") << QStringLiteral("-");
         m_ffmpegProcess.reset(new QProcess);
-        connect(m_ffmpegProcess.get(), &QProcess::readyReadStandardOutput, this, &AudioThumbJob::updateFfmpegProgress, Qt::UniqueConnection);
-        connect(this, &AudioThumbJob::jobCanceled, [&]() {
-            if (m_ffmpegProcess) {
-                disconnect(m_ffmpegProcess.get(), &QProcess::readyReadStandardOutput, this, &AudioThumbJob::updateFfmpegProgress);
-                m_ffmpegProcess->kill();
-            }
-            m_audioLevels.clear();
-            m_done = true;
-            m_successful = false;
-        });
+        m_ffmpegProcess->setReadChannel(QProcess::StandardOutput);
         m_ffmpegProcess->start(KdenliveSettings::ffmpegpath(), args);
-        m_ffmpegProcess->waitForFinished(-1);
-        disconnect(m_ffmpegProcess.get(), &QProcess::readyReadStandardOutput, this, &AudioThumbJob::updateFfmpegProgress);
-        if (m_successful && m_ffmpegProcess->exitStatus() != QProcess::CrashExit) {
-            int dataSize = 0;
-            std::vector<const qint16 *> rawChannels;
-            std::vector<QByteArray> sourceChannels;
-            for (auto &channelFile : channelFiles) {
-                channelFile->open();
-                sourceChannels.emplace_back(channelFile->readAll());
-                QByteArray &res = sourceChannels.back();
-                channelFile->close();
-                if (dataSize == 0) {
-                    dataSize = res.size();
-                }
-                if (res.isEmpty() || res.size() != dataSize) {
-                    // Something went wrong, abort
-                    m_errorMessage.append(i18n("Audio thumbs: error reading audio thumbnail created with FFmpeg\n"));
-                    return false;
-                }
-                rawChannels.emplace_back(reinterpret_cast<const qint16 *>(res.constData()));
-            }
-            int progress = 0;
-            std::vector<long> channelsData;
-            double offset = (double)dataSize / (2.0 * m_lengthInFrames);
-            int intraOffset = 1;
-            if (offset > 1000) {
-                intraOffset = offset / 60;
-            } else if (offset > 250) {
-                intraOffset = offset / 10;
-            }
-
-            long maxAudioLevel = 1;
-            if (!m_successful) {
-                m_done = true;
-                return true;
-            }
-            std::vector <long> ffmpegLevels;
-            for (int i = 0; i < m_lengthInFrames; i++) {
-                channelsData.resize((size_t)rawChannels.size());
-                std::fill(channelsData.begin(), channelsData.end(), 0);
-                int pos = (int)(i * offset);
-                int steps = 0;
-                for (int j = 0; j < (int)offset && (pos + j < dataSize); j += intraOffset) {
-                    steps++;
-                    for (size_t k = 0; k < rawChannels.size(); k++) {
-                        channelsData[k] += abs(rawChannels[k][pos + j]);
-                    }
-                }
-                steps = qMax(steps, 1);
-                for (long &k : channelsData) {
-                    if (!m_successful) {
-                        break;
-                    }
-                    k /= steps;
-                    maxAudioLevel = qMax(k, maxAudioLevel);
-                }
-                
-                int p = 80 + (i * 20 / m_lengthInFrames);
-                if (p != progress) {
-                    emit jobProgress(p);
-                    progress = p;
+        if (!m_ffmpegProcess->waitForStarted()) {
+            qWarning() << "Failed to start FFmpeg for audio thumbs";
+            return false;
+        }
+        m_levels.reset(new AudioLevelsBuilder(m_channels, sampleRate / m_prod->get_fps()));
+        const int sampleBytes = 2 * m_channels;
+        const qint64 blockSize = sampleBytes * 8192;
+        QByteArray pending;
+        int progress = 0;
+        while (m_successful) {
+            if (m_ffmpegProcess->bytesAvailable() == 0 && !m_ffmpegProcess->waitForReadyRead(500)) {
+                if (m_ffmpegProcess->state() == QProcess::NotRunning) {
+                    break;
                 }
-                ffmpegLevels.insert(ffmpegLevels.end(), channelsData.begin(), channelsData.end());
+                continue;
             }
-            if (!m_successful) {
-                m_done = true;
-                return true;
-            }
-            for (long &v : ffmpegLevels) {
-                m_audioLevels << (uint8_t) (255 * v / maxAudioLevel);
+            // Keep the incomplete sample of the previous block
+            QByteArray block = pending + m_ffmpegProcess->read(blockSize);
+            int count = block.size() / sampleBytes;
+            m_levels->addSamples(reinterpret_cast<const int16_t *>(block.constData()), count);
+            pending = block.mid(count * sampleBytes);
+            int p = qMin(99, (int)(100. * m_levels->frameCount() / qMax(1, m_lengthInFrames)));
+            if (p != progress) {
+                emit jobProgress(p);
+                progress = p;
             }
+        }
+        if (!m_successful) {
             m_done = true;
             return true;
-        } else if (m_ffmpegProcess) {
-            QString err = m_ffmpegProcess->readAllStandardError();
-            // m_errorMessage += err;
-            // m_errorMessage.append(i18n("Failed to create FFmpeg audio thumbnails, we now try to use MLT"));
-            qWarning() << "Failed to create FFmpeg audio thumbs:\n" << err << "\n---------------------";
         }
+        m_ffmpegProcess->waitForFinished(-1);
+        m_levels->finish();
+        if (m_ffmpegProcess->exitStatus() != QProcess::CrashExit && m_ffmpegProcess->exitCode() == 0 && m_levels->frameCount() > 0) {
+            m_done = true;
+            return true;
+        }
+        QString err = m_ffmpegProcess->readAllStandardError();
+        m_logDetails += err;
+        m_levels.reset();
+        qWarning() << "Failed to create FFmpeg audio thumbs:\n" << err << "\n---------------------";
     } else {
         m_done = true;
     }
     return m_done;
 }
 
-void AudioThumbJob::updateFfmpegProgress()
-{
-    if (m_ffmpegProcess == nullptr) {
-        return;
-    }
-    const QString result = m_ffmpegProcess->readAllStandardOutput();
-    const QStringList lines = result.split(QLatin1Char('\n'));
-    for (const QString &data : lines) {
-        if (data.startsWith(QStringLiteral("out_time_ms"))) {
-            double ms = data.section(QLatin1Char('='), 1).toDouble();
-            emit jobProgress((int)(ms / m_binClip->duration().ms() / 10));
-        } else {
-            m_logDetails += data + QStringLiteral("\n");
-        }
-    }
-}
-
 bool AudioThumbJob::startJob()
 {
     if (m_done) {
@@ -326,6 +217,13 @@ bool AudioThumbJob::startJob()
     m_channels = m_binClip->audioInfo()->channels();
     m_channels = m_channels <= 0 ? 2 : m_channels;
 
+    connect(this, &AudioThumbJob::jobCanceled, [&]() {
+        if (m_ffmpegProcess) {
+            m_ffmpegProcess->kill();
+        }
+        m_done = true;
+        m_successful = false;
+    });
     QMap <int, QString> streams = m_binClip->audioInfo()->streams();
     QMap <int, int> audioChannels = m_binClip->audioInfo()->streamChannels();
     QMapIterator<int, QString> st(streams);
@@ -357,33 +255,17 @@ bool AudioThumbJob::startJob()
         if (!m_successful) {
             // Job was aborted
             m_done = true;
-            m_audioLevels.clear();
+            m_levels.reset();
             return false;
         }
 
-        if (ok && !QFile::exists(m_cachePath) && m_done && !m_audioLevels.isEmpty()) {
-            // Put into an image for caching.
-            int count = m_audioLevels.size();
-            QImage image((int)lrint((count + 3) / 4.0 / m_channels), m_channels, QImage::Format_ARGB32);
-            int n = image.width() * image.height();
-            for (int i = 0; i < n; i++) {
-                QRgb p;
-                if ((4 * i + 3) < count) {
-                    p = qRgba(m_audioLevels.at(4 * i), m_audioLevels.at(4 * i + 1), m_audioLevels.at(4 * i + 2),
-                          m_audioLevels.at(4 * i + 3));
-                } else {
-                    int last = m_audioLevels.last();
-                    int r = (4 * i + 0) < count ? m_audioLevels.at(4 * i + 0) : last;
-                    int g = (4 * i + 1) < count ? m_audioLevels.at(4 * i + 1) : last;
-                    int b = (4 * i + 2) < count ? m_audioLevels.at(4 * i + 2) : last;
-                    int a = last;
-                    p = qRgba(r, g, b, a);
-                }
-                image.setPixel(i / m_channels, i % m_channels, p);
+        if (ok && !QFile::exists(m_cachePath) && m_done && m_levels && m_levels->frameCount() > 0) {
+            // Store the levels in the memory mapped cache file
+            if (!m_levels->write(m_cachePath)) {
+                qWarning() << "Cannot save audio thumbnail data" << m_cachePath;
             }
-            image.save(m_cachePath);
         }
-        m_audioLevels.clear();
+        m_levels.reset();
     }
     if (m_done || !KdenliveSettings::audiothumbnails()) {
         m_successful = true;
@@ -29,6 +29,7 @@
 /* @brief This class represents the job that corresponds to computing the audio thumb of a clip (waveform)
  */
 
+class AudioLevelsBuilder;
 class ProjectClip;
 namespace Mlt {
 class Producer;
@@ -58,9 +59,6 @@ protected:
     // MLT audio thumbs: slower but safer
     bool computeWithMlt();
 
-    // process the stdout/stderr from ffmpeg
-    void updateFfmpegProgress();
-
 private:
     std::shared_ptr<ProjectClip> m_binClip;
     std::shared_ptr<Mlt::Producer> m_prod;
@@ -69,6 +67,7 @@ private:
     bool m_thumbInCache;
     bool m_done{false}, m_successful{false};
     int m_channels, m_frequency, m_lengthInFrames, m_audioStream;
-    QVector <uint8_t>m_audioLevels;
+    /** @brief Per frame peak and RMS levels of the stream being processed */
+    std::unique_ptr<AudioLevelsBuilder> m_levels;
     std::unique_ptr<QProcess> m_ffmpegProcess;
 };
@@ -24,16 +24,15 @@
 #include "bin/projectitemmodel.h"
 #include "bin/projectsubclip.h"
 #include "core.h"
-#include "doc/kthumb.h"
 #include "klocalizedstring.h"
 #include "macros.hpp"
 #include "utils/thumbnailcache.hpp"
-#include <mlt++/MltProducer.h>
+#include "utils/thumbnailextractor.hpp"
+#include <mlt++/MltProfile.h>
 
 #include <set>
 
 #include <QImage>
-#include <QScopedPointer>
 #include <QThread>
 #include <QtConcurrent>
 
@@ -82,11 +81,6 @@ bool CacheJob::startJob()
         m_done = true;
         return true;
     }
-    m_prod = m_binClip->thumbProducer();
-    if ((m_prod == nullptr) || !m_prod->is_valid()) {
-        qDebug() << "********\nCOULD NOT READ THUMB PRODUCER\n********";
-        return false;
-    }
     int duration = m_outPoint > 0 ? m_outPoint - m_inPoint : (int)m_binClip->frameDuration();
     std::set<int> frames;
     int steps = qCeil(qMax(pCore->getCurrentFps(), (double)duration / m_thumbsCount));
@@ -95,28 +89,30 @@ bool CacheJob::startJob()
         frames.insert(pos);
         pos = m_inPoint + (steps * i);
     }
-    int size = (int)frames.size();
-    int count = 0;
+    const int size = (int)frames.size();
+    std::vector<int> missing;
     for (int i : frames) {
-        emit jobProgress(100 * count / size);
-        count++;
-        if (m_clipId.isEmpty() || ThumbnailCache::get()->hasThumbnail(m_clipId, i)) {
-            continue;
+        if (!ThumbnailCache::get()->hasThumbnail(m_clipId, i)) {
+            missing.push_back(i);
         }
-        if (m_done || !m_semaphore.tryAcquire(1)) {
-            m_semaphore.release();
-            break;
-        }
-        m_prod->seek(i);
-        QScopedPointer<Mlt::Frame> frame(m_prod->get_frame());
-        frame->set("deinterlace_method", "onefield");
-        frame->set("top_field_first", -1);
-        frame->set("rescale.interp", "nearest");
-        if (frame != nullptr && frame->is_valid()) {
-            QImage result = KThumb::getFrame(frame.data(), 0, 0, m_fullWidth);
-            QtConcurrent::run(ThumbnailCache::get().get(), &ThumbnailCache::storeThumbnail, m_clipId, i, result, true);
-        }
-        m_semaphore.release(1);
+    }
+    if (m_clipId.isEmpty() || m_done || !m_semaphore.tryAcquire(1)) {
+        // Job aborted
+        return true;
+    }
+    int count = size - (int)missing.size();
+    const QString clipId = m_clipId;
+    // The frames are decoded in order, reading forward inside a GOP instead of seeking for each thumbnail
+    int extracted = ThumbnailExtractor::get()->extract(m_binClip, missing, ThumbnailExtractor::Mode::Exact, m_fullWidth, [&](int frame, const QImage &result) {
+        // Disk writes are queued by the cache, no need to wait for them
+        ThumbnailCache::get()->storeThumbnail(clipId, frame, result, true);
+        emit jobProgress(100 * ++count / size);
+        return !m_done;
+    });
+    m_semaphore.release(1);
+    if (extracted < 0) {
+        qDebug() << "********\nCOULD NOT READ THUMB PRODUCER\n********";
+        return false;
     }
     m_done = true;
     return true;
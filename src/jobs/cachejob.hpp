@@ -30,9 +30,6 @@
  */
 
 class ProjectClip;
-namespace Mlt {
-class Producer;
-}
 
 class CacheJob : public AbstractClipJob
 {
@@ -57,7 +54,6 @@ private:
     int m_fullWidth;
 
     std::shared_ptr<ProjectClip> m_binClip;
-    std::shared_ptr<Mlt::Producer> m_prod;
     QSemaphore m_semaphore;
 
     bool m_done{false};
@@ -32,12 +32,22 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QFuture>
 #include <QFutureWatcher>
 #include <QThread>
+#include <algorithm>
 
 int JobManager::m_currentId = 0;
 JobManager::JobManager(QObject *parent)
     : QAbstractListModel(parent)
     , m_lock(QReadWriteLock::Recursive)
+    , m_scheduler(new JobScheduler())
 {
+    // Jobs running external encoders use several threads each, don't let them saturate the CPU
+    const int threads = m_scheduler->maxThreads();
+    for (auto type : {AbstractClipJob::PROXYJOB, AbstractClipJob::CUTJOB, AbstractClipJob::STABILIZEJOB, AbstractClipJob::TRANSCODEJOB,
+                      AbstractClipJob::FILTERCLIPJOB, AbstractClipJob::ANALYSECLIPJOB, AbstractClipJob::SPEEDJOB}) {
+        m_scheduler->setConcurrencyLimit(type, qMax(1, threads / 4));
+    }
+    m_scheduler->setConcurrencyLimit(AbstractClipJob::AUDIOTHUMBJOB, qMax(1, threads / 2));
+    m_scheduler->setConcurrencyLimit(AbstractClipJob::CACHEJOB, 1);
 }
 
 JobManager::~JobManager()
@@ -239,8 +249,125 @@ void JobManager::createJob(const std::shared_ptr<Job_t> &job)
     connect(&job->m_future, &QFutureWatcher<bool>::started, this, &JobManager::updateJobCount);
     connect(&job->m_future, &QFutureWatcher<bool>::finished, this, [this, id = job->m_id]() { if (m_jobs.count(id)> 0) slotManageFinishedJob(id); });
     connect(&job->m_future, &QFutureWatcher<bool>::canceled, this, [this, id = job->m_id]() { slotManageCanceledJob(id); });
-    job->m_actualFuture = QtConcurrent::mapped(job->m_job, AbstractClipJob::execute);
+    job->m_actualFuture = job->m_interface.future();
     job->m_future.setFuture(job->m_actualFuture);
+    job->m_remaining = int(job->m_job.size());
+    job->m_timer.start();
+    if (job->m_job.empty()) {
+        job->m_interface.reportStarted();
+        job->m_interface.reportFinished();
+        return;
+    }
+    for (const auto &it : job->m_indices) {
+        size_t i = it.second;
+        JobPriority priority = priorityForClip(it.first);
+        job->m_priority = std::min(job->m_priority, priority);
+        m_scheduler->enqueue(it.first, int(job->m_type), priority, [job, i]() { runJobTask(job, i); });
+    }
+}
+
+void JobManager::runJobTask(const std::shared_ptr<Job_t> &job, size_t index)
+{
+    if (!job->m_interface.isCanceled()) {
+        if (!job->m_started.exchange(true)) {
+            job->m_waitTime = job->m_timer.elapsed();
+            job->m_interface.reportStarted();
+        }
+        bool result = AbstractClipJob::execute(job->m_job[index]);
+        job->m_interface.reportResult(result, int(index));
+    }
+    if (--job->m_remaining == 0) {
+        if (job->m_started) {
+            job->m_runTime = job->m_timer.elapsed() - job->m_waitTime;
+        } else {
+            job->m_interface.reportStarted();
+        }
+        job->m_interface.reportFinished();
+    }
+}
+
+JobPriority JobManager::priorityForClip(const QString &binId) const
+{
+    QString interactiveClip;
+    {
+        QReadLocker locker(&m_lock);
+        interactiveClip = m_interactiveClip;
+    }
+    if (binId == interactiveClip) {
+        return JobPriority::Interactive;
+    }
+    if (pCore && pCore->projectItemModel()) {
+        std::shared_ptr<ProjectClip> clip = pCore->projectItemModel()->getClipByBinID(binId);
+        if (clip && clip->isIncludedInTimeline()) {
+            return JobPriority::Timeline;
+        }
+    }
+    return JobPriority::Background;
+}
+
+void JobManager::setInteractiveClip(const QString &binId)
+{
+    QString previous;
+    {
+        QWriteLocker locker(&m_lock);
+        if (binId == m_interactiveClip) {
+            return;
+        }
+        previous = m_interactiveClip;
+        m_interactiveClip = binId;
+    }
+    if (!previous.isEmpty()) {
+        m_scheduler->setPriority(previous, priorityForClip(previous));
+    }
+    if (!binId.isEmpty()) {
+        m_scheduler->setPriority(binId, JobPriority::Interactive);
+    }
+}
+
+void JobManager::setConcurrencyLimit(AbstractClipJob::JOBTYPE type, int limit)
+{
+    m_scheduler->setConcurrencyLimit(int(type), limit);
+}
+
+JobScheduler::Statistics JobManager::getStatistics(AbstractClipJob::JOBTYPE type) const
+{
+    return m_scheduler->statistics(int(type));
+}
+
+void JobManager::cancelChildJobs(int id)
+{
+    if (m_jobsByParents.count(id) == 0) {
+        return;
+    }
+    std::vector<int> children = m_jobsByParents[id];
+    m_jobsByParents.erase(id);
+    for (int cid : children) {
+        if (m_jobs.count(cid) == 0) {
+            continue;
+        }
+        // Child jobs were never handed to createJob, so their watcher has no future and
+        // will not report the cancelation: drop them here, along with their own children
+        std::shared_ptr<Job_t> child = m_jobs[cid];
+        for (const std::shared_ptr<AbstractClipJob> &job : child->m_job) {
+            emit job->jobCanceled();
+        }
+        child->m_processed = true;
+        for (const auto &it : child->m_indices) {
+            if (m_jobsByClip.count(it.first) > 0) {
+                std::vector<int> &clipJobs = m_jobsByClip.at(it.first);
+                clipJobs.erase(std::remove(clipJobs.begin(), clipJobs.end(), cid), clipJobs.end());
+                if (clipJobs.empty()) {
+                    m_jobsByClip.erase(it.first);
+                }
+            }
+            if (pCore) {
+                pCore->projectItemModel()->onItemUpdated(it.first, AbstractProjectItem::JobStatus);
+            }
+        }
+        cancelChildJobs(cid);
+        child->m_completionMutex.unlock();
+        m_jobs.erase(cid);
+    }
 }
 
 void JobManager::slotManageCanceledJob(int id)
@@ -259,9 +386,8 @@ void JobManager::slotManageCanceledJob(int id)
         pCore->projectItemModel()->onItemUpdated(it.first, AbstractProjectItem::JobStatus);
         m_jobsByClip.erase(it.first);
     }
-    if (m_jobsByParents.count(id) > 0) {
-        m_jobsByParents.erase(id);
-    }
+    // Children will never be released
+    cancelChildJobs(id);
     m_jobs.erase(id);
     updateJobCount();
 }
@@ -279,28 +405,36 @@ void JobManager::slotManageFinishedJob(int id)
             m_jobsByClip.at(it.first).erase(std::remove(m_jobsByClip.at(it.first).begin(), m_jobsByClip.at(it.first).end(), id), m_jobsByClip.at(it.first).end());
         }
     }
-    bool ok = true;
-    for (bool res : m_jobs[id]->m_future.future()) {
-        ok = ok && res;
+    // Result of each clip of the job
+    const QFuture<bool> future = m_jobs[id]->m_future.future();
+    std::vector<bool> succeeded(m_jobs[id]->m_job.size(), false);
+    for (size_t i = 0; i < succeeded.size(); ++i) {
+        succeeded[i] = future.isResultReadyAt(int(i)) && future.resultAt(int(i));
     }
+    bool ok = std::find(succeeded.begin(), succeeded.end(), false) == succeeded.end();
+    // In a job holding a batch of clips, a failure only discards the clips that failed
+    const bool partial = !ok && std::find(succeeded.begin(), succeeded.end(), true) != succeeded.end();
     Fun undo = []() { return true; };
     Fun redo = []() { return true; };
-    if (!ok) {
+    auto removeUnloadedClip = [&undo, &redo](const QString &binId) {
+        std::shared_ptr<AbstractProjectItem> item = pCore->projectItemModel()->getItemByBinId(binId);
+        if (item && item->itemType() == AbstractProjectItem::ClipItem) {
+            auto clipItem = std::static_pointer_cast<ProjectClip>(item);
+            if (!clipItem->statusReady()) {
+                // We were trying to load a new clip, delete it
+                pCore->projectItemModel()->requestBinClipDeletion(item, undo, redo);
+            }
+        }
+    };
+    if (!ok && !partial) {
         qDebug() << " * * * ** * * *\nWARNING + + +\nJOB NOT CORRECT FINISH: " << id <<"\n------------------------";
-        // TODO: delete child jobs
+        cancelChildJobs(id);
         m_jobs[id]->m_completionMutex.unlock();
         locker.unlock();
         if (m_jobs.at(id)->m_type == AbstractClipJob::LOADJOB) {
             // loading failed, remove clip
             for (const auto &it : m_jobs[id]->m_indices) {
-                std::shared_ptr<AbstractProjectItem> item = pCore->projectItemModel()->getItemByBinId(it.first);
-                if (item && item->itemType() == AbstractProjectItem::ClipItem) {
-                    auto clipItem = std::static_pointer_cast<ProjectClip>(item);
-                    if (!clipItem->statusReady()) {
-                        // We were trying to load a new clip, delete it
-                        pCore->projectItemModel()->requestBinClipDeletion(item, undo, redo);
-                    }
-                }
+                removeUnloadedClip(it.first);
             }
         } else {
             const QString bid = m_jobs.at(id)->m_indices.cbegin()->first;
@@ -320,8 +454,26 @@ void JobManager::slotManageFinishedJob(int id)
     // unlock mutex to allow further processing
     // TODO: the lock mechanism should handle this better!
     locker.unlock();
-    for (const auto &j : m_jobs[id]->m_job) {
-        ok = ok && j->commitResult(undo, redo);
+    if (partial) {
+        for (const auto &it : m_jobs[id]->m_indices) {
+            if (succeeded[it.second]) {
+                continue;
+            }
+            if (m_jobs[id]->m_type == AbstractClipJob::LOADJOB) {
+                removeUnloadedClip(it.first);
+            } else {
+                QPair<QString, QString> message = getJobMessageForClip(id, it.first);
+                if (!message.first.isEmpty()) {
+                    pCore->displayBinMessage(message.first, KMessageWidget::Warning);
+                }
+            }
+        }
+        ok = true;
+    }
+    for (size_t i = 0; i < m_jobs[id]->m_job.size(); ++i) {
+        if (succeeded[i]) {
+            ok = ok && m_jobs[id]->m_job[i]->commitResult(undo, redo);
+        }
     }
     m_jobs[id]->m_processed = true;
     if (!ok) {
@@ -344,8 +496,8 @@ void JobManager::slotManageFinishedJob(int id)
     if (m_jobsByParents.count(id) > 0) {
         std::vector<int> children = m_jobsByParents[id];
         for (int cid : children) {
-            if (!m_jobs[cid]->m_processed) {
-                QtConcurrent::run(this, &JobManager::createJob, m_jobs[cid]);
+            if (m_jobs.count(cid) > 0 && !m_jobs[cid]->m_processed) {
+                createJob(m_jobs[cid]);
             }
         }
         m_jobsByParents.erase(id);
@@ -417,14 +569,44 @@ QVariant JobManager::data(const QModelIndex &index, int role) const
     }
     auto it = m_jobs.begin();
     std::advance(it, row);
+    const std::shared_ptr<Job_t> &job = it->second;
     switch (role) {
     case Qt::DisplayRole:
-        return QVariant(it->second->m_job.front()->getDescription());
+        return QVariant(job->m_job.front()->getDescription());
         break;
+    case TypeRole:
+        return QVariant(job->m_type);
+    case PriorityRole:
+        return QVariant(int(job->m_priority));
+    case StatusRole:
+        return QVariant::fromValue(getJobStatus(it->first));
+    case WaitTimeRole:
+        if (!job->m_timer.isValid()) {
+            // Still waiting for its parent
+            return QVariant(0);
+        }
+        return QVariant(job->m_waitTime >= 0 ? job->m_waitTime.load() : job->m_timer.elapsed());
+    case RunTimeRole:
+        if (job->m_runTime >= 0) {
+            return QVariant(job->m_runTime.load());
+        }
+        return QVariant(job->m_waitTime >= 0 ? job->m_timer.elapsed() - job->m_waitTime : 0);
     }
     return QVariant();
 }
 
+QHash<int, QByteArray> JobManager::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles[Qt::DisplayRole] = "description";
+    roles[TypeRole] = "type";
+    roles[PriorityRole] = "priority";
+    roles[StatusRole] = "status";
+    roles[WaitTimeRole] = "waitTime";
+    roles[RunTimeRole] = "runTime";
+    return roles;
+}
+
 int JobManager::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
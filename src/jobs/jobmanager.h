@@ -25,11 +25,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "abstractclipjob.h"
 #include "definitions.h"
+#include "jobscheduler.hpp"
 
 #include <QAbstractListModel>
+#include <QElapsedTimer>
+#include <QFutureInterface>
 #include <QFutureWatcher>
 #include <QObject>
 #include <QReadWriteLock>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <unordered_map>
@@ -52,6 +56,13 @@ struct Job_t
     std::unordered_map<QString, size_t> m_indices;       // keys are binIds, value are ids in the vectors m_job and m_progress;
     QFutureWatcher<bool> m_future;                       // future of the job
     QFuture<bool> m_actualFuture;
+    QFutureInterface<bool> m_interface;                  // reports the results of the scheduled tasks to m_actualFuture
+    std::atomic<int> m_remaining{0};                     // number of clips not processed yet
+    std::atomic<bool> m_started{false};
+    QElapsedTimer m_timer;                               // started when the job is queued
+    std::atomic<qint64> m_waitTime{-1};                  // time spent in the queue before the first task started, in ms
+    std::atomic<qint64> m_runTime{-1};                   // time between the first task start and the last task end, in ms
+    JobPriority m_priority = JobPriority::Background;
     QMutex m_completionMutex; // mutex that is locked during execution of the process
     AbstractClipJob::JOBTYPE m_type;
     QString m_undoString;
@@ -69,6 +80,8 @@ public:
     explicit JobManager(QObject *parent);
     ~JobManager() override;
 
+    enum JobRoles { TypeRole = Qt::UserRole + 1, PriorityRole, StatusRole, WaitTimeRole, RunTimeRole };
+
     /** @brief Start a job
         This function calls the prepareJob function of the job if it provides one.
         @param T is the type of job (must inherit from AbstractClipJob)
@@ -127,14 +140,30 @@ public:
     /** @brief return the message of a given job on a given clip (message, detailed log)*/
     QPair<QString, QString> getJobMessageForClip(int jobId, const QString &binId) const;
 
+    /** @brief Mark a clip as the one the user is working on, its pending jobs run before all others */
+    void setInteractiveClip(const QString &binId);
+
+    /** @brief Limit the number of jobs of a type running at the same time, 0 for no limit */
+    void setConcurrencyLimit(AbstractClipJob::JOBTYPE type, int limit);
+
+    /** @brief return queue and latency statistics for a job type */
+    JobScheduler::Statistics getStatistics(AbstractClipJob::JOBTYPE type) const;
+
     // Mandatory overloads
     QVariant data(const QModelIndex &index, int role) const override;
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QHash<int, QByteArray> roleNames() const override;
 
 protected:
     // Helper function to launch a given job.
-    // This has to be launched asynchrnously since it blocks until all parents are finished
+    // It must only be called once all parents are finished, the clips of the job are then queued in the scheduler
     void createJob(const std::shared_ptr<Job_t> &job);
+    // Run the job on one of its clips, this is called from the scheduler threads
+    static void runJobTask(const std::shared_ptr<Job_t> &job, size_t index);
+    // Returns the scheduling class for the jobs of a clip
+    JobPriority priorityForClip(const QString &binId) const;
+    // Cancel the jobs waiting for the given one to finish
+    void cancelChildJobs(int id);
 
     void updateJobCount();
 
@@ -159,6 +188,9 @@ private:
     /** @brief List of all the jobs by clip. */
     std::unordered_map<QString, std::vector<int>> m_jobsByClip;
     std::unordered_map<int, std::vector<int>> m_jobsByParents;
+    /** @brief Clip currently opened in the clip monitor */
+    QString m_interactiveClip;
+    std::unique_ptr<JobScheduler> m_scheduler;
 
 signals:
     void jobCount(int);
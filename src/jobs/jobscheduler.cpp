@@ -0,0 +1,185 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "jobscheduler.hpp"
+
+#include <QRunnable>
+#include <QThread>
+
+class JobScheduler::Runner : public QRunnable
+{
+public:
+    Runner(JobScheduler *scheduler, Task task, qint64 waited)
+        : m_scheduler(scheduler)
+        , m_task(std::move(task))
+        , m_waited(waited)
+    {
+    }
+    void run() override
+    {
+        QElapsedTimer timer;
+        timer.start();
+        m_task.run();
+        m_scheduler->taskDone(m_task.type, m_waited, timer.elapsed());
+    }
+
+private:
+    JobScheduler *m_scheduler;
+    Task m_task;
+    qint64 m_waited;
+};
+
+JobScheduler::JobScheduler(int maxThreads)
+    : m_sequence(0)
+    , m_running(0)
+{
+    m_pool.setMaxThreadCount(qMax(1, maxThreads));
+    m_clock.start();
+}
+
+JobScheduler::~JobScheduler()
+{
+    clear();
+    m_pool.waitForDone();
+}
+
+void JobScheduler::setConcurrencyLimit(int type, int limit)
+{
+    QMutexLocker lk(&m_mutex);
+    m_limits[type] = qMax(0, limit);
+    dispatch();
+}
+
+int JobScheduler::concurrencyLimit(int type) const
+{
+    QMutexLocker lk(&m_mutex);
+    auto it = m_limits.find(type);
+    return it == m_limits.end() ? 0 : it->second;
+}
+
+int JobScheduler::maxThreads() const
+{
+    return m_pool.maxThreadCount();
+}
+
+void JobScheduler::enqueue(const QString &key, int type, JobPriority priority, std::function<void()> task)
+{
+    QMutexLocker lk(&m_mutex);
+    m_queue[{int(priority), m_sequence++}] = Task{key, type, std::move(task), m_clock.elapsed()};
+    m_stats[type].queued++;
+    dispatch();
+}
+
+void JobScheduler::setPriority(const QString &key, JobPriority priority)
+{
+    QMutexLocker lk(&m_mutex);
+    std::vector<std::pair<quint64, Task>> moved;
+    for (auto it = m_queue.begin(); it != m_queue.end();) {
+        if (it->second.key == key && it->first.first != int(priority)) {
+            // Keep the sequence number so that the task keeps its rank among older tasks
+            moved.emplace_back(it->first.second, std::move(it->second));
+            it = m_queue.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto &task : moved) {
+        m_queue[{int(priority), task.first}] = std::move(task.second);
+    }
+}
+
+void JobScheduler::clear()
+{
+    QMutexLocker lk(&m_mutex);
+    for (const auto &task : m_queue) {
+        m_stats[task.second.type].queued--;
+    }
+    m_queue.clear();
+}
+
+bool JobScheduler::waitForDone(int msecs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    forever {
+        m_mutex.lock();
+        bool done = m_queue.empty() && m_running == 0;
+        m_mutex.unlock();
+        if (done) {
+            return true;
+        }
+        if (msecs >= 0 && timer.elapsed() > msecs) {
+            return false;
+        }
+        QThread::msleep(5);
+    }
+}
+
+JobScheduler::Statistics JobScheduler::statistics(int type) const
+{
+    QMutexLocker lk(&m_mutex);
+    Statistics result;
+    auto it = m_stats.find(type);
+    if (it == m_stats.end()) {
+        return result;
+    }
+    const TypeStats &st = it->second;
+    result.queued = st.queued;
+    result.running = st.running;
+    result.completed = st.completed;
+    if (st.completed > 0) {
+        result.averageWait = double(st.totalWait) / st.completed;
+        result.averageRun = double(st.totalRun) / st.completed;
+    }
+    return result;
+}
+
+void JobScheduler::dispatch()
+{
+    for (auto it = m_queue.begin(); it != m_queue.end() && m_running < m_pool.maxThreadCount();) {
+        const int type = it->second.type;
+        auto limit = m_limits.find(type);
+        TypeStats &st = m_stats[type];
+        if (limit != m_limits.end() && limit->second > 0 && st.running >= limit->second) {
+            // This type is saturated, look for a less urgent task of another type
+            ++it;
+            continue;
+        }
+        st.queued--;
+        st.running++;
+        m_running++;
+        const qint64 waited = m_clock.elapsed() - it->second.queuedAt;
+        m_pool.start(new Runner(this, std::move(it->second), waited));
+        it = m_queue.erase(it);
+    }
+}
+
+void JobScheduler::taskDone(int type, qint64 waited, qint64 ran)
+{
+    QMutexLocker lk(&m_mutex);
+    TypeStats &st = m_stats[type];
+    st.running--;
+    st.completed++;
+    st.totalWait += waited;
+    st.totalRun += ran;
+    m_running--;
+    dispatch();
+}
@@ -0,0 +1,110 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+#include <functional>
+#include <map>
+#include <unordered_map>
+
+/** @brief Scheduling class of a job, lower values run first */
+enum class JobPriority { Interactive = 0, Timeline = 1, Background = 2 };
+
+/**
+ * @class JobScheduler
+ * @brief Runs tasks on a dedicated thread pool, by priority class and with a concurrency cap per task type.
+ *
+ * Tasks are only handed to the pool when a thread is free, so the pool never holds a backlog of its own:
+ * every free thread takes the most urgent task from the shared queue whose type is under its cap.
+ * Inside a priority class, tasks run in submission order.
+ */
+class JobScheduler
+{
+public:
+    explicit JobScheduler(int maxThreads = QThread::idealThreadCount());
+    /** @brief Drops the queued tasks and waits for the running ones */
+    ~JobScheduler();
+
+    /** @brief Limits the number of tasks of the given type that can run at the same time, 0 means no limit */
+    void setConcurrencyLimit(int type, int limit);
+    int concurrencyLimit(int type) const;
+    int maxThreads() const;
+
+    /** @brief Queues a task.
+        @param key identifies the item the task works on (a bin id), it is used to change the priority of queued tasks
+        @param type task type, for concurrency caps and statistics
+    */
+    void enqueue(const QString &key, int type, JobPriority priority, std::function<void()> task);
+    /** @brief Moves the queued tasks of the given key to another priority class */
+    void setPriority(const QString &key, JobPriority priority);
+    /** @brief Drops all queued tasks that did not start yet */
+    void clear();
+    /** @brief Waits until there is no queued or running task. Returns false on timeout */
+    bool waitForDone(int msecs = -1);
+
+    struct Statistics
+    {
+        int queued = 0;
+        int running = 0;
+        int completed = 0;
+        /** @brief Average time spent in the queue and running, in milliseconds */
+        double averageWait = 0.;
+        double averageRun = 0.;
+    };
+    /** @brief Queue and latency statistics for a task type */
+    Statistics statistics(int type) const;
+
+private:
+    struct Task
+    {
+        QString key;
+        int type;
+        std::function<void()> run;
+        qint64 queuedAt;
+    };
+    struct TypeStats
+    {
+        int queued = 0;
+        int running = 0;
+        int completed = 0;
+        qint64 totalWait = 0;
+        qint64 totalRun = 0;
+    };
+    class Runner;
+
+    /** @brief Starts as many queued tasks as the thread count and caps allow. Must be called with m_mutex held */
+    void dispatch();
+    void taskDone(int type, qint64 waited, qint64 ran);
+
+    mutable QMutex m_mutex;
+    QThreadPool m_pool;
+    QElapsedTimer m_clock;
+    /** @brief Queued tasks, ordered by priority class then submission order */
+    std::map<std::pair<int, quint64>, Task> m_queue;
+    quint64 m_sequence;
+    int m_running;
+    std::unordered_map<int, int> m_limits;
+    std::unordered_map<int, TypeStats> m_stats;
+};
@@ -42,10 +42,11 @@
 #include <mlt++/MltProducer.h>
 #include <mlt++/MltProfile.h>
 
-LoadJob::LoadJob(const QString &binId, const QDomElement &xml, const std::function<void()> &readyCallBack)
+LoadJob::LoadJob(const QString &binId, const QDomElement &xml, const std::function<void()> &readyCallBack, const std::function<void()> &failedCallBack)
     : AbstractClipJob(LOADJOB, binId)
     , m_xml(xml)
     , m_readyCallBack(readyCallBack)
+    , m_failedCallBack(failedCallBack)
 {
 }
 
@@ -409,6 +410,7 @@ bool LoadJob::startJob()
         QMetaObject::invokeMethod(pCore.get(), "displayBinMessage", Qt::QueuedConnection, Q_ARG(QString, i18n("Cannot open file %1", m_resource)),
                                   Q_ARG(int, (int)KMessageWidget::Warning));
         m_errorMessage.append(i18n("ERROR: Could not load clip %1: producer is invalid", m_resource));
+        m_failedCallBack();
         return false;
     }
     if (m_producer->get_length() == INT_MAX && m_producer->get("eof") == QLatin1String("loop")) {
@@ -422,6 +424,7 @@ bool LoadJob::startJob()
         QMetaObject::invokeMethod(pCore.get(), "displayBinMessage", Qt::QueuedConnection, Q_ARG(QString, i18n("Cannot get duration for file %1", m_resource)),
                                   Q_ARG(int, (int)KMessageWidget::Warning));
         m_errorMessage.append(i18n("ERROR: Could not load clip %1: producer is invalid", m_resource));
+        m_failedCallBack();
         return false;
     }
     if (m_producer->get_length() == INT_MAX && m_producer->get("eof") == QLatin1String("loop")) {
@@ -435,6 +438,7 @@ bool LoadJob::startJob()
         QMetaObject::invokeMethod(pCore.get(), "displayBinMessage", Qt::QueuedConnection, Q_ARG(QString, i18n("Cannot get duration for file %1", m_resource)),
                                   Q_ARG(int, (int)KMessageWidget::Warning));
         m_errorMessage.append(i18n("ERROR: Could not load clip %1: producer is invalid", m_resource));
+        m_failedCallBack();
         return false;
     }
     processProducerProperties(m_producer, m_xml);
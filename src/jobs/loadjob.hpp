@@ -39,11 +39,12 @@ class LoadJob : public AbstractClipJob
     Q_OBJECT
 
 public:
-    /* @brief Extract a thumb for given clip.
-       @param frameNumber is the frame to extract. Leave to -1 for default
-       @param persistent: if true, we will use the persistent cache (for query and saving)
+    /* @brief Load a clip from its xml description.
+       @param readyCallBack is called from the GUI thread once the clip is ready
+       @param failedCallBack is called from the job thread if the clip cannot be loaded
     */
-    LoadJob(const QString &binId, const QDomElement &xml, const std::function<void()> &readyCallBack = []() {});
+    LoadJob(const QString &binId, const QDomElement &xml, const std::function<void()> &readyCallBack = []() {},
+            const std::function<void()> &failedCallBack = []() {});
 
     const QString getDescription() const override;
 
@@ -74,6 +75,7 @@ private:
 
     bool m_done{false}, m_successful{false};
     std::function<void()> m_readyCallBack;
+    std::function<void()> m_failedCallBack;
 
     std::shared_ptr<Mlt::Producer> m_producer;
     QList<int> m_audio_list, m_video_list;
@@ -9,16 +9,22 @@ the Free Software Foundation, either version 3 of the License, or
 */
 
 #include "audioCorrelation.h"
-#include "fftCorrelation.h"
+#include "audioCorrelationInfo.h"
 
 #include "kdenlive_debug.h"
 #include "klocalizedstring.h"
 #include <QElapsedTimer>
+#include <QtConcurrent>
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <limits>
+#include <numeric>
 
 AudioCorrelation::AudioCorrelation(std::unique_ptr<AudioEnvelope> mainTrackEnvelope)
     : m_mainTrackEnvelope(std::move(mainTrackEnvelope))
+    , m_mainReady(false)
+    , m_correlating(false)
 {
     // Q_ASSERT(!mainTrackEnvelope->hasComputationStarted());
     connect(m_mainTrackEnvelope.get(), &AudioEnvelope::envelopeReady, this, &AudioCorrelation::slotAnnounceEnvelope);
@@ -27,12 +33,14 @@ AudioCorrelation::AudioCorrelation(std::unique_ptr<AudioEnvelope> mainTrackEnvel
 
 AudioCorrelation::~AudioCorrelation()
 {
+    {
+        QMutexLocker lk(&m_queueMutex);
+        m_queue.clear();
+    }
+    m_correlationTask.waitForFinished();
     for (AudioEnvelope *envelope : qAsConst(m_children)) {
         delete envelope;
     }
-    for (AudioCorrelationInfo *info : qAsConst(m_correlations)) {
-        delete info;
-    }
 
     qCDebug(KDENLIVE_LOG) << "Envelope deleted.";
 }
@@ -40,6 +48,11 @@ AudioCorrelation::~AudioCorrelation()
 void AudioCorrelation::slotAnnounceEnvelope()
 {
     emit displayMessage(i18n("Audio analysis finished"), OperationCompletedMessage, 300);
+    m_mainReady = true;
+    for (AudioEnvelope *envelope : qAsConst(m_readyChildren)) {
+        queueCorrelation(envelope);
+    }
+    m_readyChildren.clear();
 }
 
 void AudioCorrelation::addChild(AudioEnvelope *envelope)
@@ -48,59 +61,171 @@ void AudioCorrelation::addChild(AudioEnvelope *envelope)
     // there is no race condition where the signal 'envelopeReady' is
     // lost.
     Q_ASSERT(!envelope->hasComputationStarted());
+    m_children.append(envelope);
     connect(envelope, &AudioEnvelope::envelopeReady, this, &AudioCorrelation::slotProcessChild);
     envelope->startComputeEnvelope();
 }
 
 void AudioCorrelation::slotProcessChild(AudioEnvelope *envelope)
 {
-    // Note that at this point the computation of the envelope of the
-    // main track might not be finished. envelope() will block until
-    // the computation is done.
-    const size_t sizeMain = m_mainTrackEnvelope->envelope().size();
-    const size_t sizeSub = envelope->envelope().size();
-
-    auto *info = new AudioCorrelationInfo(sizeMain, sizeSub);
-    qint64 *correlation = info->correlationVector();
-
-    const std::vector<qint64> &envMain = m_mainTrackEnvelope->envelope();
-    const std::vector<qint64> &envSub = envelope->envelope();
-    qint64 max = 0;
+    // Don't block a worker thread waiting for the main envelope, start correlating once it is done
+    if (!m_mainReady) {
+        m_readyChildren.append(envelope);
+        return;
+    }
+    queueCorrelation(envelope);
+}
 
-    if (sizeSub > 200) {
-        FFTCorrelation::correlate(&envMain[0], sizeMain, &envSub[0], sizeSub, correlation);
-    } else {
-        correlate(&envMain[0], sizeMain, &envSub[0], sizeSub, correlation, &max);
-        info->setMax(max);
+void AudioCorrelation::queueCorrelation(AudioEnvelope *envelope)
+{
+    QMutexLocker lk(&m_queueMutex);
+    m_queue.append(envelope);
+    if (!m_correlating) {
+        m_correlating = true;
+        m_correlationTask = QtConcurrent::run(this, &AudioCorrelation::processQueue);
     }
+}
 
-    m_children.append(envelope);
-    m_correlations.append(info);
+void AudioCorrelation::processQueue()
+{
+    forever {
+        AudioEnvelope *envelope;
+        {
+            QMutexLocker lk(&m_queueMutex);
+            if (m_queue.isEmpty()) {
+                m_correlating = false;
+                return;
+            }
+            envelope = m_queue.takeFirst();
+        }
+        const std::vector<qint64> &envMain = m_mainTrackEnvelope->envelope();
+        const std::vector<qint64> &envSub = envelope->envelope();
+        int shift = 0;
+        if (!envMain.empty() && !envSub.empty()) {
+            shift = findShift(envMain, envSub, m_fineFFT, m_coarseFFT);
+        }
+        shift += (int)envelope->offset();
+        QMetaObject::invokeMethod(this, [this, envelope, shift]() { childDone(envelope, shift); }, Qt::QueuedConnection);
+    }
+}
 
-    Q_ASSERT(m_correlations.size() == m_children.size());
-    int index = m_children.indexOf(envelope);
-    int shift = getShift(index);
-    emit gotAudioAlignData(envelope->clipId(), shift);
+void AudioCorrelation::childDone(AudioEnvelope *envelope, int shift)
+{
+    m_shifts.insert(envelope->clipId(), shift);
+    m_children.removeOne(envelope);
+    delete envelope;
+    if (m_children.isEmpty()) {
+        // Report the whole batch at once so that it can be applied as a single operation
+        emit gotAudioAlignData(m_shifts);
+        m_shifts.clear();
+    }
 }
 
-int AudioCorrelation::getShift(int childIndex) const
+size_t AudioCorrelation::coarseFactor(size_t size)
 {
-    Q_ASSERT(childIndex >= 0);
-    Q_ASSERT(childIndex < m_correlations.size());
+    // Keep at least 256 entries in the downsampled envelope so that the coarse peak is meaningful
+    size_t factor = 1;
+    while (factor < 16 && size / (factor * 2) >= 256) {
+        factor *= 2;
+    }
+    return factor;
+}
 
-    int indexOffset = (int)m_correlations.at(childIndex)->maxIndex();
-    indexOffset -= (int)m_children.at(childIndex)->envelope().size();
-    indexOffset += (int)m_children.at(childIndex)->offset();
+namespace {
+/** Sums blocks of factor entries and removes the mean.
+    Envelopes are positive, so without centering the correlation of the summed blocks mostly
+    grows with the overlap length and the peak of a partially overlapping clip is lost. */
+std::vector<qint64> downsample(const std::vector<qint64> &envelope, size_t factor)
+{
+    std::vector<qint64> result((envelope.size() + factor - 1) / factor, 0);
+    qint64 total = 0;
+    for (size_t i = 0; i < envelope.size(); ++i) {
+        result[i / factor] += envelope[i];
+        total += envelope[i];
+    }
+    const qint64 mean = total / qint64(result.size());
+    for (qint64 &value : result) {
+        value -= mean;
+    }
+    return result;
+}
 
-    return indexOffset;
+/** Correlation of sub placed at shift in main, summed over the overlapping part */
+double correlationAt(const std::vector<qint64> &envMain, const std::vector<qint64> &envSub, int shift)
+{
+    const int sizeMain = (int)envMain.size();
+    const int sizeSub = (int)envSub.size();
+    const int first = std::max(0, -shift);
+    const int last = std::min(sizeSub, sizeMain - shift);
+    double sum = 0;
+    for (int i = first; i < last; ++i) {
+        sum += double(envSub[(size_t)i]) * double(envMain[(size_t)(i + shift)]);
+    }
+    return sum;
 }
+} // namespace
 
-AudioCorrelationInfo const *AudioCorrelation::info(int childIndex) const
+int AudioCorrelation::findShift(const std::vector<qint64> &envMain, const std::vector<qint64> &envSub, FFTCorrelation &fineFFT, FFTCorrelation &coarseFFT)
 {
-    Q_ASSERT(childIndex >= 0);
-    Q_ASSERT(childIndex < m_correlations.size());
+    const size_t sizeMain = envMain.size();
+    const size_t sizeSub = envSub.size();
+    if (sizeSub <= 200) {
+        AudioCorrelationInfo info(sizeMain, sizeSub);
+        qint64 max = 0;
+        correlate(&envMain[0], sizeMain, &envSub[0], sizeSub, info.correlationVector(), &max);
+        return (int)info.maxIndex() - (int)sizeSub;
+    }
+    const size_t factor = coarseFactor(sizeSub);
+    if (factor == 1) {
+        if (fineFFT.referenceSize() != sizeMain) {
+            fineFFT.setReference(&envMain[0], sizeMain);
+        }
+        std::vector<float> correlation(sizeMain + sizeSub + 1);
+        fineFFT.correlateWith(&envSub[0], sizeSub, &correlation[0]);
+        auto best = std::max_element(correlation.begin(), correlation.end());
+        return int(best - correlation.begin()) - (int)sizeSub;
+    }
 
-    return m_correlations.at(childIndex);
+    // Coarse pass on the downsampled envelopes
+    const std::vector<qint64> subCoarse = downsample(envSub, factor);
+    const size_t sizeMainCoarse = (sizeMain + factor - 1) / factor;
+    if (coarseFFT.referenceSize() != sizeMainCoarse) {
+        const std::vector<qint64> mainCoarse = downsample(envMain, factor);
+        coarseFFT.setReference(&mainCoarse[0], sizeMainCoarse);
+    }
+    std::vector<float> correlation(sizeMainCoarse + subCoarse.size() + 1);
+    coarseFFT.correlateWith(&subCoarse[0], subCoarse.size(), &correlation[0]);
+
+    // Keep a few distinct peaks, the downsampled envelope can slightly favour a neighbouring match
+    const int candidatesCount = 3;
+    std::vector<size_t> order(correlation.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::partial_sort(order.begin(), order.begin() + std::min(order.size(), size_t(8 * candidatesCount)), order.end(),
+                      [&correlation](size_t a, size_t b) { return correlation[a] > correlation[b]; });
+    std::vector<int> candidates;
+    for (size_t i = 0; i < order.size() && i < size_t(8 * candidatesCount) && (int)candidates.size() < candidatesCount; ++i) {
+        int shift = (int)order[i] - (int)subCoarse.size();
+        bool distinct = std::all_of(candidates.begin(), candidates.end(), [shift](int other) { return qAbs(other - shift) > 2; });
+        if (distinct) {
+            candidates.push_back(shift);
+        }
+    }
+
+    // Refine around each candidate at full resolution
+    int bestShift = candidates.front() * (int)factor;
+    double bestScore = -std::numeric_limits<double>::infinity();
+    for (int candidate : candidates) {
+        const int from = std::max(-(int)sizeSub, (candidate - 1) * (int)factor);
+        const int to = std::min((int)sizeMain, (candidate + 1) * (int)factor);
+        for (int shift = from; shift <= to; ++shift) {
+            double score = correlationAt(envMain, envSub, shift);
+            if (score > bestScore) {
+                bestScore = score;
+                bestShift = shift;
+            }
+        }
+    }
+    return bestShift;
 }
 
 void AudioCorrelation::correlate(const qint64 *envMain, size_t sizeMain, const qint64 *envSub, size_t sizeSub, qint64 *correlation, qint64 *out_max)
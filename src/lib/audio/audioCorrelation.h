@@ -11,10 +11,13 @@
 #ifndef AUDIOCORRELATION_H
 #define AUDIOCORRELATION_H
 
-#include "audioCorrelationInfo.h"
 #include "audioEnvelope.h"
 #include "definitions.h"
+#include "fftCorrelation.h"
+#include <QFuture>
 #include <QList>
+#include <QMap>
+#include <QMutex>
 
 /**
   This class does the correlation between two tracks
@@ -22,6 +25,11 @@
 
   It uses one main track (used in the initializer); further tracks will be
   aligned relative to this main track.
+
+  Children are processed as a batch: the envelopes are extracted in parallel,
+  the correlations run in a background thread reusing the FFT plans and the
+  spectrum of the main envelope, and all shifts are reported together once
+  the last pending child is done.
   */
 class AudioCorrelation : public QObject
 {
@@ -44,8 +52,8 @@ public:
     /**
       Adds a child envelope that will be aligned to the reference
       envelope. This function returns immediately, the alignment
-      computation is done asynchronously. When done, the signal
-      gotAudioAlignData will be emitted. Similarly to the main
+      computation is done asynchronously. When all added children are
+      done, the signal gotAudioAlignData will be emitted. Similarly to the main
       envelope, the computation of the envelope must not be started
       when it is passed to this object.
 
@@ -53,34 +61,59 @@ public:
       */
     void addChild(AudioEnvelope *envelope);
 
-    const AudioCorrelationInfo *info(int childIndex) const;
-    int getShift(int childIndex) const;
-
     /**
       Correlates the two vectors envMain and envSub.
       \c correlation must be a pre-allocated vector of size sizeMain+sizeSub+1.
       */
     static void correlate(const qint64 *envMain, size_t sizeMain, const qint64 *envSub, size_t sizeSub, qint64 *correlation, qint64 *out_max = nullptr);
 
+    /**
+      Returns the shift (index in envMain of the first element of envSub) with the best correlation.
+      Long envelopes are first correlated on a downsampled version, the best candidates are then
+      refined at full resolution.
+      @param fineFFT, coarseFFT FFT correlators holding the full and downsampled main envelope
+      */
+    static int findShift(const std::vector<qint64> &envMain, const std::vector<qint64> &envSub, FFTCorrelation &fineFFT, FFTCorrelation &coarseFFT);
+
+    /** Downsampling factor used by findShift for an envelope of the given size, 1 if no coarse pass is done */
+    static size_t coarseFactor(size_t size);
+
 private:
     std::unique_ptr<AudioEnvelope> m_mainTrackEnvelope;
-
+    /** Children owned by this object, until their result is reported */
     QList<AudioEnvelope *> m_children;
-    QList<AudioCorrelationInfo *> m_correlations;
+    /** Children whose envelope is ready, waiting for the main envelope */
+    QList<AudioEnvelope *> m_readyChildren;
+    bool m_mainReady;
+    /** Shift per clip id for the current batch */
+    QMap<int, int> m_shifts;
+    /** Children waiting for their correlation, protected by m_queueMutex */
+    QList<AudioEnvelope *> m_queue;
+    bool m_correlating;
+    QMutex m_queueMutex;
+    QFuture<void> m_correlationTask;
+    /** Only used by the correlation task */
+    FFTCorrelation m_fineFFT;
+    FFTCorrelation m_coarseFFT;
+
+    void queueCorrelation(AudioEnvelope *envelope);
+    /** Correlates the queued children, runs in a background thread */
+    void processQueue();
+    void childDone(AudioEnvelope *envelope, int shift);
 
 private slots:
     /**
      This is invoked when the child envelope is computed. This
      triggers the actual computations of the cross-correlation for
      aligning the envelope to the reference envelope.
-
      Takes ownership of @p envelope.
    */
     void slotProcessChild(AudioEnvelope *envelope);
     void slotAnnounceEnvelope();
 
 signals:
-    void gotAudioAlignData(int, int);
+    /** Emitted once all pending children are aligned, with the shift for each clip id */
+    void gotAudioAlignData(const QMap<int, int> &shifts);
     void displayMessage(const QString &, MessageType, int);
 };
 
@@ -0,0 +1,159 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "audioLevelsBuilder.h"
+#include "audioLevelsStore.h"
+
+#include <QtGlobal>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+AudioLevelsBuilder::AudioLevelsBuilder(int channels, double samplesPerFrame)
+    : m_channels(qMax(1, channels))
+    , m_samplesPerFrame(samplesPerFrame)
+    , m_frameEnd(samplesPerFrame)
+    , m_frameSamples(0)
+    , m_framePeaks((size_t)m_channels, 0)
+    , m_frameSquares((size_t)m_channels, 0.)
+    , m_maxPeak(1)
+{
+}
+
+void AudioLevelsBuilder::reduce(const int16_t *data, int count, int channels, int32_t *peaks, double *squares)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    // 8 samples per register, the channel of a lane is (lane % channels) as long as channels divides 8
+    if (channels == 1 || channels == 2 || channels == 4 || channels == 8) {
+        const int total = count * channels;
+        const __m128i zero = _mm_setzero_si128();
+        __m128i maxVec = zero;
+        __m128 sumLo = _mm_setzero_ps();
+        __m128 sumHi = _mm_setzero_ps();
+        for (; i + 8 <= total; i += 8) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            // Saturated negation so that -32768 becomes 32767
+            v = _mm_max_epi16(v, _mm_subs_epi16(zero, v));
+            maxVec = _mm_max_epi16(maxVec, v);
+            const __m128i lo = _mm_mullo_epi16(v, v);
+            const __m128i hi = _mm_mulhi_epi16(v, v);
+            sumLo = _mm_add_ps(sumLo, _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, hi)));
+            sumHi = _mm_add_ps(sumHi, _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, hi)));
+        }
+        alignas(16) int16_t maxLanes[8];
+        alignas(16) float sumLanes[8];
+        _mm_store_si128(reinterpret_cast<__m128i *>(maxLanes), maxVec);
+        _mm_store_ps(sumLanes, sumLo);
+        _mm_store_ps(sumLanes + 4, sumHi);
+        for (int lane = 0; lane < 8; ++lane) {
+            peaks[lane % channels] = qMax(peaks[lane % channels], (int32_t)maxLanes[lane]);
+            squares[lane % channels] += sumLanes[lane];
+        }
+    }
+#endif
+    for (; i < count * channels; ++i) {
+        // Clamp like the saturated vector path
+        const int32_t sample = qMin(32767, std::abs((int32_t)data[i]));
+        const int c = i % channels;
+        peaks[c] = qMax(peaks[c], sample);
+        squares[c] += double(sample) * sample;
+    }
+}
+
+void AudioLevelsBuilder::addSamples(const int16_t *data, int count)
+{
+    if (m_samplesPerFrame <= 0.) {
+        addFrame(data, count);
+        return;
+    }
+    while (count > 0) {
+        const int needed = qMax(1, (int)std::ceil(m_frameEnd) - m_frameSamples);
+        const int n = qMin(needed, count);
+        reduce(data, n, m_channels, m_framePeaks.data(), m_frameSquares.data());
+        m_frameSamples += n;
+        data += n * m_channels;
+        count -= n;
+        if (n == needed) {
+            pushFrame();
+            // Keep the fractional part so that frames do not drift over long clips
+            m_frameEnd += m_samplesPerFrame - m_frameSamples;
+            m_frameSamples = 0;
+        }
+    }
+}
+
+void AudioLevelsBuilder::addFrame(const int16_t *data, int count)
+{
+    reduce(data, count, m_channels, m_framePeaks.data(), m_frameSquares.data());
+    m_frameSamples += count;
+    pushFrame();
+    m_frameSamples = 0;
+}
+
+void AudioLevelsBuilder::repeatFrame()
+{
+    if (m_peaks.empty()) {
+        m_peaks.resize((size_t)m_channels, 0);
+        m_rms.resize((size_t)m_channels, 0);
+        return;
+    }
+    const size_t last = m_peaks.size() - (size_t)m_channels;
+    for (size_t c = 0; c < (size_t)m_channels; ++c) {
+        m_peaks.push_back(m_peaks[last + c]);
+        m_rms.push_back(m_rms[last + c]);
+    }
+}
+
+void AudioLevelsBuilder::finish()
+{
+    if (m_frameSamples > 0) {
+        pushFrame();
+        m_frameSamples = 0;
+        m_frameEnd = m_samplesPerFrame;
+    }
+}
+
+void AudioLevelsBuilder::pushFrame()
+{
+    const double samples = qMax(1, m_frameSamples);
+    for (size_t c = 0; c < (size_t)m_channels; ++c) {
+        m_maxPeak = qMax(m_maxPeak, m_framePeaks[c]);
+        m_peaks.push_back((uint16_t)m_framePeaks[c]);
+        m_rms.push_back((uint16_t)qMin(32767L, lrint(std::sqrt(m_frameSquares[c] / samples))));
+    }
+    std::fill(m_framePeaks.begin(), m_framePeaks.end(), 0);
+    std::fill(m_frameSquares.begin(), m_frameSquares.end(), 0.);
+}
+
+int AudioLevelsBuilder::channels() const
+{
+    return m_channels;
+}
+
+int AudioLevelsBuilder::frameCount() const
+{
+    return int(m_peaks.size() / (size_t)m_channels);
+}
+
+bool AudioLevelsBuilder::write(const QString &path) const
+{
+    std::vector<uint8_t> peaks(m_peaks.size());
+    std::vector<uint8_t> rms(m_rms.size());
+    // Peaks and RMS share the same scale so that RMS is always drawn inside the peak
+    for (size_t i = 0; i < m_peaks.size(); ++i) {
+        peaks[i] = (uint8_t)(255 * m_peaks[i] / m_maxPeak);
+        rms[i] = (uint8_t)qMin(255, 255 * m_rms[i] / m_maxPeak);
+    }
+    return AudioLevelsStore::write(path, m_channels, peaks, rms);
+}
@@ -0,0 +1,68 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef AUDIOLEVELSBUILDER_H
+#define AUDIOLEVELSBUILDER_H
+
+#include <QString>
+#include <cstdint>
+#include <vector>
+
+/**
+  Reduces a stream of interleaved 16 bit audio samples to one peak and one RMS
+  value per channel and per video frame.
+
+  Samples are consumed as they are decoded, in blocks of any size, so memory use
+  only depends on the number of frames and never on the amount of decoded audio.
+  The result can then be saved in an AudioLevelsStore.
+  */
+class AudioLevelsBuilder
+{
+public:
+    /** @param samplesPerFrame number of audio samples (per channel) in one video frame, used by addSamples */
+    AudioLevelsBuilder(int channels, double samplesPerFrame = 0.);
+
+    /** @brief Adds a block of interleaved samples, frames are cut every samplesPerFrame samples.
+        @param count number of samples per channel in the block */
+    void addSamples(const int16_t *data, int count);
+    /** @brief Adds all the samples of one video frame */
+    void addFrame(const int16_t *data, int count);
+    /** @brief Duplicates the last frame, or adds a silent one if there is none */
+    void repeatFrame();
+    /** @brief Closes the frame being filled by addSamples, if any */
+    void finish();
+
+    int channels() const;
+    /** @brief Number of complete frames */
+    int frameCount() const;
+
+    /** @brief Normalizes the levels on the loudest peak and saves them in an AudioLevelsStore file */
+    bool write(const QString &path) const;
+
+    /** @brief Accumulates the absolute peak and the sum of squares of each channel of a block of interleaved samples.
+        This is the vectorized part, peaks and squares must have one entry per channel */
+    static void reduce(const int16_t *data, int count, int channels, int32_t *peaks, double *squares);
+
+private:
+    int m_channels;
+    double m_samplesPerFrame;
+    /** @brief Sample position at which the current frame ends, and number of samples already in it */
+    double m_frameEnd;
+    int m_frameSamples;
+    std::vector<int32_t> m_framePeaks;
+    std::vector<double> m_frameSquares;
+    /** @brief Per frame levels, interleaved by channel */
+    std::vector<uint16_t> m_peaks;
+    std::vector<uint16_t> m_rms;
+    int32_t m_maxPeak;
+    void pushFrame();
+};
+
+#endif // AUDIOLEVELSBUILDER_H
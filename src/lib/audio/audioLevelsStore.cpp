@@ -0,0 +1,178 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "audioLevelsStore.h"
+
+#include <QDebug>
+#include <QSaveFile>
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+
+const quint32 AudioLevelsStore::formatVersion = 1;
+
+namespace {
+const char storeMagic[4] = {'K', 'D', 'A', 'L'};
+const int headerSize = 16;
+const int levelEntrySize = 16;
+// 2^15 frames per sample is more than 20 minutes at 25 fps, there is no need to go further
+const int maxLevels = 16;
+} // namespace
+
+AudioLevelsStore::~AudioLevelsStore()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+    }
+}
+
+std::shared_ptr<AudioLevelsStore> AudioLevelsStore::open(const QString &path)
+{
+    std::shared_ptr<AudioLevelsStore> store(new AudioLevelsStore());
+    store->m_file.setFileName(path);
+    if (path.isEmpty() || !store->m_file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+    const qint64 size = store->m_file.size();
+    if (size < headerSize) {
+        return nullptr;
+    }
+    store->m_map = store->m_file.map(0, size);
+    if (store->m_map == nullptr) {
+        qDebug() << "Cannot map audio levels" << path;
+        return nullptr;
+    }
+    const uchar *map = store->m_map;
+    if (memcmp(map, storeMagic, 4) != 0 || qFromLittleEndian<quint32>(map + 4) != formatVersion) {
+        return nullptr;
+    }
+    store->m_channels = (int)qFromLittleEndian<quint32>(map + 8);
+    const int levels = (int)qFromLittleEndian<quint32>(map + 12);
+    if (store->m_channels <= 0 || levels <= 0 || levels > maxLevels || size < headerSize + levels * levelEntrySize) {
+        return nullptr;
+    }
+    for (int i = 0; i < levels; ++i) {
+        const uchar *entry = map + headerSize + i * levelEntrySize;
+        const qint64 samples = qFromLittleEndian<quint32>(entry);
+        const qint64 offset = (qint64)qFromLittleEndian<quint64>(entry + 8);
+        if (offset < 0 || offset + 2 * samples * store->m_channels > size) {
+            qDebug() << "Corrupted audio levels" << path;
+            return nullptr;
+        }
+        store->m_levels.push_back({(int)samples, map + offset});
+    }
+    return store;
+}
+
+bool AudioLevelsStore::write(const QString &path, int channels, const std::vector<uint8_t> &peaks, const std::vector<uint8_t> &rms)
+{
+    if (channels <= 0 || peaks.empty() || peaks.size() != rms.size()) {
+        return false;
+    }
+    // Build the zoom levels, stored as one column per channel
+    std::vector<std::vector<uint8_t>> levelPeaks;
+    std::vector<std::vector<uint8_t>> levelRms;
+    const size_t frames = peaks.size() / (size_t)channels;
+    levelPeaks.emplace_back(frames * (size_t)channels);
+    levelRms.emplace_back(frames * (size_t)channels);
+    for (size_t f = 0; f < frames; ++f) {
+        for (size_t c = 0; c < (size_t)channels; ++c) {
+            levelPeaks[0][c * frames + f] = peaks[f * (size_t)channels + c];
+            levelRms[0][c * frames + f] = rms[f * (size_t)channels + c];
+        }
+    }
+    std::vector<size_t> counts{frames};
+    while (counts.back() > 1 && (int)counts.size() < maxLevels) {
+        const size_t previous = counts.back();
+        const size_t count = (previous + 1) / 2;
+        const std::vector<uint8_t> &srcPeaks = levelPeaks.back();
+        const std::vector<uint8_t> &srcRms = levelRms.back();
+        std::vector<uint8_t> dstPeaks(count * (size_t)channels);
+        std::vector<uint8_t> dstRms(count * (size_t)channels);
+        for (size_t c = 0; c < (size_t)channels; ++c) {
+            const uint8_t *p = srcPeaks.data() + c * previous;
+            const uint8_t *r = srcRms.data() + c * previous;
+            for (size_t i = 0; i < count; ++i) {
+                const size_t a = 2 * i;
+                const size_t b = qMin(a + 1, previous - 1);
+                dstPeaks[c * count + i] = qMax(p[a], p[b]);
+                dstRms[c * count + i] = (uint8_t)lrint(std::sqrt((double(r[a]) * r[a] + double(r[b]) * r[b]) / 2.));
+            }
+        }
+        counts.push_back(count);
+        levelPeaks.push_back(std::move(dstPeaks));
+        levelRms.push_back(std::move(dstRms));
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Cannot write audio levels" << path;
+        return false;
+    }
+    const int levels = (int)counts.size();
+    QByteArray header(headerSize + levels * levelEntrySize, 0);
+    auto *h = reinterpret_cast<uchar *>(header.data());
+    memcpy(h, storeMagic, 4);
+    qToLittleEndian<quint32>(formatVersion, h + 4);
+    qToLittleEndian<quint32>((quint32)channels, h + 8);
+    qToLittleEndian<quint32>((quint32)levels, h + 12);
+    quint64 offset = (quint64)header.size();
+    for (int i = 0; i < levels; ++i) {
+        uchar *entry = h + headerSize + i * levelEntrySize;
+        qToLittleEndian<quint32>((quint32)counts[(size_t)i], entry);
+        qToLittleEndian<quint64>(offset, entry + 8);
+        offset += 2 * counts[(size_t)i] * (size_t)channels;
+    }
+    file.write(header);
+    for (int i = 0; i < levels; ++i) {
+        const size_t count = counts[(size_t)i];
+        for (size_t c = 0; c < (size_t)channels; ++c) {
+            file.write(reinterpret_cast<const char *>(levelPeaks[(size_t)i].data() + c * count), (qint64)count);
+            file.write(reinterpret_cast<const char *>(levelRms[(size_t)i].data() + c * count), (qint64)count);
+        }
+    }
+    return file.commit();
+}
+
+int AudioLevelsStore::channels() const
+{
+    return m_channels;
+}
+
+int AudioLevelsStore::levelCount() const
+{
+    return (int)m_levels.size();
+}
+
+int AudioLevelsStore::sampleCount(int level) const
+{
+    return m_levels.at((size_t)level).samples;
+}
+
+const uint8_t *AudioLevelsStore::peaks(int level, int channel) const
+{
+    const Level &l = m_levels.at((size_t)level);
+    return l.data + 2 * (size_t)channel * (size_t)l.samples;
+}
+
+const uint8_t *AudioLevelsStore::rms(int level, int channel) const
+{
+    const Level &l = m_levels.at((size_t)level);
+    return l.data + (2 * (size_t)channel + 1) * (size_t)l.samples;
+}
+
+int AudioLevelsStore::levelForFramesPerPixel(double framesPerPixel) const
+{
+    int level = 0;
+    while (level + 1 < levelCount() && double(1 << (level + 1)) <= framesPerPixel) {
+        level++;
+    }
+    return level;
+}
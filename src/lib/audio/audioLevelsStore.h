@@ -0,0 +1,73 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef AUDIOLEVELSSTORE_H
+#define AUDIOLEVELSSTORE_H
+
+#include <QFile>
+#include <QString>
+#include <memory>
+#include <vector>
+
+/**
+  Persistent storage of the audio levels (waveform data) of a clip stream.
+
+  The file is memory mapped, so that painters can read the samples they need
+  directly from the page cache without decoding or copying the whole data.
+  Levels are stored as one column per channel at several zoom levels: level 0
+  has one sample per frame, level n summarizes 2^n frames per sample.
+
+  File layout, all integers are little endian:
+  - header: magic "KDAL", format version, channel count, level count (quint32 each)
+  - level table: for each level, its sample count (quint32), padding (quint32) and data offset (quint64)
+  - data: for each level and each channel, a column of peak values followed by a column of RMS values,
+    one byte per sample, normalized on [0, 255]
+  */
+class AudioLevelsStore
+{
+public:
+    /** @brief Version of the file format, bump it when changing the layout so that old caches are regenerated */
+    static const quint32 formatVersion;
+
+    ~AudioLevelsStore();
+
+    /** @brief Opens and maps an existing store. Returns nullptr if the file is missing, invalid or was written with another format version */
+    static std::shared_ptr<AudioLevelsStore> open(const QString &path);
+
+    /** @brief Builds the zoom levels and writes a store.
+        @param peaks per frame peak levels, interleaved by channel
+        @param rms per frame RMS levels, interleaved by channel, same size as peaks */
+    static bool write(const QString &path, int channels, const std::vector<uint8_t> &peaks, const std::vector<uint8_t> &rms);
+
+    int channels() const;
+    int levelCount() const;
+    /** @brief Number of samples at the given zoom level */
+    int sampleCount(int level) const;
+    /** @brief Pointers to the peak / RMS column of a channel at a zoom level.
+        They point inside the mapped file and stay valid as long as this object lives */
+    const uint8_t *peaks(int level, int channel) const;
+    const uint8_t *rms(int level, int channel) const;
+    /** @brief Returns the coarsest zoom level that still has at least one sample per framesPerPixel frames */
+    int levelForFramesPerPixel(double framesPerPixel) const;
+
+private:
+    AudioLevelsStore() = default;
+    struct Level
+    {
+        int samples;
+        const uint8_t *data;
+    };
+    QFile m_file;
+    uchar *m_map = nullptr;
+    int m_channels = 0;
+    std::vector<Level> m_levels;
+};
+
+#endif // AUDIOLEVELSSTORE_H
@@ -10,9 +10,6 @@ the Free Software Foundation, either version 3 of the License, or
 
 #include "fftCorrelation.h"
 #include <QElapsedTimer>
-extern "C" {
-#include "../external/kiss_fft/tools/kiss_fftr.h"
-}
 
 #include "kdenlive_debug.h"
 #include <algorithm>
@@ -37,41 +34,109 @@ void FFTCorrelation::correlate(const qint64 *left, const size_t leftSize, const
     QElapsedTimer t;
     t.start();
 
-    auto *leftF = new float[leftSize];
-    auto *rightF = new float[rightSize];
+    FFTCorrelation fft;
+    fft.setReference(left, leftSize);
+    fft.correlateWith(right, rightSize, out_correlated);
+
+    qCDebug(KDENLIVE_LOG) << "Correlation (FFT based) computed in " << t.elapsed() << " ms.";
+}
+
+FFTCorrelation::FFTCorrelation()
+    : m_referenceFFTSize(0)
+{
+}
+
+FFTCorrelation::~FFTCorrelation()
+{
+    for (const auto &plan : m_plans) {
+        kiss_fftr_free(plan.second.forward);
+        kiss_fftr_free(plan.second.inverse);
+    }
+}
+
+const FFTCorrelation::Plan &FFTCorrelation::plan(size_t size)
+{
+    auto it = m_plans.find(size);
+    if (it == m_plans.end()) {
+        Plan plan{kiss_fftr_alloc((int)size, 0, nullptr, nullptr), kiss_fftr_alloc((int)size, 1, nullptr, nullptr)};
+        it = m_plans.emplace(size, plan).first;
+    }
+    return it->second;
+}
 
+void FFTCorrelation::setReference(const qint64 *left, const size_t leftSize)
+{
     // First the qint64 values need to be normalized to floats
     // Dividing by the max value is maybe not the best solution, but the
     // maximum value after correlation should not be larger than the longest
     // vector since each value should be at most 1
     qint64 maxLeft = 1;
-    qint64 maxRight = 1;
     for (size_t i = 0; i < leftSize; ++i) {
         if (qAbs(left[i]) > maxLeft) {
             maxLeft = qAbs(left[i]);
         }
     }
+    m_reference.resize(leftSize);
+    for (size_t i = 0; i < leftSize; ++i) {
+        m_reference[i] = double(left[i]) / (double)maxLeft;
+    }
+    // The spectrum will be computed for the transform size of the next correlation
+    m_referenceFFTSize = 0;
+}
+
+size_t FFTCorrelation::referenceSize() const
+{
+    return m_reference.size();
+}
+
+void FFTCorrelation::correlateWith(const qint64 *right, const size_t rightSize, float *out_correlated)
+{
+    qint64 maxRight = 1;
     for (size_t i = 0; i < rightSize; ++i) {
         if (qAbs(right[i]) > maxRight) {
             maxRight = qAbs(right[i]);
         }
     }
 
+    // To avoid issues with repetition we need to pad the vectors to at least twice their size,
+    // and the size should be a power of 2 (see convolve()).
+    size_t largestSize = std::max(m_reference.size(), rightSize);
+    size_t size = 64;
+    while (size / 2 < largestSize) {
+        size = size << 1;
+    }
+    const Plan &fftPlan = plan(size);
+    const size_t fft_size = size / 2 + 1;
+
+    if (m_referenceFFTSize != size) {
+        m_data.assign(size, 0);
+        std::copy(m_reference.begin(), m_reference.end(), m_data.begin());
+        m_referenceFFT.resize(fft_size);
+        kiss_fftr(fftPlan.forward, &m_data[0], &m_referenceFFT[0]);
+        m_referenceFFTSize = size;
+    }
+
     // One side needs to be reversed, since multiplication in frequency domain (fourier space)
     // calculates the convolution: \sum l[x]r[N-x] and not the correlation: \sum l[x]r[x]
-    for (size_t i = 0; i < leftSize; ++i) {
-        leftF[i] = double(left[i]) / (double)maxLeft;
-    }
+    m_data.assign(size, 0);
     for (size_t i = 0; i < rightSize; ++i) {
-        rightF[rightSize - 1 - i] = double(right[i]) / (double)maxRight;
+        m_data[rightSize - 1 - i] = double(right[i]) / (double)maxRight;
+    }
+    m_dataFFT.resize(fft_size);
+    kiss_fftr(fftPlan.forward, &m_data[0], &m_dataFFT[0]);
+
+    for (size_t i = 0; i < fft_size; ++i) {
+        const kiss_fft_cpx l = m_referenceFFT[i];
+        const kiss_fft_cpx r = m_dataFFT[i];
+        m_dataFFT[i].r = l.r * r.r - l.i * r.i;
+        m_dataFFT[i].i = l.r * r.i + l.i * r.r;
     }
 
-    // Now we can convolve to get the correlation
-    convolve(leftF, leftSize, rightF, rightSize, out_correlated);
-
-    qCDebug(KDENLIVE_LOG) << "Correlation (FFT based) computed in " << t.elapsed() << " ms.";
-    delete[] leftF;
-    delete[] rightF;
+    // Same layout as convolve(): one leading zero, then the convolved data
+    *out_correlated = 0;
+    size_t out_size = m_reference.size() + rightSize + 1;
+    kiss_fftri(fftPlan.inverse, &m_dataFFT[0], &m_data[0]);
+    std::copy(m_data.begin(), m_data.begin() + (int)out_size - 1, out_correlated + 1);
 }
 
 void FFTCorrelation::convolve(const float *left, const size_t leftSize, const float *right, const size_t rightSize, float *out_convolved)
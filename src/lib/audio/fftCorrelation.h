@@ -11,16 +11,31 @@ the Free Software Foundation, either version 3 of the License, or
 #ifndef FFTCORRELATION_H
 #define FFTCORRELATION_H
 
+#include "../external/kiss_fft/tools/kiss_fftr.h"
 #include <QtGlobal>
+#include <map>
+#include <vector>
+
 /**
   This class provides methods to calculate convolution
   and correlation of two vectors by means of FFT, which
   is O(n log n) (convolution in spacial domain would be
   O(n²)).
+
+  The static methods allocate their FFT plans and buffers on
+  every call. When one reference vector is correlated with
+  many others, create an instance instead: it keeps the plans,
+  the working buffers and the spectrum of the reference between
+  calls to correlateWith().
   */
 class FFTCorrelation
 {
 public:
+    FFTCorrelation();
+    ~FFTCorrelation();
+    FFTCorrelation(const FFTCorrelation &) = delete;
+    FFTCorrelation &operator=(const FFTCorrelation &) = delete;
+
     /**
       Computes the convolution between \c left and \c right.
       \c out_correlated must be a pre-allocated vector of size
@@ -36,6 +51,38 @@ public:
     static void correlate(const qint64 *left, const size_t leftSize, const qint64 *right, const size_t rightSize, float *out_correlated);
 
     static void correlate(const qint64 *left, const size_t leftSize, const qint64 *right, const size_t rightSize, qint64 *out_correlated);
+
+    /**
+      Sets the vector used as \c left by the following calls to correlateWith().
+      The data is copied.
+      */
+    void setReference(const qint64 *left, const size_t leftSize);
+    size_t referenceSize() const;
+
+    /**
+      Same as correlate(), using the reference vector as \c left.
+      \c out_correlated must be a pre-allocated vector of size
+      referenceSize() + \c rightSize + 1.
+      */
+    void correlateWith(const qint64 *right, const size_t rightSize, float *out_correlated);
+
+private:
+    struct Plan
+    {
+        kiss_fftr_cfg forward;
+        kiss_fftr_cfg inverse;
+    };
+    /** FFT plans by transform size */
+    std::map<size_t, Plan> m_plans;
+    /** Normalized reference vector */
+    std::vector<float> m_reference;
+    /** Spectrum of the reference, valid for the transform size m_referenceFFTSize */
+    std::vector<kiss_fft_cpx> m_referenceFFT;
+    size_t m_referenceFFTSize;
+    std::vector<float> m_data;
+    std::vector<kiss_fft_cpx> m_dataFFT;
+
+    const Plan &plan(size_t size);
 };
 
 #endif // FFTCORRELATION_H
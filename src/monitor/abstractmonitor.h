@@ -21,6 +21,7 @@
 #define ABSTRACTMONITOR_H
 
 #include "definitions.h"
+#include "scopes/colorscopes/scopeframe.h"
 
 #include <cstdint>
 
@@ -99,8 +100,10 @@ protected:
     MonitorManager *m_monitorManager;
 
 signals:
-    /** @brief Send a frame for analysis or title background display. */
+    /** @brief Send a frame for title background display. */
     void frameUpdated(const QImage &);
+    /** @brief Send a frame for analysis by the color scopes. */
+    void scopeFrameUpdated(const ScopeFrame &);
     /** @brief This signal contains the audio of the current frame. */
     void audioSamplesSignal(const audioShortVector &, int, int, int);
     /** @brief Scopes are ready to receive a new frame. */
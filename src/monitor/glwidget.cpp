@@ -64,6 +64,7 @@ using namespace Mlt;
 GLWidget::GLWidget(int id, QObject *parent)
     : QQuickView((QWindow *)parent)
     , sendFrameForAnalysis(false)
+    , sendFullFrame(false)
     , m_glslManager(nullptr)
     , m_consumer(nullptr)
     , m_producer(nullptr)
@@ -107,6 +108,7 @@ GLWidget::GLWidget(int id, QObject *parent)
     m_texture[0] = m_texture[1] = m_texture[2] = 0;
     qRegisterMetaType<Mlt::Frame>("Mlt::Frame");
     qRegisterMetaType<SharedFrame>("SharedFrame");
+    qRegisterMetaType<ScopeFrame>("ScopeFrame");
 
     if (m_id == Kdenlive::ClipMonitor && !(KdenliveSettings::displayClipMonitorInfo() & 0x01)) {
         m_rulerHeight = 0;
@@ -601,7 +603,7 @@ void GLWidget::paintGL()
         glDrawArrays(GL_TRIANGLE_STRIP, 0, vertices.size());
         check_error(f);
         m_fbo->release();
-        emit analyseFrame(m_fbo->toImage());
+        emit analyseFrame(ScopeFrame(m_fbo->toImage()));
         m_sendFrame = false;
     }
     // Cleanup
@@ -1265,9 +1267,18 @@ void GLWidget::setZoom(float zoom)
 
 void GLWidget::onFrameDisplayed(const SharedFrame &frame)
 {
+    bool sendFrame = sendFrameForAnalysis;
+    if (sendFrame && frame.get_image_format() == mlt_image_yuv420p) {
+        // The scopes can work on the decoded planes directly, no need to read back the rendered frame
+        if (m_analyseSem.tryAcquire(1)) {
+            const int maxWidth = sendFullFrame ? 0 : ScopeFrame::defaultMaxWidth;
+            emit analyseFrame(ScopeFrame::fromYuv420(frame.get_image(mlt_image_yuv420p), frame.get_image_width(), frame.get_image_height(), m_colorSpace, maxWidth));
+        }
+        sendFrame = false;
+    }
     m_contextSharedAccess.lock();
     m_sharedFrame = frame;
-    m_sendFrame = sendFrameForAnalysis;
+    m_sendFrame = sendFrame;
     m_contextSharedAccess.unlock();
     update();
 }
@@ -35,6 +35,7 @@
 #include "bin/model/markerlistmodel.hpp"
 #include "definitions.h"
 #include "kdenlivesettings.h"
+#include "scopes/colorscopes/scopeframe.h"
 #include "scopes/sharedframe.h"
 
 #include <mlt++/MltProfile.h>
@@ -107,6 +108,8 @@ public:
     QRect displayRect() const;
     /** @brief set to true if we want to emit a QImage of the frame for analysis */
     bool sendFrameForAnalysis;
+    /** @brief set to true if the analysed frame must keep the full resolution (title background) instead of being decimated for the scopes */
+    bool sendFullFrame;
     void updateGamma();
     /** @brief delete and rebuild consumer, for example when external display is switched */
     void resetConsumer(bool fullReset);
@@ -180,7 +183,7 @@ signals:
     void switchFullScreen(bool minimizeOnly = false);
     void mouseSeek(int eventDelta, uint modifiers);
     void startDrag();
-    void analyseFrame(const QImage &);
+    void analyseFrame(const ScopeFrame &);
     void showContextMenu(const QPoint &);
     void lockMonitor(bool);
     void passKeyEvent(QKeyEvent *);
@@ -431,7 +431,13 @@ Monitor::Monitor(Kdenlive::MonitorId id, MonitorManager *manager, QWidget *paren
     setMinimumHeight(200);
 
     connect(this, &Monitor::scopesClear, m_glMonitor, &GLWidget::releaseAnalyse, Qt::DirectConnection);
-    connect(m_glMonitor, &GLWidget::analyseFrame, this, &Monitor::frameUpdated);
+    connect(m_glMonitor, &GLWidget::analyseFrame, this, [this](const ScopeFrame &frame) {
+        emit scopeFrameUpdated(frame);
+        if (receivers(SIGNAL(frameUpdated(QImage))) > 0) {
+            // The title widget uses the frame as background
+            emit frameUpdated(frame.image());
+        }
+    });
 
     if (id == Kdenlive::ProjectMonitor) {
         // TODO: reimplement
@@ -516,6 +522,7 @@ void Monitor::setOffsetY(int y)
 void Monitor::slotGetCurrentImage(bool request)
 {
     m_glMonitor->sendFrameForAnalysis = request;
+    m_glMonitor->sendFullFrame = request;
     Kdenlive::MonitorId id = m_monitorManager->activeMonitor()->id();
     m_monitorManager->activateMonitor(m_id);
     refreshMonitorIfActive(true);
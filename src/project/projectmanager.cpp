@@ -22,7 +22,9 @@ the Free Software Foundation, either version 3 of the License, or
 #include "project/dialogs/backupwidget.h"
 #include "project/dialogs/noteswidget.h"
 #include "project/dialogs/projectsettings.h"
+#include "utils/filehasher.hpp"
 #include "utils/thumbnailcache.hpp"
+#include "utils/thumbnailextractor.hpp"
 #include "xml/xml.hpp"
 
 // Temporary for testing
@@ -221,6 +223,7 @@ void ProjectManager::newFile(QString profileName, bool showProjectSettings)
     KdenliveDoc *doc = new KdenliveDoc(QUrl(), projectFolder, pCore->window()->m_commandStack, profileName, documentProperties, documentMetadata, projectTracks, audioChannels, &openBackup, pCore->window());
     doc->m_autosave = new KAutoSaveFile(startFile, doc);
     ThumbnailCache::get()->clearCache();
+    ThumbnailExtractor::get()->clear();
     pCore->bin()->setDocument(doc);
     m_project = doc;
     pCore->monitorManager()->activateMonitor(Kdenlive::ProjectMonitor);
@@ -265,7 +268,6 @@ bool ProjectManager::closeCurrentDocument(bool saveChanges, bool quit)
         }
     }
     ::mlt_pool_purge();
-    pCore->audioThumbCache.clear();
     pCore->jobManager()->slotCancelJobs();
     disconnect(pCore->window()->getMainTimeline()->controller(), &TimelineController::durationChanged, this, &ProjectManager::adjustProjectDuration);
     pCore->window()->getMainTimeline()->controller()->clipActions.clear();
@@ -307,8 +309,7 @@ bool ProjectManager::saveFileAs(const QString &outputFileName, bool saveACopy)
     }
     QUrl url = QUrl::fromLocalFile(outputFileName);
     // Save timeline thumbnails
-    QStringList thumbKeys = pCore->window()->getMainTimeline()->controller()->getThumbKeys();
-    ThumbnailCache::get()->saveCachedThumbs(thumbKeys);
+    ThumbnailCache::get()->saveCachedThumbs(pCore->window()->getMainTimeline()->controller()->getThumbKeys());
     if (!saveACopy) {
         m_project->setUrl(url);
         // setting up autosave file in ~/.kde/data/stalefiles/kdenlive/
@@ -322,6 +323,7 @@ bool ProjectManager::saveFileAs(const QString &outputFileName, bool saveACopy)
             // The file filename does not have to exist for KAutoSaveFile to be constructed (if it exists, it will not be touched).
             m_project->m_autosave = new KAutoSaveFile(autosaveUrl, m_project);
         } else {
+            m_project->flushAutoSave();
             m_project->m_autosave->setManagedFile(autosaveUrl);
         }
 
@@ -336,7 +338,8 @@ bool ProjectManager::saveFileAs(const QString &outputFileName, bool saveACopy)
         m_fileRevert->setEnabled(true);
         pCore->window()->m_undoView->stack()->setClean();
     }
-
+    // Keep the hashes of the project clips in case we crash
+    FileHasher::get()->save();
     return true;
 }
 
@@ -385,6 +388,8 @@ bool ProjectManager::saveFile()
         return saveFileAs();
     }
     bool result = saveFileAs(m_project->url().toLocalFile());
+    // A pending background write would otherwise refill the autosave file after we truncate it
+    m_project->flushAutoSave();
     m_project->m_autosave->resize(0);
     return result;
 }
@@ -517,6 +522,7 @@ void ProjectManager::doOpenFile(const QUrl &url, KAutoSaveFile *stale)
     delete m_progressDialog;
     m_progressDialog = nullptr;
     ThumbnailCache::get()->clearCache();
+    ThumbnailExtractor::get()->clear();
     pCore->monitorManager()->resetDisplay();
     pCore->monitorManager()->activateMonitor(Kdenlive::ProjectMonitor);
     if (!m_loading) {
@@ -10,6 +10,8 @@
 
 #include "histogramgenerator.h"
 #include "colorconstants.h"
+#include "scopeframe.h"
+#include "scopekernel.h"
 
 #include "klocalizedstring.h"
 #include <QImage>
@@ -19,11 +21,11 @@
 
 HistogramGenerator::HistogramGenerator() = default;
 
-QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const QImage &image, const int &components,
+QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const ScopeFrame &frame, const int &components,
                                               ITURec rec, bool unscaled, bool logScale,
                                               uint accelFactor) const
 {
-    if (paradeSize.height() <= 0 || paradeSize.width() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    if (paradeSize.height() <= 0 || paradeSize.width() <= 0 || frame.isNull()) {
         return QImage();
     }
 
@@ -33,43 +35,56 @@ QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const QIm
     bool drawB = (components & HistogramGenerator::ComponentB) != 0;
     bool drawSum = (components & HistogramGenerator::ComponentSum) != 0;
 
-    int r[256], g[256], b[256], y[256], s[766];
-    // Initialize the values to zero
-    std::fill(r, r + 256, 0);
-    std::fill(g, g + 256, 0);
-    std::fill(b, b + 256, 0);
-    std::fill(y, y + 256, 0);
-    std::fill(s, s + 766, 0);
+    // Only the RGB components need RGB pixels, the luma is read from the frame
+    const bool needRgb = drawR || drawG || drawB || drawSum;
+    const QImage source = needRgb ? ScopeKernel::toRgb32(frame.image()) : QImage();
+    const int iw = frame.width();
+    // With acceleration, only every accelFactor-th row is analysed
+    const int sampledRows = (frame.height() + (int)accelFactor - 1) / (int)accelFactor;
 
     const uint ww = (uint)paradeSize.width();
     const uint wh = (uint)paradeSize.height();
 
-    // Read the stats from the input image
-    for (int Y = 0; Y < image.height(); ++Y) {
-        for (int X = 0; X < image.width(); X += (int)accelFactor) {
-
-            QRgb col = image.pixel(X, Y);
-            r[qRed(col)]++;
-            g[qGreen(col)]++;
-            b[qBlue(col)]++;
-
+    // Read the stats from the input image, bins are laid out as r[256], g[256], b[256], y[256], s[766]
+    const std::vector<int> bins = ScopeKernel::accumulateRows<int>(sampledRows, 4 * 256 + 766, [&](const ScopeKernel::RowBlock &block, int *hist) {
+        int *r = hist;
+        int *g = hist + 256;
+        int *b = hist + 512;
+        int *y = hist + 768;
+        int *s = hist + 1024;
+        std::vector<uchar> luma(drawY ? (size_t)iw : 0);
+        for (int row = block.first; row < block.last; ++row) {
             if (drawY) {
-                // Use if branch to avoid expensive multiplication if Y disabled
-                if (rec == ITURec::Rec_601) {
-                    y[(int)floor(REC_601_R * (float) qRed(col) + REC_601_G * (float) qGreen(col) + REC_601_B * (float) qBlue(col))]++;
-                } else {
-                    y[(int)floor(REC_709_R * (float) qRed(col) + REC_709_G * (float) qGreen(col) + REC_709_B * (float) qBlue(col))]++;
+                // Only compute luma if Y is enabled
+                frame.lumaRow(row * (int)accelFactor, rec, luma.data());
+                for (int x = 0; x < iw; ++x) {
+                    y[luma[(size_t)x]]++;
                 }
             }
-
+            if (!needRgb) {
+                continue;
+            }
+            const auto *line = reinterpret_cast<const QRgb *>(source.constScanLine(row * (int)accelFactor));
+            for (int x = 0; x < iw; ++x) {
+                r[qRed(line[x])]++;
+                g[qGreen(line[x])]++;
+                b[qBlue(line[x])]++;
+            }
             if (drawSum) {
                 // Use an if branch here because the sum takes more operations than rgb
-                s[qRed(col)]++;
-                s[qGreen(col)]++;
-                s[qBlue(col)]++;
+                for (int x = 0; x < iw; ++x) {
+                    s[qRed(line[x])]++;
+                    s[qGreen(line[x])]++;
+                    s[qBlue(line[x])]++;
+                }
             }
         }
-    }
+    });
+    const int *r = bins.data();
+    const int *g = r + 256;
+    const int *b = r + 512;
+    const int *y = r + 768;
+    const int *s = r + 1024;
 
     const int nParts = (drawY ? 1 : 0) + (drawR ? 1 : 0) + (drawG ? 1 : 0) + (drawB ? 1 : 0) + (drawSum ? 1 : 0);
     if (nParts == 0) {
@@ -84,7 +99,7 @@ QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const QIm
     const int partH = int((int)wh - nParts * d) / nParts;
 
     // Total number of bytes of the image
-    const uint byteCount = (uint) image.sizeInBytes();
+    const uint byteCount = uint(frame.width()) * uint(frame.height()) * 4;
 
     // Factor for scaling the measured value to the histogram.
     // This factor is used for linear scaling and does not depend
@@ -149,6 +164,7 @@ QImage HistogramGenerator::drawComponent(const int *y, const QSize &size, const
     const int maxBinSize = *std::max_element(&y[0], &y[max - 1]);
     const float logScaling = float(size.height()) / log10f(float(maxBinSize + 1));
 
+    std::vector<int> top(max);
     for (uint x = 0; x < max; ++x) {
 
         // Calculate the height of the curve at position x
@@ -165,8 +181,17 @@ QImage HistogramGenerator::drawComponent(const int *y, const QSize &size, const
         }
         partY = partH - 1 - partY;
 
-        for (int k = partH - 1; k >= partY; --k) {
-            component.setPixel((int)x, k, color.rgba());
+        top[x] = partY;
+    }
+
+    // Write the bars line by line
+    const QRgb rgba = color.rgba();
+    for (int k = 0; k < partH; ++k) {
+        auto *line = reinterpret_cast<QRgb *>(component.scanLine(k));
+        for (uint x = 0; x < max; ++x) {
+            if (k >= top[x]) {
+                line[x] = rgba;
+            }
         }
     }
     if (unscaled && size.width() >= component.width()) {
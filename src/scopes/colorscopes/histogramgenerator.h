@@ -19,6 +19,7 @@ class QImage;
 class QPainter;
 class QRect;
 class QSize;
+class ScopeFrame;
 
 class HistogramGenerator : public QObject
 {
@@ -27,9 +28,10 @@ public:
     explicit HistogramGenerator();
 
     /**
-     * Calculates a histogram display from the input image.
+     * Calculates a histogram display from the input frame.
+     * When only the luma is requested, YUV frames are analysed without converting them to RGB.
      * @param paradeSize
-     * @param image
+     * @param frame
      * @param components OR-ed HistogramGenerator::Components flags and decide with components (Y, R, G, B) to paint.
      * @param rec
      * @param unscaled unscaled = true leaves the width at 256 if the widget is wider (to avoid scaling).
@@ -37,7 +39,7 @@ public:
      * @param accelFactor
      * @return
      */
-    QImage calculateHistogram(const QSize &paradeSize, const QImage &image, const int &components, const ITURec rec, bool unscaled,
+    QImage calculateHistogram(const QSize &paradeSize, const ScopeFrame &frame, const int &components, const ITURec rec, bool unscaled,
                               bool logScale,
                               uint accelFactor = 1) const;
 
@@ -130,13 +130,13 @@ QImage RGBParade::renderHUD(uint)
     return hud;
 }
 
-QImage RGBParade::renderGfxScope(uint accelerationFactor, const QImage &qimage)
+QImage RGBParade::renderGfxScope(uint accelerationFactor, const ScopeFrame &frame)
 {
     QElapsedTimer timer;
     timer.start();
 
     int paintmode = m_ui->paintMode->itemData(m_ui->paintMode->currentIndex()).toInt();
-    QImage parade = m_rgbParadeGenerator->calculateRGBParade(m_scopeRect.size(), qimage, (RGBParadeGenerator::PaintMode)paintmode, m_aAxis->isChecked(),
+    QImage parade = m_rgbParadeGenerator->calculateRGBParade(m_scopeRect.size(), frame.image(), (RGBParadeGenerator::PaintMode)paintmode, m_aAxis->isChecked(),
                                                              m_aGradRef->isChecked(), accelerationFactor);
     emit signalScopeRenderingFinished((uint)timer.elapsed(), accelerationFactor);
     return parade;
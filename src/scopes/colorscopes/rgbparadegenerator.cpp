@@ -9,6 +9,7 @@
  ***************************************************************************/
 
 #include "rgbparadegenerator.h"
+#include "scopekernel.h"
 #include "klocalizedstring.h"
 #include <QColor>
 #include <QPainter>
@@ -23,13 +24,6 @@ const QColor RGBParadeGenerator::colSoft(150, 150, 150, 255);
 const uchar RGBParadeGenerator::distRight(40);
 const uchar RGBParadeGenerator::distBottom(40);
 
-struct StructRGB
-{
-    uint r;
-    uint g;
-    uint b;
-};
-
 RGBParadeGenerator::RGBParadeGenerator() = default;
 
 QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const QImage &image, const RGBParadeGenerator::PaintMode paintMode, bool drawAxis,
@@ -45,92 +39,89 @@ QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const QIm
 
     QPainter davinci(&parade);
 
+    const QImage source = ScopeKernel::toRgb32(image);
     const uint ww = (uint)paradeSize.width();
     const uint wh = (uint)paradeSize.height();
-    const uint iw = (uint)image.bytesPerLine();
-    const uint ih = (uint)image.height();
-    const uint byteCount = iw * ih; // Note that 1 px = 4 B
+    const int iw = source.width();
+    const int ih = source.height();
+    // With acceleration, only every accelFactor-th row is analysed
+    const int sampledRows = (ih + (int)accelFactor - 1) / (int)accelFactor;
 
     const uchar offset = 10;
     const uint partW = (ww - 2 * offset - distRight) / 3;
     const uint partH = wh - distBottom;
 
-    // Statistics
-    uchar minR = 255, minG = 255, minB = 255, maxR = 0, maxG = 0, maxB = 0, r, g, b;
-
     // Number of input pixels that will fall on one scope pixel.
     // Must be a float because the acceleration factor can be high, leading to <1 expected px per px.
-    const float pixelDepth = (float)((byteCount >> 2) / accelFactor) / float(partW * 255);
+    const float pixelDepth = (float)(iw * sampledRows) / float(partW * 255);
     const float gain = 255 / (8 * pixelDepth);
     //        qCDebug(KDENLIVE_LOG) << "Pixel depth: expected " << pixelDepth << "; Gain: using " << gain << " (acceleration: " << accelFactor << "x)";
 
     QImage unscaled((int)ww - distRight, 256, QImage::Format_ARGB32);
     unscaled.fill(qRgba(0, 0, 0, 0));
 
-    const float wPrediv = (float)(partW - 1) / float((int)iw - 1);
-
-    std::vector<std::vector<StructRGB>> paradeVals(partW, std::vector<StructRGB>(256, {0, 0, 0}));
-
-    const uchar *bits = image.bits();
-    const uint stepsize = uint(uint(image.depth() / 8) * accelFactor);
-
-    for (uint i = 0, x = 0; i < byteCount; i += stepsize) {
-        auto *col = (const QRgb *)(bits);
-        r = (uchar)qRed(*col);
-        g = (uchar)qGreen(*col);
-        b = (uchar)qBlue(*col);
-
-        double dx = x * (double)wPrediv;
-
-        paradeVals[(size_t)dx][r].r++;
-        paradeVals[(size_t)dx][g].g++;
-        paradeVals[(size_t)dx][b].b++;
+    const float wPrediv = iw > 1 ? (float)(partW - 1) / float(iw - 1) : 0.;
+    std::vector<uint> columnIndex((size_t)iw);
+    for (int x = 0; x < iw; ++x) {
+        columnIndex[(size_t)x] = uint((float)x * wPrediv);
+    }
 
-        if (r < minR) {
-            minR = r;
-        }
-        if (g < minG) {
-            minG = g;
-        }
-        if (b < minB) {
-            minB = b;
-        }
-        if (r > maxR) {
-            maxR = r;
-        }
-        if (g > maxG) {
-            maxG = g;
-        }
-        if (b > maxB) {
-            maxB = b;
+    // One plane of 256 rows x partW columns per channel, followed by a global histogram per channel used for the statistics
+    const size_t planeSize = 256 * partW;
+    const size_t statsOffset = 3 * planeSize;
+    const std::vector<uint> paradeVals = ScopeKernel::accumulateRows<uint>(sampledRows, statsOffset + 3 * 256, [&](const ScopeKernel::RowBlock &block, uint *bins) {
+        uint *redPlane = bins;
+        uint *greenPlane = bins + planeSize;
+        uint *bluePlane = bins + 2 * planeSize;
+        uint *stats = bins + statsOffset;
+        for (int row = block.first; row < block.last; ++row) {
+            const auto *line = reinterpret_cast<const QRgb *>(source.constScanLine(row * (int)accelFactor));
+            for (int x = 0; x < iw; ++x) {
+                const uint r = (uint)qRed(line[x]);
+                const uint g = (uint)qGreen(line[x]);
+                const uint b = (uint)qBlue(line[x]);
+                const uint column = columnIndex[(size_t)x];
+                redPlane[r * partW + column]++;
+                greenPlane[g * partW + column]++;
+                bluePlane[b * partW + column]++;
+                stats[r]++;
+                stats[256 + g]++;
+                stats[512 + b]++;
+            }
         }
+    });
 
-        bits += stepsize;
-        x += stepsize;
-        x %= iw; // Modulo image width, to represent the current x position in the image
-    }
+    // Statistics
+    uchar minR = 255, minG = 255, minB = 255, maxR = 0, maxG = 0, maxB = 0;
+    auto findRange = [&paradeVals, statsOffset](int channel, uchar &min, uchar &max) {
+        const uint *stats = paradeVals.data() + statsOffset + 256 * channel;
+        for (int i = 0; i < 256; ++i) {
+            if (stats[i] > 0) {
+                min = qMin(min, (uchar)i);
+                max = qMax(max, (uchar)i);
+            }
+        }
+    };
+    findRange(0, minR, maxR);
+    findRange(1, minG, maxG);
+    findRange(2, minB, maxB);
 
     const int offset1 = (int)partW + (int)offset;
     const int offset2 = 2 * (int)partW + 2 * (int)offset;
-    switch (paintMode) {
-    case PaintMode_RGB:
-        for (int i = 0; i < (int)partW; ++i) {
-            for (int j = 0; j < 256; ++j) {
-                unscaled.setPixel(i, j, qRgba(255, 10, 10, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].r)));
-                unscaled.setPixel(i + offset1, j, qRgba(10, 255, 10, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].g)));
-                unscaled.setPixel(i + offset2, j, qRgba(10, 10, 255, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].b)));
-            }
-        }
-        break;
-    default:
+    const QRgb red = paintMode == PaintMode_RGB ? qRgb(255, 10, 10) : qRgb(255, 255, 255);
+    const QRgb green = paintMode == PaintMode_RGB ? qRgb(10, 255, 10) : qRgb(255, 255, 255);
+    const QRgb blue = paintMode == PaintMode_RGB ? qRgb(10, 10, 255) : qRgb(255, 255, 255);
+    auto withAlpha = [gain](QRgb color, uint count) { return (color & RGB_MASK) | (uint(CHOP255(gain * (float)count) & 0xff) << 24); };
+    for (int j = 0; j < 256; ++j) {
+        auto *line = reinterpret_cast<QRgb *>(unscaled.scanLine(j));
+        const uint *r = paradeVals.data() + (size_t)j * partW;
+        const uint *g = r + planeSize;
+        const uint *b = g + planeSize;
         for (int i = 0; i < (int)partW; ++i) {
-            for (int j = 0; j < 256; ++j) {
-                unscaled.setPixel(i, j, qRgba(255, 255, 255, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].r)));
-                unscaled.setPixel(i + offset1, j, qRgba(255, 255, 255, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].g)));
-                unscaled.setPixel(i + offset2, j, qRgba(255, 255, 255, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].b)));
-            }
+            line[i] = withAlpha(red, r[i]);
+            line[i + offset1] = withAlpha(green, g[i]);
+            line[i + offset2] = withAlpha(blue, b[i]);
         }
-        break;
     }
 
     // Scale the image to the target height. Scaling is not accomplished before because
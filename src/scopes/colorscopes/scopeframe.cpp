@@ -0,0 +1,219 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "scopeframe.h"
+#include "scopekernel.h"
+
+#include <QMutex>
+#include <QtGlobal>
+#include <cstring>
+#include <vector>
+
+const int ScopeFrame::defaultMaxWidth = 1024;
+
+struct ScopeFrame::Data
+{
+    int width = 0;
+    int height = 0;
+    int colorspace = 601;
+    bool yuv = false;
+    int chromaWidth = 0;
+    int chromaHeight = 0;
+    // Y plane followed by the U and V planes
+    std::vector<uchar> planes;
+    QMutex imageMutex;
+    QImage image;
+};
+
+namespace {
+// Expansion of video range luma (16-235) to full range
+struct LumaTable
+{
+    uchar values[256];
+    LumaTable()
+    {
+        for (int i = 0; i < 256; ++i) {
+            values[i] = uchar(qBound(0, ((i - 16) * 255 + 109) / 219, 255));
+        }
+    }
+};
+const LumaTable lumaTable;
+
+// Video range YCbCr to RGB, in 10 bit fixed point
+QRgb yuvToRgb(int y, int u, int v, bool rec709)
+{
+    const int c = 1192 * (y - 16) + 512;
+    const int cu = u - 128;
+    const int cv = v - 128;
+    const int r = c + (rec709 ? 1836 : 1634) * cv;
+    const int g = c - (rec709 ? 218 : 401) * cu - (rec709 ? 546 : 832) * cv;
+    const int b = c + (rec709 ? 2163 : 2066) * cu;
+    return qRgb(qBound(0, r >> 10, 255), qBound(0, g >> 10, 255), qBound(0, b >> 10, 255));
+}
+} // namespace
+
+ScopeFrame::ScopeFrame(const QImage &image)
+{
+    if (image.isNull()) {
+        return;
+    }
+    d = std::make_shared<Data>();
+    d->image = ScopeKernel::toRgb32(image);
+    d->width = d->image.width();
+    d->height = d->image.height();
+}
+
+ScopeFrame ScopeFrame::fromYuv420(const uchar *data, int width, int height, int colorspace, int maxWidth)
+{
+    ScopeFrame frame;
+    if (data == nullptr || width < 2 || height < 2) {
+        return frame;
+    }
+    // Keep one pixel out of step in both directions
+    const int step = maxWidth > 0 ? qMax(1, (width + maxWidth - 1) / maxWidth) : 1;
+    frame.d = std::make_shared<Data>();
+    Data &f = *frame.d;
+    f.yuv = true;
+    f.colorspace = colorspace;
+    f.width = width / step;
+    f.height = height / step;
+    f.chromaWidth = (f.width + 1) / 2;
+    f.chromaHeight = (f.height + 1) / 2;
+    const int lumaSize = f.width * f.height;
+    const int chromaSize = f.chromaWidth * f.chromaHeight;
+    f.planes.resize(size_t(lumaSize + 2 * chromaSize));
+
+    const int srcChromaWidth = width / 2;
+    const int srcChromaHeight = height / 2;
+    const uchar *srcU = data + width * height;
+    const uchar *srcV = srcU + srcChromaWidth * srcChromaHeight;
+    uchar *y = f.planes.data();
+    uchar *u = y + lumaSize;
+    uchar *v = u + chromaSize;
+    for (int row = 0; row < f.height; ++row) {
+        const uchar *src = data + size_t(row * step) * size_t(width);
+        uchar *dst = y + row * f.width;
+        if (step == 1) {
+            memcpy(dst, src, size_t(f.width));
+        } else {
+            for (int x = 0; x < f.width; ++x) {
+                dst[x] = src[x * step];
+            }
+        }
+    }
+    // Output chroma sample x covers output luma pixels 2x and 2x + 1, so source chroma sample x * step
+    for (int row = 0; row < f.chromaHeight; ++row) {
+        const int srcRow = qMin(row * step, srcChromaHeight - 1);
+        const uchar *su = srcU + size_t(srcRow) * size_t(srcChromaWidth);
+        const uchar *sv = srcV + size_t(srcRow) * size_t(srcChromaWidth);
+        uchar *du = u + row * f.chromaWidth;
+        uchar *dv = v + row * f.chromaWidth;
+        for (int x = 0; x < f.chromaWidth; ++x) {
+            const int sx = qMin(x * step, srcChromaWidth - 1);
+            du[x] = su[sx];
+            dv[x] = sv[sx];
+        }
+    }
+    return frame;
+}
+
+bool ScopeFrame::isNull() const
+{
+    return !d || d->width <= 0 || d->height <= 0;
+}
+
+bool ScopeFrame::isYuv() const
+{
+    return d && d->yuv;
+}
+
+int ScopeFrame::width() const
+{
+    return d ? d->width : 0;
+}
+
+int ScopeFrame::height() const
+{
+    return d ? d->height : 0;
+}
+
+int ScopeFrame::colorspace() const
+{
+    return d ? d->colorspace : 601;
+}
+
+const uchar *ScopeFrame::lumaLine(int row) const
+{
+    return d->planes.data() + row * d->width;
+}
+
+const uchar *ScopeFrame::uLine(int row) const
+{
+    return d->planes.data() + d->width * d->height + row * d->chromaWidth;
+}
+
+const uchar *ScopeFrame::vLine(int row) const
+{
+    return d->planes.data() + d->width * d->height + (d->chromaHeight + row) * d->chromaWidth;
+}
+
+int ScopeFrame::chromaWidth() const
+{
+    return d ? d->chromaWidth : 0;
+}
+
+int ScopeFrame::chromaHeight() const
+{
+    return d ? d->chromaHeight : 0;
+}
+
+void ScopeFrame::lumaRow(int row, ITURec rec, uchar *dst) const
+{
+    if (d->yuv) {
+        const uchar *src = lumaLine(row);
+        for (int x = 0; x < d->width; ++x) {
+            dst[x] = lumaTable.values[src[x]];
+        }
+    } else {
+        ScopeKernel::lumaRow(reinterpret_cast<const QRgb *>(d->image.constScanLine(row)), d->width, rec, dst);
+    }
+}
+
+QRgb ScopeFrame::pixel(int x, int y) const
+{
+    if (d->yuv) {
+        return yuvToRgb(lumaLine(y)[x], uLine(y / 2)[x / 2], vLine(y / 2)[x / 2], d->colorspace == 709);
+    }
+    return reinterpret_cast<const QRgb *>(d->image.constScanLine(y))[x];
+}
+
+QImage ScopeFrame::image() const
+{
+    if (!d) {
+        return QImage();
+    }
+    QMutexLocker lock(&d->imageMutex);
+    if (!d->image.isNull() || !d->yuv) {
+        return d->image;
+    }
+    const bool rec709 = d->colorspace == 709;
+    QImage image(d->width, d->height, QImage::Format_RGB32);
+    for (int row = 0; row < d->height; ++row) {
+        const uchar *y = lumaLine(row);
+        const uchar *u = uLine(row / 2);
+        const uchar *v = vLine(row / 2);
+        auto *line = reinterpret_cast<QRgb *>(image.scanLine(row));
+        for (int x = 0; x < d->width; ++x) {
+            line[x] = yuvToRgb(y[x], u[x / 2], v[x / 2], rec709);
+        }
+    }
+    d->image = image;
+    return d->image;
+}
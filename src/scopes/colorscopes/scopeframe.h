@@ -0,0 +1,74 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef SCOPEFRAME_H
+#define SCOPEFRAME_H
+
+#include "colorconstants.h"
+
+#include <QImage>
+#include <QMetaType>
+#include <memory>
+
+/**
+ * A frame sent to the color scopes.
+ *
+ * When the monitor displays decoded YUV 4:2:0 frames, the planes are copied here directly from the
+ * SharedFrame, decimated so that the frame is at most maxWidth pixels wide. The luma based scopes then
+ * read Y and the vectorscope reads U/V without any GPU readback or RGB conversion. Other sources
+ * (GPU rendered frames, capture devices) are wrapped as an RGB image.
+ *
+ * Copies are cheap, the data is shared. The RGB image of a YUV frame is only computed when a scope
+ * asks for it, and then shared between all copies.
+ */
+class ScopeFrame
+{
+public:
+    /** @brief Frames larger than this are decimated when created from planes, scopes do not need more */
+    static const int defaultMaxWidth;
+
+    ScopeFrame() = default;
+    explicit ScopeFrame(const QImage &image);
+    /** @brief Creates a frame from a planar yuv420p buffer (Y, then U and V at half resolution), in video range.
+     *  @param colorspace 601 or 709, used when converting to RGB */
+    static ScopeFrame fromYuv420(const uchar *data, int width, int height, int colorspace = 601, int maxWidth = defaultMaxWidth);
+
+    bool isNull() const;
+    /** @brief True if the frame holds Y/U/V planes, false if it wraps an RGB image */
+    bool isYuv() const;
+    int width() const;
+    int height() const;
+    int colorspace() const;
+
+    /** @brief Raw planes of a YUV frame. The chroma planes have chromaWidth() x chromaHeight() samples */
+    const uchar *lumaLine(int row) const;
+    const uchar *uLine(int row) const;
+    const uchar *vLine(int row) const;
+    int chromaWidth() const;
+    int chromaHeight() const;
+
+    /** @brief Writes the full range (0-255) luma of a row in dst, width() values.
+     *  The Y plane is only expanded from video range, rec is used to compute luma from RGB frames */
+    void lumaRow(int row, ITURec rec, uchar *dst) const;
+
+    /** @brief RGB value of a single pixel */
+    QRgb pixel(int x, int y) const;
+
+    /** @brief The frame as a 32 bit RGB image */
+    QImage image() const;
+
+private:
+    struct Data;
+    std::shared_ptr<Data> d;
+};
+
+Q_DECLARE_METATYPE(ScopeFrame)
+
+#endif // SCOPEFRAME_H
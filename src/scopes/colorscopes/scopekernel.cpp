@@ -0,0 +1,227 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "scopekernel.h"
+
+#include <QThread>
+#include <QtConcurrent>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+std::atomic<int> s_maxThreads(0);
+std::atomic<bool> s_simdEnabled(true);
+
+// Minimum number of rows handled by one block, below that threading costs more than it brings
+const int minBlockRows = 32;
+
+// Luma factors in 1.15 fixed point, so that they fit the 16 bit multiply-add instructions
+const int REC_601_FIXED[3] = {9798, 19235, 3736};
+const int REC_709_FIXED[3] = {6963, 23442, 2363};
+
+void lumaScalar(const QRgb *src, int count, const int *k, uchar *dst)
+{
+    for (int i = 0; i < count; ++i) {
+        const QRgb px = src[i];
+        const int y = (qRed(px) * k[0] + qGreen(px) * k[1] + qBlue(px) * k[2]) >> 15;
+        dst[i] = uchar(y > 255 ? 255 : y);
+    }
+}
+
+void chromaScalar(const QRgb *src, int count, const float *c, float *u, float *v)
+{
+    for (int i = 0; i < count; ++i) {
+        const float r = qRed(src[i]);
+        const float g = qGreen(src[i]);
+        const float b = qBlue(src[i]);
+        u[i] = c[0] * r + c[1] * g + c[2] * b;
+        v[i] = c[3] * r + c[4] * g + c[5] * b;
+    }
+}
+
+#if defined(__AVX2__)
+int lumaSimd(const QRgb *src, int count, const int *k, uchar *dst)
+{
+    // In memory, a RGB32 pixel is B, G, R, A
+    const __m256i coeffs = _mm256_setr_epi16(short(k[2]), short(k[1]), short(k[0]), 0, short(k[2]), short(k[1]), short(k[0]), 0, short(k[2]),
+                                             short(k[1]), short(k[0]), 0, short(k[2]), short(k[1]), short(k[0]), 0);
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        // Per 128 bit lane: pixels 0,1 in lo and 2,3 in hi, as 16 bit values
+        const __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi8(px, zero), coeffs);
+        const __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi8(px, zero), coeffs);
+        // Add the (b*kb + g*kg) and (r*kr) halves of each pixel
+        const __m256 even = _mm256_shuffle_ps(_mm256_castsi256_ps(lo), _mm256_castsi256_ps(hi), _MM_SHUFFLE(2, 0, 2, 0));
+        const __m256 odd = _mm256_shuffle_ps(_mm256_castsi256_ps(lo), _mm256_castsi256_ps(hi), _MM_SHUFFLE(3, 1, 3, 1));
+        __m256i y = _mm256_srli_epi32(_mm256_add_epi32(_mm256_castps_si256(even), _mm256_castps_si256(odd)), 15);
+        y = _mm256_packs_epi32(y, y);
+        y = _mm256_packus_epi16(y, y);
+        const int first = _mm_cvtsi128_si32(_mm256_castsi256_si128(y));
+        const int second = _mm_cvtsi128_si32(_mm256_extracti128_si256(y, 1));
+        memcpy(dst + i, &first, 4);
+        memcpy(dst + i + 4, &second, 4);
+    }
+    return i;
+}
+
+int chromaSimd(const QRgb *src, int count, const float *c, float *u, float *v)
+{
+    const __m256i mask = _mm256_set1_epi32(0xff);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        const __m256 r = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 16), mask));
+        const __m256 g = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 8), mask));
+        const __m256 b = _mm256_cvtepi32_ps(_mm256_and_si256(px, mask));
+        __m256 acc = _mm256_mul_ps(r, _mm256_set1_ps(c[0]));
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(g, _mm256_set1_ps(c[1])));
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(b, _mm256_set1_ps(c[2])));
+        _mm256_storeu_ps(u + i, acc);
+        acc = _mm256_mul_ps(r, _mm256_set1_ps(c[3]));
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(g, _mm256_set1_ps(c[4])));
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(b, _mm256_set1_ps(c[5])));
+        _mm256_storeu_ps(v + i, acc);
+    }
+    return i;
+}
+#elif defined(__SSE2__)
+int lumaSimd(const QRgb *src, int count, const int *k, uchar *dst)
+{
+    // In memory, a RGB32 pixel is B, G, R, A
+    const __m128i coeffs = _mm_setr_epi16(short(k[2]), short(k[1]), short(k[0]), 0, short(k[2]), short(k[1]), short(k[0]), 0);
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        // Pixels 0,1 in lo and 2,3 in hi, as 16 bit values
+        const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(px, zero), coeffs);
+        const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(px, zero), coeffs);
+        // Add the (b*kb + g*kg) and (r*kr) halves of each pixel
+        const __m128 even = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1));
+        __m128i y = _mm_srli_epi32(_mm_add_epi32(_mm_castps_si128(even), _mm_castps_si128(odd)), 15);
+        y = _mm_packs_epi32(y, y);
+        y = _mm_packus_epi16(y, y);
+        const int packed = _mm_cvtsi128_si32(y);
+        memcpy(dst + i, &packed, 4);
+    }
+    return i;
+}
+
+int chromaSimd(const QRgb *src, int count, const float *c, float *u, float *v)
+{
+    const __m128i mask = _mm_set1_epi32(0xff);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        const __m128 r = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(px, 16), mask));
+        const __m128 g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(px, 8), mask));
+        const __m128 b = _mm_cvtepi32_ps(_mm_and_si128(px, mask));
+        __m128 acc = _mm_mul_ps(r, _mm_set1_ps(c[0]));
+        acc = _mm_add_ps(acc, _mm_mul_ps(g, _mm_set1_ps(c[1])));
+        acc = _mm_add_ps(acc, _mm_mul_ps(b, _mm_set1_ps(c[2])));
+        _mm_storeu_ps(u + i, acc);
+        acc = _mm_mul_ps(r, _mm_set1_ps(c[3]));
+        acc = _mm_add_ps(acc, _mm_mul_ps(g, _mm_set1_ps(c[4])));
+        acc = _mm_add_ps(acc, _mm_mul_ps(b, _mm_set1_ps(c[5])));
+        _mm_storeu_ps(v + i, acc);
+    }
+    return i;
+}
+#else
+int lumaSimd(const QRgb *, int, const int *, uchar *)
+{
+    return 0;
+}
+
+int chromaSimd(const QRgb *, int, const float *, float *, float *)
+{
+    return 0;
+}
+#endif
+} // namespace
+
+void ScopeKernel::setMaxThreads(int count)
+{
+    s_maxThreads = qMax(0, count);
+}
+
+int ScopeKernel::maxThreads()
+{
+    int count = s_maxThreads;
+    return count > 0 ? count : qMax(1, QThread::idealThreadCount());
+}
+
+void ScopeKernel::setSimdEnabled(bool enabled)
+{
+    s_simdEnabled = enabled;
+}
+
+bool ScopeKernel::simdEnabled()
+{
+    return s_simdEnabled;
+}
+
+QImage ScopeKernel::toRgb32(const QImage &image)
+{
+    switch (image.format()) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        return image;
+    default:
+        return image.convertToFormat(QImage::Format_ARGB32);
+    }
+}
+
+std::vector<ScopeKernel::RowBlock> ScopeKernel::rowBlocks(int rowCount)
+{
+    std::vector<RowBlock> blocks;
+    if (rowCount <= 0) {
+        return blocks;
+    }
+    const int count = qBound(1, rowCount / minBlockRows, maxThreads());
+    blocks.reserve((size_t)count);
+    for (int i = 0; i < count; ++i) {
+        blocks.push_back({i, int((qint64)rowCount * i / count), int((qint64)rowCount * (i + 1) / count)});
+    }
+    return blocks;
+}
+
+void ScopeKernel::runBlocks(std::vector<RowBlock> &blocks, const std::function<void(const RowBlock &)> &fn)
+{
+    if (blocks.size() == 1) {
+        fn(blocks.front());
+        return;
+    }
+    QtConcurrent::blockingMap(blocks, [&fn](RowBlock &block) { fn(block); });
+}
+
+void ScopeKernel::lumaRow(const QRgb *src, int count, ITURec rec, uchar *dst)
+{
+    const int *k = rec == ITURec::Rec_601 ? REC_601_FIXED : REC_709_FIXED;
+    int done = s_simdEnabled ? lumaSimd(src, count, k, dst) : 0;
+    lumaScalar(src + done, count - done, k, dst + done);
+}
+
+void ScopeKernel::chromaRow(const QRgb *src, int count, const float *coeffs, float *u, float *v)
+{
+    int done = s_simdEnabled ? chromaSimd(src, count, coeffs, u, v) : 0;
+    chromaScalar(src + done, count - done, coeffs, u + done, v + done);
+}
@@ -0,0 +1,90 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef SCOPEKERNEL_H
+#define SCOPEKERNEL_H
+
+#include "colorconstants.h"
+
+#include <QImage>
+#include <functional>
+#include <vector>
+
+/**
+ * Shared building blocks for the color scope generators.
+ *
+ * The input image is split in blocks of rows that are processed in parallel, each block accumulating
+ * into its own flat buffer so that no synchronization is needed. Luma and chroma conversion of a row
+ * use SSE2/AVX2 when the compiler targets them, with a scalar fallback.
+ */
+namespace ScopeKernel {
+
+/** @brief A range of rows [first, last) processed by one thread */
+struct RowBlock
+{
+    int index;
+    int first;
+    int last;
+};
+
+/** @brief Limits the number of threads used by the kernels, 0 means QThread::idealThreadCount() */
+void setMaxThreads(int count);
+int maxThreads();
+
+/** @brief Enables or disables the vectorized code paths. Mostly useful to compare against the scalar fallback */
+void setSimdEnabled(bool enabled);
+bool simdEnabled();
+
+/** @brief Returns the image in a 32 bit per pixel format the kernels can read, converting it only if required */
+QImage toRgb32(const QImage &image);
+
+/** @brief Splits rowCount rows in blocks, one per available thread */
+std::vector<RowBlock> rowBlocks(int rowCount);
+
+/** @brief Runs fn on every block, in parallel */
+void runBlocks(std::vector<RowBlock> &blocks, const std::function<void(const RowBlock &)> &fn);
+
+/** @brief Computes the 8 bit luma of count packed RGB32 pixels */
+void lumaRow(const QRgb *src, int count, ITURec rec, uchar *dst);
+
+/** @brief Computes the chroma components of count packed RGB32 pixels.
+ *  @param coeffs the RGB to U and RGB to V factors, in this order: ur, ug, ub, vr, vg, vb
+ */
+void chromaRow(const QRgb *src, int count, const float *coeffs, float *u, float *v);
+
+/** @brief Accumulates rowCount rows in parallel into binCount counters.
+ *  fn is called for each block with a zeroed buffer of binCount elements owned by that block.
+ *  The buffers are then summed and the result returned.
+ */
+template <typename T> std::vector<T> accumulateRows(int rowCount, size_t binCount, const std::function<void(const RowBlock &, T *)> &fn)
+{
+    std::vector<RowBlock> blocks = rowBlocks(rowCount);
+    std::vector<std::vector<T>> buffers(blocks.size());
+    runBlocks(blocks, [&](const RowBlock &block) {
+        buffers[(size_t)block.index].assign(binCount, T());
+        fn(block, buffers[(size_t)block.index].data());
+    });
+    if (buffers.empty()) {
+        return std::vector<T>(binCount, T());
+    }
+    std::vector<T> &result = buffers.front();
+    for (size_t i = 1; i < buffers.size(); ++i) {
+        const T *src = buffers[i].data();
+        T *dst = result.data();
+        for (size_t j = 0; j < binCount; ++j) {
+            dst[j] += src[j];
+        }
+    }
+    return std::move(result);
+}
+
+} // namespace ScopeKernel
+
+#endif // SCOPEKERNEL_H
@@ -64,7 +64,10 @@ mRgb2YPbPr =                        r =
  */
 
 #include "vectorscopegenerator.h"
+#include "scopeframe.h"
+#include "scopekernel.h"
 #include <QImage>
+#include <algorithm>
 #include <cmath>
 
 // The maximum distance from the center for any RGB color is 0.63, so
@@ -108,11 +111,11 @@ QPoint VectorscopeGenerator::mapToCircle(const QSize &targetSize, const QPointF
     return {int((targetSize.width() - 1) * (point.x() + 1) / 2), int((targetSize.height() - 1) * (1 - (point.y() + 1) / 2))};
 }
 
-QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize, const QImage &image, const float &gain,
+QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize, const ScopeFrame &frame, const float &gain,
                                                   const VectorscopeGenerator::PaintMode &paintMode, const VectorscopeGenerator::ColorSpace &colorSpace, bool,
                                                   uint accelFactor) const
 {
-    if (vectorscopeSize.width() <= 0 || vectorscopeSize.height() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    if (vectorscopeSize.width() <= 0 || vectorscopeSize.height() <= 0 || frame.isNull()) {
         // Invalid size
         return QImage();
     }
@@ -122,147 +125,186 @@ QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize,
     QImage scope = QImage(cw, cw, QImage::Format_ARGB32);
     scope.fill(qRgba(0, 0, 0, 0));
 
-    const uchar *bits = image.bits();
-
-    double dy, dr, dg, db, dmax;
-    double /*y,*/ u, v;
-    QPoint pt;
-    QRgb px;
-
-    const int stepsize = int(uint(image.depth() / 8) * accelFactor);
+    // YUV frames are plotted from their chroma planes, one point per chroma sample
+    const bool yuv = frame.isYuv();
+    const QImage source = yuv ? QImage() : ScopeKernel::toRgb32(frame.image());
+    const int iw = yuv ? frame.chromaWidth() : frame.width();
+    const int ih = yuv ? frame.chromaHeight() : frame.height();
+    // With acceleration, only every accelFactor-th row is analysed
+    const int sampledRows = (ih + (int)accelFactor - 1) / (int)accelFactor;
 
     // Just an average for the number of image pixels per scope pixel.
-    // NOTE: byteCount() has to be replaced by (img.bytesPerLine()*img.height()) for Qt 4.5 to compile, see:
-    // https://doc.qt.io/qt-5/qimage.html#bytesPerLine
-    double avgPxPerPx = (double)image.depth() / 8 * (image.bytesPerLine() * image.height()) / scope.size().width() / scope.size().height() / accelFactor;
-
-    for (int i = 0; i < (image.bytesPerLine() * image.height()); i += stepsize) {
-        auto *col = (const QRgb *)(bits);
-
-        int r = qRed(*col);
-        int g = qGreen(*col);
-        int b = qBlue(*col);
-
-        switch (colorSpace) {
-        case VectorscopeGenerator::ColorSpace_YUV:
-            //             y = (double)  0.001173 * r +0.002302 * g +0.0004471* b;
-            u = (double)-0.0005781 * r - 0.001135 * g + 0.001713 * b;
-            v = (double)0.002411 * r - 0.002019 * g - 0.0003921 * b;
-            break;
-        case VectorscopeGenerator::ColorSpace_YPbPr:
-        default:
-            //             y = (double)  0.001173 * r +0.002302 * g +0.0004471* b;
-            u = (double)-0.0006671 * r - 0.001299 * g + 0.0019608 * b;
-            v = (double)0.001961 * r - 0.001642 * g - 0.0003189 * b;
-            break;
+    // Kept in the historical unit (bytes of a 32 bit image, scaled by the pixel depth) so that the paint modes look the same.
+    const double avgPxPerPx = 16. * iw * sampledRows / scope.size().width() / scope.size().height();
+
+    // RGB to U and V conversion factors
+    const float yuvCoeffs[6] = {-0.0005781f, -0.001135f, 0.001713f, 0.002411f, -0.002019f, -0.0003921f};
+    const float ypbprCoeffs[6] = {-0.0006671f, -0.001299f, 0.0019608f, 0.001961f, -0.001642f, -0.0003189f};
+    const float *coeffs = colorSpace == VectorscopeGenerator::ColorSpace_YUV ? yuvCoeffs : ypbprCoeffs;
+    // Video range Cb/Cr to U and V (or Pb and Pr), which only differ by a scaling factor
+    float uTable[256];
+    float vTable[256];
+    if (yuv) {
+        const float uScale = colorSpace == VectorscopeGenerator::ColorSpace_YUV ? 0.436f / 0.5f : 1.f;
+        const float vScale = colorSpace == VectorscopeGenerator::ColorSpace_YUV ? 0.615f / 0.5f : 1.f;
+        for (int i = 0; i < 256; ++i) {
+            uTable[i] = uScale * float(i - 128) / 224.f;
+            vTable[i] = vScale * float(i - 128) / 224.f;
         }
+    }
 
-        pt = mapToCircle(vectorscopeSize, QPointF(SCALING * gain * u, SCALING * gain * v));
-
-        if (pt.x() >= scope.width() || pt.x() < 0 || pt.y() >= scope.height() || pt.y() < 0) {
-            // Point lies outside (because of scaling), don't plot it
-
-        } else {
-
-            // Draw the pixel using the chosen draw mode.
-            switch (paintMode) {
-            case PaintMode_YUV:
-                // see yuvColorWheel
-                dy = 128; // Default Y value. Lower = darker.
-
-                // Calculate the RGB values from YUV/YPbPr
-                switch (colorSpace) {
-                case VectorscopeGenerator::ColorSpace_YUV:
-                    dr = dy + 290.8 * v;
-                    dg = dy - 100.6 * u - 148 * v;
-                    db = dy + 517.2 * u;
-                    break;
-                case VectorscopeGenerator::ColorSpace_YPbPr:
-                default:
-                    dr = dy + 357.5 * v;
-                    dg = dy - 87.75 * u - 182 * v;
-                    db = dy + 451.9 * u;
-                    break;
-                }
-
-                if (dr < 0) {
-                    dr = 0;
-                }
-                if (dg < 0) {
-                    dg = 0;
-                }
-                if (db < 0) {
-                    db = 0;
+    // Each block counts the hits per scope pixel, and remembers the last input color that hit it
+    // since some paint modes only use the color of the last plotted pixel.
+    const size_t scopeSize = size_t(cw) * size_t(cw);
+    std::vector<ScopeKernel::RowBlock> blocks = ScopeKernel::rowBlocks(sampledRows);
+    std::vector<std::vector<uint>> hits(blocks.size());
+    std::vector<std::vector<QRgb>> lastColor(blocks.size());
+    const bool needColor = paintMode == PaintMode_YUV || paintMode == PaintMode_Chroma || paintMode == PaintMode_Original;
+    ScopeKernel::runBlocks(blocks, [&](const ScopeKernel::RowBlock &block) {
+        std::vector<uint> &blockHits = hits[(size_t)block.index];
+        std::vector<QRgb> &blockColor = lastColor[(size_t)block.index];
+        blockHits.assign(scopeSize, 0);
+        if (needColor) {
+            blockColor.assign(scopeSize, 0);
+        }
+        std::vector<float> u((size_t)iw), v((size_t)iw);
+        for (int row = block.first; row < block.last; ++row) {
+            const int srcRow = row * (int)accelFactor;
+            const QRgb *line = nullptr;
+            if (yuv) {
+                const uchar *cb = frame.uLine(srcRow);
+                const uchar *cr = frame.vLine(srcRow);
+                for (int x = 0; x < iw; ++x) {
+                    u[(size_t)x] = uTable[cb[x]];
+                    v[(size_t)x] = vTable[cr[x]];
                 }
-                if (dr > 255) {
-                    dr = 255;
+            } else {
+                line = reinterpret_cast<const QRgb *>(source.constScanLine(srcRow));
+                ScopeKernel::chromaRow(line, iw, coeffs, u.data(), v.data());
+            }
+            for (int x = 0; x < iw; ++x) {
+                const QPoint pt = mapToCircle(vectorscopeSize, QPointF(SCALING * gain * u[(size_t)x], SCALING * gain * v[(size_t)x]));
+                if (pt.x() >= cw || pt.x() < 0 || pt.y() >= cw || pt.y() < 0) {
+                    // Point lies outside (because of scaling), don't plot it
+                    continue;
                 }
-                if (dg > 255) {
-                    dg = 255;
+                const size_t index = size_t(pt.y()) * size_t(cw) + size_t(pt.x());
+                blockHits[index]++;
+                if (needColor) {
+                    blockColor[index] = yuv ? frame.pixel(qMin(2 * x, frame.width() - 1), qMin(2 * srcRow, frame.height() - 1)) : line[x];
                 }
-                if (db > 255) {
-                    db = 255;
+            }
+        }
+    });
+
+    // Merge the blocks. They are ordered by rows, so the last block hitting a pixel holds its last color
+    std::vector<uint> totalHits(scopeSize, 0);
+    std::vector<QRgb> colors(needColor ? scopeSize : 0, 0);
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        for (size_t i = 0; i < scopeSize; ++i) {
+            if (hits[b][i] > 0) {
+                totalHits[i] += hits[b][i];
+                if (needColor) {
+                    colors[i] = lastColor[b][i];
                 }
+            }
+        }
+    }
 
-                scope.setPixel(pt, qRgba(dr, dg, db, 255));
+    // For the accumulating paint modes, the result only depends on the number of hits:
+    // precompute the color after n hits until it does not change anymore.
+    std::vector<QRgb> accumulated;
+    if (!needColor) {
+        auto step = [paintMode, avgPxPerPx](QRgb px) -> QRgb {
+            switch (paintMode) {
+            case PaintMode_Green:
+                return qRgba(qRed(px) + (255 - qRed(px)) / (3 * avgPxPerPx), qGreen(px) + 20 * (255 - qGreen(px)) / (avgPxPerPx),
+                             qBlue(px) + (255 - qBlue(px)) / (avgPxPerPx), qAlpha(px) + (255 - qAlpha(px)) / (avgPxPerPx));
+            case PaintMode_Green2:
+                return qRgba(qRed(px) + ceil((255 - (float)qRed(px)) / (4 * avgPxPerPx)), 255, qBlue(px) + ceil((255 - (float)qBlue(px)) / (avgPxPerPx)),
+                             qAlpha(px) + ceil((255 - (float)qAlpha(px)) / (avgPxPerPx)));
+            default:
+                return qRgba(0, 0, 0, qAlpha(px) + (255 - qAlpha(px)) / 20);
+            }
+        };
+        const uint maxHits = totalHits.empty() ? 0 : *std::max_element(totalHits.begin(), totalHits.end());
+        accumulated.push_back(qRgba(0, 0, 0, 0));
+        while (accumulated.size() <= maxHits) {
+            QRgb next = step(accumulated.back());
+            if (next == accumulated.back()) {
                 break;
+            }
+            accumulated.push_back(next);
+        }
+    }
 
-            case PaintMode_Chroma:
-                dy = 200; // Default Y value. Lower = darker.
-
-                // Calculate the RGB values from YUV/YPbPr
-                switch (colorSpace) {
-                case VectorscopeGenerator::ColorSpace_YUV:
-                    dr = dy + 290.8 * v;
-                    dg = dy - 100.6 * u - 148 * v;
-                    db = dy + 517.2 * u;
-                    break;
-                case VectorscopeGenerator::ColorSpace_YPbPr:
-                default:
-                    dr = dy + 357.5 * v;
-                    dg = dy - 87.75 * u - 182 * v;
-                    db = dy + 451.9 * u;
-                    break;
-                }
+    // Draw the pixels using the chosen draw mode.
+    for (int j = 0; j < cw; ++j) {
+        auto *line = reinterpret_cast<QRgb *>(scope.scanLine(j));
+        for (int i = 0; i < cw; ++i) {
+            const size_t index = size_t(j) * size_t(cw) + size_t(i);
+            const uint count = totalHits[index];
+            if (count == 0) {
+                continue;
+            }
+            if (!needColor) {
+                line[i] = accumulated[qMin<size_t>(count, accumulated.size() - 1)];
+                continue;
+            }
+            const QRgb col = colors[index];
+            if (paintMode == PaintMode_Original) {
+                line[i] = col;
+                continue;
+            }
+            double dy, dr, dg, db, dmax;
+            double u, v;
+            int r = qRed(col);
+            int g = qGreen(col);
+            int b = qBlue(col);
+            switch (colorSpace) {
+            case VectorscopeGenerator::ColorSpace_YUV:
+                u = (double)-0.0005781 * r - 0.001135 * g + 0.001713 * b;
+                v = (double)0.002411 * r - 0.002019 * g - 0.0003921 * b;
+                break;
+            case VectorscopeGenerator::ColorSpace_YPbPr:
+            default:
+                u = (double)-0.0006671 * r - 0.001299 * g + 0.0019608 * b;
+                v = (double)0.001961 * r - 0.001642 * g - 0.0003189 * b;
+                break;
+            }
+            // see yuvColorWheel
+            // Default Y value. Lower = darker.
+            dy = paintMode == PaintMode_YUV ? 128 : 200;
+
+            // Calculate the RGB values from YUV/YPbPr
+            switch (colorSpace) {
+            case VectorscopeGenerator::ColorSpace_YUV:
+                dr = dy + 290.8 * v;
+                dg = dy - 100.6 * u - 148 * v;
+                db = dy + 517.2 * u;
+                break;
+            case VectorscopeGenerator::ColorSpace_YPbPr:
+            default:
+                dr = dy + 357.5 * v;
+                dg = dy - 87.75 * u - 182 * v;
+                db = dy + 451.9 * u;
+                break;
+            }
 
+            if (paintMode == PaintMode_YUV) {
+                dr = qBound(0., dr, 255.);
+                dg = qBound(0., dg, 255.);
+                db = qBound(0., db, 255.);
+            } else {
                 // Scale the RGB values back to max 255
-                dmax = dr;
-                if (dg > dmax) {
-                    dmax = dg;
-                }
-                if (db > dmax) {
-                    dmax = db;
-                }
+                dmax = qMax(dr, qMax(dg, db));
                 dmax = 255 / dmax;
-
                 dr *= dmax;
                 dg *= dmax;
                 db *= dmax;
-
-                scope.setPixel(pt, qRgba(dr, dg, db, 255));
-                break;
-            case PaintMode_Original:
-                scope.setPixel(pt, *col);
-                break;
-            case PaintMode_Green:
-                px = scope.pixel(pt);
-                scope.setPixel(pt, qRgba(qRed(px) + (255 - qRed(px)) / (3 * avgPxPerPx), qGreen(px) + 20 * (255 - qGreen(px)) / (avgPxPerPx),
-                                         qBlue(px) + (255 - qBlue(px)) / (avgPxPerPx), qAlpha(px) + (255 - qAlpha(px)) / (avgPxPerPx)));
-                break;
-            case PaintMode_Green2:
-                px = scope.pixel(pt);
-                scope.setPixel(pt,
-                               qRgba(qRed(px) + ceil((255 - (float)qRed(px)) / (4 * avgPxPerPx)), 255,
-                                     qBlue(px) + ceil((255 - (float)qBlue(px)) / (avgPxPerPx)), qAlpha(px) + ceil((255 - (float)qAlpha(px)) / (avgPxPerPx))));
-                break;
-            case PaintMode_Black:
-                px = scope.pixel(pt);
-                scope.setPixel(pt, qRgba(0, 0, 0, qAlpha(px) + (255 - qAlpha(px)) / 20));
-                break;
             }
+            line[i] = qRgba(dr, dg, db, 255);
         }
-
-        bits += stepsize;
     }
     return scope;
 }
@@ -10,7 +10,10 @@
 
 #include "waveformgenerator.h"
 #include "colorconstants.h"
+#include "scopeframe.h"
+#include "scopekernel.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include <QImage>
@@ -25,7 +28,7 @@ WaveformGenerator::WaveformGenerator() = default;
 
 WaveformGenerator::~WaveformGenerator() = default;
 
-QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const QImage &image, WaveformGenerator::PaintMode paintMode, bool drawAxis,
+QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const ScopeFrame &frame, WaveformGenerator::PaintMode paintMode, bool drawAxis,
                                             ITURec rec, uint accelFactor)
 {
     Q_ASSERT(accelFactor >= 1);
@@ -35,93 +38,77 @@ QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const QIm
 
     QImage wave(waveformSize, QImage::Format_ARGB32);
 
-    if (waveformSize.width() <= 0 || waveformSize.height() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    if (waveformSize.width() <= 0 || waveformSize.height() <= 0 || frame.isNull()) {
         return QImage();
     }
 
-    // Fill with transparent color
-    wave.fill(qRgba(0, 0, 0, 0));
-
     const uint ww = (uint)waveformSize.width();
     const uint wh = (uint)waveformSize.height();
-    const uint iw = (uint)image.bytesPerLine();
-    const uint ih = (uint)image.height();
-    const uint byteCount = iw * ih;
-
-    std::vector<std::vector<uint>> waveValues((size_t)waveformSize.width(), std::vector<uint>((size_t)waveformSize.height(), 0));
+    const int iw = frame.width();
+    const int ih = frame.height();
+    // With acceleration, only every accelFactor-th row is analysed
+    const int sampledRows = (ih + (int)accelFactor - 1) / (int)accelFactor;
 
     // Number of input pixels that will fall on one scope pixel.
     // Must be a float because the acceleration factor can be high, leading to <1 expected px per px.
-    const float pixelDepth = (float)((byteCount >> 2) / accelFactor) / float(ww * wh);
+    const float pixelDepth = (float)(iw * sampledRows) / float(ww * wh);
     const float gain = 255. / (8. * pixelDepth);
     // qCDebug(KDENLIVE_LOG) << "Pixel depth: expected " << pixelDepth << "; Gain: using " << gain << " (acceleration: " << accelFactor << "x)";
 
     // Subtract 1 from sizes because we start counting from 0.
     // Not doing it would result in attempts to paint outside of the image.
     const float hPrediv = (float)(wh - 1) / 255.;
-    const float wPrediv = (float)(ww - 1) / float(iw - 1);
-
-    const uchar *bits = image.bits();
-    const int bpp = image.depth() / 8;
-
-    for (uint i = 0, x = 0; i < byteCount; i += (uint)bpp) {
+    const float wPrediv = iw > 1 ? (float)(ww - 1) / float(iw - 1) : 0.;
 
-        Q_ASSERT(bits < image.bits() + byteCount);
-
-        double dY, dx, dy;
-        auto *col = (const QRgb *)bits;
-
-        if (rec == ITURec::Rec_601) {
-            // CIE 601 Luminance
-            dY = REC_601_R * float(qRed(*col)) + REC_601_G * float(qGreen(*col)) + REC_601_B * float(qBlue(*col));
-        } else {
-            // CIE 709 Luminance
-            dY = REC_709_R * float(qRed(*col)) + REC_709_G * float(qGreen(*col)) + REC_709_B * float(qBlue(*col));
-        }
-        // dY is on [0,255] now.
-
-        dy = dY * hPrediv;
-        dx = (float)x * wPrediv;
-        waveValues[(size_t)dx][(size_t)dy]++;
-
-        bits += bpp;
-        x += (uint)bpp;
-        if (x > iw) {
-            x -= iw;
-            if (accelFactor > 1) {
-                bits += bpp * (int)iw * ((int)accelFactor - 1);
-                i += (uint)bpp * iw * (accelFactor - 1);
-            }
-        }
+    // Scope column of each input column, and scope row offset of each luma value.
+    // The counters are stored row major so that they can be written line by line.
+    std::vector<uint> columnIndex((size_t)iw);
+    for (int x = 0; x < iw; ++x) {
+        columnIndex[(size_t)x] = uint((float)x * wPrediv);
+    }
+    uint rowOffset[256];
+    for (int y = 0; y < 256; ++y) {
+        rowOffset[y] = uint((float)y * hPrediv) * ww;
     }
 
-    switch (paintMode) {
-    case PaintMode_Green:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                // Logarithmic scale. Needs fine tuning by hand, but looks great.
-                wave.setPixel(i, waveformSize.height() - j - 1,
-                              qRgba(CHOP255(52 * log(0.1 * gain * (float)waveValues[(size_t)i][(size_t)j])),
-                                    CHOP255(52 * std::log(gain * (float)waveValues[(size_t)i][(size_t)j])),
-                                    CHOP255(52 * log(.25 * gain * (float)waveValues[(size_t)i][(size_t)j])),
-                                    CHOP255(64 * std::log(gain * (float)waveValues[(size_t)i][(size_t)j]))));
+    const std::vector<uint> waveValues = ScopeKernel::accumulateRows<uint>(sampledRows, ww * wh, [&](const ScopeKernel::RowBlock &block, uint *bins) {
+        std::vector<uchar> luma((size_t)iw);
+        for (int row = block.first; row < block.last; ++row) {
+            frame.lumaRow(row * (int)accelFactor, rec, luma.data());
+            for (int x = 0; x < iw; ++x) {
+                bins[rowOffset[luma[(size_t)x]] + columnIndex[(size_t)x]]++;
             }
         }
-        break;
-    case PaintMode_Yellow:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                wave.setPixel(i, waveformSize.height() - j - 1, qRgba(255, 242, 0, CHOP255(gain * (float)waveValues[(size_t)i][(size_t)j])));
-            }
+    });
+
+    auto colorFor = [paintMode, gain](uint count) -> QRgb {
+        switch (paintMode) {
+        case PaintMode_Green:
+            // Logarithmic scale. Needs fine tuning by hand, but looks great.
+            return qRgba(CHOP255(52 * log(0.1 * gain * (float)count)), CHOP255(52 * std::log(gain * (float)count)), CHOP255(52 * log(.25 * gain * (float)count)),
+                         CHOP255(64 * std::log(gain * (float)count)));
+        case PaintMode_Yellow:
+            return qRgba(255, 242, 0, CHOP255(gain * (float)count));
+        default:
+            return qRgba(255, 255, 255, CHOP255(2. * gain * (float)count));
         }
-        break;
-    default:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                wave.setPixel(i, waveformSize.height() - j - 1, qRgba(255, 255, 255, CHOP255(2. * gain * (float)waveValues[(size_t)i][(size_t)j])));
-            }
+    };
+
+    // The color only depends on the number of hits, so compute it once per count value
+    const uint maxCount = waveValues.empty() ? 0 : *std::max_element(waveValues.begin(), waveValues.end());
+    std::vector<QRgb> colors(std::min<size_t>(maxCount, 1 << 16) + 1);
+    // log(0) is not defined, empty bins stay transparent
+    colors[0] = paintMode == PaintMode_Green ? qRgba(0, 0, 0, 0) : colorFor(0);
+    for (size_t i = 1; i < colors.size(); ++i) {
+        colors[i] = colorFor((uint)i);
+    }
+
+    for (uint j = 0; j < wh; ++j) {
+        auto *line = reinterpret_cast<QRgb *>(wave.scanLine(int(wh - j - 1)));
+        const uint *values = waveValues.data() + j * ww;
+        for (uint i = 0; i < ww; ++i) {
+            line[i] = values[i] < colors.size() ? colors[values[i]] : colorFor(values[i]);
         }
-        break;
     }
 
     if (drawAxis) {
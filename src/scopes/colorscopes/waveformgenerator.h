@@ -16,6 +16,7 @@
 
 class QImage;
 class QSize;
+class ScopeFrame;
 
 class WaveformGenerator : public QObject
 {
@@ -27,7 +28,7 @@ public:
     WaveformGenerator();
     ~WaveformGenerator() override;
 
-    QImage calculateWaveform(const QSize &waveformSize, const QImage &image, WaveformGenerator::PaintMode paintMode, bool drawAxis,
+    QImage calculateWaveform(const QSize &waveformSize, const ScopeFrame &frame, WaveformGenerator::PaintMode paintMode, bool drawAxis,
                              const ITURec rec, uint accelFactor = 1);
 };
 
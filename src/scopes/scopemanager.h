@@ -127,7 +127,7 @@ private slots:
       */
     void checkActiveColourScopes();
 
-    void slotDistributeFrame(const QImage &image);
+    void slotDistributeFrame(const ScopeFrame &frame);
     void slotDistributeAudio(const audioShortVector &sampleData, int freq, int num_channels, int num_samples);
     /**
       Allows a scope to explicitly request a new frame, even if the scope's autoRefresh is disabled.
@@ -20,6 +20,7 @@
  ***************************************************************************/
 #include "snapmodel.hpp"
 #include <QDebug>
+#include <algorithm>
 #include <climits>
 #include <cstdlib>
 
@@ -29,31 +30,44 @@ SnapInterface::~SnapInterface() = default;
 
 SnapModel::SnapModel() = default;
 
+namespace {
+using SnapPoint = std::pair<int, int>;
+bool positionLess(const SnapPoint &point, int position)
+{
+    return point.first < position;
+}
+} // namespace
+
 void SnapModel::addPoint(int position)
 {
-    if (m_snaps.count(position) == 0) {
-        m_snaps[position] = 1;
+    auto it = std::lower_bound(m_snaps.begin(), m_snaps.end(), position, positionLess);
+    if (it != m_snaps.end() && it->first == position) {
+        it->second++;
     } else {
-        m_snaps[position]++;
+        m_snaps.insert(it, {position, 1});
     }
 }
 
 void SnapModel::removePoint(int position)
 {
-    Q_ASSERT(m_snaps.count(position) > 0);
-    if (m_snaps[position] == 1) {
-        m_snaps.erase(position);
+    auto it = std::lower_bound(m_snaps.begin(), m_snaps.end(), position, positionLess);
+    Q_ASSERT(it != m_snaps.end() && it->first == position);
+    if (it == m_snaps.end() || it->first != position) {
+        return;
+    }
+    if (it->second == 1) {
+        m_snaps.erase(it);
     } else {
-        m_snaps[position]--;
+        it->second--;
     }
 }
 
-int SnapModel::getClosestPoint(int position)
+int SnapModel::getClosestPoint(int position) const
 {
     if (m_snaps.empty()) {
         return -1;
     }
-    auto it = m_snaps.lower_bound(position);
+    auto it = std::lower_bound(m_snaps.begin(), m_snaps.end(), position, positionLess);
     long long int prev = INT_MIN, next = INT_MAX;
     if (it != m_snaps.end()) {
         next = (*it).first;
@@ -68,12 +82,12 @@ int SnapModel::getClosestPoint(int position)
     return (int)next;
 }
 
-int SnapModel::getNextPoint(int position)
+int SnapModel::getNextPoint(int position) const
 {
     if (m_snaps.empty()) {
         return position;
     }
-    auto it = m_snaps.lower_bound(position + 1);
+    auto it = std::lower_bound(m_snaps.begin(), m_snaps.end(), position + 1, positionLess);
     long long int next = position;
     if (it != m_snaps.end()) {
         next = (*it).first;
@@ -81,12 +95,12 @@ int SnapModel::getNextPoint(int position)
     return (int)next;
 }
 
-int SnapModel::getPreviousPoint(int position)
+int SnapModel::getPreviousPoint(int position) const
 {
     if (m_snaps.empty()) {
         return 0;
     }
-    auto it = m_snaps.lower_bound(position);
+    auto it = std::lower_bound(m_snaps.begin(), m_snaps.end(), position, positionLess);
     long long int prev = 0;
     if (it != m_snaps.begin()) {
         --it;
@@ -95,6 +109,82 @@ int SnapModel::getPreviousPoint(int position)
     return (int)prev;
 }
 
+bool SnapModel::getBestSnap(const std::vector<int> &points, int offset, int maxDistance, int &snappedOffset, const std::vector<int> &exclude,
+                            const std::vector<int> &extra) const
+{
+    if (points.empty()) {
+        return false;
+    }
+    std::vector<int> moved(points);
+    std::sort(moved.begin(), moved.end());
+    moved.erase(std::unique(moved.begin(), moved.end()), moved.end());
+    std::vector<int> excluded(exclude);
+    std::sort(excluded.begin(), excluded.end());
+    std::vector<int> added(extra);
+    std::sort(added.begin(), added.end());
+
+    // Walks the snap points merged with the extra points, skipping the excluded ones
+    size_t snapIx = 0, addedIx = 0, excludedIx = 0;
+    const long long none = LLONG_MAX;
+    auto nextSnap = [&]() -> long long {
+        while (snapIx < m_snaps.size() || addedIx < added.size()) {
+            long long pos = none;
+            if (snapIx < m_snaps.size()) {
+                pos = m_snaps[snapIx].first;
+            }
+            if (addedIx < added.size()) {
+                pos = std::min(pos, (long long)added[addedIx]);
+            }
+            int count = 0;
+            if (snapIx < m_snaps.size() && m_snaps[snapIx].first == pos) {
+                count += m_snaps[snapIx++].second;
+            }
+            while (addedIx < added.size() && added[addedIx] == pos) {
+                count++;
+                addedIx++;
+            }
+            while (excludedIx < excluded.size() && excluded[excludedIx] < pos) {
+                excludedIx++;
+            }
+            while (excludedIx < excluded.size() && excluded[excludedIx] == pos) {
+                count--;
+                excludedIx++;
+            }
+            if (count > 0) {
+                return pos;
+            }
+        }
+        return none;
+    };
+
+    // Moved points are visited in increasing order, so the snap cursor only moves forward
+    long long prev = none, next = nextSnap();
+    long long bestDistance = (long long)maxDistance + 1;
+    bool found = false;
+    for (int point : moved) {
+        const long long target = (long long)point + offset;
+        while (next != none && next < target) {
+            prev = next;
+            next = nextSnap();
+        }
+        // Same rule as getClosestPoint: the previous point only wins if it is strictly closer
+        long long snapped = next;
+        if (prev != none && (next == none || target - prev < next - target)) {
+            snapped = prev;
+        }
+        if (snapped == none) {
+            continue;
+        }
+        const long long distance = std::llabs(target - snapped);
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            snappedOffset = int(snapped - point);
+            found = true;
+        }
+    }
+    return found;
+}
+
 void SnapModel::ignore(const std::vector<int> &pts)
 {
     for (int pt : pts) {
@@ -111,44 +201,25 @@ void SnapModel::unIgnore()
     m_ignore.clear();
 }
 
-int SnapModel::proposeSize(int in, int out, int size, bool right, int maxSnapDist)
+int SnapModel::proposeSize(int in, int out, int size, bool right, int maxSnapDist, const std::vector<int> &extra) const
 {
-    ignore({in, out});
-    int proposed_size = -1;
-    if (right) {
-        int target_pos = in + size - 1;
-        int snapped_pos = getClosestPoint(target_pos);
-        if (snapped_pos != -1 && qAbs(target_pos - snapped_pos) <= maxSnapDist) {
-            proposed_size = snapped_pos - in;
-        }
-    } else {
-        int target_pos = out + 1 - size;
-        int snapped_pos = getClosestPoint(target_pos);
-        if (snapped_pos != -1 && qAbs(target_pos - snapped_pos) <= maxSnapDist) {
-            proposed_size = out - snapped_pos;
-        }
-    }
-    unIgnore();
-    return proposed_size;
+    return proposeSize(in, out, {in, out}, size, right, maxSnapDist, extra);
 }
 
-int SnapModel::proposeSize(int in, int out, const std::vector<int> boundaries, int size, bool right, int maxSnapDist)
+int SnapModel::proposeSize(int in, int out, const std::vector<int> &boundaries, int size, bool right, int maxSnapDist, const std::vector<int> &extra) const
 {
-    ignore(boundaries);
     int proposed_size = -1;
+    int snappedOffset = 0;
     if (right) {
         int target_pos = in + size - 1;
-        int snapped_pos = getClosestPoint(target_pos);
-        if (snapped_pos != -1 && qAbs(target_pos - snapped_pos) <= maxSnapDist) {
-            proposed_size = snapped_pos - in;
+        if (getBestSnap({target_pos}, 0, maxSnapDist, snappedOffset, boundaries, extra)) {
+            proposed_size = target_pos + snappedOffset - in;
         }
     } else {
         int target_pos = out + 1 - size;
-        int snapped_pos = getClosestPoint(target_pos);
-        if (snapped_pos != -1 && qAbs(target_pos - snapped_pos) <= maxSnapDist) {
-            proposed_size = out - snapped_pos;
+        if (getBestSnap({target_pos}, 0, maxSnapDist, snappedOffset, boundaries, extra)) {
+            proposed_size = out - (target_pos + snappedOffset);
         }
     }
-    unIgnore();
     return proposed_size;
 }
@@ -23,6 +23,7 @@
 #define SNAPMODEL_H
 
 #include <map>
+#include <utility>
 #include <vector>
 
 /** @brief This is a base class for snap models (timeline, clips)
@@ -59,17 +60,31 @@ public:
     void removePoint(int position) override;
 
     /* @brief Retrieves closest point. Returns -1 if there is no snappoint available */
-    int getClosestPoint(int position);
+    int getClosestPoint(int position) const;
 
     /* @brief Retrieves next snap point. Returns position if there is no snappoint available */
-    int getNextPoint(int position);
+    int getNextPoint(int position) const;
 
     /* @brief Retrieves previous snap point. Returns 0 if there is no snappoint available */
-    int getPreviousPoint(int position);
+    int getPreviousPoint(int position) const;
+
+    /* @brief Finds the best snap for a set of points moved by the same offset, without modifying the model.
+       All points are matched in a single sweep over the snap points, so this is safe to call concurrently with other read-only queries.
+       @param points positions of the moved points, before the move
+       @param offset displacement applied to all the points
+       @param maxDistance maximal distance in frames between a moved point and its snap
+       @param snappedOffset is set to the displacement that makes the closest moved point land on its snap
+       @param exclude snap points to ignore, typically the points being moved. Each occurrence masks one snap point at that position
+       @param extra additional snap points, like the timeline cursor
+       @return false if no snap point is close enough
+    */
+    bool getBestSnap(const std::vector<int> &points, int offset, int maxDistance, int &snappedOffset, const std::vector<int> &exclude = std::vector<int>(),
+                     const std::vector<int> &extra = std::vector<int>()) const;
 
     /* @brief Ignores the given positions until unIgnore() is called
        You can make several call to this before unIgnoring
        Note that you cannot remove ignored points.
+       Prefer passing an exclusion list to getBestSnap, which does not modify the model.
        @param points list of point to ignore
      */
     void ignore(const std::vector<int> &pts);
@@ -84,16 +99,19 @@ public:
        @param size is the size requested before snapping
        @param right true if we resize the right end of the item
        @param maxSnapDist maximal number of frames we are allowed to snap to
+       @param extra additional snap points, like the timeline cursor
     */
-    int proposeSize(int in, int out, int size, bool right, int maxSnapDist);
-    int proposeSize(int in, int out, const std::vector<int> boundaries, int size, bool right, int maxSnapDist);
+    int proposeSize(int in, int out, int size, bool right, int maxSnapDist, const std::vector<int> &extra = std::vector<int>()) const;
+    int proposeSize(int in, int out, const std::vector<int> &boundaries, int size, bool right, int maxSnapDist,
+                    const std::vector<int> &extra = std::vector<int>()) const;
 
     // For testing only
-    std::map<int, int> _snaps() { return m_snaps; }
+    std::map<int, int> _snaps() const { return std::map<int, int>(m_snaps.begin(), m_snaps.end()); }
 
 private:
-    std::map<int, int> m_snaps; // This represents the snappoints internally. The keys are the positions and the values are the number of elements at this
-                                // position. Note that it is important that the datastructure is ordered. QMap is NOT ordered, and therefore not suitable.
+    // The snappoints, sorted by position. The values are the number of elements at this position.
+    // A flat array is much faster to sweep than a map, and snap points change far less often than they are queried.
+    std::vector<std::pair<int, int>> m_snaps;
 
     std::vector<int> m_ignore;
 };
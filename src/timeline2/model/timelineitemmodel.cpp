@@ -98,9 +98,7 @@ QModelIndex TimelineItemModel::index(int row, int column, const QModelIndex &par
     } else if (row < (int)m_allTracks.size() && row >= 0) {
         // Get sort order
         // row = getTracksCount() - 1 - row;
-        auto it = m_allTracks.cbegin();
-        std::advance(it, row);
-        int trackId = (*it)->getId();
+        int trackId = m_trackOrder[(size_t)row];
         result = createIndex(row, column, quintptr(trackId));
     }
     return result;
@@ -133,10 +131,8 @@ QModelIndex TimelineItemModel::makeCompositionIndexFromID(int compoId) const
 
 QModelIndex TimelineItemModel::makeTrackIndexFromID(int trackId) const
 {
-    // we retrieve iterator
     Q_ASSERT(m_iteratorTable.count(trackId) > 0);
-    auto it = m_iteratorTable.at(trackId);
-    int ind = (int)std::distance<decltype(m_allTracks.cbegin())>(m_allTracks.begin(), it);
+    int ind = m_trackRows.at(trackId);
     // Get sort order
     // ind = getTracksCount() - 1 - ind;
     return index(ind);
@@ -346,9 +346,17 @@ int TimelineModel::getTrackPosition(int trackId) const
 {
     READ_LOCK();
     Q_ASSERT(isTrack(trackId));
-    auto it = m_allTracks.cbegin();
-    int pos = (int)std::distance(it, (decltype(it))m_iteratorTable.at(trackId));
-    return pos;
+    return m_trackRows.at(trackId);
+}
+
+void TimelineModel::updateTrackRows()
+{
+    m_trackOrder.clear();
+    m_trackRows.clear();
+    for (const auto &track : m_allTracks) {
+        m_trackRows[track->getId()] = (int)m_trackOrder.size();
+        m_trackOrder.push_back(track->getId());
+    }
 }
 
 int TimelineModel::getTrackMltIndex(int trackId) const
@@ -2153,9 +2161,7 @@ int TimelineModel::requestItemResizeInfo(int itemId, int in, int out, int size,
             }
         }
         int timelinePos = pCore->getTimelinePosition();
-        m_snaps->addPoint(timelinePos);
-        int proposed_size = m_snaps->proposeSize(in, out, getBoundaries(itemId), size, right, snapDistance);
-        m_snaps->removePoint(timelinePos);
+        int proposed_size = m_snaps->proposeSize(in, out, getBoundaries(itemId), size, right, snapDistance, {timelinePos});
         if (proposed_size > 0) {
             // only test move if proposed_size is valid
             bool success = false;
@@ -2200,9 +2206,7 @@ int TimelineModel::requestItemSpeedChange(int itemId, int size, bool right, int
         }
     }
     int timelinePos = pCore->getTimelinePosition();
-    m_snaps->addPoint(timelinePos);
-    int proposed_size = m_snaps->proposeSize(in, out, getBoundaries(itemId), size, right, snapDistance);
-    m_snaps->removePoint(timelinePos);
+    int proposed_size = m_snaps->proposeSize(in, out, getBoundaries(itemId), size, right, snapDistance, {timelinePos});
     qDebug()<<"==== RESIZE REQUEST: "<<size<<"*, RESULKT: "<<proposed_size;
     return proposed_size > 0 ? proposed_size : size;
 }
@@ -2692,6 +2696,7 @@ void TimelineModel::registerTrack(std::shared_ptr<TrackModel> track, int pos, bo
     // it now contains the iterator to the inserted element, we store it
     Q_ASSERT(m_iteratorTable.count(id) == 0); // check that id is not used (shouldn't happen)
     m_iteratorTable[id] = it;
+    updateTrackRows();
     endInsertRows();
     int cache = (int)QThread::idealThreadCount() + ((int)m_allTracks.size() + 1) * 2;
     mlt_service_cache_set_size(NULL, "producer_avformat", qMax(4, cache));
@@ -2730,6 +2735,7 @@ Fun TimelineModel::deregisterTrack_lambda(int id)
         m_allTracks.erase(it);
         // clean table
         m_iteratorTable.erase(id);
+        updateTrackRows();
         // Finish operation
         endRemoveRows();
         int cache = (int)QThread::idealThreadCount() + ((int)m_allTracks.size() + 1) * 2;
@@ -2946,37 +2952,18 @@ int TimelineModel::suggestSnapPoint(int pos, int snapDistance)
     return (qAbs(snapped - pos) < snapDistance ? snapped : pos);
 }
 
-int TimelineModel::getBestSnapPos(int referencePos, int diff, std::vector<int> pts, int cursorPosition, int snapDistance)
+int TimelineModel::getBestSnapPos(int referencePos, int diff, std::vector<int> pts, int cursorPosition, int snapDistance) const
 {
-    if (!pts.empty()) {
-        if (m_editMode == TimelineMode::NormalEdit) {
-            m_snaps->ignore(pts);
-        }
-    } else {
+    if (pts.empty()) {
         return -1;
     }
-    // Sort and remove duplicates
-    std::sort(pts.begin(), pts.end());
-    pts.erase( std::unique(pts.begin(), pts.end()), pts.end());
-    m_snaps->addPoint(cursorPosition);
-    int closest = -1;
-    int lowestDiff = snapDistance + 1;
-    for (int point : pts) {
-        int snapped = m_snaps->getClosestPoint(point + diff);
-        int currentDiff = qAbs(point + diff - snapped);
-        if (currentDiff < lowestDiff) {
-            lowestDiff = currentDiff;
-            closest = snapped - (point - referencePos);
-            if (lowestDiff < 2) {
-                break;
-            }
-        }
+    // In normal edit mode, the moved items must not snap to their own points
+    const std::vector<int> excluded = m_editMode == TimelineMode::NormalEdit ? pts : std::vector<int>();
+    int snappedOffset = 0;
+    if (m_snaps->getBestSnap(pts, diff, snapDistance, snappedOffset, excluded, {cursorPosition})) {
+        return referencePos + snappedOffset;
     }
-    if (m_editMode == TimelineMode::NormalEdit) {
-        m_snaps->unIgnore();
-    }
-    m_snaps->removePoint(cursorPosition);
-    return closest;
+    return -1;
 }
 
 int TimelineModel::getNextSnapPos(int pos, std::vector<int> &snaps)
@@ -3434,6 +3421,14 @@ bool TimelineModel::checkConsistency()
             return false;
         }
     }
+    int trackPos = 0;
+    for (const auto &track : m_allTracks) {
+        if (m_trackRows.count(track->getId()) == 0 || m_trackRows.at(track->getId()) != trackPos || m_trackOrder[(size_t)trackPos] != track->getId()) {
+            qDebug() << "Wrong position stored for track" << track->getId();
+            return false;
+        }
+        ++trackPos;
+    }
 
     // We store all in/outs of clips to check snap points
     std::map<int, int> snaps;
@@ -558,7 +558,7 @@ protected:
        @param snapDistance the maximum distance for a snap result, -1 for no snapping
        @returns best snap position or -1 if no snap point is near
      */
-    int getBestSnapPos(int referencePos, int diff, std::vector<int> pts = std::vector<int>(), int cursorPosition = 0, int snapDistance = -1);
+    int getBestSnapPos(int referencePos, int diff, std::vector<int> pts = std::vector<int>(), int cursorPosition = 0, int snapDistance = -1) const;
 
     /* @brief Returns the best possible size for a clip on resize
      */
@@ -694,6 +694,9 @@ protected:
      */
     void registerTrack(std::shared_ptr<TrackModel> track, int pos = -1, bool doInsert = true);
 
+    /* @brief Rebuild the track position lookup tables after the track list changed */
+    void updateTrackRows();
+
     /* @brief Register a new clip. This is a call-back meant to be called from ClipModel
      */
     void registerClip(const std::shared_ptr<ClipModel> &clip, bool registerProducer = false);
@@ -796,6 +799,8 @@ protected:
 
     std::unordered_map<int, std::list<std::shared_ptr<TrackModel>>::iterator>
         m_iteratorTable; // this logs the iterator associated which each track id. This allows easy access of a track based on its id.
+    std::vector<int> m_trackOrder;               // track ids by position, rebuilt by updateTrackRows() when tracks are added or removed
+    std::unordered_map<int, int> m_trackRows;    // position of each track id
 
     std::unordered_map<int, std::shared_ptr<ClipModel>> m_allClips; // the keys are the clip id, and the values are the corresponding pointers
 
@@ -30,6 +30,32 @@
 #include <QDebug>
 #include <QModelIndex>
 #include <mlt++/MltTransition.h>
+#include <algorithm>
+
+namespace {
+// Rows of the items of a track follow their id order. The ids are kept in a sorted vector: new items usually get the largest id
+// so insertion is amortized O(1), and row lookups are a binary search instead of walking the items map
+void insertRow(std::vector<int> &rows, int id)
+{
+    auto it = std::lower_bound(rows.begin(), rows.end(), id);
+    if (it == rows.end() || *it != id) {
+        rows.insert(it, id);
+    }
+}
+
+void removeRow(std::vector<int> &rows, int id)
+{
+    auto it = std::lower_bound(rows.begin(), rows.end(), id);
+    if (it != rows.end() && *it == id) {
+        rows.erase(it);
+    }
+}
+
+int rowOf(const std::vector<int> &rows, int id)
+{
+    return int(std::lower_bound(rows.begin(), rows.end(), id) - rows.begin());
+}
+} // namespace
 
 TrackModel::TrackModel(const std::weak_ptr<TimelineModel> &parent, int id, const QString &trackName, bool audioTrack)
     : m_parent(parent)
@@ -146,8 +172,10 @@ Fun TrackModel::requestClipInsertion_lambda(int clipId, int position, bool updat
         if (auto ptr = m_parent.lock()) {
             std::shared_ptr<ClipModel> clip = ptr->getClipPtr(clipId);
             m_allClips[clip->getId()] = clip; // store clip
+            insertRow(m_clipRows, clipId);
             // update clip position and track
             clip->setPosition(position);
+            m_clipPos[position] = clipId;
             clip->setSubPlaylistIndex(subPlaylist);
             int new_in = clip->getPosition();
             int new_out = new_in + clip->getPlaytime();
@@ -358,6 +386,8 @@ Fun TrackModel::requestClipDeletion_lambda(int clipId, bool updateView, bool fin
             m_allClips[clipId]->setCurrentTrackId(-1);
             m_allClips[clipId]->setSubPlaylistIndex(-1);
             m_allClips.erase(clipId);
+            removeRow(m_clipRows, clipId);
+            m_clipPos.erase(clip_position);
             delete prod;
             m_playlists[target_track].unlock();
             if (auto ptr = m_parent.lock()) {
@@ -597,7 +627,7 @@ Fun TrackModel::requestClipResize_lambda(int clipId, int in, int out, bool right
             // The second is parameter is delta - 1 because this function expects an out time, which is basically size - 1
             m_playlists[target_track].insert_blank(blank_index, delta - 1);
             if (!right) {
-                m_allClips[clipId]->setPosition(clip_position + delta);
+                setClipPosition(clipId, clip_position + delta);
                 // Because we inserted blank before, the index of our clip has increased
                 target_clip_mutable++;
             }
@@ -680,7 +710,7 @@ Fun TrackModel::requestClipResize_lambda(int clipId, int in, int out, bool right
                     err = m_playlists[target_track].resize_clip(target_clip_mutable, in, out);
                 }
                 if (!right && err == 0) {
-                    m_allClips[clipId]->setPosition(m_playlists[target_track].clip_start(target_clip_mutable));
+                    setClipPosition(clipId, m_playlists[target_track].clip_start(target_clip_mutable));
                 }
                 if (err == 0) {
                     update_snaps(m_allClips[clipId]->getPosition(), m_allClips[clipId]->getPosition() + out - in + 1);
@@ -732,16 +762,17 @@ QSharedPointer<Mlt::Producer> TrackModel::getClipProducer(int clipId)
 int TrackModel::getCompositionByPosition(int position)
 {
     READ_LOCK();
-    for (const auto &comp : m_compoPos) {
-        if (comp.first == position) {
-            return comp.second;
-        } else if (comp.first < position) {
-            if (comp.first + m_allCompositions[comp.second]->getPlaytime() >= position) {
-                return comp.second;
-            }
+    // Compositions don't overlap, so only the two last ones starting at or before position can match (the previous one
+    // ending exactly on position takes precedence)
+    auto it = m_compoPos.upper_bound(position);
+    int result = -1;
+    for (int i = 0; i < 2 && it != m_compoPos.begin(); ++i) {
+        --it;
+        if (it->first == position || it->first + m_allCompositions[it->second]->getPlaytime() >= position) {
+            result = it->second;
         }
     }
-    return -1;
+    return result;
 }
 
 int TrackModel::getClipByRow(int row) const
@@ -750,25 +781,45 @@ int TrackModel::getClipByRow(int row) const
     if (row >= static_cast<int>(m_allClips.size())) {
         return -1;
     }
-    auto it = m_allClips.cbegin();
-    std::advance(it, row);
-    return (*it).first;
+    return m_clipRows[(size_t)row];
 }
 
-std::unordered_set<int> TrackModel::getClipsInRange(int position, int end)
+template <typename T>
+void TrackModel::collectItemsInRange(const std::map<int, int> &positions, const std::map<int, std::shared_ptr<T>> &items, int position, int end,
+                                     std::unordered_set<int> &ids) const
 {
-    READ_LOCK();
-    std::unordered_set<int> ids;
-    for (const auto &clp : m_allClips) {
-        int pos = clp.second->getPosition();
-        int length = clp.second->getPlaytime();
-        if (end > -1 && pos >= end) {
-            continue;
+    auto it = positions.lower_bound(position);
+    if (it != positions.begin()) {
+        // The previous item starts before position, check if it reaches it
+        auto prev = std::prev(it);
+        if ((end == -1 || prev->first < end) && prev->first + items.at(prev->second)->getPlaytime() - 1 >= position) {
+            ids.insert(prev->second);
         }
-        if (pos >= position || pos + length - 1 >= position) {
-            ids.insert(clp.first);
+    }
+    for (; it != positions.end(); ++it) {
+        if (end > -1 && it->first >= end) {
+            break;
         }
+        ids.insert(it->second);
+    }
+}
+
+void TrackModel::setClipPosition(int clipId, int position)
+{
+    auto clip = m_allClips[clipId];
+    auto it = m_clipPos.find(clip->getPosition());
+    if (it != m_clipPos.end() && it->second == clipId) {
+        m_clipPos.erase(it);
     }
+    clip->setPosition(position);
+    m_clipPos[position] = clipId;
+}
+
+std::unordered_set<int> TrackModel::getClipsInRange(int position, int end)
+{
+    READ_LOCK();
+    std::unordered_set<int> ids;
+    collectItemsInRange(m_clipPos, m_allClips, position, end, ids);
     return ids;
 }
 
@@ -776,7 +827,7 @@ int TrackModel::getRowfromClip(int clipId) const
 {
     READ_LOCK();
     Q_ASSERT(m_allClips.count(clipId) > 0);
-    return (int)std::distance(m_allClips.begin(), m_allClips.find(clipId));
+    return rowOf(m_clipRows, clipId);
 }
 
 std::unordered_set<int> TrackModel::getCompositionsInRange(int position, int end)
@@ -784,17 +835,7 @@ std::unordered_set<int> TrackModel::getCompositionsInRange(int position, int end
     READ_LOCK();
     // TODO: this function doesn't take into accounts the fact that there are two tracks
     std::unordered_set<int> ids;
-    for (const auto &compo : m_allCompositions) {
-        int pos = compo.second->getPosition();
-        int length = compo.second->getPlaytime();
-        if (end > -1 && pos >= end) {
-            continue;
-        }
-        if (pos >= position || pos + length - 1 >= position) {
-            
-            ids.insert(compo.first);
-        }
-    }
+    collectItemsInRange(m_compoPos, m_allCompositions, position, end, ids);
     return ids;
 }
 
@@ -802,7 +843,7 @@ int TrackModel::getRowfromComposition(int tid) const
 {
     READ_LOCK();
     Q_ASSERT(m_allCompositions.count(tid) > 0);
-    return (int)m_allClips.size() + (int)std::distance(m_allCompositions.begin(), m_allCompositions.find(tid));
+    return (int)m_allClips.size() + rowOf(m_compoRows, tid);
 }
 
 QVariant TrackModel::getProperty(const QString &name) const
@@ -949,6 +990,31 @@ bool TrackModel::checkConsistency()
         return false;
     }
 
+    // Check the clip start index
+    if (m_allClips.size() != m_clipPos.size()) {
+        qDebug() << "Error: the number of clips position doesn't match number of clips";
+        return false;
+    }
+    for (const auto &c : clips) {
+        if (m_clipPos.count(c.first) == 0 || m_clipPos[c.first] != c.second) {
+            qDebug() << "Error: the position of clip " << c.second << " is not properly stored";
+            return false;
+        }
+    }
+
+    // Check the row index
+    std::vector<int> clipRows, compoRows;
+    for (const auto &clip : m_allClips) {
+        clipRows.push_back(clip.first);
+    }
+    for (const auto &compo : m_allCompositions) {
+        compoRows.push_back(compo.first);
+    }
+    if (clipRows != m_clipRows || compoRows != m_compoRows) {
+        qDebug() << "Error: the rows of the track items are not properly stored";
+        return false;
+    }
+
     // We now check compositions positions
     if (m_allCompositions.size() != m_compoPos.size()) {
         qDebug() << "Error: the number of compositions position doesn't match number of compositions";
@@ -1181,6 +1247,7 @@ Fun TrackModel::requestCompositionDeletion_lambda(int compoId, bool updateView,
         }
         m_allCompositions[compoId]->setCurrentTrackId(-1);
         m_allCompositions.erase(compoId);
+        removeRow(m_compoRows, compoId);
         m_compoPos.erase(old_in);
         ptr->m_snaps->removePoint(old_in);
         ptr->m_snaps->removePoint(old_out);
@@ -1198,9 +1265,7 @@ int TrackModel::getCompositionByRow(int row) const
         return -1;
     }
     Q_ASSERT(row <= (int)m_allClips.size() + (int)m_allCompositions.size());
-    auto it = m_allCompositions.cbegin();
-    std::advance(it, row - (int)m_allClips.size());
-    return (*it).first;
+    return m_compoRows[size_t(row - (int)m_allClips.size())];
 }
 
 int TrackModel::getCompositionsCount() const
@@ -1224,6 +1289,7 @@ Fun TrackModel::requestCompositionInsertion_lambda(int compoId, int position, bo
             if (auto ptr = m_parent.lock()) {
                 std::shared_ptr<CompositionModel> composition = ptr->getCompositionPtr(compoId);
                 m_allCompositions[composition->getId()] = composition; // store clip
+                insertRow(m_compoRows, compoId);
                 // update clip position and track
                 composition->setCurrentTrackId(getId());
                 int new_in = position;
@@ -263,6 +263,13 @@ protected:
     std::unordered_set<int> getClipsInRange(int position, int end = -1);
     /* @brief Returns the list of the ids of the compositions that intersect the given range */
     std::unordered_set<int> getCompositionsInRange(int position, int end);
+    /* @brief Helper for range queries: collects the ids stored in a start position index (m_clipPos or m_compoPos) that intersect the given range.
+       Relies on the fact that items of a track never overlap, so only the item starting just before position can span into the range */
+    template <typename T>
+    void collectItemsInRange(const std::map<int, int> &positions, const std::map<int, std::shared_ptr<T>> &items, int position, int end,
+                             std::unordered_set<int> &ids) const;
+    /* @brief Updates the position of a clip and keeps the start position index in sync */
+    void setClipPosition(int clipId, int position);
 
     /* @brief Import effects from a service that contains some (another track) */
     bool importEffects(std::weak_ptr<Mlt::Service> service);
@@ -292,6 +299,10 @@ private:
 
     std::map<int, int> m_compoPos; // We store the positions of the compositions. In Melt, the compositions are not inserted at the track level, but we keep
                                    // those positions here to check for moves and resize
+    std::vector<int> m_clipRows;  // Ids of m_allClips in row order (sorted), giving rows by binary search and ids by row in O(1)
+    std::vector<int> m_compoRows; // Same for m_allCompositions
+    std::map<int, int> m_clipPos; // Clips ordered by start position. Since clips of a track never overlap, this allows range and position queries in
+                                  // O(log n + k) without walking the MLT playlists or all the clips
 
     mutable QReadWriteLock m_lock; // This is a lock that ensures safety in case of concurrent access
 
@@ -30,6 +30,7 @@
 #include <QProcess>
 #include <QStandardPaths>
 #include <QCollator>
+#include <QThread>
 
 PreviewManager::PreviewManager(TimelineController *controller, Mlt::Tractor *tractor)
     : QObject()
@@ -539,15 +540,24 @@ void PreviewManager::startPreviewRender()
 
 void PreviewManager::receivedStderr()
 {
-    QStringList resultList = QString::fromLocal8Bit(m_previewProcess.readAllStandardError()).split(QLatin1Char('\n'));
+    // Several workers report at the same time, only process complete lines
+    m_stderrBuffer.append(m_previewProcess.readAllStandardError());
+    int lastLine = m_stderrBuffer.lastIndexOf('\n');
+    if (lastLine < 0) {
+        return;
+    }
+    QStringList resultList = QString::fromLocal8Bit(m_stderrBuffer.left(lastLine)).split(QLatin1Char('\n'));
+    m_stderrBuffer.remove(0, lastLine + 1);
     for (auto &result : resultList) {
         qDebug() << "GOT PROCESS RESULT: " << result;
         if (result.startsWith(QLatin1String("START:"))) {
             workingPreview = result.section(QLatin1String("START:"), 1).simplified().toInt();
+            m_workingChunks.insert(workingPreview);
             qDebug() << "// GOT START INFO: " << workingPreview;
             emit m_controller->workingPreviewChanged();
         } else if (result.startsWith(QLatin1String("DONE:"))) {
             int chunk = result.section(QLatin1String("DONE:"), 1).simplified().toInt();
+            m_workingChunks.remove(chunk);
             m_processedChunks++;
             QString fileName = QStringLiteral("%1.%2").arg(chunk).arg(m_extension);
             qDebug() << "---------------\nJOB PROGRRESS: " << m_chunksToRender << ", " << m_processedChunks << " = "
@@ -568,13 +578,30 @@ void PreviewManager::doPreviewRender(const QString &scene)
     }
     Q_ASSERT(m_previewProcess.state() == QProcess::NotRunning);
 
-    QStringList chunks;
+    int chunkSize = KdenliveSettings::timelinechunks();
+    // Render the chunks closest to the playhead first, at equal distance the one after it before the one before it
+    const int playhead = pCore->getTimelinePosition();
+    const int playheadChunk = playhead - playhead % chunkSize;
+    QList<int> ordered;
     for (QVariant &frame : m_dirtyChunks) {
-        chunks << frame.toString();
+        ordered << frame.toInt();
+    }
+    std::stable_sort(ordered.begin(), ordered.end(), [playheadChunk](int a, int b) {
+        return std::make_pair(qAbs(a - playheadChunk), a < playheadChunk) < std::make_pair(qAbs(b - playheadChunk), b < playheadChunk);
+    });
+    QStringList chunks;
+    for (int frame : qAsConst(ordered)) {
+        chunks << QString::number(frame);
     }
     m_chunksToRender = m_dirtyChunks.count();
     m_processedChunks = 0;
-    int chunkSize = KdenliveSettings::timelinechunks();
+    m_workingChunks.clear();
+    m_stderrBuffer.clear();
+    int workers = KdenliveSettings::previewworkers();
+    if (workers <= 0) {
+        // Each chunk encode is already multithreaded, so one worker for 4 cores keeps the machine busy
+        workers = qBound(1, QThread::idealThreadCount() / 4, 8);
+    }
     QStringList args{KdenliveSettings::rendererpath(),
                      scene,
                      m_cacheDir.absolutePath(),
@@ -583,7 +610,8 @@ void PreviewManager::doPreviewRender(const QString &scene)
                      QString::number(chunkSize - 1),
                      pCore->getCurrentProfilePath(),
                      m_extension,
-                     m_consumerParams.join(QLatin1Char(' '))};
+                     m_consumerParams.join(QLatin1Char(' ')),
+                     QStringLiteral("-workers:%1").arg(workers)};
     qDebug() << " -  - -STARTING PREVIEW JOBS: " << args;
     pCore->currentDoc()->previewProgress(0);
     m_previewProcess.start(m_renderer, args);
@@ -600,8 +628,9 @@ void PreviewManager::processEnded(int, QProcess::ExitStatus status)
     if (status == QProcess::QProcess::CrashExit) {
         qDebug() << "// PROCESS CRASHED!!!!!!";
         pCore->currentDoc()->previewProgress(-1);
-        if (workingPreview >= 0) {
-            const QString fileName = QStringLiteral("%1.%2").arg(workingPreview).arg(m_extension);
+        // Remove the partial files of all chunks being rendered
+        for (int chunk : qAsConst(m_workingChunks)) {
+            const QString fileName = QStringLiteral("%1.%2").arg(chunk).arg(m_extension);
             if (m_cacheDir.exists(fileName)) {
                 m_cacheDir.remove(fileName);
             }
@@ -609,6 +638,7 @@ void PreviewManager::processEnded(int, QProcess::ExitStatus status)
     } else {
         pCore->currentDoc()->previewProgress(1000);
     }
+    m_workingChunks.clear();
     workingPreview = -1;
     emit m_controller->workingPreviewChanged();
 }
@@ -26,6 +26,7 @@
 #include <QFuture>
 #include <QMutex>
 #include <QProcess>
+#include <QSet>
 #include <QTimer>
 
 class TimelineController;
@@ -122,6 +123,10 @@ private:
     int m_processedChunks;
     /** @brief: The render process output, useful in case of failure */
     QString m_errorLog;
+    /** @brief: Incomplete line of the render process output */
+    QByteArray m_stderrBuffer;
+    /** @brief: The chunks currently processed by the render workers */
+    QSet<int> m_workingChunks;
     /** @brief: After an undo/redo, if we have preview history, use it. */
     void reloadChunks(const QVariantList chunks);
     /** @brief: A chunk failed to render, abort. */
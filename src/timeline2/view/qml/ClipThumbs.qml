@@ -31,6 +31,8 @@ Row {
         property real imageWidth: Math.max(thumbRow.thumbWidth, container.width / thumbRepeater.count)
         property int thumbStartFrame: fixedThumbs ? 0 : (clipRoot.speed >= 0) ? Math.round(clipRoot.inPoint * clipRoot.speed) : Math.round((clipRoot.maxDuration - clipRoot.inPoint) * -clipRoot.speed - 1)
         property int thumbEndFrame: fixedThumbs ? 0 : (clipRoot.speed >= 0) ? Math.round(clipRoot.outPoint * clipRoot.speed) : Math.round((clipRoot.maxDuration - clipRoot.outPoint) * -clipRoot.speed - 1)
+        // When thumbnails are several seconds apart, the nearest keyframe is close enough and much faster to decode
+        property string framePrefix: !fixedThumbs && thumbRepeater.count > 2 && thumbRepeater.imageWidth / timeline.scaleFactor > 5 * timeline.fps() ? 'k' : ''
 
         Image {
             width: thumbRepeater.imageWidth
@@ -40,12 +42,15 @@ Row {
             cache: enableCache
             property int currentFrame: fixedThumbs ? 0 : thumbRepeater.count < 3 ? (index == 0 ? thumbRepeater.thumbStartFrame : thumbRepeater.thumbEndFrame) : Math.floor(clipRoot.inPoint + Math.round((index) * width / timeline.scaleFactor)* clipRoot.speed)
             horizontalAlignment: thumbRepeater.count < 3 ? (index == 0 ? Image.AlignLeft : Image.AlignRight) : Image.AlignLeft
-            source: thumbRepeater.count < 3 ? (clipRoot.baseThumbPath + currentFrame) : (index * width < clipRoot.scrollStart - width || index * width > clipRoot.scrollStart + scrollView.width) ? '' : clipRoot.baseThumbPath + currentFrame
+            source: thumbRepeater.count < 3 ? (clipRoot.baseThumbPath + currentFrame) : (index * width < clipRoot.scrollStart - width || index * width > clipRoot.scrollStart + scrollView.width) ? '' : clipRoot.baseThumbPath + thumbRepeater.framePrefix + currentFrame
             onStatusChanged: {
                 if (thumbRepeater.count < 3) {
                     if (status === Image.Ready) {
                         thumbPlaceholder.source = source
                     }
+                } else if (status === Image.Loading) {
+                    // Show the closest thumbnail we already have while this one is decoded
+                    thumbPlaceholder.source = clipRoot.baseThumbPath + 'p' + currentFrame
                 }
             }
             BusyIndicator {
@@ -64,6 +69,7 @@ Row {
                     horizontalAlignment: Image.AlignLeft
                     fillMode: Image.PreserveAspectFit
                     asynchronous: true
+                    cache: false
                 }
             }
             Rectangle {
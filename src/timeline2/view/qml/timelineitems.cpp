@@ -23,12 +23,23 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "kdenlivesettings.h"
 #include "core.h"
 #include "bin/projectitemmodel.h"
+#include "lib/audio/audioLevelsStore.h"
+#include <QElapsedTimer>
+#include <QGuiApplication>
 #include <QPainter>
 #include <QPainterPath>
+#include <QPointer>
 #include <QQuickPaintedItem>
-#include <QElapsedTimer>
+#include <QQuickWindow>
+#include <QSGFlatColorMaterial>
+#include <QSGGeometryNode>
+#include <QSGSimpleRectNode>
+#include <QSGSimpleTextureNode>
+#include <QtConcurrent>
 #include <QtMath>
 #include <cmath>
+#include <map>
+#include <set>
 #include "kdenlivesettings.h"
 
 const QStringList chanelNames{"L", "R", "C", "LFE", "BL", "BR"};
@@ -77,7 +88,129 @@ private:
     QColor m_color;
 };
 
-class TimelineWaveform : public QQuickPaintedItem
+namespace {
+/** @brief Width in pixels of a waveform tile, tiles are the unit of generation and caching */
+const int waveformTileWidth = 256;
+
+/** @brief Everything the levels of a tile depend on. When one of them changes (zoom, clip, channel mode), cached tiles are dropped */
+struct WaveformTileParams
+{
+    std::shared_ptr<AudioLevelsStore> store;
+    int inPoint = 0;
+    int outPoint = 0;
+    int width = 0;
+    int channels = 1;
+    bool merged = true;
+    double audioMax = 0;
+
+    bool operator==(const WaveformTileParams &other) const
+    {
+        return store == other.store && inPoint == other.inPoint && outPoint == other.outPoint && width == other.width && channels == other.channels &&
+               merged == other.merged && qFuzzyCompare(1. + audioMax, 1. + other.audioMax);
+    }
+    bool operator!=(const WaveformTileParams &other) const { return !(*this == other); }
+};
+
+/** @brief Computes the levels of one tile, normalized on [0, 1].
+    The result holds one value per pixel column and per lane (a single lane for merged channels, one per channel otherwise),
+    a negative value marks a column without audio data. Only reads the memory mapped store, so it is safe to run in a worker thread */
+std::vector<float> buildWaveformTile(const WaveformTileParams &params, int tile)
+{
+    const int first = tile * waveformTileWidth;
+    const int last = qMin(params.width, first + waveformTileWidth);
+    const int lanes = params.merged ? 1 : params.channels;
+    std::vector<float> levels(size_t(qMax(0, last - first) * lanes), -1.f);
+    const double indicesPrPixel = double(params.outPoint - params.inPoint) / params.width;
+    if (levels.empty() || qFuzzyIsNull(indicesPrPixel)) {
+        return levels;
+    }
+    double scaleFactor = 255;
+    if (params.audioMax > 1) {
+        scaleFactor *= params.audioMax;
+    }
+    const int startPos = int(params.inPoint / indicesPrPixel);
+    // Read the coarsest zoom level that still has one sample per pixel column
+    const AudioLevelsStore &store = *params.store;
+    const int zoomLevel = store.levelForFramesPerPixel(qAbs(indicesPrPixel) / params.channels);
+    const int frameCount = store.sampleCount(0);
+    const int levelCount = store.sampleCount(zoomLevel);
+    const int storedChannels = qMin(params.channels, store.channels());
+    std::vector<const uint8_t *> peaks;
+    for (int k = 0; k < storedChannels; k++) {
+        peaks.push_back(store.peaks(zoomLevel, k));
+    }
+    auto frameAt = [&](int x) {
+        int idx = int(ceil((startPos + x) * indicesPrPixel));
+        idx += idx % params.channels;
+        return idx < 0 ? -1 : idx / params.channels;
+    };
+    int frame = frameAt(first);
+    for (int x = first; x < last; ++x) {
+        const int next = frameAt(x + 1);
+        if (frame < 0 || frame >= frameCount || levelCount <= 0) {
+            frame = next;
+            continue;
+        }
+        // A column covers the frames up to the next one, whatever the playback direction
+        int lastFrame = frame;
+        if (next > frame + 1) {
+            lastFrame = next - 1;
+        } else if (next >= 0 && next < frame - 1) {
+            lastFrame = next + 1;
+        }
+        const int from = qMin(levelCount - 1, qMin(frame, lastFrame) >> zoomLevel);
+        const int to = qMin(levelCount - 1, qMin(frameCount - 1, qMax(frame, lastFrame)) >> zoomLevel);
+        float *column = &levels[size_t((x - first) * lanes)];
+        for (int k = 0; k < storedChannels; k++) {
+            uint8_t peak = 0;
+            for (int s = from; s <= to; s++) {
+                peak = qMax(peak, peaks[size_t(k)][s]);
+            }
+            float &level = column[params.merged ? 0 : k];
+            level = qMax(level, float(qMin(1., peak / scaleFactor)));
+        }
+        frame = next;
+    }
+    return levels;
+}
+
+/** @brief Builds a filled waveform for one lane of a tile, as a triangle strip with one quad per pixel column.
+    Each column extends up by level * up and down by level * down from the baseline y */
+QSGGeometryNode *createWaveformNode(const std::vector<float> &levels, int lanes, int lane, int x, double y, double up, double down, const QColor &color)
+{
+    const int columns = int(levels.size()) / lanes;
+    if (columns == 0) {
+        return nullptr;
+    }
+    auto *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), columns * 4);
+    geometry->setDrawingMode(QSGGeometry::DrawTriangleStrip);
+    QSGGeometry::Point2D *vertices = geometry->vertexDataAsPoint2D();
+    for (int c = 0; c < columns; c++) {
+        // Columns without data collapse on the baseline, the quads between columns are degenerate
+        const double level = qMax(0.f, levels[size_t(c * lanes + lane)]);
+        const float top = float(y - level * up);
+        const float bottom = float(y + level * down);
+        const float left = float(x + c);
+        vertices[4 * c].set(left, top);
+        vertices[4 * c + 1].set(left, bottom);
+        vertices[4 * c + 2].set(left + 1, top);
+        vertices[4 * c + 3].set(left + 1, bottom);
+    }
+    auto *node = new QSGGeometryNode;
+    node->setGeometry(geometry);
+    node->setFlag(QSGNode::OwnsGeometry);
+    auto *material = new QSGFlatColorMaterial;
+    material->setColor(color);
+    node->setMaterial(material);
+    node->setFlag(QSGNode::OwnsMaterial);
+    return node;
+}
+} // namespace
+
+/** @brief Audio thumbnail of a clip chunk, drawn as scene graph nodes.
+    The waveform is split in tiles of waveformTileWidth pixels. Tiles are computed in worker threads from the audio levels store,
+    only when they get exposed in the view, and are kept as long as the zoom level does not change, so that scrolling reuses them */
+class TimelineWaveform : public QQuickItem
 {
     Q_OBJECT
     Q_PROPERTY(QColor fillColor1 MEMBER m_color NOTIFY propertyChanged)
@@ -98,28 +231,24 @@ class TimelineWaveform : public QQuickPaintedItem
 public:
     TimelineWaveform()
     {
-        setAntialiasing(false);
-        // setClip(true);
+        setFlag(QQuickItem::ItemHasContents);
         setEnabled(false);
         m_showItem = false;
-        m_precisionFactor = 1;
-        //setRenderTarget(QQuickPaintedItem::FramebufferObject);
-        //setMipmap(true);
-        setTextureSize(QSize(1, 1));
         connect(this, &TimelineWaveform::levelsChanged, [&]() {
-            if (!m_binId.isEmpty()) {
-                if (m_audioLevels.isEmpty() && m_stream >= 0) {
-                    update();
-                } else {
-                    // Clip changed, reset levels
-                    m_audioLevels.clear();
-                }
-            }
+            // Clip changed, reset levels
+            m_audioStore.reset();
+            polish();
         });
         connect(this, &TimelineWaveform::propertyChanged, [&]() {
-            m_audioMax = KdenliveSettings::normalizechannels() ? 0 : pCore->projectItemModel()->getAudioMaxLevel(m_binId);
+            if (!m_binId.isEmpty()) {
+                m_audioMax = KdenliveSettings::normalizechannels() ? 0 : pCore->projectItemModel()->getAudioMaxLevel(m_binId);
+            }
+            polish();
             update();
         });
+        connect(this, &TimelineWaveform::audioChannelsChanged, this, &QQuickItem::polish);
+        connect(this, &QQuickItem::widthChanged, this, &QQuickItem::polish);
+        connect(this, &QQuickItem::heightChanged, this, &QQuickItem::polish);
     }
     bool showItem() const
     {
@@ -128,146 +257,123 @@ public:
     void setShowItem(bool show)
     {
         m_showItem = show;
-        if (show) {
-            setTextureSize(QSize(width(), height()));
-            update();
-        } else {
-            // Free memory
-            setTextureSize(QSize(1, 1));
-        }
+        polish();
+        update();
     }
 
-    void paint(QPainter *painter) override
+protected:
+    /** @brief Drops the cached tiles if the zoom changed and requests the exposed tiles that are missing */
+    void updatePolish() override
     {
-        if (!m_showItem || m_binId.isEmpty()) {
+        if (!m_showItem || m_binId.isEmpty() || m_stream < 0 || width() < 1 || m_channels < 1) {
             return;
         }
-        if (m_audioLevels.isEmpty() && m_stream >= 0) {
-            m_audioLevels = pCore->projectItemModel()->getAudioLevelsByBinID(m_binId, m_stream);
+        if (!m_audioStore) {
+            m_audioStore = pCore->projectItemModel()->getAudioLevelsStore(m_binId, m_stream);
             m_audioMax = KdenliveSettings::normalizechannels() ? 0 : pCore->projectItemModel()->getAudioMaxLevel(m_binId);
-            if (m_audioLevels.isEmpty()) {
+            if (!m_audioStore) {
                 return;
             }
         }
-        qreal indicesPrPixel = qreal(m_outPoint - m_inPoint) / width() * m_precisionFactor;
-        QPen pen = painter->pen();
-        pen.setColor(m_color);
-        painter->setBrush(m_color);
-        pen.setCapStyle(Qt::FlatCap);
-        double increment = qMax(1., 1. / qAbs(indicesPrPixel));
-        int h = height();
-        double offset = 0;
-        bool pathDraw = increment > 1.2;
-        if (increment > 1. && !pathDraw) {
-            pen.setWidth(ceil(increment));
-            offset = pen.width() / 2.;
-        } else if (pathDraw) {
-            pen.setWidthF(0);
+        WaveformTileParams params;
+        params.store = m_audioStore;
+        params.inPoint = m_inPoint;
+        params.outPoint = m_outPoint;
+        params.width = int(width());
+        params.channels = m_channels;
+        params.merged = !KdenliveSettings::displayallchannels();
+        params.audioMax = m_audioMax;
+        if (params != m_params) {
+            m_params = params;
+            m_generation++;
+            m_tiles.clear();
+            m_pendingTiles.clear();
         }
-        painter->setPen(pen);
-        double scaleFactor = 255;
-        if (m_audioMax > 1) {
-            scaleFactor *= m_audioMax;
+        updateLabels();
+        // Only generate the tiles that are visible
+        const int start = qMax(0, m_drawInPoint);
+        const int end = qMin(params.width, m_drawOutPoint);
+        if (end <= start) {
+            return;
         }
-        int startPos = m_inPoint / indicesPrPixel;
-        if (!KdenliveSettings::displayallchannels()) {
-            // Draw merged channels
-            double i = 0;
-            double level;
-            int j = 0;
-            QPainterPath path;
-            if (m_drawInPoint > 0) {
-                j = m_drawInPoint / increment;
+        for (int tile = start / waveformTileWidth; tile <= (end - 1) / waveformTileWidth; tile++) {
+            if (m_tiles.count(tile) == 0 && m_pendingTiles.count(tile) == 0) {
+                requestTile(tile);
             }
-            if (pathDraw) {
-                path.moveTo(j - 1, height());
-            }
-            for (; i <= width() && i < m_drawOutPoint; j++) {
-                i = j * increment;
-                int idx = ceil((startPos + i) * indicesPrPixel);
-                idx += idx % m_channels;
-                i -= offset;
-                if (idx + m_channels >= m_audioLevels.length() || idx < 0) {
-                    break;
-                }
-                level = m_audioLevels.at(idx) / scaleFactor;
-                for (int k = 1; k < m_channels; k++) {
-                    level = qMax(level, m_audioLevels.at(idx + k) / scaleFactor);
-                }
-                if (pathDraw) {
-                    path.lineTo(i, height() - level * height());
-                } else {
-                    painter->drawLine(i, h, i, h - (h * level));
+        }
+    }
+
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *) override
+    {
+        if (!m_showItem || !m_audioStore || m_params.store != m_audioStore) {
+            delete oldNode;
+            m_tileNodes.clear();
+            return nullptr;
+        }
+        const bool merged = m_params.merged;
+        const int channels = m_params.channels;
+        const QRectF rect(0, 0, width(), height());
+        if (oldNode && (rect != m_nodeRect || m_color != m_nodeColor || m_color2 != m_nodeColor2 || m_generation != m_nodeGeneration || m_labelsChanged)) {
+            // Geometry or colors changed, rebuild everything from the cached levels
+            delete oldNode;
+            oldNode = nullptr;
+        }
+        if (!oldNode) {
+            m_tileNodes.clear();
+            m_nodeRect = rect;
+            m_nodeColor = m_color;
+            m_nodeColor2 = m_color2;
+            m_nodeGeneration = m_generation;
+            m_labelsChanged = false;
+            oldNode = new QSGNode;
+            if (!merged) {
+                // Dark background on odd channels and channel median lines
+                const double channelHeight = rect.height() / channels;
+                for (int channel = 0; channel < channels; channel++) {
+                    if (channel % 2 == 0) {
+                        oldNode->appendChildNode(new QSGSimpleRectNode(QRectF(0, channel * channelHeight, rect.width(), channelHeight), QColor(0, 0, 0, 51)));
+                    }
+                    QColor lineColor = channel % 2 == 0 ? m_color : m_color2;
+                    lineColor.setAlphaF(lineColor.alphaF() * 0.5);
+                    const double y = channel * channelHeight + channelHeight / 2;
+                    oldNode->appendChildNode(new QSGSimpleRectNode(QRectF(0, y, rect.width(), 1), lineColor));
                 }
             }
-            if (pathDraw) {
-                path.lineTo(i, height());
-                painter->drawPath(path);
+            m_tilesNode = new QSGNode;
+            oldNode->appendChildNode(m_tilesNode);
+            if (!m_labels.isNull() && window()) {
+                auto *labels = new QSGSimpleTextureNode;
+                labels->setTexture(window()->createTextureFromImage(m_labels));
+                labels->setOwnsTexture(true);
+                labels->setRect(QRectF(QPointF(), m_labels.size()));
+                oldNode->appendChildNode(labels);
             }
-        } else {
-            double channelHeight = (double)height() / m_channels;
-            // Draw separate channels
-            scaleFactor = channelHeight / (2 * scaleFactor);
-            double i = 0;
-            double level;
-            QRectF bgRect(0, 0, width(), channelHeight);
-            // Path for vector drawing
-            //qDebug()<<"==== DRAWING FROM: "<<m_drawInPoint<<" - "<<m_drawOutPoint<<", FIRST: "<<m_firstChunk;
-            for (int channel = 0; channel < m_channels; channel++) {
-                // y is channel median pos
-                double y = (channel * channelHeight) + channelHeight / 2;
-                QPainterPath path;
-                path.moveTo(-1, y);
-                if (channel % 2 == 0) {
-                    // Add dark background on odd channels
-                    painter->setOpacity(0.2);
-                    bgRect.moveTo(0, channel * channelHeight);
-                    painter->fillRect(bgRect, Qt::black);
-                }
-                // Draw channel median line
-                pen.setColor(channel % 2 == 0 ? m_color : m_color2);
-                painter->setBrush(channel % 2 == 0 ? m_color : m_color2);
-                painter->setOpacity(0.5);
-                pen.setWidthF(0);
-                painter->setPen(pen);
-                painter->drawLine(QLineF(0., y, width(), y));
-                pen.setWidth(ceil(increment));
-                painter->setPen(pathDraw ? Qt::NoPen : pen);
-                painter->setOpacity(1);
-                i = 0;
-                int j = 0;
-                if (m_drawInPoint > 0) {
-                    j = m_drawInPoint / increment;
-                }
-                if (pathDraw) {
-                    path.moveTo(m_drawInPoint - 1, y);
+        }
+        // Add the nodes of the tiles that became ready since the last update
+        for (const auto &tile : m_tiles) {
+            if (m_tileNodes.count(tile.first) > 0) {
+                continue;
+            }
+            auto *tileNode = new QSGNode;
+            const int x = tile.first * waveformTileWidth;
+            if (merged) {
+                if (QSGGeometryNode *node = createWaveformNode(tile.second, 1, 0, x, rect.height(), rect.height(), 0, m_color)) {
+                    tileNode->appendChildNode(node);
                 }
-                for (; i <= width() && i < m_drawOutPoint; j++) {
-                    i = j * increment;
-                    int idx = ceil((startPos + i) * indicesPrPixel);
-                    idx += idx % m_channels;
-                    i -= offset;
-                    idx += channel;
-                    if (idx >= m_audioLevels.length() || idx < 0) break;
-                    if (pathDraw) {
-                        level = m_audioLevels.at(idx) * scaleFactor;
-                        path.lineTo(i, y - level);
-                    } else {
-                        level = m_audioLevels.at(idx) * scaleFactor; // divide height by 510 (2*255) to get height
-                        painter->drawLine(i, y - level, i, y + level);
+            } else {
+                const double channelHeight = rect.height() / channels;
+                for (int channel = 0; channel < channels; channel++) {
+                    const double y = channel * channelHeight + channelHeight / 2;
+                    if (QSGGeometryNode *node = createWaveformNode(tile.second, channels, channel, x, y, channelHeight / 2, channelHeight / 2,
+                                                                   channel % 2 == 0 ? m_color : m_color2)) {
+                        tileNode->appendChildNode(node);
                     }
                 }
-                if (pathDraw) {
-                    path.lineTo(i, y);
-                    painter->drawPath(path);
-                    QTransform tr(1, 0, 0, -1, 0, 2 * y);
-                    painter->drawPath(tr.map(path));
-                }
-                if (m_firstChunk && m_channels > 1 && m_channels < 7) {
-                    painter->drawText(2, y + channelHeight / 2, chanelNames[channel]);
-                }
             }
+            m_tilesNode->appendChildNode(tileNode);
+            m_tileNodes.insert(tile.first);
         }
+        return oldNode;
     }
 
 signals:
@@ -278,7 +384,55 @@ signals:
     void audioChannelsChanged();
 
 private:
-    QVector<uint8_t> m_audioLevels;
+    void requestTile(int tile)
+    {
+        m_pendingTiles.insert(tile);
+        QPointer<TimelineWaveform> self(this);
+        const WaveformTileParams params = m_params;
+        const int generation = m_generation;
+        QtConcurrent::run([self, params, tile, generation]() {
+            const std::vector<float> levels = buildWaveformTile(params, tile);
+            QMetaObject::invokeMethod(QCoreApplication::instance(), [self, tile, generation, levels]() {
+                if (self) {
+                    self->tileReady(tile, generation, levels);
+                }
+            }, Qt::QueuedConnection);
+        });
+    }
+    void tileReady(int tile, int generation, const std::vector<float> &levels)
+    {
+        if (generation != m_generation) {
+            // Zoom changed while the tile was computed
+            return;
+        }
+        m_pendingTiles.erase(tile);
+        m_tiles[tile] = levels;
+        update();
+    }
+    /** @brief Renders the channel names displayed at the start of the first chunk */
+    void updateLabels()
+    {
+        QImage labels;
+        if (m_firstChunk && !m_params.merged && m_channels > 1 && m_channels < 7 && height() >= 1) {
+            const double channelHeight = height() / m_channels;
+            labels = QImage(QFontMetrics(QGuiApplication::font()).horizontalAdvance(QStringLiteral("LFE")) + 4, int(height()),
+                            QImage::Format_ARGB32_Premultiplied);
+            labels.fill(Qt::transparent);
+            QPainter painter(&labels);
+            for (int channel = 0; channel < m_channels; channel++) {
+                painter.setPen(channel % 2 == 0 ? m_color : m_color2);
+                painter.drawText(QPointF(2, channel * channelHeight + channelHeight), chanelNames[channel]);
+            }
+        }
+        if (labels != m_labels) {
+            m_labels = labels;
+            m_labelsChanged = true;
+            update();
+        }
+    }
+
+    /** @brief Memory mapped levels of the clip stream, only the zoom level needed for painting is read */
+    std::shared_ptr<AudioLevelsStore> m_audioStore;
     int m_inPoint;
     int m_outPoint;
     // Pixels outside the view, can be dropped
@@ -291,12 +445,27 @@ private:
     bool m_normalize;
     bool m_showItem;
     int m_channels;
-    int m_precisionFactor;
     int m_stream;
     double m_audioMax;
     bool m_firstChunk;
+    /** @brief Parameters of the cached tiles, and a counter bumped each time they change to discard late worker results */
+    WaveformTileParams m_params;
+    int m_generation = 0;
+    /** @brief Computed tiles by index, and tiles being computed */
+    std::map<int, std::vector<float>> m_tiles;
+    std::set<int> m_pendingTiles;
+    QImage m_labels;
+    bool m_labelsChanged = false;
+    // Scene graph state, only accessed in updatePaintNode
+    QSGNode *m_tilesNode = nullptr;
+    std::set<int> m_tileNodes;
+    QRectF m_nodeRect;
+    QColor m_nodeColor;
+    QColor m_nodeColor2;
+    int m_nodeGeneration = -1;
 };
 
+
 void registerTimelineItems()
 {
     qmlRegisterType<TimelineTriangle>("Kdenlive.Controls", 1, 0, "TimelineTriangle");
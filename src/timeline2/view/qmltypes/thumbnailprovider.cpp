@@ -21,76 +21,287 @@
 #include "bin/projectitemmodel.h"
 #include "core.h"
 #include "utils/thumbnailcache.hpp"
-#include "doc/kthumb.h"
+#include "utils/thumbnailextractor.hpp"
 
-#include <QCryptographicHash>
-#include <QDebug>
-#include <QQuickImageProvider>
-#include <mlt++/MltFilter.h>
+#include <QMutex>
+#include <QQuickTextureFactory>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
 #include <mlt++/MltProfile.h>
+#include <unordered_map>
+#include <vector>
 
-ThumbnailProvider::ThumbnailProvider()
-    : QQuickImageProvider(QQmlImageProviderBase::Image, QQmlImageProviderBase::ForceAsynchronousImageLoading)
+namespace {
+// How far from the requested frame a cached thumbnail can be used as placeholder, in seconds
+const int placeholderRange = 30;
+
+class ThumbnailResponse : public QQuickImageResponse
 {
-}
+public:
+    explicit ThumbnailResponse(std::weak_ptr<ThumbnailRequestQueue> queue)
+        : m_queue(std::move(queue))
+    {
+    }
+    QQuickTextureFactory *textureFactory() const override { return QQuickTextureFactory::textureFactoryForImage(m_image); }
+    void cancel() override;
+    /** @brief Deliver the result, from any thread. The engine may only be notified once the request returned */
+    void finish(const QImage &image)
+    {
+        QMetaObject::invokeMethod(this, [this, image]() {
+            m_image = image;
+            emit finished();
+        }, Qt::QueuedConnection);
+    }
 
-ThumbnailProvider::~ThumbnailProvider() = default;
+private:
+    std::weak_ptr<ThumbnailRequestQueue> m_queue;
+    QImage m_image;
+};
+} // namespace
 
-QImage ThumbnailProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+class ThumbnailRequestQueue
 {
-    QImage result;
-    // id is binID/#frameNumber
-    QString binId = id.section('/', 0, 0);
-    bool ok;
-    int frameNumber = id.section('#', -1).toInt(&ok);
-    if (ok) {
-        if (ThumbnailCache::get()->hasThumbnail(binId, frameNumber, false)) {
-            result = ThumbnailCache::get()->getThumbnail(binId, frameNumber);
-            *size = result.size();
-            return result;
+public:
+    ThumbnailRequestQueue() { m_pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() / 2, 4)); }
+
+    void enqueue(const std::shared_ptr<ThumbnailRequestQueue> &self, ThumbnailResponse *response, const QString &binId, int frame, bool keyframesOnly)
+    {
+        const QString key = requestKey(binId, frame, keyframesOnly);
+        QMutexLocker lock(&m_mutex);
+        auto pending = m_pending.find(key);
+        if (pending != m_pending.end()) {
+            // A close enough frame is already requested, share its result
+            const std::shared_ptr<Job> &job = pending->second;
+            job->responses.push_back(response);
+            job->frames.push_back(frame);
+            job->generation = ++m_generation;
+            m_jobs[response] = job;
+            return;
         }
-        std::shared_ptr<ProjectClip> binClip = pCore->projectItemModel()->getClipByBinID(binId);
-        if (binClip) {
-            std::shared_ptr<Mlt::Producer> prod = binClip->thumbProducer();
-            if (prod && prod->is_valid()) {
-                result = makeThumbnail(prod, frameNumber, requestedSize);
-                ThumbnailCache::get()->storeThumbnail(binId, frameNumber, result, false);
+        auto job = std::make_shared<Job>();
+        job->key = key;
+        job->binId = binId;
+        job->keyframesOnly = keyframesOnly;
+        job->frames.push_back(frame);
+        job->responses.push_back(response);
+        job->generation = ++m_generation;
+        m_pending[key] = job;
+        m_jobs[response] = job;
+        lock.unlock();
+        std::weak_ptr<ThumbnailRequestQueue> queue = self;
+        QtConcurrent::run(&m_pool, [queue]() {
+            if (auto current = queue.lock()) {
+                current->runNext();
             }
+        });
+    }
+
+    void cancel(ThumbnailResponse *response)
+    {
+        QMutexLocker lock(&m_mutex);
+        auto found = m_jobs.find(response);
+        if (found == m_jobs.end()) {
+            // Already delivered
+            return;
+        }
+        std::shared_ptr<Job> job = found->second;
+        m_jobs.erase(found);
+        job->responses.erase(std::remove(job->responses.begin(), job->responses.end(), response), job->responses.end());
+        if (job->responses.empty() && !job->running) {
+            // Nobody wants it anymore, don't decode it
+            m_pending.erase(job->key);
         }
+        lock.unlock();
+        response->finish(QImage());
     }
-    if (size) *size = result.size();
-    return result;
-}
 
-QString ThumbnailProvider::cacheKey(Mlt::Properties &properties, const QString &service, const QString &resource, const QString &hash, int frameNumber)
+    void shutdown()
+    {
+        QMutexLocker lock(&m_mutex);
+        for (const auto &job : m_jobs) {
+            job.first->finish(QImage());
+        }
+        m_jobs.clear();
+        m_pending.clear();
+        lock.unlock();
+        m_pool.clear();
+        m_pool.waitForDone();
+    }
+
+private:
+    struct Job
+    {
+        QString key;
+        QString binId;
+        bool keyframesOnly;
+        std::vector<int> frames;
+        std::vector<ThumbnailResponse *> responses;
+        quint64 generation;
+        bool running{false};
+    };
+
+    // Frames of a clip that round to the same centisecond are decoded once, keyframes being approximate anyway are grouped by tenth of second
+    static QString requestKey(const QString &binId, int frame, bool keyframesOnly)
+    {
+        const double fps = pCore->getCurrentFps();
+        const qint64 time = keyframesOnly ? qRound64(frame * 10. / fps) : qRound64(frame * 100. / fps);
+        return QStringLiteral("%1/%2%3").arg(binId, keyframesOnly ? QStringLiteral("k") : QString()).arg(time);
+    }
+
+    // Decode the most recently requested job, along with the other pending jobs of its clip
+    void runNext()
+    {
+        QMutexLocker lock(&m_mutex);
+        if (m_pending.empty()) {
+            return;
+        }
+        auto next = m_pending.begin();
+        for (auto it = m_pending.begin(); it != m_pending.end(); ++it) {
+            if (it->second->generation > next->second->generation) {
+                next = it;
+            }
+        }
+        const QString binId = next->second->binId;
+        const bool keyframesOnly = next->second->keyframesOnly;
+        // Requests come newest first, so decoding them one by one would walk the clip backwards and seek for each of them.
+        // Take all the pending frames of the clip instead, the extractor reaches those sharing a GOP by decoding forward.
+        std::vector<std::shared_ptr<Job>> batch;
+        for (auto it = m_pending.begin(); it != m_pending.end();) {
+            if (it->second->binId == binId && it->second->keyframesOnly == keyframesOnly) {
+                it->second->running = true;
+                batch.push_back(it->second);
+                it = m_pending.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        lock.unlock();
+
+        std::unordered_map<int, QImage> images;
+        std::vector<int> missing;
+        for (const auto &job : batch) {
+            const int frame = job->frames.front();
+            QImage cached = ThumbnailCache::get()->getThumbnail(binId, frame);
+            if (cached.isNull()) {
+                missing.push_back(frame);
+            } else {
+                images[frame] = cached;
+            }
+        }
+        std::sort(missing.begin(), missing.end());
+        missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+        if (!missing.empty()) {
+            std::shared_ptr<ProjectClip> binClip = pCore->projectItemModel()->getClipByBinID(binId);
+            if (binClip) {
+                makeThumbnails(binClip, missing, keyframesOnly, images);
+            }
+        }
+
+        lock.relock();
+        std::vector<std::pair<ThumbnailResponse *, QImage>> responses;
+        for (const auto &job : batch) {
+            auto found = images.find(job->frames.front());
+            const QImage result = found == images.end() ? QImage() : found->second;
+            for (ThumbnailResponse *response : job->responses) {
+                // Responses already answered by shutdown() are not ours anymore
+                if (m_jobs.erase(response) > 0) {
+                    responses.emplace_back(response, result);
+                }
+            }
+            job->responses.clear();
+        }
+        lock.unlock();
+        // Approximate thumbnails are not cached, they would be returned for exact requests
+        if (!keyframesOnly) {
+            for (const auto &job : batch) {
+                const int frame = job->frames.front();
+                auto found = images.find(frame);
+                if (found == images.end() || !std::binary_search(missing.begin(), missing.end(), frame)) {
+                    continue;
+                }
+                for (int requested : job->frames) {
+                    ThumbnailCache::get()->storeThumbnail(binId, requested, found->second, false);
+                }
+            }
+        }
+        for (const auto &response : responses) {
+            response.first->finish(response.second);
+        }
+    }
+
+    // Extract the given frames, sorted, in a single pass over the clip
+    static void makeThumbnails(const std::shared_ptr<ProjectClip> &binClip, const std::vector<int> &frames, bool keyframesOnly,
+                               std::unordered_map<int, QImage> &images)
+    {
+        // TODO: cache these values ?
+        int imageHeight = pCore->thumbProfile()->height();
+        int fullWidth = imageHeight * pCore->getCurrentDar() + 0.5;
+        if (fullWidth == pCore->thumbProfile()->width()) {
+            // No need to scale
+            fullWidth = 0;
+        }
+        ThumbnailExtractor::get()->extract(binClip, frames, keyframesOnly ? ThumbnailExtractor::Mode::KeyframesOnly : ThumbnailExtractor::Mode::Exact,
+                                           fullWidth, [&images](int frame, const QImage &image) {
+                                               images[frame] = image;
+                                               return true;
+                                           });
+    }
+
+    QMutex m_mutex;
+    // Jobs waiting for a thread, by request key
+    std::unordered_map<QString, std::shared_ptr<Job>> m_pending;
+    // Job of each response that is not delivered yet
+    std::unordered_map<ThumbnailResponse *, std::shared_ptr<Job>> m_jobs;
+    quint64 m_generation{0};
+    QThreadPool m_pool;
+};
+
+void ThumbnailResponse::cancel()
 {
-    QString time = properties.frames_to_time(frameNumber, mlt_time_clock);
-    // Reduce the precision to centiseconds to increase chance for cache hit
-    // without much loss of accuracy.
-    time = time.left(time.size() - 1);
-    QString key;
-    if (hash.isEmpty()) {
-        key = QString("%1 %2 %3").arg(service).arg(resource, time);
-        QCryptographicHash hash2(QCryptographicHash::Sha1);
-        hash2.addData(key.toUtf8());
-        key = hash2.result().toHex();
-    } else {
-        key = QString("%1 %2").arg(hash, time);
+    if (auto queue = m_queue.lock()) {
+        queue->cancel(this);
     }
-    return key;
 }
 
-QImage ThumbnailProvider::makeThumbnail(const std::shared_ptr<Mlt::Producer> &producer, int frameNumber, const QSize &requestedSize)
+ThumbnailProvider::ThumbnailProvider()
+    : m_queue(std::make_shared<ThumbnailRequestQueue>())
+{
+}
+
+ThumbnailProvider::~ThumbnailProvider()
+{
+    m_queue->shutdown();
+}
+
+QQuickImageResponse *ThumbnailProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
 {
     Q_UNUSED(requestedSize)
-    producer->seek(frameNumber);
-    QScopedPointer<Mlt::Frame> frame(producer->get_frame());
-    if (frame == nullptr || !frame->is_valid()) {
-        return QImage();
+    auto *response = new ThumbnailResponse(m_queue);
+    // id is binID/#frameNumber, the frame number can be prefixed by k (keyframes only) or p (placeholder)
+    QString binId = id.section('/', 0, 0);
+    QString frame = id.section('#', -1);
+    const bool keyframesOnly = frame.startsWith(QLatin1Char('k'));
+    const bool placeholder = frame.startsWith(QLatin1Char('p'));
+    if (keyframesOnly || placeholder) {
+        frame.remove(0, 1);
+    }
+    bool ok;
+    int frameNumber = frame.toInt(&ok);
+    if (!ok) {
+        response->finish(QImage());
+        return response;
+    }
+    QImage result = ThumbnailCache::get()->getThumbnail(binId, frameNumber, true);
+    if (!result.isNull()) {
+        response->finish(result);
+    } else if (placeholder) {
+        const int range = qRound(placeholderRange * pCore->getCurrentFps());
+        result = ThumbnailCache::get()->getNearestThumbnail(binId, frameNumber, range);
+        response->finish(result.isNull() ? result : result.scaled(result.size() / 2, Qt::IgnoreAspectRatio, Qt::FastTransformation));
+    } else {
+        m_queue->enqueue(m_queue, response, binId, frameNumber, keyframesOnly);
     }
-    // TODO: cache these values ?
-    int imageHeight = pCore->thumbProfile()->height();
-    int imageWidth = pCore->thumbProfile()->width();
-    int fullWidth = imageHeight * pCore->getCurrentDar() + 0.5;
-    return KThumb::getFrame(frame.data(), imageWidth, imageHeight, fullWidth);
+    return response;
 }
@@ -19,23 +19,28 @@
 #ifndef THUMBNAILPROVIDER_H
 #define THUMBNAILPROVIDER_H
 
-#include <KImageCache>
-#include <QCache>
-#include <QQuickImageProvider>
+#include <QQuickAsyncImageProvider>
 #include <memory>
-#include <mlt++/MltProducer.h>
-#include <mlt++/MltProfile.h>
 
-class ThumbnailProvider : public QQuickImageProvider
+class ThumbnailRequestQueue;
+
+/** @brief Provides the thumbnails of the timeline clips.
+    Ids are binId/documentId/#frame. The frame can be prefixed by k when the nearest keyframe is good enough,
+    or by p for a low resolution placeholder taken from the closest cached thumbnail, which is returned at once.
+    The other requests are decoded by a small thread pool, newest first since they are the ones for the part of the
+    timeline that is currently displayed. The clip of the newest request is processed with all its pending frames
+    in one forward pass. The requests dropped by the view when it scrolls are cancelled before being decoded,
+    and requests that round to the same centisecond of a clip share a single decode.
+ */
+class ThumbnailProvider : public QQuickAsyncImageProvider
 {
 public:
     explicit ThumbnailProvider();
     ~ThumbnailProvider() override;
-    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
 
 private:
-    QImage makeThumbnail(const std::shared_ptr<Mlt::Producer> &producer, int frameNumber, const QSize &requestedSize);
-    QString cacheKey(Mlt::Properties &properties, const QString &service, const QString &resource, const QString &hash, int frameNumber);
+    std::shared_ptr<ThumbnailRequestQueue> m_queue;
 };
 
 #endif // THUMBNAILPROVIDER_H
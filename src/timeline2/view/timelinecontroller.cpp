@@ -55,6 +55,7 @@
 #include <QClipboard>
 #include <QQuickItem>
 #include <memory>
+#include <set>
 #include <unistd.h>
 
 int TimelineController::m_duration = 0;
@@ -2402,14 +2403,21 @@ void TimelineController::setAudioRef(int clipId)
         }
     }
     m_audioRef = clipId;
+    m_pendingAlignMoves.clear();
     std::unique_ptr<AudioEnvelope> envelope(new AudioEnvelope(getClipBinId(clipId), clipId));
     m_audioCorrelator.reset(new AudioCorrelation(std::move(envelope)));
-    connect(m_audioCorrelator.get(), &AudioCorrelation::gotAudioAlignData, this, [&](int cid, int shift) {
-        int pos = m_model->getClipPosition(m_audioRef) + shift - m_model->getClipIn(m_audioRef);
-        bool result = m_model->requestClipMove(cid, m_model->getClipTrackId(cid), pos, true, true, true);
-        if (!result) {
-            pCore->displayMessage(i18n("Cannot move clip to frame %1.", (pos + shift)), InformationMessage, 500);
+    connect(m_audioCorrelator.get(), &AudioCorrelation::gotAudioAlignData, this, [&](const QMap<int, int> &shifts) {
+        QMap<int, int> positions;
+        if (m_model->isClip(m_audioRef)) {
+            for (auto it = shifts.cbegin(); it != shifts.cend(); ++it) {
+                positions.insert(it.key(), m_model->getClipPosition(m_audioRef) + it.value() - m_model->getClipIn(m_audioRef));
+            }
         }
+        for (auto it = m_pendingAlignMoves.cbegin(); it != m_pendingAlignMoves.cend(); ++it) {
+            positions.insert(it.key(), it.value());
+        }
+        m_pendingAlignMoves.clear();
+        applyAudioAlignment(positions);
     });
     connect(m_audioCorrelator.get(), &AudioCorrelation::displayMessage, pCore.get(), &Core::displayMessage);
 }
@@ -2437,6 +2445,8 @@ void TimelineController::alignAudio(int clipId)
         clipsToAnalyse.insert(clipId);
     }
     QList <int> processedGroups;
+    QList<AudioEnvelope *> envelopes;
+    QMap<int, int> sameClipMoves;
     int processed = 0;
     for (int cid : clipsToAnalyse) {
         if (!m_model->isClip(cid) || cid == m_audioRef) {
@@ -2464,24 +2474,59 @@ void TimelineController::alignAudio(int clipId)
             // easy, same clip.
             int newPos = m_model->getClipPosition(m_audioRef) - m_model->getClipIn(m_audioRef) + m_model->getClipIn(cid);
             if (newPos) {
-                bool result = m_model->requestClipMove(cid, m_model->getClipTrackId(cid), newPos, true, true, true);
+                sameClipMoves.insert(cid, newPos);
                 processed ++;
-                if (!result) {
-                    pCore->displayMessage(i18n("Cannot move clip to frame %1.", newPos), InformationMessage, 500);
-                }
                 continue;
             }
         }
         processed ++;
         // Perform audio calculation
-        AudioEnvelope *envelope = new AudioEnvelope(otherBinId, cid, (size_t)m_model->getClipIn(cid), (size_t)m_model->getClipPlaytime(cid),
-                                                (size_t)m_model->getClipPosition(cid));
-        m_audioCorrelator->addChild(envelope);
+        envelopes << new AudioEnvelope(otherBinId, cid, (size_t)m_model->getClipIn(cid), (size_t)m_model->getClipPlaytime(cid),
+                                       (size_t)m_model->getClipPosition(cid));
     }
     if (processed == 0) {
         //TODO: improve feedback message after freeze
         pCore->displayMessage(i18n("Select a clip to apply an effect"), InformationMessage, 500);
     }
+    if (envelopes.isEmpty()) {
+        applyAudioAlignment(sameClipMoves);
+        return;
+    }
+    // Moves are applied together with the analysed clips, as one undo operation
+    for (auto it = sameClipMoves.cbegin(); it != sameClipMoves.cend(); ++it) {
+        m_pendingAlignMoves.insert(it.key(), it.value());
+    }
+    for (AudioEnvelope *envelope : qAsConst(envelopes)) {
+        m_audioCorrelator->addChild(envelope);
+    }
+}
+
+void TimelineController::applyAudioAlignment(const QMap<int, int> &positions)
+{
+    Fun undo = []() { return true; };
+    Fun redo = []() { return true; };
+    int moved = 0;
+    for (auto it = positions.cbegin(); it != positions.cend(); ++it) {
+        int cid = it.key();
+        if (!m_model->isClip(cid) || m_model->getClipPosition(cid) == it.value()) {
+            continue;
+        }
+        bool result;
+        if (m_model->m_groups->isInGroup(cid)) {
+            int groupId = m_model->m_groups->getRootId(cid);
+            result = m_model->requestGroupMove(cid, groupId, 0, it.value() - m_model->getClipPosition(cid), true, true, undo, redo);
+        } else {
+            result = m_model->requestClipMove(cid, m_model->getClipTrackId(cid), it.value(), true, true, true, true, undo, redo);
+        }
+        if (result) {
+            moved++;
+        } else {
+            pCore->displayMessage(i18n("Cannot move clip to frame %1.", it.value()), InformationMessage, 500);
+        }
+    }
+    if (moved > 0) {
+        pCore->pushUndo(undo, redo, i18n("Align clips"));
+    }
 }
 
 void TimelineController::switchTrackActive(int trackId)
@@ -3211,17 +3256,15 @@ bool TimelineController::endFakeGroupMove(int clipId, int groupId, int delta_tra
     return true;
 }
 
-QStringList TimelineController::getThumbKeys()
+std::vector<std::pair<QString, int>> TimelineController::getThumbKeys()
 {
-    QStringList result;
+    std::set<std::pair<QString, int>> result;
     for (const auto &clp : m_model->m_allClips) {
         const QString binId = getClipBinId(clp.first);
-        std::shared_ptr<ProjectClip> binClip = pCore->bin()->getBinClip(binId);
-        result << binClip->hash() + QLatin1Char('#') + QString::number(clp.second->getIn()) + QStringLiteral(".png");
-        result << binClip->hash() + QLatin1Char('#') + QString::number(clp.second->getOut()) + QStringLiteral(".png");
+        result.insert({binId, clp.second->getIn()});
+        result.insert({binId, clp.second->getOut()});
     }
-    result.removeDuplicates();
-    return result;
+    return std::vector<std::pair<QString, int>>(result.begin(), result.end());
 }
 
 bool TimelineController::isInSelection(int itemId)
@@ -528,8 +528,8 @@ public:
     Q_INVOKABLE const QString getAssetName(const QString &assetId, bool isTransition);
     /** @brief Set keyboard grabbing on current selection */
     Q_INVOKABLE void grabCurrent();
-    /** @brief Returns keys for all used thumbnails */
-    QStringList getThumbKeys();
+    /** @brief Returns (bin id, position) of all the thumbnails used in timeline */
+    std::vector<std::pair<QString, int>> getThumbKeys();
     /** @brief Returns true if a drag operation is currently running in timeline */
     bool dragOperationRunning();
     /** @brief Disconnect some stuff before closing project */
@@ -622,6 +622,8 @@ private:
     PreviewManager *m_timelinePreview;
     QAction *m_disablePreview;
     std::shared_ptr<AudioCorrelation> m_audioCorrelator;
+    /** @brief Positions of clips aligned without analysis, applied with the pending audio alignment results */
+    QMap<int, int> m_pendingAlignMoves;
     QMutex m_metaMutex;
     bool m_ready;
     std::vector<int> m_activeSnaps;
@@ -632,6 +634,8 @@ private:
     void initializePreview();
     bool darkBackground() const;
     int getMenuOrTimelinePos() const;
+    /** @brief Move clips to the given positions (clip id, position) as a single undo operation */
+    void applyAudioAlignment(const QMap<int, int> &positions);
 
 signals:
     void selected(Mlt::Producer *producer);
@@ -23,6 +23,94 @@
 #include "logger.hpp"
 #include <QDebug>
 #include <utility>
+
+FunSequence::Data &FunSequence::sequence(Fun &lambda)
+{
+    auto *seq = lambda.target<FunSequence>();
+    if (seq == nullptr) {
+        FunSequence created;
+        created.m_data = std::make_shared<Data>();
+        if (lambda) {
+            created.m_data->back.push_back({std::move(lambda), 0, false});
+        }
+        lambda = std::move(created);
+        seq = lambda.target<FunSequence>();
+    } else if (seq->m_data.use_count() > 1) {
+        // Another copy of this Fun still refers to the steps, detach
+        seq->m_data = std::make_shared<Data>(*seq->m_data);
+    }
+    return *seq->m_data;
+}
+
+void FunSequence::append(Fun &lambda, Fun operation, bool shortCircuit)
+{
+    Data &data = sequence(lambda);
+    data.back.push_back({std::move(operation), 0, shortCircuit});
+}
+
+void FunSequence::prepend(Fun &lambda, Fun operation, bool shortCircuit)
+{
+    Data &data = sequence(lambda);
+    data.front.push_back({std::move(operation), data.back.size(), shortCircuit});
+}
+
+size_t FunSequence::stepCount(const Fun &lambda)
+{
+    if (const auto *seq = lambda.target<FunSequence>()) {
+        return seq->m_data->front.size() + seq->m_data->back.size();
+    }
+    return lambda ? 1 : 0;
+}
+
+size_t FunSequence::memoryUsage(const Fun &lambda)
+{
+    if (const auto *seq = lambda.target<FunSequence>()) {
+        return sizeof(Data) + (seq->m_data->front.capacity() + seq->m_data->back.capacity()) * sizeof(Step);
+    }
+    return 0;
+}
+
+bool FunSequence::operator()() const
+{
+    // Each prepended step wraps everything that was in the sequence when it was added: the older prepended steps and the appended steps
+    // before its barrier. We keep a frame for every wrapper whose inner part is still running, and merge its own result when the inner part ends.
+    struct Frame
+    {
+        size_t barrier;
+        bool result;
+    };
+    const Data &data = *m_data;
+    std::vector<Frame> frames;
+    frames.reserve(data.front.size());
+    bool ok = true;
+    size_t start = 0;
+    for (auto step = data.front.rbegin(); step != data.front.rend(); ++step) {
+        bool res = step->fn();
+        if (step->shortCircuit && !res) {
+            // Skip the wrapped part entirely
+            ok = false;
+            start = step->barrier;
+            break;
+        }
+        frames.push_back({step->barrier, res});
+    }
+    for (size_t i = start; i < data.back.size(); ++i) {
+        while (!frames.empty() && frames.back().barrier <= i) {
+            ok = ok && frames.back().result;
+            frames.pop_back();
+        }
+        const Step &step = data.back[i];
+        if (step.shortCircuit) {
+            ok = ok && step.fn();
+        } else {
+            ok = step.fn() && ok;
+        }
+    }
+    for (auto frame = frames.rbegin(); frame != frames.rend(); ++frame) {
+        ok = ok && frame->result;
+    }
+    return ok;
+}
 FunctionalUndoCommand::FunctionalUndoCommand(Fun undo, Fun redo, const QString &text, QUndoCommand *parent)
     : QUndoCommand(parent)
     , m_undo(std::move(undo))
@@ -22,24 +22,58 @@
 #ifndef UNDOHELPER_H
 #define UNDOHELPER_H
 #include <functional>
+#include <memory>
+#include <vector>
 
 using Fun = std::function<bool(void)>;
 
-/* @brief this macro executes an operation after a given lambda
+/* @brief Flat list of operations stored inside a Fun.
+   Wrapping the previous lambda in a new closure for every composed operation builds chains thousands of closures deep on large group
+   operations, allocating at each step and recursing through the whole chain when executed. Instead, the macros below turn the Fun into a
+   FunSequence on first use and then append (or prepend) steps to its contiguous storage, which is executed with a loop.
+   The storage is shared between copies of the Fun and duplicated on write, so copies keep value semantics.
+   Executing the sequence gives exactly the same result and evaluation order as the equivalent nested lambdas.
  */
-#define PUSH_LAMBDA(operation, lambda)                                                                                                                         \
-    lambda = [lambda, operation]() {                                                                                                                           \
-        bool v = lambda();                                                                                                                                     \
-        return v && operation();                                                                                                                               \
+class FunSequence
+{
+public:
+    /* @brief Add operation after lambda. If shortCircuit is true, operation is skipped when lambda fails */
+    static void append(Fun &lambda, Fun operation, bool shortCircuit);
+    /* @brief Add operation before lambda. If shortCircuit is true, lambda is skipped when operation fails */
+    static void prepend(Fun &lambda, Fun operation, bool shortCircuit);
+    /* @brief Number of steps stored in lambda (1 if it is a plain function) */
+    static size_t stepCount(const Fun &lambda);
+    /* @brief Bytes used by the step storage of lambda, not counting the heap allocated captures of the steps themselves */
+    static size_t memoryUsage(const Fun &lambda);
+
+    bool operator()() const;
+
+private:
+    struct Step
+    {
+        Fun fn;
+        /* @brief For prepended steps, number of appended steps that existed when this one was added */
+        size_t barrier;
+        bool shortCircuit;
+    };
+    struct Data
+    {
+        /* @brief Prepended steps, in insertion order (executed last to first) */
+        std::vector<Step> front;
+        std::vector<Step> back;
     };
+    std::shared_ptr<Data> m_data;
+
+    static Data &sequence(Fun &lambda);
+};
+
+/* @brief this macro executes an operation after a given lambda
+ */
+#define PUSH_LAMBDA(operation, lambda) FunSequence::append(lambda, operation, true);
 
 /* @brief this macro executes an operation before a given lambda
  */
-#define PUSH_FRONT_LAMBDA(operation, lambda)                                                                                                                   \
-    lambda = [lambda, operation]() {                                                                                                                           \
-        bool v = operation();                                                                                                                                  \
-        return v && lambda();                                                                                                                                  \
-    };
+#define PUSH_FRONT_LAMBDA(operation, lambda) FunSequence::prepend(lambda, operation, true);
 
 #include <QUndoCommand>
 
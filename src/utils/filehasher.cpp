@@ -0,0 +1,289 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "filehasher.hpp"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+std::unique_ptr<FileHasher> FileHasher::instance;
+std::once_flag FileHasher::m_onceFlag;
+
+namespace {
+// Files larger than this are hashed on their first and last sampleSize bytes
+const qint64 sampleSize = 1000000;
+// Default number of files read at the same time
+const int defaultIoConcurrency = 4;
+// Entries kept in the persistent cache, the least recently used ones are dropped
+const size_t maxCacheEntries = 50000;
+const quint32 cacheMagic = 0x4b444648;
+const qint32 cacheVersion = 1;
+
+/* @brief Reads the size, modification time and inode of a regular file, returns false if it does not exist */
+bool fileIdentity(const QString &path, qint64 &size, qint64 &modified, quint64 &inode)
+{
+#ifdef Q_OS_UNIX
+    struct stat info;
+    if (::stat(QFile::encodeName(path).constData(), &info) != 0 || !S_ISREG(info.st_mode)) {
+        return false;
+    }
+    size = qint64(info.st_size);
+#ifdef Q_OS_DARWIN
+    modified = qint64(info.st_mtimespec.tv_sec) * 1000 + info.st_mtimespec.tv_nsec / 1000000;
+#else
+    modified = qint64(info.st_mtim.tv_sec) * 1000 + info.st_mtim.tv_nsec / 1000000;
+#endif
+    inode = quint64(info.st_ino);
+#else
+    QFileInfo info(path);
+    if (!info.isFile()) {
+        return false;
+    }
+    size = info.size();
+    modified = info.lastModified().toMSecsSinceEpoch();
+    inode = 0;
+#endif
+    return true;
+}
+
+/* @brief A 64 bits multiply / xorshift hash reading 8 bytes per step */
+QByteArray fastHash(const QByteArray &data)
+{
+    const quint64 prime = 0x9e3779b97f4a7c15ULL;
+    const uchar *bytes = reinterpret_cast<const uchar *>(data.constData());
+    const int length = data.size();
+    quint64 h = quint64(length) * prime;
+    int i = 0;
+    for (; i + 8 <= length; i += 8) {
+        quint64 k = qFromLittleEndian<quint64>(bytes + i);
+        k *= 0xbf58476d1ce4e5b9ULL;
+        k ^= k >> 31;
+        h = (h ^ k) * prime;
+    }
+    quint64 tail = 0;
+    for (int shift = 0; i < length; ++i, shift += 8) {
+        tail |= quint64(bytes[i]) << shift;
+    }
+    h = (h ^ tail) * prime;
+    // Final mix so that all input bits affect all output bits
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    QByteArray result(8, '\0');
+    qToBigEndian(h, reinterpret_cast<uchar *>(result.data()));
+    return result;
+}
+} // namespace
+
+FileHasher::FileHasher(const QString &cachePath)
+    : m_cachePath(cachePath)
+{
+    m_pool.setMaxThreadCount(defaultIoConcurrency);
+    load();
+}
+
+FileHasher::~FileHasher()
+{
+    // The cache is saved explicitly, see Core::clean(), the instance might be destroyed after the application
+    m_pool.waitForDone();
+}
+
+std::unique_ptr<FileHasher> &FileHasher::get()
+{
+    std::call_once(m_onceFlag, [] {
+        instance.reset(new FileHasher(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/filehashes.cache")));
+    });
+    return instance;
+}
+
+QString FileHasher::cacheKey(const QString &path, Mode mode)
+{
+    return (mode == Mode::Md5 ? QStringLiteral("md5:") : QStringLiteral("fast:")) + path;
+}
+
+FileHasher::Result FileHasher::computeHash(const QString &path, Mode mode)
+{
+    Result result;
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly)) { // write size and hash only if resource points to a file
+        /*
+        * 1 MB = 1 second per 450 files (or faster)
+        * 10 MB = 9 seconds per 450 files (or faster)
+        */
+        QByteArray fileData;
+        result.size = file.size();
+        if (result.size > 2 * sampleSize) {
+            fileData = file.read(sampleSize);
+            if (file.seek(result.size - sampleSize)) {
+                fileData.append(file.readAll());
+            }
+        } else {
+            fileData = file.readAll();
+        }
+        file.close();
+        result.hash = mode == Mode::Md5 ? QCryptographicHash::hash(fileData, QCryptographicHash::Md5) : fastHash(fileData);
+    }
+    return result;
+}
+
+FileHasher::Result FileHasher::hash(const QString &path, Mode mode)
+{
+    qint64 size, modified;
+    quint64 inode;
+    if (!fileIdentity(path, size, modified, inode)) {
+        return Result();
+    }
+    const QString key = cacheKey(path, mode);
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    {
+        QMutexLocker lock(&m_mutex);
+        auto it = m_cache.find(key);
+        if (it != m_cache.end() && it->second.size == size && it->second.modified == modified && it->second.inode == inode) {
+            it->second.used = now;
+            m_stats.hits++;
+            return {it->second.hash, size};
+        }
+        m_stats.misses++;
+    }
+    Result result = computeHash(path, mode);
+    if (!result.hash.isEmpty()) {
+        // If the file changed while we read it, the identity stored is the old one and the next query will read it again
+        QMutexLocker lock(&m_mutex);
+        m_cache[key] = {size, modified, inode, result.hash, now};
+        m_dirty = true;
+    }
+    return result;
+}
+
+std::vector<FileHasher::Result> FileHasher::hashFiles(const QStringList &paths, Mode mode)
+{
+    std::vector<Result> results(size_t(paths.size()));
+    QVector<QFuture<void>> futures;
+    futures.reserve(paths.size());
+    for (int i = 0; i < paths.size(); ++i) {
+        futures << QtConcurrent::run(&m_pool, [this, &paths, &results, i, mode]() { results[size_t(i)] = hash(paths.at(i), mode); });
+    }
+    for (auto &future : futures) {
+        future.waitForFinished();
+    }
+    save();
+    return results;
+}
+
+void FileHasher::setIoConcurrency(int count)
+{
+    m_pool.setMaxThreadCount(qMax(1, count));
+}
+
+int FileHasher::ioConcurrency() const
+{
+    return m_pool.maxThreadCount();
+}
+
+FileHasher::Statistics FileHasher::statistics() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_stats;
+}
+
+void FileHasher::clearCache()
+{
+    QMutexLocker lock(&m_mutex);
+    m_cache.clear();
+    m_dirty = true;
+}
+
+void FileHasher::load()
+{
+    QFile file(m_cachePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_11);
+    quint32 magic = 0;
+    qint32 version = 0;
+    quint32 count = 0;
+    in >> magic >> version >> count;
+    if (magic != cacheMagic || version != cacheVersion) {
+        return;
+    }
+    QMutexLocker lock(&m_mutex);
+    for (quint32 i = 0; i < count; ++i) {
+        QString key;
+        Entry entry;
+        in >> key >> entry.size >> entry.modified >> entry.inode >> entry.hash >> entry.used;
+        if (in.status() != QDataStream::Ok) {
+            qDebug() << "File hash cache" << m_cachePath << "is corrupted";
+            m_cache.clear();
+            return;
+        }
+        m_cache[key] = entry;
+    }
+}
+
+void FileHasher::save()
+{
+    std::vector<std::pair<QString, Entry>> entries;
+    {
+        QMutexLocker lock(&m_mutex);
+        if (!m_dirty) {
+            return;
+        }
+        m_dirty = false;
+        entries.assign(m_cache.begin(), m_cache.end());
+    }
+    if (entries.size() > maxCacheEntries) {
+        std::nth_element(entries.begin(), entries.begin() + maxCacheEntries, entries.end(),
+                         [](const std::pair<QString, Entry> &a, const std::pair<QString, Entry> &b) { return a.second.used > b.second.used; });
+        entries.resize(maxCacheEntries);
+    }
+    if (!QDir().mkpath(QFileInfo(m_cachePath).absolutePath())) {
+        return;
+    }
+    QSaveFile file(m_cachePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Cannot write file hash cache" << m_cachePath;
+        return;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_11);
+    out << cacheMagic << cacheVersion << quint32(entries.size());
+    for (const auto &entry : entries) {
+        out << entry.first << entry.second.size << entry.second.modified << entry.second.inode << entry.second.hash << entry.second.used;
+    }
+    file.commit();
+}
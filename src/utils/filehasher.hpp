@@ -0,0 +1,113 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#pragma once
+
+#include "definitions.h"
+#include <QByteArray>
+#include <QMutex>
+#include <QStringList>
+#include <QThreadPool>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/** @brief This class computes the hashes that identify the content of media files.
+    A file hash is computed on at most 2 MB of the file: its first and last megabyte.
+    Hashes are kept in a persistent cache indexed by path, checked against the file size, modification time and inode,
+    so that the file is not read again as long as it does not change.
+    Several files can be hashed in parallel, with a bounded number of files read at the same time.
+ * Note that this class is a Singleton
+ */
+
+class FileHasher
+{
+
+public:
+    enum class Mode {
+        /** @brief MD5, the hash stored in project files as kdenlive:file_hash */
+        Md5,
+        /** @brief A non cryptographic 64 bits hash, much faster to compute, for keys that are not stored in documents */
+        Fast
+    };
+
+    struct Result
+    {
+        /** @brief The hash, empty if the file could not be read */
+        QByteArray hash;
+        qint64 size = 0;
+    };
+
+    // Returns the instance of the Singleton
+    static std::unique_ptr<FileHasher> &get();
+    ~FileHasher();
+
+    /* @brief Returns the hash of a file, from the cache if it did not change */
+    Result hash(const QString &path, Mode mode = Mode::Md5);
+    /* @brief Returns the hashes of several files, in the same order, computed in parallel */
+    std::vector<Result> hashFiles(const QStringList &paths, Mode mode = Mode::Md5);
+    /* @brief Computes the hash of a file, without using the cache */
+    static Result computeHash(const QString &path, Mode mode = Mode::Md5);
+
+    /* @brief Sets the maximum number of files that are read at the same time */
+    void setIoConcurrency(int count);
+    int ioConcurrency() const;
+
+    /* @brief Writes the persistent cache to disk if it changed, done after saving a project and on exit */
+    void save();
+    /* @brief Drops all cached hashes */
+    void clearCache();
+
+    struct Statistics
+    {
+        int hits = 0;
+        int misses = 0;
+    };
+    Statistics statistics() const;
+
+protected:
+    // Constructor is protected because class is a Singleton
+    explicit FileHasher(const QString &cachePath);
+
+    struct Entry
+    {
+        qint64 size;
+        qint64 modified;
+        quint64 inode;
+        QByteArray hash;
+        /** @brief Time of the last use in seconds, to drop the oldest entries */
+        qint64 used;
+    };
+    static QString cacheKey(const QString &path, Mode mode);
+    void load();
+
+    static std::unique_ptr<FileHasher> instance;
+    static std::once_flag m_onceFlag; // flag to create the hasher only once;
+
+    QString m_cachePath;
+    QThreadPool m_pool;
+    // This mutex protects the cache and statistics, it is never held while reading a file
+    mutable QMutex m_mutex;
+    std::unordered_map<QString, Entry> m_cache;
+    bool m_dirty{false};
+    Statistics m_stats;
+};
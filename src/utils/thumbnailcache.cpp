@@ -26,78 +26,222 @@
 #include "doc/kdenlivedoc.h"
 #include <QDir>
 #include <QMutexLocker>
-#include <list>
+#include <QReadWriteLock>
+#include <QtConcurrent>
+#include <algorithm>
+#include <atomic>
+#include <set>
 
 std::unique_ptr<ThumbnailCache> ThumbnailCache::instance;
 std::once_flag ThumbnailCache::m_onceFlag;
 
+namespace {
+// Number of thumbnails written to disk before the pending queue is checked again
+const int writeBatchSize = 16;
+} // namespace
+
 class ThumbnailCache::Cache_t
 {
 public:
-    Cache_t(int maxCost)
-        : m_maxCost(maxCost)
+    explicit Cache_t(qint64 budget)
+        : m_budget(budget)
     {
     }
 
-    bool contains(const QString &key) const { return m_cache.count(key) > 0; }
+    bool contains(const QString &binId, int pos) const
+    {
+        const Key key{binId, pos};
+        const Shard &shard = shardFor(key);
+        QReadLocker lk(&shard.lock);
+        return shard.entries.count(key) > 0;
+    }
 
-    void remove(const QString &key)
+    QImage get(const QString &binId, int pos) const
     {
-        if (!contains(key)) {
-            return;
+        const Key key{binId, pos};
+        const Shard &shard = shardFor(key);
+        QReadLocker lk(&shard.lock);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end()) {
+            return QImage();
         }
-        auto it = m_cache.at(key);
-        m_currentCost -= (*it).second.second;
-        m_data.erase(it);
-        m_cache.erase(key);
+        // Readers only refresh the access stamp, so they never need the write lock
+        it->second.lastAccess = ++m_clock;
+        return it->second.image;
     }
 
-    void insert(const QString &key, const QImage &img, int cost)
+    // Returns the cached position closest to pos, or -1 if there is none at most maxDistance away
+    int nearest(const QString &binId, int pos, int maxDistance) const
     {
-        if (cost > m_maxCost) {
+        QMutexLocker lk(&m_indexMutex);
+        auto positions = m_positions.find(binId);
+        if (positions == m_positions.end()) {
+            return -1;
+        }
+        const std::set<int> &stored = positions->second;
+        int best = -1;
+        auto after = stored.lower_bound(pos);
+        if (after != stored.end() && *after - pos <= maxDistance) {
+            best = *after;
+        }
+        if (after != stored.begin()) {
+            const int before = *std::prev(after);
+            if (before >= 0 && pos - before <= maxDistance && (best < 0 || pos - before < best - pos)) {
+                best = before;
+            }
+        }
+        return best;
+    }
+
+    void insert(const QString &binId, int pos, const QImage &img)
+    {
+        const Key key{binId, pos};
+        Shard &shard = shardFor(key);
+        const qint64 cost = img.sizeInBytes();
+        const qint64 shardBudget = m_budget / shardCount;
+        QWriteLocker lk(&shard.lock);
+        auto existing = shard.entries.find(key);
+        if (existing != shard.entries.end()) {
+            shard.cost -= existing->second.cost;
+            shard.entries.erase(existing);
+        }
+        if (cost > shardBudget) {
+            unindex(key);
             return;
         }
-        m_data.push_front({key, {img, cost}});
-        auto it = m_data.begin();
-        m_cache[key] = it;
-        m_currentCost += cost;
-        while (m_currentCost > m_maxCost) {
-            remove(m_data.back().first);
+        Entry &entry = shard.entries[key];
+        entry.image = img;
+        entry.cost = cost;
+        entry.lastAccess = ++m_clock;
+        shard.cost += cost;
+        {
+            QMutexLocker indexLock(&m_indexMutex);
+            m_positions[binId].insert(pos);
+        }
+        if (shard.cost > shardBudget) {
+            evict(shard, shardBudget);
         }
     }
 
-    QImage get(const QString &key)
+    void removeClip(const QString &binId)
     {
-        if (!contains(key)) {
-            return QImage();
+        {
+            QMutexLocker indexLock(&m_indexMutex);
+            m_positions.erase(binId);
+        }
+        for (Shard &shard : m_shards) {
+            QWriteLocker lk(&shard.lock);
+            for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+                if (it->first.first == binId) {
+                    shard.cost -= it->second.cost;
+                    it = shard.entries.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    void setBudget(qint64 budget)
+    {
+        m_budget = budget;
+        const qint64 shardBudget = budget / shardCount;
+        for (Shard &shard : m_shards) {
+            QWriteLocker lk(&shard.lock);
+            if (shard.cost > shardBudget) {
+                evict(shard, shardBudget);
+            }
         }
-        // when a get operation occurs, we put the corresponding list item in front to remember last access
-        std::pair<QString, std::pair<QImage, int>> data;
-        auto it = m_cache.at(key);
-        std::swap(data, (*it));                                         // take data out without copy
-        QImage result = data.second.first;                              // a copy occurs here
-        m_data.erase(it);                                               // delete old iterator
-        m_cache[key] = m_data.emplace(m_data.begin(), std::move(data)); // reinsert without copy and store iterator
-        return result;
     }
+
     void clear()
     {
-        m_data.clear();
-        m_cache.clear();
-        m_currentCost = 0;
+        {
+            QMutexLocker indexLock(&m_indexMutex);
+            m_positions.clear();
+        }
+        for (Shard &shard : m_shards) {
+            QWriteLocker lk(&shard.lock);
+            shard.entries.clear();
+            shard.cost = 0;
+        }
     }
 
 protected:
-    int m_maxCost;
-    int m_currentCost{0};
+    using Key = std::pair<QString, int>;
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const { return qHash(key.first) ^ (uint(key.second) * 0x9E3779B1u); }
+    };
+    struct Entry
+    {
+        QImage image;
+        qint64 cost = 0;
+        mutable std::atomic<quint64> lastAccess{0};
+    };
+    struct Shard
+    {
+        mutable QReadWriteLock lock;
+        std::unordered_map<Key, Entry, KeyHash> entries;
+        qint64 cost = 0;
+    };
+    static const int shardCount = 8;
+
+    Shard &shardFor(const Key &key) { return m_shards[KeyHash()(key) % shardCount]; }
+    const Shard &shardFor(const Key &key) const { return m_shards[KeyHash()(key) % shardCount]; }
+
+    void unindex(const Key &key)
+    {
+        QMutexLocker indexLock(&m_indexMutex);
+        auto positions = m_positions.find(key.first);
+        if (positions != m_positions.end()) {
+            positions->second.erase(key.second);
+            if (positions->second.empty()) {
+                m_positions.erase(positions);
+            }
+        }
+    }
+
+    // Drop the least recently used entries until the shard uses 3/4 of its budget, so that we don't evict on every insertion
+    void evict(Shard &shard, qint64 shardBudget)
+    {
+        std::vector<std::pair<quint64, Key>> byAge;
+        byAge.reserve(shard.entries.size());
+        for (const auto &entry : shard.entries) {
+            byAge.emplace_back(entry.second.lastAccess.load(), entry.first);
+        }
+        std::sort(byAge.begin(), byAge.end(), [](const std::pair<quint64, Key> &a, const std::pair<quint64, Key> &b) { return a.first < b.first; });
+        const qint64 target = shardBudget * 3 / 4;
+        for (const auto &old : byAge) {
+            if (shard.cost <= target) {
+                break;
+            }
+            auto it = shard.entries.find(old.second);
+            shard.cost -= it->second.cost;
+            shard.entries.erase(it);
+            unindex(old.second);
+        }
+    }
 
-    std::list<std::pair<QString, std::pair<QImage, int>>> m_data; // the data is stored as (key,(image, cost))
-    std::unordered_map<QString, decltype(m_data.begin())> m_cache;
+    Shard m_shards[shardCount];
+    // Cached positions of each clip, to find the closest thumbnail. Locked after the shard locks
+    mutable QMutex m_indexMutex;
+    std::unordered_map<QString, std::set<int>> m_positions;
+    std::atomic<qint64> m_budget;
+    mutable std::atomic<quint64> m_clock{0};
 };
 
 ThumbnailCache::ThumbnailCache()
-    : m_volatileCache(new Cache_t(10000000))
+    : m_volatileCache(new Cache_t(32 * 1024 * 1024))
+{
+}
+
+ThumbnailCache::~ThumbnailCache()
 {
+    QMutexLocker lk(&m_diskMutex);
+    QFuture<void> pendingWrite = m_writeFuture;
+    lk.unlock();
+    pendingWrite.waitForFinished();
 }
 
 std::unique_ptr<ThumbnailCache> &ThumbnailCache::get()
@@ -108,33 +252,43 @@ std::unique_ptr<ThumbnailCache> &ThumbnailCache::get()
 
 bool ThumbnailCache::hasThumbnail(const QString &binId, int pos, bool volatileOnly) const
 {
-    QMutexLocker locker(&m_mutex);
-    bool ok = false;
-    auto key = pos < 0 ? getAudioKey(binId, &ok).first() : getKey(binId, pos, &ok);
-    if (ok && m_volatileCache->contains(key)) {
+    if (m_volatileCache->contains(binId, pos)) {
         return true;
     }
-    if (!ok || volatileOnly) {
+    if (volatileOnly) {
         return false;
     }
+    bool ok = false;
+    auto key = pos < 0 ? getAudioKey(binId, &ok).first() : getKey(binId, pos, &ok);
+    if (!ok) {
+        return false;
+    }
+    if (pos >= 0) {
+        QMutexLocker lk(&m_diskMutex);
+        if (m_pendingWrites.count({binId, pos}) > 0) {
+            return true;
+        }
+    }
     QDir thumbFolder = getDir(pos < 0, &ok);
     return ok && thumbFolder.exists(key);
 }
 
 QImage ThumbnailCache::getAudioThumbnail(const QString &binId, bool volatileOnly) const
 {
-    QMutexLocker locker(&m_mutex);
+    QImage img = m_volatileCache->get(binId, -1);
+    if (!img.isNull() || volatileOnly) {
+        return img;
+    }
     bool ok = false;
     auto key = getAudioKey(binId, &ok).first();
-    if (ok && m_volatileCache->contains(key)) {
-        return m_volatileCache->get(key);
-    }
-    if (!ok || volatileOnly) {
+    if (!ok) {
         return QImage();
     }
     QDir thumbFolder = getDir(true, &ok);
     if (ok && thumbFolder.exists(key)) {
+        QMutexLocker lk(&m_diskMutex);
         m_storedOnDisk[binId].push_back(-1);
+        lk.unlock();
         return QImage(thumbFolder.absoluteFilePath(key));
     }
     return QImage();
@@ -142,7 +296,6 @@ QImage ThumbnailCache::getAudioThumbnail(const QString &binId, bool volatileOnly
 
 const QList <QUrl> ThumbnailCache::getAudioThumbPath(const QString &binId) const
 {
-    QMutexLocker locker(&m_mutex);
     bool ok = false;
     auto key = getAudioKey(binId, &ok);
     QDir thumbFolder = getDir(true, &ok);
@@ -157,20 +310,37 @@ const QList <QUrl> ThumbnailCache::getAudioThumbPath(const QString &binId) const
     return pathList;
 }
 
+QImage ThumbnailCache::getNearestThumbnail(const QString &binId, int pos, int maxDistance, int *foundPos) const
+{
+    const int nearest = m_volatileCache->nearest(binId, pos, maxDistance);
+    if (foundPos) {
+        *foundPos = nearest;
+    }
+    return nearest < 0 ? QImage() : m_volatileCache->get(binId, nearest);
+}
+
 QImage ThumbnailCache::getThumbnail(const QString &binId, int pos, bool volatileOnly) const
 {
-    QMutexLocker locker(&m_mutex);
+    QImage img = m_volatileCache->get(binId, pos);
+    if (!img.isNull() || volatileOnly) {
+        return img;
+    }
+    QMutexLocker lk(&m_diskMutex);
+    auto pending = m_pendingWrites.find({binId, pos});
+    if (pending != m_pendingWrites.end()) {
+        return pending->second.second;
+    }
+    lk.unlock();
     bool ok = false;
     auto key = getKey(binId, pos, &ok);
-    if (ok && m_volatileCache->contains(key)) {
-        return m_volatileCache->get(key);
-    }
-    if (!ok || volatileOnly) {
+    if (!ok) {
         return QImage();
     }
     QDir thumbFolder = getDir(false, &ok);
     if (ok && thumbFolder.exists(key)) {
+        lk.relock();
         m_storedOnDisk[binId].push_back(pos);
+        lk.unlock();
         return QImage(thumbFolder.absoluteFilePath(key));
     }
     return QImage();
@@ -178,68 +348,115 @@ QImage ThumbnailCache::getThumbnail(const QString &binId, int pos, bool volatile
 
 void ThumbnailCache::storeThumbnail(const QString &binId, int pos, const QImage &img, bool persistent)
 {
-    QMutexLocker locker(&m_mutex);
-    bool ok = false;
-    const QString key = getKey(binId, pos, &ok);
-    if (!ok) {
+    if (binId.isEmpty()) {
         return;
     }
     if (persistent) {
+        bool ok = false;
+        const QString key = getKey(binId, pos, &ok);
+        if (!ok) {
+            return;
+        }
         QDir thumbFolder = getDir(false, &ok);
-        if (ok) {
-            if (!img.save(thumbFolder.absoluteFilePath(key))) {
-                qDebug() << ".............\n!!!!!!!! ERROR SAVING THUMB in: "<<thumbFolder.absoluteFilePath(key);
-            }
-            m_storedOnDisk[binId].push_back(pos);
-            // if volatile cache also contains this entry, update it
-            if (m_volatileCache->contains(key)) {
-                m_volatileCache->remove(key);
-            } else {
-                m_storedVolatile[binId].push_back(pos);
+        if (!ok) {
+            return;
+        }
+        QMutexLocker lk(&m_diskMutex);
+        m_pendingWrites[{binId, pos}] = {thumbFolder.absoluteFilePath(key), img};
+        if (!m_writeScheduled) {
+            m_writeScheduled = true;
+            m_writeFuture = QtConcurrent::run(this, &ThumbnailCache::writePending);
+        }
+    }
+    m_volatileCache->insert(binId, pos, img);
+}
+
+void ThumbnailCache::writePending()
+{
+    forever {
+        QMutexLocker writeLock(&m_writeMutex);
+        std::vector<std::pair<std::pair<QString, int>, std::pair<QString, QImage>>> batch;
+        QMutexLocker lk(&m_diskMutex);
+        while (!m_pendingWrites.empty() && (int)batch.size() < writeBatchSize) {
+            batch.emplace_back(*m_pendingWrites.begin());
+            m_pendingWrites.erase(m_pendingWrites.begin());
+        }
+        if (batch.empty()) {
+            m_writeScheduled = false;
+            return;
+        }
+        lk.unlock();
+        std::vector<std::pair<QString, int>> written;
+        for (const auto &item : batch) {
+            if (!item.second.second.save(item.second.first)) {
+                qDebug() << ".............\n!!!!!!!! ERROR SAVING THUMB in: " << item.second.first;
+                continue;
             }
-            m_volatileCache->insert(key, img, (int)img.sizeInBytes());
+            written.push_back(item.first);
+        }
+        lk.relock();
+        for (const auto &item : written) {
+            m_storedOnDisk[item.first].push_back(item.second);
         }
-    } else {
-        m_volatileCache->insert(key, img, (int)img.sizeInBytes());
-        m_storedVolatile[binId].push_back(pos);
     }
 }
 
-void ThumbnailCache::saveCachedThumbs(QStringList keys)
+void ThumbnailCache::flushPendingWrites()
+{
+    writePending();
+    QMutexLocker lk(&m_diskMutex);
+    QFuture<void> pendingWrite = m_writeFuture;
+    lk.unlock();
+    pendingWrite.waitForFinished();
+}
+
+void ThumbnailCache::saveCachedThumbs(const std::vector<std::pair<QString, int>> &thumbs)
 {
     bool ok;
     QDir thumbFolder = getDir(false, &ok);
     if (!ok) {
         return;
     }
-    for (const QString &key : keys) {
-        if (!thumbFolder.exists(key) && m_volatileCache->contains(key)) {
-            QImage img = m_volatileCache->get(key);
-            if (!img.save(thumbFolder.absoluteFilePath(key))) {
-                qDebug() << "// Error writing thumbnails to " << thumbFolder.absolutePath();
-                break;
-            }
+    flushPendingWrites();
+    for (const auto &thumb : thumbs) {
+        const QString key = getKey(thumb.first, thumb.second, &ok);
+        if (!ok || thumbFolder.exists(key)) {
+            continue;
         }
+        QImage img = m_volatileCache->get(thumb.first, thumb.second);
+        if (img.isNull()) {
+            continue;
+        }
+        if (!img.save(thumbFolder.absoluteFilePath(key))) {
+            qDebug() << "// Error writing thumbnails to " << thumbFolder.absolutePath();
+            break;
+        }
+        QMutexLocker lk(&m_diskMutex);
+        m_storedOnDisk[thumb.first].push_back(thumb.second);
     }
 }
 
+void ThumbnailCache::setMemoryBudget(qint64 bytes)
+{
+    m_volatileCache->setBudget(bytes);
+}
+
 void ThumbnailCache::invalidateThumbsForClip(const QString &binId)
 {
-    QMutexLocker locker(&m_mutex);
-    if (m_storedVolatile.find(binId) != m_storedVolatile.end()) {
-        bool ok = false;
-        for (int pos : m_storedVolatile.at(binId)) {
-            auto key = getKey(binId, pos, &ok);
-            if (ok) {
-                m_volatileCache->remove(key);
-            }
+    m_volatileCache->removeClip(binId);
+    // Wait for the batch being written, it may contain thumbnails of this clip
+    QMutexLocker writeLock(&m_writeMutex);
+    QMutexLocker lk(&m_diskMutex);
+    for (auto it = m_pendingWrites.begin(); it != m_pendingWrites.end();) {
+        if (it->first.first == binId) {
+            it = m_pendingWrites.erase(it);
+        } else {
+            ++it;
         }
-        m_storedVolatile.erase(binId);
     }
     bool ok = false;
     // Video thumbs
     QDir thumbFolder = getDir(false, &ok);
-    QDir audioThumbFolder = getDir(true, &ok);
     if (ok && m_storedOnDisk.find(binId) != m_storedOnDisk.end()) {
         // Remove persistent cache
         for (int pos : m_storedOnDisk.at(binId)) {
@@ -256,9 +473,10 @@ void ThumbnailCache::invalidateThumbsForClip(const QString &binId)
 
 void ThumbnailCache::clearCache()
 {
-    QMutexLocker locker(&m_mutex);
+    // Thumbnails of the closed project must still reach its cache folder
+    flushPendingWrites();
     m_volatileCache->clear();
-    m_storedVolatile.clear();
+    QMutexLocker lk(&m_diskMutex);
     m_storedOnDisk.clear();
 }
 
@@ -312,5 +530,10 @@ QStringList ThumbnailCache::getAudioKey(const QString &binId, bool *ok)
 // static
 QDir ThumbnailCache::getDir(bool audio, bool *ok)
 {
+    if (pCore->projectManager() == nullptr || pCore->currentDoc() == nullptr) {
+        // No project open, only the memory cache is available
+        *ok = false;
+        return QDir();
+    }
     return pCore->currentDoc()->getCacheDir(audio ? CacheAudio : CacheThumbs, ok);
 }
@@ -23,12 +23,15 @@
 
 #include "definitions.h"
 #include <QDir>
+#include <QFuture>
 #include <QUrl>
 #include <QImage>
 #include <QMutex>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 /** @brief This class class is an interface to the caches that store thumbnails.
@@ -37,6 +40,9 @@
     Note that for the volatile cache uses a custom implementation.
     QCache is not suitable since it operates on pointers and since the object is removed from the cache when accessed.
     KImageCache is not suitable since it lacks a way to remove objects from the cache.
+    The volatile cache is split in shards with their own read/write lock, so that readers only wait for a writer
+    working on the same shard, and it is bounded by a memory budget in bytes.
+    Writes to the persistent cache are queued and done in batches by a background thread.
  * Note that this class is a Singleton
  */
 
@@ -46,6 +52,7 @@ class ThumbnailCache
 public:
     // Returns the instance of the Singleton
     static std::unique_ptr<ThumbnailCache> &get();
+    ~ThumbnailCache();
 
     /* @brief Check whether a given thumbnail is in the cache
        @param binId is the id of the queried clip
@@ -60,21 +67,33 @@ public:
        @param volatileOnly if true, we only check the volatile cache (no disk access)
     */
     QImage getThumbnail(const QString &binId, int pos, bool volatileOnly = false) const;
+
+    /* @brief Get the closest thumbnail of a clip from the volatile cache
+       @param maxDistance is the maximum distance in frames
+       @param foundPos if not null, is set to the position of the returned thumbnail
+    */
+    QImage getNearestThumbnail(const QString &binId, int pos, int maxDistance, int *foundPos = nullptr) const;
     QImage getAudioThumbnail(const QString &binId, bool volatileOnly = false) const;
     const QList <QUrl> getAudioThumbPath(const QString &binId) const;
 
     /* @brief Get a given thumbnail from the cache
        @param binId is the id of the queried clip
        @param pos is the position where we query
-       @param persistent if true, we store the image in the persistent cache, which generates a disk access
+       @param persistent if true, we also queue the image for the persistent cache, it is written to disk asynchronously
     */
     void storeThumbnail(const QString &binId, int pos, const QImage &img, bool persistent = false);
 
     /* @brief Removes all the thumbnails for a given clip */
     void invalidateThumbsForClip(const QString &binId);
 
-    /* @brief Save all cached thumbs to disk */
-    void saveCachedThumbs(QStringList keys);
+    /* @brief Save the given cached thumbs to disk, as (binId, position) pairs */
+    void saveCachedThumbs(const std::vector<std::pair<QString, int>> &thumbs);
+
+    /* @brief Write all the thumbnails queued for the persistent cache now */
+    void flushPendingWrites();
+
+    /* @brief Set the maximum memory used by the volatile cache, in bytes */
+    void setMemoryBudget(qint64 bytes);
 
     /* @brief Reset cache (discarding all thumbs stored in memory) */
     void clearCache();
@@ -90,15 +109,24 @@ protected:
     // Return the dir where the persistent cache lives
     static QDir getDir(bool audio, bool *ok);
 
+    // Write queued thumbnails to disk, by batches
+    void writePending();
+
     static std::unique_ptr<ThumbnailCache> instance;
     static std::once_flag m_onceFlag; // flag to create the repository only once;
 
     class Cache_t;
     std::unique_ptr<Cache_t> m_volatileCache;
-    mutable QMutex m_mutex;
 
-    // the following maps keeps track of the positions that we store for each clip in volatile caches.
-    // Note that we don't track deletions due to items dropped from the cache. So the maps can contain more items that are currently stored.
-    std::unordered_map<QString, std::vector<int>> m_storedVolatile;
+    // This mutex protects the disk bookkeeping below, it is never held while accessing the disk
+    mutable QMutex m_diskMutex;
+    // This mutex is held while a batch of thumbnails is written
+    QMutex m_writeMutex;
+    // Thumbnails waiting to be written, with their file path
+    std::map<std::pair<QString, int>, std::pair<QString, QImage>> m_pendingWrites;
+    bool m_writeScheduled{false};
+    QFuture<void> m_writeFuture;
+
+    // the following map keeps track of the positions that we store for each clip in the persistent cache.
     mutable std::unordered_map<QString, std::vector<int>> m_storedOnDisk;
 };
@@ -0,0 +1,190 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "thumbnailextractor.hpp"
+#include "bin/projectclip.h"
+#include "core.h"
+#include "doc/kthumb.h"
+#include <mlt++/MltProducer.h>
+
+#include <QStringList>
+#include <algorithm>
+
+std::unique_ptr<ThumbnailExtractor> ThumbnailExtractor::instance;
+std::once_flag ThumbnailExtractor::m_onceFlag;
+
+// MLT's avformat producer seeks when the requested frame is 12 frames or more after the next one it expects
+const int ThumbnailExtractor::decoderForwardWindow = 12;
+const int ThumbnailExtractor::poolSize = 6;
+
+std::unique_ptr<ThumbnailExtractor> &ThumbnailExtractor::get()
+{
+    std::call_once(m_onceFlag, [] { instance.reset(new ThumbnailExtractor()); });
+    return instance;
+}
+
+std::vector<ThumbnailExtractor::Step> ThumbnailExtractor::plan(std::vector<int> frames, int gopLength, Mode mode)
+{
+    std::sort(frames.begin(), frames.end());
+    frames.erase(std::unique(frames.begin(), frames.end()), frames.end());
+    std::vector<Step> steps;
+    steps.reserve(frames.size());
+    int last = -1;
+    for (int frame : frames) {
+        if (mode == Mode::Exact && last >= 0 && frame - last < gopLength) {
+            // Same GOP: decoding forward is cheaper than seeking back to the keyframe.
+            // Stop every few frames on the way so that the decoder never has a reason to seek.
+            while (frame - last > decoderForwardWindow) {
+                last += decoderForwardWindow;
+                steps.push_back({last, false});
+            }
+        }
+        steps.push_back({frame, true});
+        last = frame;
+    }
+    return steps;
+}
+
+int ThumbnailExtractor::extract(Mlt::Producer &producer, const std::vector<int> &frames, int gopLength, Mode mode, int scaledWidth, const Callback &callback)
+{
+    int count = 0;
+    for (const Step &step : plan(frames, gopLength, mode)) {
+        producer.seek(step.position);
+        std::unique_ptr<Mlt::Frame> frame(producer.get_frame());
+        if (frame == nullptr || !frame->is_valid()) {
+            continue;
+        }
+        frame->set("deinterlace_method", "onefield");
+        frame->set("top_field_first", -1);
+        frame->set("rescale.interp", "nearest");
+        if (!step.output) {
+            // Decode only, the image is not needed
+            mlt_image_format format = mlt_image_yuv422;
+            int width = 0;
+            int height = 0;
+            frame->get_image(format, width, height);
+            continue;
+        }
+        QImage result = KThumb::getFrame(frame.get(), 0, 0, scaledWidth);
+        if (result.isNull()) {
+            continue;
+        }
+        count++;
+        if (!callback(step.position, result)) {
+            break;
+        }
+    }
+    return count;
+}
+
+std::shared_ptr<ThumbnailExtractor::PooledProducer> ThumbnailExtractor::acquire(const std::shared_ptr<ProjectClip> &clip, Mode mode)
+{
+    const QString binId = clip->clipId();
+    auto find = [&]() -> std::shared_ptr<PooledProducer> {
+        for (const auto &pooled : m_pool) {
+            if (pooled->binId == binId && pooled->mode == mode) {
+                pooled->lastUse = ++m_useCounter;
+                return pooled;
+            }
+        }
+        return nullptr;
+    };
+    {
+        QMutexLocker lock(&m_poolMutex);
+        if (auto pooled = find()) {
+            return pooled;
+        }
+    }
+    // Opening the file can take a while, don't block the other clips meanwhile
+    std::shared_ptr<Mlt::Producer> producer = clip->createThumbProducer();
+    if (producer == nullptr || !producer->is_valid()) {
+        return nullptr;
+    }
+    if (mode == Mode::KeyframesOnly) {
+        // Passed to the decoder by the avformat producer, the other producers ignore it
+        producer->set("skip_frame", "nokey");
+    }
+    const int gop = gopLength(clip);
+    QMutexLocker lock(&m_poolMutex);
+    if (auto pooled = find()) {
+        // Another thread was faster
+        return pooled;
+    }
+    if ((int)m_pool.size() >= poolSize) {
+        // Evict the least recently used producer that is not in use
+        auto oldest = m_pool.end();
+        for (auto it = m_pool.begin(); it != m_pool.end(); ++it) {
+            if (it->use_count() == 1 && (oldest == m_pool.end() || (*it)->lastUse < (*oldest)->lastUse)) {
+                oldest = it;
+            }
+        }
+        if (oldest != m_pool.end()) {
+            m_pool.erase(oldest);
+        }
+    }
+    auto pooled = std::make_shared<PooledProducer>();
+    pooled->binId = binId;
+    pooled->mode = mode;
+    pooled->gopLength = gop;
+    pooled->producer = std::move(producer);
+    pooled->lastUse = ++m_useCounter;
+    m_pool.push_back(pooled);
+    return pooled;
+}
+
+int ThumbnailExtractor::extract(const std::shared_ptr<ProjectClip> &clip, const std::vector<int> &frames, Mode mode, int scaledWidth, const Callback &callback)
+{
+    std::shared_ptr<PooledProducer> pooled = acquire(clip, mode);
+    if (pooled == nullptr) {
+        return -1;
+    }
+    QMutexLocker lock(&pooled->mutex);
+    return extract(*pooled->producer.get(), frames, pooled->gopLength, mode, scaledWidth, callback);
+}
+
+void ThumbnailExtractor::releaseClip(const QString &binId)
+{
+    QMutexLocker lock(&m_poolMutex);
+    m_pool.erase(std::remove_if(m_pool.begin(), m_pool.end(), [&binId](const std::shared_ptr<PooledProducer> &pooled) { return pooled->binId == binId; }),
+                 m_pool.end());
+}
+
+void ThumbnailExtractor::clear()
+{
+    QMutexLocker lock(&m_poolMutex);
+    m_pool.clear();
+}
+
+int ThumbnailExtractor::gopLength(const std::shared_ptr<ProjectClip> &clip)
+{
+    if (clip->clipType() != ClipType::Video && clip->clipType() != ClipType::AV) {
+        return 1;
+    }
+    static const QStringList intraCodecs{QStringLiteral("prores"),  QStringLiteral("dnxhd"),    QStringLiteral("mjpeg"),   QStringLiteral("huffyuv"),
+                                         QStringLiteral("ffvhuff"), QStringLiteral("ffv1"),     QStringLiteral("rawvideo"), QStringLiteral("png"),
+                                         QStringLiteral("tiff"),    QStringLiteral("cfhd"),     QStringLiteral("dvvideo"), QStringLiteral("utvideo"),
+                                         QStringLiteral("qtrle"),   QStringLiteral("jpeg2000"), QStringLiteral("v210"),    QStringLiteral("magicyuv")};
+    if (intraCodecs.contains(clip->codec(false))) {
+        return 1;
+    }
+    // Camera files usually have a keyframe every half second to a second
+    return qMax(decoderForwardWindow, qRound(pCore->getCurrentFps()));
+}
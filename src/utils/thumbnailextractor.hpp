@@ -0,0 +1,118 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by the Kdenlive developers                         *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QImage>
+#include <QMutex>
+#include <QString>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class ProjectClip;
+namespace Mlt {
+class Producer;
+}
+
+/** @brief This class extracts thumbnails from clips.
+    Seeking a long GOP file decodes everything from the previous keyframe, so extracting frames one seek at a time
+    costs about one GOP decode per thumbnail. The requests are instead sorted and the frames that are close enough
+    are reached by decoding forward. A keyframe only mode decodes a single picture per request, for views where a
+    GOP of imprecision does not matter.
+    Each clip gets its own producers from a small pool, so that several clips can be processed in parallel
+    while the requests on the same clip are serialized.
+ * Note that this class is a Singleton
+ */
+class ThumbnailExtractor
+{
+public:
+    // Returns the instance of the Singleton
+    static std::unique_ptr<ThumbnailExtractor> &get();
+
+    enum class Mode {
+        Exact,        ///< The requested frames
+        KeyframesOnly ///< A keyframe at most one GOP away from the requested frames
+    };
+
+    /** @brief Called with each extracted thumbnail, return false to stop the extraction */
+    using Callback = std::function<bool(int frame, const QImage &image)>;
+
+    /** @brief One frame to decode */
+    struct Step
+    {
+        int position;
+        bool output; ///< false if the frame is only decoded to move the decoder forward
+    };
+
+    /* @brief Decoding order for the given frames.
+       @param frames the requested frames, in any order and with duplicates
+       @param gopLength the number of frames after which seeking is cheaper than decoding forward
+    */
+    static std::vector<Step> plan(std::vector<int> frames, int gopLength, Mode mode);
+
+    /* @brief Extract thumbnails from a producer, following plan()
+       @param scaledWidth if not 0, the width of the returned images
+       @return the number of extracted thumbnails
+    */
+    static int extract(Mlt::Producer &producer, const std::vector<int> &frames, int gopLength, Mode mode, int scaledWidth, const Callback &callback);
+
+    /* @brief Extract thumbnails from a bin clip, using a producer from the pool
+       @return the number of extracted thumbnails, -1 if the clip cannot be read
+    */
+    int extract(const std::shared_ptr<ProjectClip> &clip, const std::vector<int> &frames, Mode mode, int scaledWidth, const Callback &callback);
+
+    /* @brief Drop the producers of a clip, to call when its source changed */
+    void releaseClip(const QString &binId);
+    /* @brief Drop all producers */
+    void clear();
+
+    /* @brief Estimation of the GOP length of a clip: intra only codecs can seek anywhere */
+    static int gopLength(const std::shared_ptr<ProjectClip> &clip);
+
+    /** @brief The decoder reads forward rather than seeking when the next frame is at most this far away */
+    static const int decoderForwardWindow;
+    /** @brief Number of producers kept in the pool */
+    static const int poolSize;
+
+private:
+    ThumbnailExtractor() = default;
+
+    struct PooledProducer
+    {
+        QString binId;
+        Mode mode;
+        int gopLength;
+        std::shared_ptr<Mlt::Producer> producer;
+        QMutex mutex;
+        quint64 lastUse;
+    };
+    /* @brief Returns a producer for the clip, creating it if needed */
+    std::shared_ptr<PooledProducer> acquire(const std::shared_ptr<ProjectClip> &clip, Mode mode);
+
+    static std::unique_ptr<ThumbnailExtractor> instance;
+    static std::once_flag m_onceFlag; // flag to create the extractor only once;
+
+    QMutex m_poolMutex;
+    std::vector<std::shared_ptr<PooledProducer>> m_pool;
+    quint64 m_useCounter{0};
+};
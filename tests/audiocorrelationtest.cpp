@@ -0,0 +1,64 @@
+#include "catch.hpp"
+#include "lib/audio/audioCorrelation.h"
+#include "lib/audio/audioCorrelationInfo.h"
+
+#include <random>
+#include <vector>
+
+namespace {
+/** Shift with the best correlation, computed over every possible position */
+int exhaustiveShift(const std::vector<qint64> &envMain, const std::vector<qint64> &envSub)
+{
+    AudioCorrelationInfo info(envMain.size(), envSub.size());
+    AudioCorrelation::correlate(&envMain[0], envMain.size(), &envSub[0], envSub.size(), info.correlationVector());
+    return (int)info.maxIndex() - (int)envSub.size();
+}
+} // namespace
+
+TEST_CASE("Audio correlation", "[AudioCorrelation]")
+{
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> level(0, 1000);
+    std::uniform_int_distribution<int> noise(-20, 20);
+    std::vector<qint64> envMain(4000);
+    for (qint64 &value : envMain) {
+        value = level(gen);
+    }
+    FFTCorrelation fineFFT;
+    FFTCorrelation coarseFFT;
+
+    SECTION("Coarse to fine search finds the exhaustive shift")
+    {
+        // Sub clip starting inside the main one, at a position that is not a multiple of the downsampling factor
+        const int expected = 1234;
+        std::vector<qint64> envSub(1500);
+        for (size_t i = 0; i < envSub.size(); ++i) {
+            envSub[i] = qMax(0, int(envMain[i + size_t(expected)]) + noise(gen));
+        }
+        REQUIRE(AudioCorrelation::coarseFactor(envSub.size()) > 1);
+        REQUIRE(exhaustiveShift(envMain, envSub) == expected);
+        REQUIRE(AudioCorrelation::findShift(envMain, envSub, fineFFT, coarseFFT) == expected);
+
+        // The correlators keep the main envelope, a second child gives the same result
+        REQUIRE(AudioCorrelation::findShift(envMain, envSub, fineFFT, coarseFFT) == expected);
+    }
+
+    SECTION("Sub clip starting before the main one")
+    {
+        const int expected = -300;
+        std::vector<qint64> envSub(1500);
+        for (size_t i = 0; i < envSub.size(); ++i) {
+            envSub[i] = i < 300 ? level(gen) : envMain[i - 300];
+        }
+        REQUIRE(exhaustiveShift(envMain, envSub) == expected);
+        REQUIRE(AudioCorrelation::findShift(envMain, envSub, fineFFT, coarseFFT) == expected);
+    }
+
+    SECTION("Short envelopes skip the coarse pass")
+    {
+        std::vector<qint64> envSub(envMain.begin() + 2500, envMain.begin() + 2800);
+        REQUIRE(AudioCorrelation::coarseFactor(envSub.size()) == 1);
+        REQUIRE(exhaustiveShift(envMain, envSub) == 2500);
+        REQUIRE(AudioCorrelation::findShift(envMain, envSub, fineFFT, coarseFFT) == 2500);
+    }
+}
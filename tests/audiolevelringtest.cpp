@@ -0,0 +1,61 @@
+#include "catch.hpp"
+#include "audiomixer/audiolevelring.hpp"
+
+#include <thread>
+
+TEST_CASE("Audio level ring buffer", "[AudioLevels]")
+{
+    AudioLevelRing ring(5);
+    REQUIRE(ring.capacity() == 8);
+    AudioLevelRing::Record record{};
+
+    SECTION("Records are read in order and dropped when full")
+    {
+        REQUIRE_FALSE(ring.pop(record));
+        for (int i = 0; i < ring.capacity(); ++i) {
+            record.position = i;
+            REQUIRE(ring.push(record));
+        }
+        record.position = 100;
+        REQUIRE_FALSE(ring.push(record));
+        for (int i = 0; i < ring.capacity(); ++i) {
+            REQUIRE(ring.pop(record));
+            REQUIRE(record.position == i);
+        }
+        REQUIRE_FALSE(ring.pop(record));
+
+        REQUIRE(ring.push(record));
+        ring.discard();
+        REQUIRE_FALSE(ring.pop(record));
+    }
+
+    SECTION("Concurrent producer and consumer")
+    {
+        const int count = 100000;
+        std::thread producer([&ring]() {
+            AudioLevelRing::Record rec{};
+            rec.channels = 2;
+            for (int i = 0; i < count; ++i) {
+                rec.position = i;
+                rec.levels[0] = float(i);
+                rec.levels[1] = float(-i);
+                while (!ring.push(rec)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        int expected = 0;
+        bool consistent = true;
+        while (expected < count) {
+            if (ring.pop(record)) {
+                consistent = consistent && record.position == expected && record.levels[0] == float(expected) && record.levels[1] == float(-expected);
+                ++expected;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        producer.join();
+        REQUIRE(consistent);
+        REQUIRE_FALSE(ring.pop(record));
+    }
+}
@@ -0,0 +1,133 @@
+#include "catch.hpp"
+#include "lib/audio/audioLevelsBuilder.h"
+#include "lib/audio/audioLevelsStore.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <random>
+#include <vector>
+
+TEST_CASE("Audio levels store", "[AudioLevels]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("levels.kdal"));
+
+    // 5 frames, 2 channels, interleaved
+    std::vector<uint8_t> peaks{10, 200, 20, 100, 30, 0, 40, 50, 255, 60};
+    std::vector<uint8_t> rms{5, 100, 10, 50, 15, 0, 20, 25, 128, 30};
+
+    SECTION("Invalid input is rejected")
+    {
+        REQUIRE_FALSE(AudioLevelsStore::write(path, 0, peaks, rms));
+        REQUIRE_FALSE(AudioLevelsStore::write(path, 2, peaks, std::vector<uint8_t>(3)));
+        REQUIRE(AudioLevelsStore::open(path) == nullptr);
+    }
+
+    SECTION("Levels are stored per channel and mipmapped")
+    {
+        REQUIRE(AudioLevelsStore::write(path, 2, peaks, rms));
+        auto store = AudioLevelsStore::open(path);
+        REQUIRE(store != nullptr);
+        REQUIRE(store->channels() == 2);
+        // 5 -> 3 -> 2 -> 1 samples
+        REQUIRE(store->levelCount() == 4);
+        REQUIRE(store->sampleCount(0) == 5);
+        REQUIRE(store->sampleCount(1) == 3);
+        REQUIRE(store->sampleCount(3) == 1);
+        for (int i = 0; i < 5; ++i) {
+            REQUIRE(store->peaks(0, 0)[i] == peaks[2 * i]);
+            REQUIRE(store->peaks(0, 1)[i] == peaks[2 * i + 1]);
+            REQUIRE(store->rms(0, 1)[i] == rms[2 * i + 1]);
+        }
+        REQUIRE(store->peaks(1, 0)[0] == 20);
+        REQUIRE(store->peaks(1, 1)[0] == 200);
+        REQUIRE(store->peaks(1, 0)[2] == 255);
+        REQUIRE(store->peaks(3, 0)[0] == 255);
+        REQUIRE(store->peaks(3, 1)[0] == 200);
+        // RMS of 5 and 10
+        REQUIRE(store->rms(1, 0)[0] == 8);
+
+        REQUIRE(store->levelForFramesPerPixel(0.5) == 0);
+        REQUIRE(store->levelForFramesPerPixel(1) == 0);
+        REQUIRE(store->levelForFramesPerPixel(2.5) == 1);
+        REQUIRE(store->levelForFramesPerPixel(1000) == 3);
+    }
+
+    SECTION("Corrupted files are rejected")
+    {
+        REQUIRE(AudioLevelsStore::write(path, 2, peaks, rms));
+        QFile file(path);
+        REQUIRE(file.open(QIODevice::ReadWrite));
+        file.resize(file.size() - 4);
+        file.close();
+        REQUIRE(AudioLevelsStore::open(path) == nullptr);
+    }
+}
+
+TEST_CASE("Audio levels builder", "[AudioLevels]")
+{
+    SECTION("Reducer matches a plain computation for any channel count")
+    {
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<int> dist(-32768, 32767);
+        for (int channels : {1, 2, 3, 6, 8}) {
+            std::vector<int16_t> samples(size_t(333 * channels));
+            for (auto &s : samples) {
+                s = (int16_t)dist(gen);
+            }
+            samples[0] = -32768;
+            std::vector<int32_t> peaks((size_t)channels, 0);
+            std::vector<double> squares((size_t)channels, 0.);
+            AudioLevelsBuilder::reduce(samples.data(), 333, channels, peaks.data(), squares.data());
+            for (int c = 0; c < channels; ++c) {
+                int32_t peak = 0;
+                double sum = 0;
+                for (int i = 0; i < 333; ++i) {
+                    int32_t v = qMin(32767, std::abs((int32_t)samples[size_t(i * channels + c)]));
+                    peak = qMax(peak, v);
+                    sum += double(v) * v;
+                }
+                REQUIRE(peaks[(size_t)c] == peak);
+                REQUIRE(squares[(size_t)c] == Approx(sum).epsilon(1e-5));
+            }
+        }
+    }
+
+    SECTION("Streamed blocks are cut in frames without drifting")
+    {
+        // 60.5 samples per frame, fed in blocks that do not match frame boundaries
+        AudioLevelsBuilder builder(2, 60.5);
+        std::vector<int16_t> block(2 * 1000, 1000);
+        for (int i = 0; i < 121; ++i) {
+            builder.addSamples(block.data(), 1000);
+        }
+        builder.finish();
+        REQUIRE(builder.frameCount() == 2000);
+    }
+
+    SECTION("Levels are written normalized")
+    {
+        AudioLevelsBuilder builder(1);
+        std::vector<int16_t> loud(100, -20000);
+        std::vector<int16_t> quiet(100, 5000);
+        builder.repeatFrame();
+        builder.addFrame(loud.data(), 100);
+        builder.addFrame(quiet.data(), 100);
+        builder.repeatFrame();
+        REQUIRE(builder.frameCount() == 4);
+
+        QTemporaryDir dir;
+        const QString path = dir.filePath(QStringLiteral("levels.kdal"));
+        REQUIRE(builder.write(path));
+        auto store = AudioLevelsStore::open(path);
+        REQUIRE(store != nullptr);
+        REQUIRE(store->sampleCount(0) == 4);
+        REQUIRE(store->peaks(0, 0)[0] == 0);
+        REQUIRE(store->peaks(0, 0)[1] == 255);
+        REQUIRE(store->peaks(0, 0)[2] == 63);
+        REQUIRE(store->peaks(0, 0)[3] == 63);
+        // Constant signal, RMS equals peak
+        REQUIRE(store->rms(0, 0)[1] == 255);
+    }
+}
@@ -0,0 +1,330 @@
+#include "test_utils.hpp"
+#include "macros.hpp"
+#include "scopes/colorscopes/histogramgenerator.h"
+#include "scopes/colorscopes/rgbparadegenerator.h"
+#include "scopes/colorscopes/scopeframe.h"
+#include "scopes/colorscopes/scopekernel.h"
+#include "scopes/colorscopes/vectorscopegenerator.h"
+#include "scopes/colorscopes/waveformgenerator.h"
+#include "timeline2/model/snapmodel.hpp"
+#include "utils/thumbnailextractor.hpp"
+#include "doc/kthumb.h"
+#include "effects/effectsrepository.hpp"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <climits>
+
+using namespace fakeit;
+Mlt::Profile profile_benchmarks;
+
+/* Benchmarks are hidden by default, run them with:
+   runTests "[.benchmark]" -d yes
+*/
+
+TEST_CASE("Track range queries scaling", "[.benchmark][TrackModel]")
+{
+    Logger::clear();
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> guideModel = std::make_shared<MarkerListModel>(undoStack);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    TimelineItemModel tim(&profile_benchmarks, undoStack);
+    Mock<TimelineItemModel> timMock(tim);
+    auto timeline = std::shared_ptr<TimelineItemModel>(&timMock.get(), [](...) {});
+    TimelineItemModel::finishConstruct(timeline, guideModel);
+
+    Fake(Method(timMock, adjustAssetRange));
+    Fake(Method(timMock, _beginInsertRows));
+    Fake(Method(timMock, _beginRemoveRows));
+    Fake(Method(timMock, _endInsertRows));
+    Fake(Method(timMock, _endRemoveRows));
+
+    QString binId = createProducer(profile_benchmarks, "red", binModel, 20);
+    int tid1 = TrackModel::construct(timeline);
+    int count = 0;
+    for (int target : {500, 2000, 8000}) {
+        // Append clips with a small gap between them until we reach the requested count
+        for (; count < target; ++count) {
+            int cid = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
+            REQUIRE(timeline->requestClipMove(cid, tid1, count * 25, true, false, false));
+        }
+        int duration = count * 25;
+        BENCHMARK(QStringLiteral("getItemsInRange, %1 clips").arg(count).toStdString())
+        {
+            // Mimic a spacer drag: query everything after a moving position
+            for (int pos = 0; pos < duration; pos += duration / 100) {
+                REQUIRE(timeline->getItemsInRange(tid1, pos, pos + 100).size() <= 5);
+            }
+        }
+    }
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
+
+TEST_CASE("Timeline model index scaling", "[.benchmark][TimelineModel]")
+{
+    Logger::clear();
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> guideModel = std::make_shared<MarkerListModel>(undoStack);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    TimelineItemModel tim(&profile_benchmarks, undoStack);
+    Mock<TimelineItemModel> timMock(tim);
+    auto timeline = std::shared_ptr<TimelineItemModel>(&timMock.get(), [](...) {});
+    TimelineItemModel::finishConstruct(timeline, guideModel);
+
+    Fake(Method(timMock, adjustAssetRange));
+    Fake(Method(timMock, _beginInsertRows));
+    Fake(Method(timMock, _beginRemoveRows));
+    Fake(Method(timMock, _endInsertRows));
+    Fake(Method(timMock, _endRemoveRows));
+
+    QString binId = createProducer(profile_benchmarks, "red", binModel, 20);
+    std::vector<int> tracks;
+    for (int i = 0; i < 4; ++i) {
+        tracks.push_back(TrackModel::construct(timeline));
+    }
+    const int clipCount = 10000;
+    std::vector<int> clips;
+    for (int i = 0; i < clipCount; ++i) {
+        int cid = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
+        REQUIRE(timeline->requestClipMove(cid, tracks[i % 4], (i / 4) * 25, true, false, false));
+        clips.push_back(cid);
+    }
+    BENCHMARK(QStringLiteral("model reset, %1 clips").arg(clipCount).toStdString())
+    {
+        // What a view does after a reset: walk all rows, then resolve the parent of each item
+        int items = 0;
+        for (int row = 0; row < timeline->rowCount(); ++row) {
+            QModelIndex trackIndex = timeline->index(row, 0);
+            for (int i = 0; i < timeline->rowCount(trackIndex); ++i) {
+                QModelIndex ix = timeline->index(i, 0, trackIndex);
+                REQUIRE(timeline->parent(ix) == trackIndex);
+                items++;
+            }
+        }
+        REQUIRE(items == clipCount);
+    }
+    BENCHMARK(QStringLiteral("index from id, %1 clips").arg(clipCount).toStdString())
+    {
+        // What dataChanged notifications do
+        for (int cid : clips) {
+            REQUIRE(timeline->makeClipIndexFromID(cid).isValid());
+        }
+    }
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
+
+TEST_CASE("Undo composition scaling", "[.benchmark][Undo]")
+{
+    for (int count : {500, 5000, 50000}) {
+        // Mimic a group operation: one reverse/operation pair per moved item
+        Fun undo = []() { return true; };
+        Fun redo = []() { return true; };
+        int executed = 0;
+        BENCHMARK(QStringLiteral("compose %1 operations").arg(count).toStdString())
+        {
+            for (int i = 0; i < count; ++i) {
+                Fun operation = [&executed]() {
+                    ++executed;
+                    return true;
+                };
+                Fun reverse = operation;
+                UPDATE_UNDO_REDO_NOLOCK(operation, reverse, undo, redo);
+            }
+        }
+        BENCHMARK(QStringLiteral("undo + redo %1 operations").arg(count).toStdString())
+        {
+            REQUIRE(undo());
+            REQUIRE(redo());
+        }
+        WARN(QStringLiteral("%1 operations: %2 bytes per recorded step")
+                 .arg(count)
+                 .arg(double(FunSequence::memoryUsage(undo) + FunSequence::memoryUsage(redo)) / double(FunSequence::stepCount(undo) + FunSequence::stepCount(redo)))
+                 .toStdString());
+    }
+}
+
+TEST_CASE("Color scope generators", "[.benchmark][Scopes]")
+{
+    WaveformGenerator waveform;
+    RGBParadeGenerator parade;
+    VectorscopeGenerator vectorscope;
+    HistogramGenerator histogram;
+    const QSize scopeSize(720, 400);
+    const int histogramComponents = HistogramGenerator::ComponentY | HistogramGenerator::ComponentR | HistogramGenerator::ComponentG |
+                                    HistogramGenerator::ComponentB;
+
+    for (const QSize &frameSize : {QSize(1920, 1080), QSize(3840, 2160)}) {
+        // A gradient with some noise, so that all the bins get used
+        QImage frame(frameSize, QImage::Format_ARGB32);
+        for (int y = 0; y < frame.height(); ++y) {
+            auto *line = reinterpret_cast<QRgb *>(frame.scanLine(y));
+            for (int x = 0; x < frame.width(); ++x) {
+                line[x] = qRgb((x * 255) / frame.width(), (y * 255) / frame.height(), (x * 31 + y * 17) % 256);
+            }
+        }
+        const ScopeFrame rgbFrame(frame);
+        // The same content as the planes the monitor sends, decimated like the monitor does
+        std::vector<uchar> planes(size_t(frameSize.width() * frameSize.height() * 3 / 2));
+        for (size_t i = 0; i < planes.size(); ++i) {
+            planes[i] = uchar(16 + (i * 31) % 220);
+        }
+        // The single threaded scalar configuration is the baseline the previous generators were running
+        for (bool fast : {false, true}) {
+            ScopeKernel::setMaxThreads(fast ? 0 : 1);
+            ScopeKernel::setSimdEnabled(fast);
+            const QString label = QStringLiteral("%1x%2 %3").arg(frameSize.width()).arg(frameSize.height()).arg(fast ? QStringLiteral("parallel simd") : QStringLiteral("scalar"));
+            BENCHMARK((QStringLiteral("Waveform ") + label).toStdString())
+            {
+                REQUIRE(!waveform.calculateWaveform(scopeSize, rgbFrame, WaveformGenerator::PaintMode_Green, true, ITURec::Rec_709).isNull());
+            }
+            BENCHMARK((QStringLiteral("RGB parade ") + label).toStdString())
+            {
+                REQUIRE(!parade.calculateRGBParade(scopeSize, frame, RGBParadeGenerator::PaintMode_RGB, true, true).isNull());
+            }
+            BENCHMARK((QStringLiteral("Vectorscope ") + label).toStdString())
+            {
+                REQUIRE(!vectorscope.calculateVectorscope(scopeSize, rgbFrame, 1, VectorscopeGenerator::PaintMode_Green2, VectorscopeGenerator::ColorSpace_YUV, false).isNull());
+            }
+            BENCHMARK((QStringLiteral("Histogram ") + label).toStdString())
+            {
+                REQUIRE(!histogram.calculateHistogram(scopeSize, rgbFrame, histogramComponents, ITURec::Rec_709, false, false).isNull());
+            }
+            BENCHMARK((QStringLiteral("YUV planes waveform and vectorscope ") + label).toStdString())
+            {
+                const ScopeFrame yuvFrame = ScopeFrame::fromYuv420(planes.data(), frameSize.width(), frameSize.height(), 709);
+                REQUIRE(!waveform.calculateWaveform(scopeSize, yuvFrame, WaveformGenerator::PaintMode_Green, true, ITURec::Rec_709).isNull());
+                REQUIRE(!vectorscope.calculateVectorscope(scopeSize, yuvFrame, 1, VectorscopeGenerator::PaintMode_Green2, VectorscopeGenerator::ColorSpace_YUV, false).isNull());
+            }
+        }
+    }
+    ScopeKernel::setMaxThreads(0);
+    ScopeKernel::setSimdEnabled(true);
+}
+
+TEST_CASE("Thumbnail extraction", "[.benchmark][ThumbnailCache]")
+{
+    // The difference shows on long GOP camera files, set KDENLIVE_BENCH_VIDEO to use one
+    QString path = QString::fromLocal8Bit(qgetenv("KDENLIVE_BENCH_VIDEO"));
+    if (path.isEmpty()) {
+        path = QFileInfo(QStringLiteral(__FILE__)).absolutePath() + QStringLiteral("/small.mkv");
+    }
+    Mlt::Producer producer(profile_benchmarks, "avformat-novalidate", path.toUtf8().constData());
+    Mlt::Producer keyframesProducer(profile_benchmarks, "avformat-novalidate", path.toUtf8().constData());
+    if (!producer.is_valid() || !keyframesProducer.is_valid()) {
+        WARN("Cannot read " << path.toStdString() << ", skipping");
+        return;
+    }
+    keyframesProducer.set("skip_frame", "nokey");
+    const int length = producer.get_length();
+    // A 100 thumbnails strip, in the order the timeline requests them
+    std::vector<int> frames;
+    for (int i = 0; i < 100; ++i) {
+        frames.push_back(i * length / 100);
+    }
+    const int gopLength = qMax(ThumbnailExtractor::decoderForwardWindow, qRound(profile_benchmarks.fps()));
+    auto accept = [](int, const QImage &) { return true; };
+
+    BENCHMARK("One seek per thumbnail")
+    {
+        int count = 0;
+        for (int frame : frames) {
+            producer.seek(frame);
+            std::unique_ptr<Mlt::Frame> mltFrame(producer.get_frame());
+            if (!KThumb::getFrame(mltFrame.get(), 0, 0, 0).isNull()) {
+                count++;
+            }
+        }
+        REQUIRE(count > 0);
+    }
+    BENCHMARK("Decoding forward inside GOPs")
+    {
+        REQUIRE(ThumbnailExtractor::extract(producer, frames, gopLength, ThumbnailExtractor::Mode::Exact, 0, accept) > 0);
+    }
+    BENCHMARK("Keyframes only")
+    {
+        REQUIRE(ThumbnailExtractor::extract(keyframesProducer, frames, gopLength, ThumbnailExtractor::Mode::KeyframesOnly, 0, accept) > 0);
+    }
+}
+
+TEST_CASE("Group move snapping", "[.benchmark][SnapModel]")
+{
+    // A 200 clips group dragged over a timeline with 5000 snap points
+    SnapModel snaps;
+    for (int i = 0; i < 5000; ++i) {
+        snaps.addPoint(i * 37);
+    }
+    std::vector<int> group;
+    for (int i = 0; i < 200; ++i) {
+        group.push_back(i * 50);
+        group.push_back(i * 50 + 40);
+        snaps.addPoint(i * 50);
+        snaps.addPoint(i * 50 + 40);
+    }
+
+    BENCHMARK("Ignore and one lookup per point")
+    {
+        int best = INT_MAX;
+        for (int diff = 0; diff < 100; ++diff) {
+            snaps.ignore(group);
+            for (int point : group) {
+                best = qMin(best, qAbs(point + diff - snaps.getClosestPoint(point + diff)));
+            }
+            snaps.unIgnore();
+        }
+        REQUIRE(best >= 0);
+    }
+    BENCHMARK("Single sweep with exclusions")
+    {
+        int found = 0;
+        int offset = 0;
+        for (int diff = 0; diff < 100; ++diff) {
+            found += snaps.getBestSnap(group, diff, 10, offset, group) ? 1 : 0;
+        }
+        REQUIRE(found > 0);
+    }
+}
+
+TEST_CASE("Asset catalog startup", "[.benchmark][Effects]")
+{
+    // Keep away from the user's real cache
+    struct TestPaths
+    {
+        TestPaths() { QStandardPaths::setTestModeEnabled(true); }
+        ~TestPaths()
+        {
+            QFile::remove(EffectsRepository::get()->catalogPath());
+            QStandardPaths::setTestModeEnabled(false);
+        }
+    } testPaths;
+    const QString cachePath = EffectsRepository::get()->catalogPath();
+    BENCHMARK("Parse effects catalog")
+    {
+        QFile::remove(cachePath);
+        std::unique_ptr<EffectsRepository> repository(new EffectsRepository());
+        REQUIRE_FALSE(repository->m_fromCache);
+    }
+    BENCHMARK("Load cached effects catalog")
+    {
+        std::unique_ptr<EffectsRepository> repository(new EffectsRepository());
+        REQUIRE(repository->m_fromCache);
+    }
+}
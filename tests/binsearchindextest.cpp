@@ -0,0 +1,112 @@
+#include "catch.hpp"
+#include "bin/binsearchindex.hpp"
+
+#include <random>
+#include <vector>
+
+namespace {
+BinSearchIndex::Fields fields(const QString &text, const QString &tags = QString(), int type = 0, int rating = 0)
+{
+    BinSearchIndex::Fields result;
+    result.text = text;
+    result.tags = tags;
+    result.type = type;
+    result.rating = rating;
+    return result;
+}
+
+BinSearchIndex::Filter search(const QString &text)
+{
+    BinSearchIndex::Filter filter;
+    filter.search = text;
+    return filter;
+}
+} // namespace
+
+TEST_CASE("Bin search index", "[BinSearch]")
+{
+    BinSearchIndex index;
+    index.setItem(1, fields(QStringLiteral("Interview.mp4\nSecond take"), QStringLiteral("#ff0000:Interview"), 2, 3));
+    index.setItem(2, fields(QStringLiteral("Landscape.png\nSunset on the lake"), QString(), 5, 5));
+    index.setItem(3, fields(QStringLiteral("music.wav\nINTRO theme"), QStringLiteral("#00ff00:Audio"), 1, 3));
+    index.setItem(4, fields(QStringLiteral("Folder")));
+    REQUIRE(index.count() == 4);
+
+    SECTION("Substring search is case insensitive")
+    {
+        REQUIRE(index.match(search(QStringLiteral("INTERVIEW"))) == std::unordered_set<int>{1});
+        REQUIRE(index.match(search(QStringLiteral("take"))) == std::unordered_set<int>{1});
+        REQUIRE(index.match(search(QStringLiteral("intro"))) == std::unordered_set<int>{3});
+        REQUIRE(index.match(search(QStringLiteral("ake"))) == std::unordered_set<int>{1, 2});
+        // All trigrams present in item 2 ("the lake", "landscape"), but not contiguous
+        REQUIRE(index.match(search(QStringLiteral("the land"))).empty());
+        REQUIRE(index.match(search(QStringLiteral("missing"))).empty());
+    }
+
+    SECTION("Short and empty searches")
+    {
+        REQUIRE(index.match(search(QStringLiteral("in"))) == std::unordered_set<int>{1, 3});
+        REQUIRE(index.match(search(QStringLiteral("z"))).empty());
+        REQUIRE(index.match(search(QString())).size() == 4);
+        REQUIRE(search(QString()).isEmpty());
+    }
+
+    SECTION("Tags, type and rating")
+    {
+        BinSearchIndex::Filter filter;
+        filter.rating = 3;
+        REQUIRE(index.match(filter) == std::unordered_set<int>{1, 3});
+        filter.type = 1;
+        REQUIRE(index.match(filter) == std::unordered_set<int>{3});
+        filter = BinSearchIndex::Filter();
+        filter.tags << QStringLiteral("#ff0000");
+        REQUIRE(index.match(filter) == std::unordered_set<int>{1});
+        filter.search = QStringLiteral("music");
+        REQUIRE(index.match(filter).empty());
+        REQUIRE_FALSE(filter.isEmpty());
+    }
+
+    SECTION("Updates and removal")
+    {
+        index.setItem(2, fields(QStringLiteral("Renamed.png")));
+        REQUIRE(index.match(search(QStringLiteral("sunset"))).empty());
+        REQUIRE(index.match(search(QStringLiteral("renamed"))) == std::unordered_set<int>{2});
+        index.removeItem(1);
+        REQUIRE_FALSE(index.contains(1));
+        REQUIRE(index.count() == 3);
+        REQUIRE(index.match(search(QStringLiteral("interview"))).empty());
+        index.removeItem(1);
+        index.clear();
+        REQUIRE(index.count() == 0);
+        REQUIRE(index.match(search(QStringLiteral("music"))).empty());
+    }
+
+    SECTION("Same results as a linear scan")
+    {
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<int> letter(0, 3);
+        auto randomText = [&](int length) {
+            QString text;
+            for (int i = 0; i < length; ++i) {
+                text.append(QChar('a' + letter(gen)));
+            }
+            return text;
+        };
+        index.clear();
+        std::vector<QString> texts;
+        for (int id = 0; id < 200; ++id) {
+            texts.push_back(randomText(12));
+            index.setItem(id, fields(texts.back()));
+        }
+        for (int query = 0; query < 100; ++query) {
+            const QString needle = randomText(1 + query % 5);
+            std::unordered_set<int> expected;
+            for (int id = 0; id < int(texts.size()); ++id) {
+                if (texts[size_t(id)].contains(needle, Qt::CaseInsensitive)) {
+                    expected.insert(id);
+                }
+            }
+            REQUIRE(index.match(search(needle)) == expected);
+        }
+    }
+}
@@ -2,7 +2,10 @@
 #include "doc/docundostack.hpp"
 #include "test_utils.hpp"
 
+#include <QFile>
+#include <QStandardPaths>
 #include <QString>
+#include <QTextStream>
 #include <cmath>
 #include <iostream>
 #include <tuple>
@@ -114,3 +117,51 @@ TEST_CASE("Effects stack", "[Effects]")
     }
     Logger::print_trace();
 }
+
+TEST_CASE("Asset catalog cache", "[Effects]")
+{
+    auto toString = [](const QDomElement &xml) {
+        QString result;
+        QTextStream stream(&result);
+        xml.save(stream, 0);
+        return result;
+    };
+    // Keep away from the user's real cache
+    struct TestPaths
+    {
+        TestPaths() { QStandardPaths::setTestModeEnabled(true); }
+        ~TestPaths()
+        {
+            QFile::remove(EffectsRepository::get()->catalogPath());
+            QStandardPaths::setTestModeEnabled(false);
+        }
+    } testPaths;
+    QFile::remove(EffectsRepository::get()->catalogPath());
+
+    // Without cache, the catalog is parsed and the cache written
+    std::unique_ptr<EffectsRepository> parsed(new EffectsRepository());
+    REQUIRE_FALSE(parsed->m_fromCache);
+    REQUIRE(QFile::exists(parsed->catalogPath()));
+
+    std::unique_ptr<EffectsRepository> cached(new EffectsRepository());
+    REQUIRE(cached->m_fromCache);
+    REQUIRE(cached->m_assets.size() == parsed->m_assets.size());
+    REQUIRE(cached->getNames() == parsed->getNames());
+    for (const auto &asset : parsed->m_assets) {
+        REQUIRE(cached->exists(asset.first));
+        const auto &info = cached->m_assets.at(asset.first);
+        REQUIRE(info.id == asset.second.id);
+        REQUIRE(info.mltId == asset.second.mltId);
+        REQUIRE(info.description == asset.second.description);
+        REQUIRE(info.version == asset.second.version);
+        REQUIRE(info.type == asset.second.type);
+        REQUIRE(toString(info.xml) == toString(asset.second.xml));
+    }
+
+    // A different blacklist invalidates the cache
+    QScopedPointer<Mlt::Properties> services(cached->retrieveListFromMlt());
+    const QStringList dirs = cached->assetDirs();
+    const QByteArray key = cached->catalogKey(*services, dirs, QFileInfoList());
+    cached->m_blacklist.insert(QStringLiteral("kdenlive_test_blacklist"));
+    REQUIRE(cached->catalogKey(*services, dirs, QFileInfoList()) != key);
+}
@@ -0,0 +1,102 @@
+#include "catch.hpp"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QTemporaryDir>
+
+#define protected public
+#include "utils/filehasher.hpp"
+
+namespace {
+void writeFile(const QString &path, const QByteArray &data)
+{
+    QFile file(path);
+    REQUIRE(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    REQUIRE(file.write(data) == data.size());
+}
+} // namespace
+
+TEST_CASE("File hashes", "[FileHasher]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString cachePath = dir.filePath(QStringLiteral("hashes.cache"));
+    const QString small = dir.filePath(QStringLiteral("small.bin"));
+    const QString large = dir.filePath(QStringLiteral("large.bin"));
+    QByteArray smallData(1000, 'a');
+    QByteArray largeData(3000000, '\0');
+    for (int i = 0; i < largeData.size(); ++i) {
+        largeData[i] = char(i * 7 % 251);
+    }
+    writeFile(small, smallData);
+    writeFile(large, largeData);
+
+    SECTION("Hashes match the sampled MD5")
+    {
+        FileHasher hasher(cachePath);
+        FileHasher::Result result = hasher.hash(small);
+        REQUIRE(result.size == 1000);
+        REQUIRE(result.hash == QCryptographicHash::hash(smallData, QCryptographicHash::Md5));
+        // Large files are hashed on their first and last MB
+        result = hasher.hash(large);
+        REQUIRE(result.size == 3000000);
+        REQUIRE(result.hash == QCryptographicHash::hash(largeData.left(1000000) + largeData.right(1000000), QCryptographicHash::Md5));
+        REQUIRE(hasher.hash(dir.filePath(QStringLiteral("missing.bin"))).hash.isEmpty());
+    }
+
+    SECTION("Unchanged files are read once, across sessions")
+    {
+        {
+            FileHasher hasher(cachePath);
+            const QByteArray hash = hasher.hash(small).hash;
+            REQUIRE(hasher.hash(small).hash == hash);
+            REQUIRE(hasher.statistics().misses == 1);
+            REQUIRE(hasher.statistics().hits == 1);
+            hasher.save();
+        }
+        FileHasher hasher(cachePath);
+        REQUIRE(hasher.hash(small).hash == QCryptographicHash::hash(smallData, QCryptographicHash::Md5));
+        REQUIRE(hasher.statistics().hits == 1);
+        REQUIRE(hasher.statistics().misses == 0);
+
+        // A changed file is read again
+        smallData.append("changed");
+        writeFile(small, smallData);
+        REQUIRE(hasher.hash(small).hash == QCryptographicHash::hash(smallData, QCryptographicHash::Md5));
+        REQUIRE(hasher.statistics().misses == 1);
+    }
+
+    SECTION("Files are hashed in parallel")
+    {
+        FileHasher hasher(cachePath);
+        hasher.setIoConcurrency(2);
+        REQUIRE(hasher.ioConcurrency() == 2);
+        QStringList paths;
+        for (int i = 0; i < 10; ++i) {
+            const QString path = dir.filePath(QStringLiteral("file%1.bin").arg(i));
+            writeFile(path, QByteArray(100 + i, char('a' + i)));
+            paths << path;
+        }
+        paths << small << large;
+        const std::vector<FileHasher::Result> results = hasher.hashFiles(paths);
+        REQUIRE(results.size() == size_t(paths.size()));
+        for (int i = 0; i < paths.size(); ++i) {
+            REQUIRE(results.at(size_t(i)).hash == FileHasher::computeHash(paths.at(i)).hash);
+        }
+        REQUIRE(hasher.statistics().misses == paths.size());
+        hasher.hashFiles(paths);
+        REQUIRE(hasher.statistics().hits == paths.size());
+    }
+
+    SECTION("Fast hashes")
+    {
+        FileHasher hasher(cachePath);
+        const QByteArray fast = hasher.hash(large, FileHasher::Mode::Fast).hash;
+        REQUIRE(fast.size() == 8);
+        REQUIRE(fast == FileHasher::computeHash(large, FileHasher::Mode::Fast).hash);
+        REQUIRE(fast != hasher.hash(small, FileHasher::Mode::Fast).hash);
+        // Both modes are cached separately
+        REQUIRE(hasher.hash(large).hash.size() == 16);
+        REQUIRE(hasher.statistics().misses == 3);
+    }
+}
@@ -0,0 +1,92 @@
+#include "catch.hpp"
+#include "jobs/jobscheduler.hpp"
+
+#include <QMutex>
+#include <QSemaphore>
+#include <QStringList>
+#include <atomic>
+
+TEST_CASE("Job scheduler", "[JobScheduler]")
+{
+    SECTION("Tasks run by priority class, then in submission order")
+    {
+        JobScheduler scheduler(1);
+        QSemaphore gate;
+        QMutex mutex;
+        QStringList order;
+        auto record = [&](const QString &name) {
+            return [&, name]() {
+                QMutexLocker lk(&mutex);
+                order << name;
+            };
+        };
+        // Occupy the only thread while we fill the queue
+        scheduler.enqueue(QStringLiteral("0"), 0, JobPriority::Background, [&]() { gate.acquire(); });
+        scheduler.enqueue(QStringLiteral("1"), 0, JobPriority::Background, record(QStringLiteral("bg1")));
+        scheduler.enqueue(QStringLiteral("2"), 0, JobPriority::Timeline, record(QStringLiteral("tl")));
+        scheduler.enqueue(QStringLiteral("3"), 0, JobPriority::Background, record(QStringLiteral("bg2")));
+        scheduler.enqueue(QStringLiteral("4"), 0, JobPriority::Interactive, record(QStringLiteral("int")));
+        scheduler.enqueue(QStringLiteral("5"), 0, JobPriority::Background, record(QStringLiteral("bg3")));
+        // The clip opened in the monitor jumps ahead
+        scheduler.setPriority(QStringLiteral("5"), JobPriority::Interactive);
+        REQUIRE(scheduler.statistics(0).queued == 5);
+        REQUIRE(scheduler.statistics(0).running == 1);
+        gate.release();
+        REQUIRE(scheduler.waitForDone(5000));
+        REQUIRE(order == QStringList({QStringLiteral("int"), QStringLiteral("bg3"), QStringLiteral("tl"), QStringLiteral("bg1"), QStringLiteral("bg2")}));
+        JobScheduler::Statistics stats = scheduler.statistics(0);
+        REQUIRE(stats.queued == 0);
+        REQUIRE(stats.running == 0);
+        REQUIRE(stats.completed == 6);
+    }
+
+    SECTION("Concurrency caps are respected without blocking other types")
+    {
+        JobScheduler scheduler(4);
+        scheduler.setConcurrencyLimit(1, 1);
+        REQUIRE(scheduler.concurrencyLimit(1) == 1);
+        REQUIRE(scheduler.concurrencyLimit(2) == 0);
+        std::atomic<int> running{0};
+        std::atomic<int> maxRunning{0};
+        QSemaphore gate;
+        QSemaphore others;
+        for (int i = 0; i < 4; ++i) {
+            scheduler.enqueue(QString::number(i), 1, JobPriority::Interactive, [&]() {
+                int current = ++running;
+                int previous = maxRunning;
+                while (current > previous && !maxRunning.compare_exchange_weak(previous, current)) {
+                }
+                gate.acquire();
+                --running;
+            });
+        }
+        // Less urgent tasks of another type can use the free threads
+        for (int i = 0; i < 3; ++i) {
+            scheduler.enqueue(QString::number(i), 2, JobPriority::Background, [&]() { others.release(); });
+        }
+        REQUIRE(others.tryAcquire(3, 5000));
+        REQUIRE(scheduler.statistics(1).running == 1);
+        REQUIRE(scheduler.statistics(1).queued == 3);
+        gate.release(4);
+        REQUIRE(scheduler.waitForDone(5000));
+        REQUIRE(maxRunning == 1);
+        REQUIRE(scheduler.statistics(1).completed == 4);
+    }
+
+    SECTION("Clearing drops queued tasks only")
+    {
+        JobScheduler scheduler(1);
+        QSemaphore gate;
+        std::atomic<int> done{0};
+        scheduler.enqueue(QStringLiteral("0"), 0, JobPriority::Background, [&]() {
+            gate.acquire();
+            ++done;
+        });
+        scheduler.enqueue(QStringLiteral("1"), 0, JobPriority::Background, [&]() { ++done; });
+        scheduler.clear();
+        gate.release();
+        REQUIRE(scheduler.waitForDone(5000));
+        REQUIRE(done == 1);
+        REQUIRE(scheduler.statistics(0).queued == 0);
+    }
+}
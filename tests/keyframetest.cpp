@@ -251,6 +251,41 @@ TEST_CASE("Keyframe model", "[KeyframeModel]")
         undoStack->undo();
         state1(6.1);
     }
+
+    SECTION("Interpolation matches MLT")
+    {
+        auto check_curve = [&]() {
+            Mlt::Properties mlt_prop;
+            mlt_prop.set("key", model->getAnimProperty().toUtf8().constData());
+            QVector<double> values = model->getInterpolatedValues(-5, 60);
+            REQUIRE(values.size() == 60);
+            for (int i = -5; i < 0; ++i) {
+                REQUIRE(values.at(i + 5) == Approx(model->getInterpolatedValue(0).toDouble()));
+            }
+            for (int i = 0; i < 55; ++i) {
+                double expected = mlt_prop.anim_get_double("key", i, 55);
+                REQUIRE(model->getInterpolatedValue(i).toDouble() == Approx(expected));
+                REQUIRE(values.at(i + 5) == Approx(expected));
+            }
+        };
+        REQUIRE(model->addKeyframe(GenTime(10, 25), KeyframeType::Linear, 20));
+        REQUIRE(model->addKeyframe(GenTime(20, 25), KeyframeType::Curve, 80));
+        REQUIRE(model->addKeyframe(GenTime(30, 25), KeyframeType::Discrete, 40));
+        REQUIRE(model->addKeyframe(GenTime(40, 25), KeyframeType::Curve, 60));
+        REQUIRE(model->addKeyframe(GenTime(45, 25), KeyframeType::Curve, 10));
+        check_curve();
+
+        // The compiled curve follows moves, updates and undo
+        REQUIRE(model->moveKeyframe(GenTime(20, 25), GenTime(25, 25), -1, true));
+        check_curve();
+        REQUIRE(model->updateKeyframe(GenTime(40, 25), QVariant(90)));
+        check_curve();
+        undoStack->undo();
+        check_curve();
+        undoStack->undo();
+        check_curve();
+        REQUIRE(model->getInterpolatedValue(15).toDouble() == Approx(50));
+    }
     pCore->m_projectManager = nullptr;
     Logger::print_trace();
 }
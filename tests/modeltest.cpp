@@ -2071,3 +2071,115 @@ TEST_CASE("Operations under locked tracks", "[Locked]")
     pCore->m_projectManager = nullptr;
     Logger::print_trace();
 }
+
+TEST_CASE("Range queries", "[TrackModel]")
+{
+    Logger::clear();
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> guideModel = std::make_shared<MarkerListModel>(undoStack);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    TimelineItemModel tim(&profile_model, undoStack);
+    Mock<TimelineItemModel> timMock(tim);
+    auto timeline = std::shared_ptr<TimelineItemModel>(&timMock.get(), [](...) {});
+    TimelineItemModel::finishConstruct(timeline, guideModel);
+
+    RESET(timMock);
+
+    QString binId = createProducer(profile_model, "red", binModel, 20);
+    int tid1 = TrackModel::construct(timeline);
+    int cid1 = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
+    int cid2 = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
+    int cid3 = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
+
+    // Clips at [0, 19], [30, 49], [50, 69]
+    REQUIRE(timeline->requestClipMove(cid1, tid1, 0));
+    REQUIRE(timeline->requestClipMove(cid2, tid1, 30));
+    REQUIRE(timeline->requestClipMove(cid3, tid1, 50));
+    REQUIRE(timeline->checkConsistency());
+
+    auto track = timeline->getTrackById(tid1);
+    REQUIRE(track->getClipsInRange(0) == std::unordered_set<int>({cid1, cid2, cid3}));
+    REQUIRE(track->getClipsInRange(10) == std::unordered_set<int>({cid1, cid2, cid3}));
+    REQUIRE(track->getClipsInRange(20) == std::unordered_set<int>({cid2, cid3}));
+    REQUIRE(track->getClipsInRange(20, 30).empty());
+    REQUIRE(track->getClipsInRange(19, 31) == std::unordered_set<int>({cid1, cid2}));
+    REQUIRE(track->getClipsInRange(49, 50) == std::unordered_set<int>({cid2}));
+    REQUIRE(track->getClipsInRange(70).empty());
+
+    // Resizing from the left moves the clip start, the index must follow
+    REQUIRE(timeline->requestItemResize(cid2, 15, false) == 15);
+    REQUIRE(timeline->checkConsistency());
+    REQUIRE(timeline->getClipPosition(cid2) == 35);
+    REQUIRE(track->getClipsInRange(20, 35).empty());
+    REQUIRE(track->getClipsInRange(20, 36) == std::unordered_set<int>({cid2}));
+    undoStack->undo();
+    REQUIRE(timeline->checkConsistency());
+    REQUIRE(track->getClipsInRange(20, 31) == std::unordered_set<int>({cid2}));
+
+    // Moves and deletions keep the index in sync
+    REQUIRE(timeline->requestClipMove(cid1, tid1, 80));
+    REQUIRE(timeline->checkConsistency());
+    REQUIRE(track->getClipsInRange(0, 30).empty());
+    REQUIRE(track->getClipsInRange(75) == std::unordered_set<int>({cid1}));
+    REQUIRE(timeline->requestItemDeletion(cid3));
+    REQUIRE(timeline->checkConsistency());
+    REQUIRE(timeline->getItemsInRange(tid1, 0) == std::unordered_set<int>({cid1, cid2}));
+    undoStack->undo();
+    undoStack->undo();
+    REQUIRE(timeline->checkConsistency());
+    REQUIRE(timeline->getItemsInRange(tid1, 0, 50) == std::unordered_set<int>({cid1, cid2}));
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+    Logger::print_trace();
+}
+
+TEST_CASE("Bin id lookups", "[BinModel]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    QString binId = createProducer(profile_model, "red", binModel);
+    QString folderId;
+    Fun undo = []() { return true; };
+    Fun redo = []() { return true; };
+    REQUIRE(binModel->requestAddFolder(folderId, QStringLiteral("folder"), binModel->getRootFolder()->clipId(), undo, redo));
+
+    REQUIRE(binModel->getClipByBinID(binId) != nullptr);
+    REQUIRE(binModel->getClipByBinID(binId + QStringLiteral("_1")) == binModel->getClipByBinID(binId));
+    REQUIRE(binModel->getItemByBinId(binId) == binModel->getClipByBinID(binId));
+    REQUIRE(binModel->getFolderByBinId(binId) == nullptr);
+    REQUIRE(binModel->getFolderByBinId(folderId) != nullptr);
+    REQUIRE(binModel->getClipByBinID(folderId) == nullptr);
+    REQUIRE(binModel->getItemByBinId(binModel->getRootFolder()->clipId()) == binModel->getRootFolder());
+    REQUIRE_FALSE(binModel->isIdFree(binId));
+    REQUIRE_FALSE(binModel->isIdFree(folderId));
+
+    // Deleting and restoring an item keeps the index in sync
+    Fun undoDel = []() { return true; };
+    Fun redoDel = []() { return true; };
+    REQUIRE(binModel->requestBinClipDeletion(binModel->getClipByBinID(binId), undoDel, redoDel));
+    REQUIRE(binModel->getClipByBinID(binId) == nullptr);
+    REQUIRE(binModel->getItemByBinId(binId) == nullptr);
+    REQUIRE(binModel->isIdFree(binId));
+    REQUIRE(undoDel());
+    REQUIRE(binModel->getClipByBinID(binId) != nullptr);
+    REQUIRE_FALSE(binModel->isIdFree(binId));
+
+    binModel->clean();
+    REQUIRE(binModel->getClipByBinID(binId) == nullptr);
+    REQUIRE(binModel->getFolderByBinId(folderId) == nullptr);
+    pCore->m_projectManager = nullptr;
+}
@@ -0,0 +1,63 @@
+#include "catch.hpp"
+#include "assets/model/parameterupdatecoalescer.hpp"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <vector>
+
+TEST_CASE("Parameter update coalescing", "[AssetParameterModel]")
+{
+    std::vector<ParameterUpdateCoalescer::Batch> batches;
+    ParameterUpdateCoalescer updates([&](const ParameterUpdateCoalescer::Batch &batch) { batches.push_back(batch); });
+
+    SECTION("Updates are merged until flush")
+    {
+        updates.addUpdate(4, true, true, 1000);
+        updates.addUpdate(2, true, false, 1000);
+        updates.addUpdate(7, false, true, 1000);
+        updates.addUpdate(3, true, true, 1000);
+        REQUIRE(updates.isPending());
+        REQUIRE(batches.empty());
+        updates.flush();
+        REQUIRE_FALSE(updates.isPending());
+        REQUIRE(batches.size() == 1);
+        // Only the rows that need a view update are in the range
+        REQUIRE(batches[0].firstRow == 2);
+        REQUIRE(batches[0].lastRow == 4);
+        REQUIRE_FALSE(batches[0].allRows);
+        REQUIRE(batches[0].refreshOwner);
+        REQUIRE(batches[0].updates == 4);
+        REQUIRE(updates.statistics().updates == 4);
+        REQUIRE(updates.statistics().batches == 1);
+        REQUIRE(updates.statistics().merged() == 3);
+
+        // Nothing to send
+        updates.flush();
+        REQUIRE(batches.size() == 1);
+
+        updates.addUpdate(-1, true, false, 1000);
+        updates.addUpdate(5, false, false, 1000);
+        updates.flush();
+        REQUIRE(batches.size() == 2);
+        REQUIRE(batches[1].allRows);
+        REQUIRE_FALSE(batches[1].refreshOwner);
+        REQUIRE(updates.statistics().merged() == 4);
+    }
+
+    SECTION("Pending updates are sent when the timer expires")
+    {
+        for (int i = 0; i < 20; ++i) {
+            updates.addUpdate(1, true, true, 10);
+        }
+        QElapsedTimer timer;
+        timer.start();
+        while (batches.empty() && timer.elapsed() < 5000) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 50);
+        }
+        REQUIRE(batches.size() == 1);
+        REQUIRE(batches[0].firstRow == 1);
+        REQUIRE(batches[0].lastRow == 1);
+        REQUIRE(batches[0].updates == 20);
+        REQUIRE_FALSE(updates.isPending());
+    }
+}
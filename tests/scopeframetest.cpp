@@ -0,0 +1,77 @@
+#include "catch.hpp"
+#include "scopes/colorscopes/histogramgenerator.h"
+#include "scopes/colorscopes/scopeframe.h"
+#include "scopes/colorscopes/vectorscopegenerator.h"
+#include "scopes/colorscopes/waveformgenerator.h"
+
+#include <vector>
+
+namespace {
+// A yuv420p buffer with a constant luma and neutral chroma
+std::vector<uchar> grayPlanes(int width, int height, uchar luma)
+{
+    std::vector<uchar> planes(size_t(width * height * 3 / 2), 128);
+    std::fill(planes.begin(), planes.begin() + width * height, luma);
+    return planes;
+}
+} // namespace
+
+TEST_CASE("Scope frames from yuv planes", "[Scopes]")
+{
+    SECTION("Video range is expanded")
+    {
+        std::vector<uchar> white = grayPlanes(64, 32, 235);
+        const ScopeFrame frame = ScopeFrame::fromYuv420(white.data(), 64, 32);
+        REQUIRE(frame.isYuv());
+        REQUIRE(frame.width() == 64);
+        REQUIRE(frame.height() == 32);
+        REQUIRE(frame.chromaWidth() == 32);
+        REQUIRE(frame.chromaHeight() == 16);
+        std::vector<uchar> luma(64);
+        frame.lumaRow(5, ITURec::Rec_709, luma.data());
+        REQUIRE(luma[0] == 255);
+        REQUIRE(luma[63] == 255);
+        REQUIRE(frame.pixel(10, 10) == qRgb(255, 255, 255));
+
+        std::vector<uchar> black = grayPlanes(64, 32, 16);
+        const ScopeFrame dark = ScopeFrame::fromYuv420(black.data(), 64, 32, 709);
+        dark.lumaRow(0, ITURec::Rec_601, luma.data());
+        REQUIRE(luma[0] == 0);
+        REQUIRE(dark.image().pixel(3, 3) == qRgb(0, 0, 0));
+    }
+
+    SECTION("Large frames are decimated")
+    {
+        std::vector<uchar> planes = grayPlanes(2048, 64, 128);
+        const ScopeFrame frame = ScopeFrame::fromYuv420(planes.data(), 2048, 64);
+        REQUIRE(frame.width() == 1024);
+        REQUIRE(frame.height() == 32);
+        const ScopeFrame full = ScopeFrame::fromYuv420(planes.data(), 2048, 64, 601, 0);
+        REQUIRE(full.width() == 2048);
+    }
+
+    SECTION("Scopes accept yuv and rgb frames")
+    {
+        std::vector<uchar> planes = grayPlanes(64, 32, 235);
+        const ScopeFrame yuvFrame = ScopeFrame::fromYuv420(planes.data(), 64, 32);
+        QImage white(64, 32, QImage::Format_RGB32);
+        white.fill(Qt::white);
+        const ScopeFrame rgbFrame(white);
+        REQUIRE_FALSE(rgbFrame.isYuv());
+
+        WaveformGenerator waveform;
+        const QImage yuvWave = waveform.calculateWaveform(QSize(100, 100), yuvFrame, WaveformGenerator::PaintMode_Yellow, false, ITURec::Rec_601);
+        const QImage rgbWave = waveform.calculateWaveform(QSize(100, 100), rgbFrame, WaveformGenerator::PaintMode_Yellow, false, ITURec::Rec_601);
+        REQUIRE(yuvWave == rgbWave);
+
+        HistogramGenerator histogram;
+        REQUIRE(!histogram.calculateHistogram(QSize(100, 100), yuvFrame, HistogramGenerator::ComponentY, ITURec::Rec_601, false, false).isNull());
+
+        // Gray has no chroma, everything lands in the center of the vectorscope
+        VectorscopeGenerator vectorscope;
+        const QImage scope =
+            vectorscope.calculateVectorscope(QSize(101, 101), yuvFrame, 1, VectorscopeGenerator::PaintMode_Green2, VectorscopeGenerator::ColorSpace_YUV, false);
+        REQUIRE(qAlpha(scope.pixel(50, 50)) > 0);
+        REQUIRE(qAlpha(scope.pixel(10, 10)) == 0);
+    }
+}
@@ -1,5 +1,7 @@
 #include "catch.hpp"
 #include "timeline2/model/snapmodel.hpp"
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <unordered_set>
 
@@ -124,3 +126,81 @@ TEST_CASE("Snap points model test", "[SnapModel]")
         REQUIRE(snap.getClosestPoint(999) == 15);
     }
 }
+
+TEST_CASE("Multi point snap queries", "[SnapModel]")
+{
+    SnapModel snap;
+    for (int pos : {10, 10, 50, 100, 130}) {
+        snap.addPoint(pos);
+    }
+    const std::map<int, int> before = snap._snaps();
+    int offset = 0;
+
+    SECTION("Closest moved point wins")
+    {
+        // 22 + 25 = 47 is 3 frames from 50, 98 + 25 = 123 is 7 frames from 130
+        REQUIRE(snap.getBestSnap({22, 98}, 25, 5, offset));
+        REQUIRE(offset == 28);
+        REQUIRE_FALSE(snap.getBestSnap({22, 98}, 25, 2, offset));
+        // Ties pick the following snap point, like getClosestPoint
+        REQUIRE(snap.getBestSnap({30}, 0, 20, offset));
+        REQUIRE(offset == 20);
+    }
+
+    SECTION("Excluded and extra points")
+    {
+        // Moving the item at 50-100 by 2 frames, its own points are ignored
+        REQUIRE_FALSE(snap.getBestSnap({50, 100}, 2, 5, offset, {50, 100}));
+        REQUIRE(snap.getBestSnap({50, 100}, 2, 5, offset, {50, 100}, {104}));
+        REQUIRE(offset == 4);
+        // Only one occurrence of a stacked point is masked
+        REQUIRE(snap.getBestSnap({12}, 0, 5, offset, {10}));
+        REQUIRE(offset == -2);
+        REQUIRE_FALSE(snap.getBestSnap({12}, 0, 5, offset, {10, 10}));
+        REQUIRE(snap.proposeSize(50, 100, 82, true, 5) == 80);
+        REQUIRE(snap.proposeSize(50, 100, 82, true, 5, {133}) == 80);
+        REQUIRE(snap.proposeSize(50, 100, 85, true, 5, {135}) == 85);
+    }
+
+    SECTION("Same result as ignoring points")
+    {
+        std::srand(42);
+        for (int i = 0; i < 200; ++i) {
+            snap.addPoint(std::rand() % 2000);
+        }
+        for (int test = 0; test < 100; ++test) {
+            std::vector<int> points;
+            for (int i = 0; i < 5; ++i) {
+                points.push_back(std::rand() % 2000);
+            }
+            const std::vector<int> excluded{std::rand() % 2 == 0 ? 10 : 50};
+            const int diff = std::rand() % 200 - 100;
+            // Reference: one closest point lookup per moved point
+            snap.ignore(excluded);
+            std::sort(points.begin(), points.end());
+            int lowestDiff = 11;
+            int expected = 0;
+            for (int point : points) {
+                int snapped = snap.getClosestPoint(point + diff);
+                if (std::abs(point + diff - snapped) < lowestDiff) {
+                    lowestDiff = std::abs(point + diff - snapped);
+                    expected = snapped - point;
+                }
+            }
+            snap.unIgnore();
+            const bool found = snap.getBestSnap(points, diff, 10, offset, excluded);
+            REQUIRE(found == (lowestDiff <= 10));
+            if (found) {
+                REQUIRE(offset == expected);
+            }
+        }
+    }
+
+    // Queries never modify the model
+    SECTION("Queries are read only")
+    {
+        const SnapModel &constSnap = snap;
+        constSnap.getBestSnap({10, 50}, 3, 10, offset, {10, 10, 50}, {0});
+        REQUIRE(constSnap._snaps() == before);
+    }
+}
@@ -0,0 +1,154 @@
+#include "test_utils.hpp"
+#include "utils/thumbnailcache.hpp"
+#include "utils/thumbnailextractor.hpp"
+
+#include <QtConcurrent>
+
+using namespace fakeit;
+
+TEST_CASE("Volatile thumbnail cache", "[ThumbnailCache]")
+{
+    auto &cache = ThumbnailCache::get();
+    cache->clearCache();
+    QImage img(100, 100, QImage::Format_ARGB32);
+    img.fill(Qt::red);
+    const qint64 cost = img.sizeInBytes();
+
+    SECTION("Store and retrieve by clip and position")
+    {
+        // Invalidation also looks for the project cache folder, so we mock a project manager without opened document
+        Mock<ProjectManager> pmMock;
+        When(Method(pmMock, current)).AlwaysReturn(nullptr);
+        ProjectManager &mocked = pmMock.get();
+        pCore->m_projectManager = &mocked;
+
+        cache->setMemoryBudget(1000 * cost);
+        cache->storeThumbnail(QStringLiteral("1"), 10, img, false);
+        REQUIRE(cache->hasThumbnail(QStringLiteral("1"), 10, true));
+        REQUIRE_FALSE(cache->hasThumbnail(QStringLiteral("1"), 11, true));
+        REQUIRE_FALSE(cache->hasThumbnail(QStringLiteral("2"), 10, true));
+        REQUIRE(cache->getThumbnail(QStringLiteral("1"), 10, true) == img);
+
+        cache->storeThumbnail(QStringLiteral("2"), 10, img, false);
+        cache->invalidateThumbsForClip(QStringLiteral("1"));
+        REQUIRE_FALSE(cache->hasThumbnail(QStringLiteral("1"), 10, true));
+        REQUIRE(cache->hasThumbnail(QStringLiteral("2"), 10, true));
+        pCore->m_projectManager = nullptr;
+    }
+
+    SECTION("Memory budget is respected and recently used items are kept")
+    {
+        cache->setMemoryBudget(64 * cost);
+        cache->storeThumbnail(QStringLiteral("1"), 0, img, false);
+        for (int i = 1; i < 500; ++i) {
+            // Keep the first item in use
+            REQUIRE(!cache->getThumbnail(QStringLiteral("1"), 0, true).isNull());
+            cache->storeThumbnail(QStringLiteral("1"), i, img, false);
+        }
+        int stored = 0;
+        for (int i = 0; i < 500; ++i) {
+            if (cache->hasThumbnail(QStringLiteral("1"), i, true)) {
+                stored++;
+            }
+        }
+        REQUIRE(stored <= 64);
+        REQUIRE(stored > 0);
+        REQUIRE(cache->hasThumbnail(QStringLiteral("1"), 0, true));
+        REQUIRE(cache->hasThumbnail(QStringLiteral("1"), 499, true));
+    }
+
+    SECTION("Concurrent readers and writers")
+    {
+        cache->setMemoryBudget(256 * cost);
+        QList<int> writers{0, 1, 2, 3};
+        QFuture<void> write = QtConcurrent::map(writers, [&](int w) {
+            for (int i = 0; i < 200; ++i) {
+                cache->storeThumbnail(QString::number(w), i, img, false);
+            }
+        });
+        int found = 0;
+        while (!write.isFinished()) {
+            for (int i = 0; i < 200; ++i) {
+                QImage res = cache->getThumbnail(QStringLiteral("0"), i, true);
+                if (!res.isNull()) {
+                    REQUIRE(res.size() == img.size());
+                    found++;
+                }
+            }
+        }
+        write.waitForFinished();
+        REQUIRE(cache->hasThumbnail(QStringLiteral("3"), 199, true));
+    }
+
+    SECTION("Closest cached thumbnail")
+    {
+        Mock<ProjectManager> pmMock;
+        When(Method(pmMock, current)).AlwaysReturn(nullptr);
+        ProjectManager &mocked = pmMock.get();
+        pCore->m_projectManager = &mocked;
+
+        cache->setMemoryBudget(1000 * cost);
+        int found = 0;
+        REQUIRE(cache->getNearestThumbnail(QStringLiteral("1"), 50, 100, &found).isNull());
+        REQUIRE(found == -1);
+        cache->storeThumbnail(QStringLiteral("1"), 10, img, false);
+        cache->storeThumbnail(QStringLiteral("1"), 100, img, false);
+        cache->storeThumbnail(QStringLiteral("2"), 50, img, false);
+        REQUIRE(cache->getNearestThumbnail(QStringLiteral("1"), 40, 100, &found) == img);
+        REQUIRE(found == 10);
+        REQUIRE(!cache->getNearestThumbnail(QStringLiteral("1"), 70, 100, &found).isNull());
+        REQUIRE(found == 100);
+        REQUIRE(cache->getNearestThumbnail(QStringLiteral("1"), 200, 50, &found).isNull());
+        // Removed thumbnails are not proposed anymore
+        cache->invalidateThumbsForClip(QStringLiteral("1"));
+        REQUIRE(cache->getNearestThumbnail(QStringLiteral("1"), 40, 100, &found).isNull());
+        REQUIRE(cache->getNearestThumbnail(QStringLiteral("2"), 40, 100, &found) == img);
+        REQUIRE(found == 50);
+        pCore->m_projectManager = nullptr;
+    }
+    cache->clearCache();
+    cache->setMemoryBudget(32 * 1024 * 1024);
+}
+
+TEST_CASE("Thumbnail extraction order", "[ThumbnailCache]")
+{
+    using Step = ThumbnailExtractor::Step;
+    auto positions = [](const std::vector<Step> &steps, bool output) {
+        std::vector<int> result;
+        for (const Step &step : steps) {
+            if (step.output == output) {
+                result.push_back(step.position);
+            }
+        }
+        return result;
+    };
+    const int window = ThumbnailExtractor::decoderForwardWindow;
+
+    SECTION("Requests are sorted and deduplicated")
+    {
+        auto steps = ThumbnailExtractor::plan({50, 10, 30, 10}, 1, ThumbnailExtractor::Mode::Exact);
+        REQUIRE(positions(steps, true) == std::vector<int>({10, 30, 50}));
+        REQUIRE(positions(steps, false).empty());
+    }
+
+    SECTION("Frames of the same GOP are reached by decoding forward")
+    {
+        const int gop = 4 * window;
+        auto steps = ThumbnailExtractor::plan({0, 3 * window + 1, 10 * window}, gop, ThumbnailExtractor::Mode::Exact);
+        REQUIRE(positions(steps, true) == std::vector<int>({0, 3 * window + 1, 10 * window}));
+        // The decoder is never asked to jump further than it reads forward
+        REQUIRE(positions(steps, false) == std::vector<int>({window, 2 * window, 3 * window}));
+        int last = 0;
+        for (size_t i = 1; i < steps.size() - 1; ++i) {
+            REQUIRE(steps[i].position - last <= window);
+            last = steps[i].position;
+        }
+    }
+
+    SECTION("Keyframe mode always seeks")
+    {
+        auto steps = ThumbnailExtractor::plan({0, 3 * window, 100}, 1000, ThumbnailExtractor::Mode::KeyframesOnly);
+        REQUIRE(positions(steps, true) == std::vector<int>({0, 3 * window, 100}));
+        REQUIRE(positions(steps, false).empty());
+    }
+}
@@ -185,3 +185,89 @@ TEST_CASE("Basic tree testing", "[TreeModel]")
         state();
     }
 }
+
+TEST_CASE("Tree rows stay consistent", "[TreeModel]")
+{
+    auto model = AbstractTreeModel::construct();
+    auto root = model->getRoot();
+    std::vector<std::shared_ptr<TreeItem>> items;
+    for (int i = 0; i < 6; ++i) {
+        items.push_back(root->appendChild(QList<QVariant>{QString::number(i)}));
+    }
+    for (int i = 0; i < 6; ++i) {
+        REQUIRE(items[i]->row() == i);
+        REQUIRE(root->child(i) == items[i]);
+    }
+
+    // Removing an item shifts the following rows
+    root->removeChild(items[1]);
+    REQUIRE(items[0]->row() == 0);
+    REQUIRE(items[5]->row() == 4);
+    REQUIRE(items[2]->row() == 1);
+    REQUIRE(root->child(1) == items[2]);
+    REQUIRE(items[1]->row() == -1);
+
+    // Moving an item inside the same parent
+    root->moveChild(0, items[4]);
+    REQUIRE(items[4]->row() == 0);
+    REQUIRE(items[0]->row() == 1);
+    REQUIRE(items[3]->row() == 3);
+    REQUIRE(items[5]->row() == 4);
+    REQUIRE(root->child(4) == items[5]);
+
+    // Appending after a move
+    root->appendChild(items[1]);
+    REQUIRE(items[1]->row() == 5);
+    REQUIRE(model->checkConsistency());
+}
+
+TEST_CASE("Batch insertion in the tree", "[TreeModel]")
+{
+    auto model = AbstractTreeModel::construct();
+    auto root = model->getRoot();
+    auto folder = root->appendChild(QList<QVariant>{QString("folder")});
+    folder->appendChild(QList<QVariant>{QString("existing")});
+
+    std::vector<std::shared_ptr<TreeItem>> batch;
+    for (int i = 0; i < 5; ++i) {
+        batch.push_back(TreeItem::construct(QList<QVariant>{QString::number(i)}, model, false));
+    }
+    int notifications = 0;
+    int first = -1;
+    int last = -1;
+    QObject::connect(model.get(), &QAbstractItemModel::rowsInserted, [&](const QModelIndex &, int start, int end) {
+        notifications++;
+        first = start;
+        last = end;
+    });
+
+    Fun undo = []() { return true; };
+    Fun redo = model->addItems_lambda(batch, folder->getId());
+    REQUIRE(redo());
+    REQUIRE(notifications == 1);
+    REQUIRE(first == 1);
+    REQUIRE(last == 5);
+    REQUIRE(model->checkConsistency());
+    REQUIRE(model->rowCount(model->getIndexFromItem(folder)) == 6);
+    for (int i = 0; i < 5; ++i) {
+        REQUIRE(batch[i]->row() == i + 1);
+        REQUIRE(batch[i]->depth() == 2);
+        REQUIRE(model->getItemById(batch[i]->getId()) == batch[i]);
+    }
+
+    // Items that already have a parent are rejected as a whole
+    auto extra = TreeItem::construct(QList<QVariant>{QString("extra")}, model, false);
+    REQUIRE_FALSE(root->appendChildren({extra, batch[0]}));
+    REQUIRE(notifications == 1);
+    REQUIRE(extra->parentItem().expired());
+
+    // Removal and reinsertion of the batch, as done by undo / redo
+    for (const auto &item : batch) {
+        REQUIRE(model->removeItem_lambda(item->getId())());
+    }
+    REQUIRE(model->rowCount(model->getIndexFromItem(folder)) == 1);
+    REQUIRE(redo());
+    REQUIRE(notifications == 2);
+    REQUIRE(model->rowCount(model->getIndexFromItem(folder)) == 6);
+    REQUIRE(model->checkConsistency());
+}
@@ -0,0 +1,65 @@
+#include "catch.hpp"
+#include "macros.hpp"
+
+#include <QReadWriteLock>
+#include <vector>
+
+TEST_CASE("Flat undo sequences", "[Undo]")
+{
+    std::vector<int> log;
+    auto step = [&log](int id, bool result) {
+        return Fun([&log, id, result]() {
+            log.push_back(id);
+            return result;
+        });
+    };
+
+    SECTION("Operations run in the same order as nested lambdas")
+    {
+        Fun undo = []() { return true; };
+        Fun redo = []() { return true; };
+        for (int i = 0; i < 3; ++i) {
+            Fun operation = step(i, true);
+            Fun reverse = step(-i, true);
+            UPDATE_UNDO_REDO_NOLOCK(operation, reverse, undo, redo);
+        }
+        REQUIRE(FunSequence::stepCount(redo) == 4);
+        REQUIRE(redo());
+        REQUIRE(log == std::vector<int>{0, 1, 2});
+        log.clear();
+        REQUIRE(undo());
+        REQUIRE(log == std::vector<int>{-2, -1, 0});
+    }
+
+    SECTION("Failures short circuit only pushed lambdas")
+    {
+        Fun lambda = step(0, false);
+        Fun next = step(1, true);
+        PUSH_LAMBDA(next, lambda);
+        REQUIRE_FALSE(lambda());
+        REQUIRE(log == std::vector<int>{0});
+        log.clear();
+
+        Fun front = step(2, false);
+        Fun inner = step(3, true);
+        PUSH_FRONT_LAMBDA(front, inner);
+        Fun after = step(4, true);
+        UPDATE_UNDO_REDO_NOLOCK(after, after, inner, inner);
+        REQUIRE_FALSE(inner());
+        REQUIRE(log == std::vector<int>{4, 2, 4});
+    }
+
+    SECTION("Copies are not affected by later pushes")
+    {
+        Fun lambda = step(0, true);
+        Fun next = step(1, true);
+        PUSH_LAMBDA(next, lambda);
+        Fun copy = lambda;
+        PUSH_LAMBDA(next, lambda);
+        REQUIRE(copy());
+        REQUIRE(log == std::vector<int>{0, 1});
+        log.clear();
+        REQUIRE(lambda());
+        REQUIRE(log == std::vector<int>{0, 1, 1});
+    }
+}